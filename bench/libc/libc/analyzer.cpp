@@ -0,0 +1,34 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/inputs.hpp>
+#include <libc/symtab.hpp>
+
+namespace {
+
+void BM_Analyze(benchmark::State &state, const std::string &source) {
+    auto program = parse_program(source);
+    auto symtab = c::get_symtab(program);
+    for (auto _ : state) {
+        c::analyze(program, symtab);
+    }
+    set_throughput(state, source.size(), program.get_number_of_nodes());
+}
+
+void BM_AnalyzeSynthetic(benchmark::State &state) {
+    BM_Analyze(state, synthetic(static_cast<std::size_t>(state.range(0))));
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(BM_Analyze, hello_world, example("hello_world.c"));
+BENCHMARK_CAPTURE(
+    BM_Analyze,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"));
+BENCHMARK_CAPTURE(BM_Analyze, search_substr, example("search_substr.c"));
+BENCHMARK(BM_AnalyzeSynthetic)->Apply(synthetic_sizes);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
@@ -0,0 +1,40 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/code_generator.hpp>
+#include <libc/inputs.hpp>
+#include <libc/symtab.hpp>
+
+#include <sstream>
+
+namespace {
+
+void BM_Generate(benchmark::State &state, const std::string &source) {
+    auto program = parse_program(source);
+    auto symtab = c::get_symtab(program);
+    c::analyze(program, symtab);
+    for (auto _ : state) {
+        std::ostringstream ir;
+        c::generate(ir, program, symtab);
+        benchmark::DoNotOptimize(ir);
+    }
+    set_throughput(state, source.size(), program.get_number_of_nodes());
+}
+
+void BM_GenerateSynthetic(benchmark::State &state) {
+    BM_Generate(state, synthetic(static_cast<std::size_t>(state.range(0))));
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(BM_Generate, hello_world, example("hello_world.c"));
+BENCHMARK_CAPTURE(
+    BM_Generate,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"));
+BENCHMARK_CAPTURE(BM_Generate, search_substr, example("search_substr.c"));
+BENCHMARK(BM_GenerateSynthetic)->Apply(synthetic_sizes);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
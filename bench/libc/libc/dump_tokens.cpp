@@ -0,0 +1,36 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/dump_tokens.hpp>
+#include <libc/inputs.hpp>
+
+#include <sstream>
+
+namespace {
+
+void BM_DumpTokens(benchmark::State &state, const std::string &source) {
+    for (auto _ : state) {
+        std::istringstream in(source);
+        std::ostringstream out;
+        c::dump_tokens(in, out);
+        benchmark::DoNotOptimize(out);
+    }
+    set_throughput(state, source.size(), 0);
+}
+
+void BM_DumpTokensSynthetic(benchmark::State &state) {
+    BM_DumpTokens(state, synthetic(static_cast<std::size_t>(state.range(0))));
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(BM_DumpTokens, hello_world, example("hello_world.c"));
+BENCHMARK_CAPTURE(
+    BM_DumpTokens,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"));
+BENCHMARK_CAPTURE(BM_DumpTokens, search_substr, example("search_substr.c"));
+BENCHMARK(BM_DumpTokensSynthetic)->Apply(synthetic_sizes);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
@@ -0,0 +1,82 @@
+#include <libc/inputs.hpp>
+#include <libc/parser.hpp>
+#include <libc/source_dir.hpp>
+#include <libc/workload.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t lines_per_function = 1000;
+// Every function takes a slot in the global scope of the symbol table
+constexpr std::size_t max_functions = 64;
+
+std::string make_synthetic(std::size_t lines) {
+    c::WorkloadOptions options;
+    options.functions_ =
+        std::clamp<std::size_t>(lines / lines_per_function, 1, max_functions);
+    // The reductions of the stored values and the closing braces of the
+    // nested statements make a statement about 15/8 lines
+    options.statements_ = lines / options.functions_ * 8 / 15;
+
+    std::ostringstream out;
+    c::generate_workload(out, options);
+    return out.str();
+}
+
+} // namespace
+
+const std::string &example(const std::string &name) {
+    static std::map<std::string, std::string> cache;
+
+    auto it = cache.find(name);
+    if (it == cache.end()) {
+        std::ifstream file(c_source_dir / "examples" / name);
+        if (!file) {
+            throw std::runtime_error("Can't open example " + name);
+        }
+        std::ostringstream source;
+        source << file.rdbuf();
+        it = cache.emplace(name, source.str()).first;
+    }
+    return it->second;
+}
+
+const std::string &synthetic(std::size_t lines) {
+    static std::map<std::size_t, std::string> cache;
+
+    auto it = cache.find(lines);
+    if (it == cache.end()) {
+        it = cache.emplace(lines, make_synthetic(lines)).first;
+    }
+    return it->second;
+}
+
+c::ast::Program parse_program(const std::string &source) {
+    std::istringstream in(source);
+    auto result = c::parse(in);
+    if (!result.errors_.empty()) {
+        throw std::runtime_error("Benchmark input has syntax errors");
+    }
+    return std::move(result.program_);
+}
+
+void synthetic_sizes(benchmark::internal::Benchmark *bench) {
+    bench->ArgName("lines")
+        ->RangeMultiplier(10)
+        ->Range(1'000, 1'000'000)
+        ->Unit(benchmark::kMillisecond);
+}
+
+void set_throughput(
+    benchmark::State &state, std::size_t bytes, std::size_t nodes) {
+    const auto iterations = static_cast<std::size_t>(state.iterations());
+    state.SetBytesProcessed(static_cast<int64_t>(iterations * bytes));
+    state.counters["nodes"] = benchmark::Counter(
+        static_cast<double>(iterations * nodes),
+        benchmark::Counter::kIsRate);
+}
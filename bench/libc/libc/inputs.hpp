@@ -0,0 +1,24 @@
+#pragma once
+
+#include <libc/ast/ast.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <string>
+
+// Source of a program from the examples directory
+const std::string &example(const std::string &name);
+
+// Generated program of about `lines` lines, the same on every run
+const std::string &synthetic(std::size_t lines);
+
+// Parses the input of the later phases outside of their timed loops
+c::ast::Program parse_program(const std::string &source);
+
+// Runs the benchmark on synthetic programs from 1K to 1M lines
+void synthetic_sizes(benchmark::internal::Benchmark *bench);
+
+// Reports bytes/s of source text and AST nodes/s for the finished loop
+void set_throughput(
+    benchmark::State &state, std::size_t bytes, std::size_t nodes);
@@ -0,0 +1,148 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/code_generator.hpp>
+#include <libc/inputs.hpp>
+#include <libc/interpreter.hpp>
+#include <libc/symtab.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Counts the primes below 100000 ten times, the examples are too short to
+// time the execution
+const std::string sieve = R"(#include <stdio.h>
+
+int main(int argc, char **argv) {
+    const int size = 100000;
+    char composite[size];
+    int count = 0;
+    for (int round = 0; round < 10; round += 1) {
+        for (int i = 0; i < size; i += 1) {
+            composite[i] = 0;
+        }
+        count = 0;
+        for (int i = 2; i < size; i += 1) {
+            if (composite[i] == 0) {
+                count += 1;
+                for (int j = i * 2; j < size; j += i) {
+                    composite[j] = 1;
+                }
+            }
+        }
+    }
+    printf("%d\n", count);
+    return 0;
+}
+)";
+
+// Compiles the program to bytecode and runs it in every iteration
+void BM_Interpret(
+    benchmark::State &state,
+    const std::string &source,
+    const std::vector<std::string> &args) {
+    auto program = parse_program(source);
+    auto symtab = c::get_symtab(program);
+    c::analyze(program, symtab);
+    std::FILE *out = std::fopen("/dev/null", "w");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(c::interpret(program, symtab, args, out));
+    }
+    std::fclose(out);
+}
+
+// Runs the binary clang -O2 builds from the IR of the program, the time
+// includes the start of the process and is the real one, the CPU time of
+// the child isn't counted
+void BM_Native(
+    benchmark::State &state,
+    const std::string &source,
+    const std::vector<std::string> &args) {
+    if (std::system("clang --version > /dev/null 2>&1") != 0) {
+        state.SkipWithError("clang is not available");
+        return;
+    }
+
+    auto program = parse_program(source);
+    auto symtab = c::get_symtab(program);
+    c::analyze(program, symtab);
+
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto ir_path = dir / ("c-bench-" + args[0] + ".ll");
+    const auto exe_path = dir / ("c-bench-" + args[0]);
+    {
+        std::ofstream ir(ir_path);
+        c::generate(ir, program, symtab);
+    }
+    if (std::system(("clang -O2 -w " + ir_path.string() + " -o " +
+                     exe_path.string())
+                        .c_str()) != 0) {
+        state.SkipWithError("clang failed");
+        std::filesystem::remove(ir_path);
+        return;
+    }
+
+    auto command = exe_path.string();
+    for (std::size_t i = 1; i < args.size(); ++i) {
+        command += " '" + args[i] + "'";
+    }
+    command += " > /dev/null";
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(std::system(command.c_str()));
+    }
+
+    std::filesystem::remove(ir_path);
+    std::filesystem::remove(exe_path);
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(
+    BM_Interpret,
+    hello_world,
+    example("hello_world.c"),
+    {"hello_world"});
+BENCHMARK_CAPTURE(
+    BM_Interpret,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"),
+    {"search_min_elem_in_array"});
+BENCHMARK_CAPTURE(
+    BM_Interpret,
+    search_substr,
+    example("search_substr.c"),
+    {"search_substr", "Hello world", "world"});
+BENCHMARK_CAPTURE(BM_Interpret, sieve, sieve, {"sieve"})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_CAPTURE(
+    BM_Native,
+    hello_world,
+    example("hello_world.c"),
+    {"hello_world"})
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_Native,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"),
+    {"search_min_elem_in_array"})
+    ->UseRealTime();
+BENCHMARK_CAPTURE(
+    BM_Native,
+    search_substr,
+    example("search_substr.c"),
+    {"search_substr", "Hello world", "world"})
+    ->UseRealTime();
+BENCHMARK_CAPTURE(BM_Native, sieve, sieve, {"sieve"})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
\ No newline at end of file
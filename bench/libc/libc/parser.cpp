@@ -0,0 +1,35 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/inputs.hpp>
+#include <libc/parser.hpp>
+
+#include <sstream>
+
+namespace {
+
+void BM_Parse(benchmark::State &state, const std::string &source) {
+    std::size_t nodes = 0;
+    for (auto _ : state) {
+        std::istringstream in(source);
+        auto result = c::parse(in);
+        nodes = result.program_.get_number_of_nodes();
+        benchmark::DoNotOptimize(result);
+    }
+    set_throughput(state, source.size(), nodes);
+}
+
+void BM_ParseSynthetic(benchmark::State &state) {
+    BM_Parse(state, synthetic(static_cast<std::size_t>(state.range(0))));
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(BM_Parse, hello_world, example("hello_world.c"));
+BENCHMARK_CAPTURE(
+    BM_Parse, search_min_elem_in_array, example("search_min_elem_in_array.c"));
+BENCHMARK_CAPTURE(BM_Parse, search_substr, example("search_substr.c"));
+BENCHMARK(BM_ParseSynthetic)->Apply(synthetic_sizes);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
@@ -0,0 +1,33 @@
+#include <benchmark/benchmark.h>
+
+#include <libc/inputs.hpp>
+#include <libc/symtab.hpp>
+
+namespace {
+
+void BM_GetSymtab(benchmark::State &state, const std::string &source) {
+    auto program = parse_program(source);
+    for (auto _ : state) {
+        auto symtab = c::get_symtab(program);
+        benchmark::DoNotOptimize(symtab);
+    }
+    set_throughput(state, source.size(), program.get_number_of_nodes());
+}
+
+void BM_GetSymtabSynthetic(benchmark::State &state) {
+    BM_GetSymtab(state, synthetic(static_cast<std::size_t>(state.range(0))));
+}
+
+} // namespace
+
+// NOLINTBEGIN(cppcoreguidelines-avoid-non-const-global-variables)
+
+BENCHMARK_CAPTURE(BM_GetSymtab, hello_world, example("hello_world.c"));
+BENCHMARK_CAPTURE(
+    BM_GetSymtab,
+    search_min_elem_in_array,
+    example("search_min_elem_in_array.c"));
+BENCHMARK_CAPTURE(BM_GetSymtab, search_substr, example("search_substr.c"));
+BENCHMARK(BM_GetSymtabSynthetic)->Apply(synthetic_sizes);
+
+// NOLINTEND(cppcoreguidelines-avoid-non-const-global-variables)
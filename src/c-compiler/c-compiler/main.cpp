@@ -1,37 +1,61 @@
 #include <libc/analyzer.hpp>
+#include <libc/asm_generator.hpp>
 #include <libc/code_generator.hpp>
 #include <libc/dump_tokens.hpp>
+#include <libc/interpreter.hpp>
+#include <libc/jit.hpp>
 #include <libc/parser.hpp>
+#include <libc/profile.hpp>
 #include <libc/symtab.hpp>
+#include <libc/time_report.hpp>
+#include <libc/trace.hpp>
 
 #include <cxxopts.hpp>
 
+#include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
 
-int main(int argc, char **argv) {
-    cxxopts::Options options("c-compiler");
-    options.positional_help("<file-path>");
-    // clang-format off
-    options.add_options()
-        ("file-path", "", cxxopts::value<std::filesystem::path>())
-        ("dump-tokens", "")
-        ("dump-ast", "")
-        ("dump-symtab", "")
-        ("dump-asm", "")
-        ("h,help", "")
-    ;
-    // clang-format on
-    options.parse_positional({"file-path"});
-    const auto result = options.parse(argc, argv);
+namespace {
 
-    if (result.count("file-path") != 1 || result.count("help") > 0) {
-        std::cout << options.help() << "\n";
+// Compiles by the x86-64 backend and links by the system compiler driver
+int compile_native(
+    const cxxopts::ParseResult &result,
+    c::ast::Program &program,
+    c::ast::symtab::Symtab &symtab,
+    c::TimeReport *report) {
+    if (result.count("dump-asm") > 0) {
+        c::generate_asm(std::cout, program, symtab, report);
         return 0;
     }
 
+    std::string filename =
+        result["file-path"].as<std::filesystem::path>().filename();
+    filename.replace(filename.find_first_of('.'), 3, ".s");
+
+    std::ofstream asm_out(filename);
+    if (!asm_out.good()) {
+        std::cerr << "Unable to write stream - " << filename << "\n";
+        return 0;
+    }
+
+    c::generate_asm(asm_out, program, symtab, report);
+
+    asm_out.close();
+
+    c::TimeReport::Phase phase(report, "assembler invocation");
+    C_TRACE_SCOPE("pipeline", "assembler invocation");
+    std::system(("cc " + filename).c_str());
+
+    return 0;
+}
+
+int compile(const cxxopts::ParseResult &result, c::TimeReport *report) {
     std::ifstream input_stream(result["file-path"].as<std::filesystem::path>());
     if (!input_stream.good()) {
         std::cerr << "Unable to read stream\n";
@@ -43,7 +67,7 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    auto parser_result = c::parse(input_stream);
+    auto parser_result = c::parse(input_stream, report);
     if (!parser_result.errors_.empty()) {
         c::dump_errors(parser_result.errors_, std::cerr);
         return 0;
@@ -55,6 +79,8 @@ int main(int argc, char **argv) {
 
     c::ast::symtab::Symtab symtab;
     try {
+        c::TimeReport::Phase phase(report, "symtab construction");
+        C_TRACE_SCOPE("pipeline", "symtab construction");
         symtab = c::get_symtab(parser_result.program_);
     } catch (const c::ast::symtab::UndefinedReference &ex) {
         std::cout << ex.what() << '\n';
@@ -63,19 +89,119 @@ int main(int argc, char **argv) {
         std::cout << ex.what() << '\n';
         return 0;
     }
+    if (report != nullptr) {
+        report->add_count("symbols", symtab.get_number_of_symbols());
+    }
     if (result.count("dump-symtab") > 0) {
         c::dump_symtab(symtab, std::cout);
         return 0;
     }
 
+    std::vector<std::string> exported;
+    if (result.count("export") > 0) {
+        exported = result["export"].as<std::vector<std::string>>();
+    }
+    if (result.count("optimize") > 0) {
+        c::TimeReport::Phase phase(report, "dead function elimination");
+        C_TRACE_SCOPE("pipeline", "dead function elimination");
+        auto removed =
+            c::eliminate_dead_functions(parser_result.program_, exported);
+        if (report != nullptr) {
+            report->add_count("dead functions", removed);
+        }
+    }
+
     try {
+        c::TimeReport::Phase phase(report, "type analysis");
+        C_TRACE_SCOPE("pipeline", "type analysis");
         c::analyze(parser_result.program_, symtab);
     } catch (const c::ast::TypeAnalyzer::Exception &ex) {
+        // The nodes after the error have no types, so there is nothing to
+        // generate the code from
         std::cout << ex.what() << '\n';
+        return 1;
+    }
+
+    if (result.count("run") > 0) {
+        std::vector<std::string> args = {
+            result["file-path"].as<std::filesystem::path>().string()};
+        if (result.count("args") > 0) {
+            auto rest = result["args"].as<std::vector<std::string>>();
+            args.insert(args.end(), rest.begin(), rest.end());
+        }
+        try {
+            if (result["backend"].as<std::string>() == "bytecode") {
+                return c::interpret(
+                    parser_result.program_, symtab, args, stdout, report);
+            }
+            return c::run(parser_result.program_, symtab, args, report);
+        } catch (const std::runtime_error &ex) {
+            std::cerr << ex.what() << '\n';
+            return 1;
+        }
+    }
+
+    if (result["backend"].as<std::string>() == "x86-64") {
+        return compile_native(result, parser_result.program_, symtab, report);
+    }
+    if (result["backend"].as<std::string>() == "bytecode") {
+        if (result.count("dump-asm") == 0) {
+            std::cerr << "The bytecode backend only runs programs, use --run\n";
+            return 1;
+        }
+        c::dump_bytecode(std::cout, parser_result.program_, symtab, report);
+        return 0;
+    }
+
+    c::ast::CodeGenOptions codegen_options;
+    codegen_options.promote_scalars_ = result.count("optimize") > 0;
+    codegen_options.fold_constants_ = result.count("optimize") > 0;
+    codegen_options.hoist_invariant_calls_ = result.count("optimize") > 0;
+    codegen_options.internalize_ = result.count("optimize") > 0;
+    codegen_options.infer_attributes_ = result.count("optimize") > 0;
+    codegen_options.simplify_cfg_ = result.count("optimize") > 0;
+    codegen_options.rotate_loops_ = result.count("optimize") > 0;
+    codegen_options.hoist_allocas_ = result.count("optimize") > 0;
+    codegen_options.optimize_indexing_ = result.count("optimize") > 0;
+    codegen_options.number_values_ = result.count("optimize") > 0;
+    codegen_options.branch_weights_ = result.count("optimize") > 0;
+    // The rewrites are local and cheap, so they are done without -O too
+    codegen_options.reduce_strength_ = true;
+    codegen_options.exported_ = exported;
+    if (result.count("optimize") > 0) {
+        codegen_options.inline_threshold_ =
+            result["inline-threshold"].as<std::size_t>();
+    }
+    if (result.count("inline-report") > 0) {
+        codegen_options.inline_report_ = &std::cerr;
+    }
+    if (result.count("profile-generate") > 0) {
+        codegen_options.profile_generate_ =
+            result["profile-generate"].as<std::string>();
+    }
+    if (result.count("instrument-functions") > 0) {
+        codegen_options.instrument_functions_ =
+            result["instrument-functions"].as<std::string>();
+    }
+    c::Profile profile;
+    if (result.count("profile-use") > 0) {
+        std::ifstream profile_stream(result["profile-use"].as<std::string>());
+        if (!profile_stream.good()) {
+            std::cerr << "Unable to read the profile\n";
+            return 1;
+        }
+        try {
+            profile = c::read_profile(profile_stream);
+        } catch (const std::runtime_error &ex) {
+            std::cerr << ex.what() << '\n';
+            return 1;
+        }
+        codegen_options.profile_use_ = &profile;
     }
 
     if (result.count("dump-asm") > 0) {
-        c::generate(std::cout, parser_result.program_, symtab);
+        c::generate(
+            std::cout, parser_result.program_, symtab, codegen_options, report);
         return 0;
     }
 
@@ -89,11 +215,110 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    c::generate(ir_out, parser_result.program_, symtab);
+    c::generate(
+        ir_out, parser_result.program_, symtab, codegen_options, report);
 
     ir_out.close();
 
+    c::TimeReport::Phase phase(report, "clang invocation");
+    C_TRACE_SCOPE("pipeline", "clang invocation");
     std::system(("clang " + filename).c_str());
 
     return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    cxxopts::Options options("c-compiler");
+    options.positional_help("<file-path> [args...]");
+    // clang-format off
+    options.add_options()
+        ("file-path", "", cxxopts::value<std::filesystem::path>())
+        ("args", "", cxxopts::value<std::vector<std::string>>())
+        ("dump-tokens", "")
+        ("dump-ast", "")
+        ("dump-symtab", "")
+        ("dump-asm", "")
+        ("backend", "Generate LLVM IR and compile it by clang (llvm), "
+            "x86-64 assembly and assemble it by cc (x86-64) or register "
+            "bytecode and interpret it with --run (bytecode), the "
+            "optimizations of -O besides dead function elimination only "
+            "apply to llvm",
+            cxxopts::value<std::string>()->default_value("llvm"))
+        ("O,optimize", "Keep scalar variables in SSA registers, fold "
+            "constants, hoist invariant calls out of loops, internalize "
+            "functions, infer their attributes, inline small ones, drop "
+            "the ones main doesn't call and the unreachable code, merge "
+            "the blocks, rotate the loops, allocate the locals in the entry "
+            "block, index arrays by 64-bit loop counters, reuse the "
+            "values computed in the block and weight the branches")
+        ("inline-threshold", "Inline the calls of non-recursive functions "
+            "of at most this size with -O, 0 turns inlining off",
+            cxxopts::value<std::size_t>()->default_value("25"))
+        ("inline-report", "Print the inlined calls to stderr")
+        ("export", "Functions called from outside of the program besides "
+            "main, -O keeps them and their callees",
+            cxxopts::value<std::vector<std::string>>())
+        ("time-report", "Print time and memory of every phase to stderr "
+            "(text or json)",
+            cxxopts::value<std::string>()->implicit_value("text"))
+        ("trace", "Write Chrome trace events of the compilation to the file "
+            "(needs a build with C_ENABLE_TRACING)",
+            cxxopts::value<std::string>())
+        ("profile-generate", "Count the calls and the branches, every run "
+            "of the program appends the counts to the file",
+            cxxopts::value<std::string>())
+        ("profile-use", "Weight the branches and mark the hot and cold "
+            "functions by the counts of the file",
+            cxxopts::value<std::string>())
+        ("instrument-functions", "Count the calls of the functions and "
+            "the cycles spent in them, the program writes a flat profile to "
+            "the file at exit",
+            cxxopts::value<std::string>()->implicit_value("functions.prof"))
+        ("run", "Compile to x86-64 machine code in memory, or to bytecode "
+            "with --backend bytecode, and run it with the arguments after "
+            "the file path, the exit code is the one of main")
+        ("h,help", "")
+    ;
+    // clang-format on
+    options.parse_positional({"file-path", "args"});
+    const auto result = options.parse(argc, argv);
+
+    if (result.count("file-path") != 1 || result.count("help") > 0) {
+        std::cout << options.help() << "\n";
+        return 0;
+    }
+
+    const auto backend = result["backend"].as<std::string>();
+    if (backend != "llvm" && backend != "x86-64" && backend != "bytecode") {
+        std::cerr << "Unknown backend - " << backend << "\n";
+        return 1;
+    }
+
+    c::TimeReport time_report;
+    c::TimeReport *report =
+        result.count("time-report") > 0 ? &time_report : nullptr;
+
+    const bool is_tracing = result.count("trace") > 0;
+    if (is_tracing && !c::trace::start(result["trace"].as<std::string>())) {
+        std::cerr << "c-compiler was built without C_ENABLE_TRACING\n";
+        return 1;
+    }
+
+    const int ret = compile(result, report);
+
+    if (is_tracing) {
+        c::trace::stop();
+    }
+
+    if (report != nullptr) {
+        if (result["time-report"].as<std::string>() == "json") {
+            report->print_json(std::cerr);
+        } else {
+            report->print(std::cerr);
+        }
+    }
+
+    return ret;
 }
\ No newline at end of file
@@ -0,0 +1,87 @@
+#include <libc/workload.hpp>
+
+#include <cxxopts.hpp>
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv) {
+    const c::WorkloadOptions defaults;
+
+    cxxopts::Options options(
+        "c-workload", "Generates a C program for stress and scaling tests");
+    // clang-format off
+    options.add_options()
+        ("o,output", "Write the program to the file instead of stdout",
+            cxxopts::value<std::string>())
+        ("seed", "Seed of the generator",
+            cxxopts::value<std::uint64_t>()->default_value(
+                std::to_string(defaults.seed_)))
+        ("functions", "Number of functions besides main",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.functions_)))
+        ("statements", "Statements in every function",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.statements_)))
+        ("depth", "Maximum nesting depth of ifs, loops and blocks",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.nesting_depth_)))
+        ("expression-length", "Average number of operands in an expression",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.expression_length_)))
+        ("identifiers", "Distinct names of variables",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.identifiers_)))
+        ("shadowing", "Probability that a nested declaration hides a variable",
+            cxxopts::value<double>()->default_value(
+                std::to_string(defaults.shadowing_density_)))
+        ("strings", "Probability that a statement prints a string literal",
+            cxxopts::value<double>()->default_value(
+                std::to_string(defaults.string_volume_)))
+        ("string-length", "Length of a string literal",
+            cxxopts::value<std::size_t>()->default_value(
+                std::to_string(defaults.string_length_)))
+        ("h,help", "")
+    ;
+    // clang-format on
+    const auto result = options.parse(argc, argv);
+
+    if (result.count("help") > 0) {
+        std::cout << options.help() << "\n";
+        return 0;
+    }
+
+    c::WorkloadOptions workload;
+    workload.seed_ = result["seed"].as<std::uint64_t>();
+    workload.functions_ = result["functions"].as<std::size_t>();
+    workload.statements_ = result["statements"].as<std::size_t>();
+    workload.nesting_depth_ = result["depth"].as<std::size_t>();
+    workload.expression_length_ =
+        result["expression-length"].as<std::size_t>();
+    workload.identifiers_ = result["identifiers"].as<std::size_t>();
+    workload.shadowing_density_ = result["shadowing"].as<double>();
+    workload.string_volume_ = result["strings"].as<double>();
+    workload.string_length_ = result["string-length"].as<std::size_t>();
+
+    try {
+        if (result.count("output") > 0) {
+            std::ofstream out(result["output"].as<std::string>());
+            if (!out.good()) {
+                std::cerr << "Unable to write stream - "
+                          << result["output"].as<std::string>() << "\n";
+                return 1;
+            }
+            c::generate_workload(out, workload);
+        } else {
+            c::generate_workload(std::cout, workload);
+        }
+    } catch (const std::invalid_argument &ex) {
+        std::cerr << ex.what() << '\n';
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
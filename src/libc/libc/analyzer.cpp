@@ -4,6 +4,14 @@ namespace c {
 
 void analyze(ast::Program &program, ast::symtab::Symtab &symtab) {
     ast::TypeAnalyzer::exec(program, symtab);
+    ast::EffectAnalyzer::exec(program, symtab);
+}
+
+std::size_t eliminate_dead_functions(
+    ast::Program &program, const std::vector<std::string> &exported) {
+    std::vector<std::string> roots{"main"};
+    roots.insert(roots.end(), exported.begin(), exported.end());
+    return ast::DeadFunctionEliminator::exec(program, roots);
 }
 
 } // namespace c
\ No newline at end of file
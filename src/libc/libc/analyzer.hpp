@@ -1,9 +1,19 @@
 #pragma once
 
+#include <libc/ast/dead_function_eliminator.hpp>
+#include <libc/ast/effect_analyzer.hpp>
 #include <libc/ast/type_analyzer.hpp>
 
+#include <string>
+#include <vector>
+
 namespace c {
 
 void analyze(ast::Program &program, ast::symtab::Symtab &symtab);
 
+// Removes the functions that neither main nor the exported ones call and
+// returns their number
+std::size_t eliminate_dead_functions(
+    ast::Program &program, const std::vector<std::string> &exported = {});
+
 } // namespace c
\ No newline at end of file
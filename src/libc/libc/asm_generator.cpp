@@ -0,0 +1,40 @@
+#include <libc/asm_generator.hpp>
+
+#include <libc/ast/detail/asm_printer.hpp>
+#include <libc/ast/detail/register_allocator.hpp>
+#include <libc/ast/instruction_selector.hpp>
+
+namespace c {
+
+void generate_asm(
+    std::ostream &out,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    TimeReport *report) {
+    ast::detail::MachineModule module;
+    {
+        TimeReport::Phase phase(report, "instruction selection");
+        module = ast::InstructionSelector::exec(program, symtab);
+    }
+    {
+        TimeReport::Phase phase(report, "register allocation");
+        for (auto &func : module.functions_) {
+            ast::detail::RegisterAllocator::exec(func);
+        }
+    }
+
+    if (report != nullptr) {
+        std::size_t instructions = 0;
+        for (const auto &func : module.functions_) {
+            for (const auto &block : func.blocks_) {
+                instructions += block.instructions_.size();
+            }
+        }
+        report->add_count("machine instructions", instructions);
+    }
+
+    TimeReport::Phase phase(report, "asm printing");
+    ast::detail::AsmPrinter::exec(out, module);
+}
+
+} // namespace c
\ No newline at end of file
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <libc/ast/ast.hpp>
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/time_report.hpp>
+
+#include <ostream>
+
+namespace c {
+
+// Compiles the analyzed program to x86-64 assembly for the System V ABI
+void generate_asm(
+    std::ostream &out,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    TimeReport *report = nullptr);
+
+} // namespace c
\ No newline at end of file
@@ -1,7 +1,10 @@
 #pragma once
 
+#include <libc/ast/expression_type.hpp>
+
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace c::ast {
@@ -30,10 +33,22 @@ class Program final {
     const Childs &get_childs() const {
         return childs_;
     }
+    std::size_t get_number_of_nodes() const {
+        return nodes_.size();
+    }
+
+    // Set by the type analysis for every expression node it checks
+    void set_expression_type(const Node *node, ExpressionType type) {
+        expression_types_[node] = std::move(type);
+    }
+    const ExpressionType &get_expression_type(const Node *node) const {
+        return expression_types_.at(node);
+    }
 
   private:
     std::vector<std::unique_ptr<Node>> nodes_;
     Childs childs_;
+    std::unordered_map<const Node *, ExpressionType> expression_types_;
 };
 
 class HeaderFile final : public Node {
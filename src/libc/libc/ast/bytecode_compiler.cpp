@@ -0,0 +1,1072 @@
+#include <libc/ast/bytecode_compiler.hpp>
+
+#include <libc/ast/detail/string_pool.hpp>
+#include <libc/trace.hpp>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace c::ast {
+
+using detail::Op;
+
+namespace {
+
+// In the order of the comparisons of a family of operations
+const std::unordered_map<std::string, int> c_compares = {
+    {"==", 0}, {"!=", 1}, {"<", 2}, {"<=", 3}, {">", 4}, {">=", 5}};
+
+// The same comparison with the operands swapped
+const std::array<int, 6> c_swapped = {0, 1, 4, 5, 2, 3};
+
+// The opposite comparison, of the integers only
+const std::array<int, 6> c_negated = {1, 0, 5, 4, 3, 2};
+
+const std::unordered_map<std::string, Op> c_arithmetic = {
+    {"+", Op::add_i8},
+    {"-", Op::sub_i8},
+    {"*", Op::mul_i8},
+    {"/", Op::div_i8},
+    {"%", Op::rem_i8}};
+
+constexpr std::size_t c_max_regs =
+    std::numeric_limits<detail::BytecodeReg>::max();
+
+Op get_op(Op first, int index) {
+    return static_cast<Op>(static_cast<int>(first) + index);
+}
+
+int get_index(Op op, Op first) {
+    return static_cast<int>(op) - static_cast<int>(first);
+}
+
+bool is_jump(Op op) {
+    return op >= Op::jmp && op <= Op::jge_f64;
+}
+
+// The instruction computes the register a_
+bool is_computing(Op op) {
+    return !is_jump(op) && op != Op::stack_restore && op != Op::ret &&
+        !(op >= Op::store_i8 && op <= Op::store_ptr);
+}
+
+bool is_terminator(Op op) {
+    return op == Op::jmp || op == Op::ret;
+}
+
+// False if the value only reads, assignments and calls are assumed to
+// write
+bool may_write_variables(const Node *node) {
+    if (dynamic_cast<const IntegerLiteral *>(node) != nullptr ||
+        dynamic_cast<const StringLiteral *>(node) != nullptr ||
+        dynamic_cast<const VariableAccess *>(node) != nullptr ||
+        dynamic_cast<const ArithmeticOperator *>(node) != nullptr ||
+        dynamic_cast<const RelationalOperator *>(node) != nullptr) {
+        return false;
+    }
+    if (const auto *access = dynamic_cast<const ArrayElementAccess *>(node)) {
+        return may_write_variables(access->idx());
+    }
+    if (const auto *operation = dynamic_cast<const RvalueOperation *>(node)) {
+        const auto &rpn = operation->rpn();
+        return std::any_of(rpn.begin(), rpn.end(), may_write_variables);
+    }
+    return true;
+}
+
+template <typename T>
+bool fits(std::int64_t value) {
+    return value >= std::numeric_limits<T>::min() &&
+        value <= std::numeric_limits<T>::max();
+}
+
+} // namespace
+
+detail::BytecodeModule BytecodeCompiler::exec(
+    Program &program, symtab::Symtab &symtab) {
+    BytecodeCompiler compiler(program, symtab);
+    // The calls take the numbers of the functions, also of the ones that
+    // are defined after them
+    for (auto *child : program.get_childs()) {
+        if (auto *func = dynamic_cast<FunctionDefinition *>(child)) {
+            compiler.function_ids_.emplace(
+                func->id(), compiler.function_ids_.size());
+        }
+    }
+    for (auto *child : program.get_childs()) {
+        child->accept(compiler);
+    }
+    return std::move(compiler.module_);
+}
+
+void BytecodeCompiler::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("bytecode compilation", node.id());
+    auto *func_sym = get_funcsym(node.id());
+    scopes_.push(func_sym);
+    current_func_ = func_sym;
+
+    func_ = detail::BytecodeFunction();
+    func_.name_ = node.id();
+    blocks_.clear();
+    layout_.clear();
+    variables_.clear();
+    next_reg_ = 0;
+    floor_ = 0;
+    saved_scopes_.assign(1, Scope{0, std::nullopt});
+    start_block(create_block());
+
+    // The arguments are the first registers
+    for (auto *param : func_sym->get_params()) {
+        auto *var = dynamic_cast<symtab::VariableSymbol *>(param);
+        Variable variable;
+        variable.type_ = get_type(var->get_type());
+        variable.element_ = get_element_type(var->get_type());
+        variable.reg_ = make_variable_reg();
+        variables_[var] = variable;
+        ++func_.num_params_;
+    }
+
+    compile_actions(node.actions());
+    // Falling off the end of main returns 0
+    free_temporaries();
+    auto zero = make_reg();
+    emit(Op::load_const, zero);
+    emit(Op::ret, zero);
+
+    finish_function();
+    module_.functions_.push_back(std::move(func_));
+    scopes_.pop();
+    scope_order_ = 0;
+}
+
+void BytecodeCompiler::visit(LocalScope &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    enter_scope();
+    compile_actions(node.actions());
+    leave_scope();
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+// Expressions
+
+void BytecodeCompiler::visit(Expression &node) {
+    discard(node.expression());
+}
+
+void BytecodeCompiler::visit(FunctionCall &node) {
+    std::vector<Value> args;
+    for (auto *arg : node.args()) {
+        args.push_back(evaluate(arg));
+    }
+
+    if (node.id() == "printf") {
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            auto type = get_promoted_type(
+                program_.get_expression_type(node.args()[i]).type_);
+            args[i] = convert(
+                node.args()[i], std::move(args[i]), get_type(type));
+        }
+        emit_call(Op::call_printf, 0, std::move(args), Type::i32);
+        return;
+    }
+
+    // The hint only matters to the LLVM backend
+    if (node.id() == "__builtin_expect") {
+        push(convert(node.args()[0], std::move(args[0]), Type::i64));
+        return;
+    }
+
+    auto id = function_ids_.find(node.id());
+    if (id == function_ids_.end()) {
+        throw std::runtime_error("Unresolved function - " + node.id());
+    }
+    auto *func = get_funcsym(node.id());
+    auto params = func->get_params();
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        auto *param = dynamic_cast<symtab::VariableSymbol *>(params[i]);
+        args[i] = convert(
+            node.args()[i], std::move(args[i]), get_type(param->get_type()));
+    }
+    emit_call(
+        Op::call, static_cast<std::int32_t>(id->second), std::move(args),
+        get_type(func->get_type()));
+}
+
+void BytecodeCompiler::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void BytecodeCompiler::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+// Statements
+
+void BytecodeCompiler::visit(ReturnStatement &node) {
+    auto type = get_type(current_func_->get_type());
+    auto value = convert(node.value(), evaluate(node.value()), type);
+    emit(Op::ret, to_reg(value));
+    start_block(create_block());
+}
+
+void BytecodeCompiler::visit(ForStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    enter_scope();
+    if (node.for_data_using() != nullptr) {
+        discard(node.for_data_using());
+    }
+    const auto body = create_block();
+    const auto latch = create_block();
+    const auto cond = create_block();
+    const auto exit = create_block();
+    jump(cond);
+
+    start_block(body);
+    loops_.push_back({latch, exit, saved_scopes_.size()});
+    enter_scope();
+    compile_actions(node.actions());
+    leave_scope();
+    loops_.pop_back();
+
+    start_block(latch);
+    if (node.value() != nullptr) {
+        free_temporaries();
+        discard(node.value());
+    }
+
+    start_block(cond);
+    if (node.truth_value() != nullptr) {
+        free_temporaries();
+        branch(emit_condition(node.truth_value()), body);
+    } else {
+        jump(body);
+    }
+
+    start_block(exit);
+    leave_scope();
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+void BytecodeCompiler::visit(IfStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    const auto skip = create_block();
+    branch(negate(emit_condition(node.truth_value())), skip);
+
+    start_block(create_block());
+    enter_scope();
+    compile_actions(node.actions());
+    leave_scope();
+
+    start_block(skip);
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+void BytecodeCompiler::visit(ContinueStatement & /*node*/) {
+    restore_stack(loops_.back().stack_depth_);
+    jump(loops_.back().latch_);
+    start_block(create_block());
+}
+
+void BytecodeCompiler::visit(BreakStatement & /*node*/) {
+    restore_stack(loops_.back().stack_depth_);
+    jump(loops_.back().exit_);
+    start_block(create_block());
+}
+
+// Array
+
+void BytecodeCompiler::visit(ArrayUninit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.is_array_ = true;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = variable.type_;
+    const auto element_size = get_size(variable.element_);
+
+    auto count = convert(node.size(), evaluate(node.size()), Type::i64);
+    if (count.constant_) {
+        auto size = static_cast<std::size_t>(
+                        std::max<std::int64_t>(*count.constant_, 1)) *
+            element_size;
+        variable.reg_ = make_variable_reg();
+        emit(
+            Op::frame_address, variable.reg_, 0, 0,
+            static_cast<std::int32_t>(func_.frame_size_));
+        // The objects stay aligned for any element
+        func_.frame_size_ += (size + 7) & ~std::size_t{7};
+        if (!fits<std::int32_t>(
+                static_cast<std::int64_t>(func_.frame_size_))) {
+            throw std::runtime_error(
+                "The arrays of the function are too large - " + func_.name_);
+        }
+        variables_[var] = variable;
+        return;
+    }
+
+    auto size = make_reg();
+    auto bytes = make_reg();
+    emit(
+        Op::load_const, size, 0, 0, static_cast<std::int32_t>(element_size));
+    emit(Op::mul_i64, bytes, to_reg(count), size);
+    auto &saved_stack = saved_scopes_.back().saved_stack_;
+    if (!saved_stack) {
+        saved_stack = make_variable_reg();
+        emit(Op::stack_save, *saved_stack);
+    }
+    variable.reg_ = make_variable_reg();
+    emit(Op::allocate, variable.reg_, bytes);
+    variables_[var] = variable;
+}
+
+void BytecodeCompiler::visit(ArrayElementAccess &node) {
+    auto index = convert(node.idx(), evaluate(node.idx()), Type::i64);
+    // The rest of the assignment may change the variable before the
+    // element is stored
+    auto it = lvalues_.find(&node);
+    if (it != lvalues_.end() && it->second.is_index_written_ &&
+        index.var_ != nullptr) {
+        index = copy(index);
+    }
+
+    const auto &variable = variables_.at(get_varsym(node.id()));
+    access(&node, {variable.reg_, to_reg(index)}, variable.element_);
+}
+
+// Variable
+
+void BytecodeCompiler::visit(VariableInit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = get_element_type(var->get_type());
+    variable.reg_ = make_variable_reg();
+
+    auto value =
+        convert(node.value(), evaluate(node.value()), variable.type_);
+    // The constants are used in place of their variables
+    if (var->get_type()->is_const() && value.constant_) {
+        variable.constant_ = value.constant_;
+    }
+    variables_[var] = variable;
+    move(variable.reg_, value);
+}
+
+void BytecodeCompiler::visit(VariableUninit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = get_element_type(var->get_type());
+    variable.reg_ = make_variable_reg();
+    variables_[var] = variable;
+}
+
+void BytecodeCompiler::visit(VariableAccess &node) {
+    auto *var = get_varsym(node.id());
+    const auto &variable = variables_.at(var);
+
+    if (variable.is_array_) {
+        auto zero = make_reg();
+        emit(Op::load_const, zero);
+        access(&node, {variable.reg_, zero}, variable.element_);
+        return;
+    }
+
+    Value value;
+    value.reg_ = variable.reg_;
+    value.constant_ = variable.constant_;
+    value.type_ = variable.type_;
+    value.var_ = var;
+    push(std::move(value));
+}
+
+// Operations
+
+void BytecodeCompiler::visit(Assignment &node) {
+    const auto &expression = node.expression();
+    const bool is_index_written =
+        expression.size() != 3 || may_write_variables(expression.back());
+    for (std::size_t i = 0; i + 1 < expression.size(); i += 2) {
+        auto *oper = dynamic_cast<AssignmentOperator *>(expression[i + 1]);
+        lvalues_[expression[i]] = {
+            oper->assign_operator() != "=", is_index_written};
+    }
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+    for (std::size_t i = 0; i + 1 < expression.size(); i += 2) {
+        lvalues_.erase(expression[i]);
+    }
+}
+
+void BytecodeCompiler::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void BytecodeCompiler::visit(AssignmentOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = lhs.type_;
+    if (expression_type.rhs_conversion_ != Conversion::none) {
+        rhs = emit_conversion(
+            expression_type.rhs_conversion_, std::move(rhs), type);
+    }
+    if (node.assign_operator()[0] != '=') {
+        Value value;
+        value.reg_ = lhs.reg_;
+        value.constant_ = lhs.constant_;
+        value.type_ = type;
+        rhs = emit_arithmetic(
+            node.assign_operator().substr(0, 1), std::move(value),
+            std::move(rhs), type);
+    }
+    store(lhs, rhs);
+    // The value may have been computed right into the variable
+    if (!lhs.element_) {
+        rhs.reg_ = variables_.at(lhs.var_).reg_;
+    }
+
+    rhs.var_ = nullptr;
+    rhs.element_.reset();
+    push(std::move(rhs));
+}
+
+void BytecodeCompiler::visit(ArithmeticOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = get_type(expression_type.operand_type_);
+    lhs = emit_conversion(
+        expression_type.lhs_conversion_, std::move(lhs), type);
+    rhs = emit_conversion(
+        expression_type.rhs_conversion_, std::move(rhs), type);
+    push(emit_arithmetic(
+        node.arithmetic_operator(), std::move(lhs), std::move(rhs), type));
+}
+
+void BytecodeCompiler::visit(RelationalOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = get_type(expression_type.operand_type_);
+    lhs = emit_conversion(
+        expression_type.lhs_conversion_, std::move(lhs), type);
+    rhs = emit_conversion(
+        expression_type.rhs_conversion_, std::move(rhs), type);
+    push(emit_relational(
+        node.relational_operator(), std::move(lhs), std::move(rhs), type));
+}
+
+// Literals
+
+void BytecodeCompiler::visit(StringLiteral &node) {
+    auto content = detail::StringPool::decode(node.string());
+    auto [it, is_inserted] =
+        string_ids_.emplace(std::move(content), module_.strings_.size());
+    if (is_inserted) {
+        module_.strings_.push_back(it->first);
+    }
+
+    Value value;
+    value.type_ = Type::ptr;
+    value.reg_ = make_reg();
+    emit(
+        Op::load_string, value.reg_, 0, 0,
+        static_cast<std::int32_t>(it->second));
+    push(std::move(value));
+}
+
+void BytecodeCompiler::visit(IntegerLiteral &node) {
+    Value value;
+    value.constant_ = std::stoll(node.integer());
+    value.type_ = Type::i32;
+    push(std::move(value));
+}
+
+// private methods
+
+symtab::VariableSymbol *BytecodeCompiler::get_varsym(const std::string &id) {
+    return dynamic_cast<symtab::VariableSymbol *>(scopes_.top()->resolve(id));
+}
+
+symtab::FunctionSymbol *BytecodeCompiler::get_funcsym(const std::string &id) {
+    for (auto *stack_node = symtab_.find_sym(id); stack_node != nullptr;
+         stack_node = stack_node->prev_) {
+        if (auto *func_sym =
+                dynamic_cast<symtab::FunctionSymbol *>(stack_node->sym_.get());
+            func_sym != nullptr) {
+            return func_sym;
+        }
+    }
+    return nullptr;
+}
+
+BytecodeCompiler::Type BytecodeCompiler::get_type(const ValueType &type) {
+    if (type.pointer_level_ > 0) {
+        return Type::ptr;
+    }
+    static const std::unordered_map<std::string, Type> c_types = {
+        {"bool", Type::i1},
+        {"char", Type::i8},
+        {"short", Type::i16},
+        {"int", Type::i32},
+        {"long", Type::i64},
+        {"float", Type::f32},
+        {"double", Type::f64},
+        {"void", Type::void_}};
+    return c_types.at(type.name_);
+}
+
+// An array is its element as a value
+BytecodeCompiler::Type BytecodeCompiler::get_type(symtab::Type *type) {
+    return get_type(ValueType{
+        type->get_name(),
+        type->get_type() == std::string("*") ? std::size_t{1} : 0});
+}
+
+BytecodeCompiler::Type BytecodeCompiler::get_element_type(
+    symtab::Type *type) {
+    auto *pointer_type = dynamic_cast<symtab::PointerType *>(type);
+    return get_type(ValueType{
+        type->get_name(),
+        pointer_type == nullptr ? 0 : pointer_type->get_level() - 1});
+}
+
+std::size_t BytecodeCompiler::get_size(Type type) {
+    switch (type) {
+    case Type::i8:
+        return 1;
+    case Type::i16:
+        return 2;
+    case Type::i1:
+    case Type::i32:
+    case Type::f32:
+        return 4;
+    default:
+        return 8;
+    }
+}
+
+// The value wraps around as in the integer of the type
+std::int64_t BytecodeCompiler::wrap(std::int64_t value, Type type) {
+    switch (type) {
+    case Type::i8:
+        return static_cast<std::int8_t>(value);
+    case Type::i16:
+        return static_cast<std::int16_t>(value);
+    case Type::i1:
+    case Type::i32:
+        return static_cast<std::int32_t>(value);
+    default:
+        return value;
+    }
+}
+
+// bool is operated on as int
+Op BytecodeCompiler::get_typed(Op first, Type type) {
+    switch (type) {
+    case Type::i8:
+        return get_op(first, 0);
+    case Type::i16:
+        return get_op(first, 1);
+    case Type::i64:
+        return get_op(first, 3);
+    case Type::f32:
+        return get_op(first, 4);
+    case Type::f64:
+        return get_op(first, 5);
+    case Type::ptr:
+        return get_op(first, 6);
+    default:
+        return get_op(first, 2);
+    }
+}
+
+Op BytecodeCompiler::get_compare(Op first, const std::string &oper) {
+    return get_op(first, c_compares.at(oper));
+}
+
+BytecodeCompiler::Reg BytecodeCompiler::make_reg() {
+    if (next_reg_ == c_max_regs) {
+        throw std::runtime_error(
+            "The function has too many values - " + func_.name_);
+    }
+    func_.num_regs_ = std::max(func_.num_regs_, next_reg_ + 1);
+    return static_cast<Reg>(next_reg_++);
+}
+
+// The temporaries below it live as long too
+BytecodeCompiler::Reg BytecodeCompiler::make_variable_reg() {
+    auto reg = make_reg();
+    floor_ = next_reg_;
+    return reg;
+}
+
+void BytecodeCompiler::emit(Op op, Reg a, Reg b, Reg c, std::int32_t imm) {
+    blocks_[current_block_].push_back({op, a, b, c, imm});
+}
+
+std::size_t BytecodeCompiler::create_block() {
+    blocks_.emplace_back();
+    return blocks_.size() - 1;
+}
+
+// The previous block falls through to the started one
+void BytecodeCompiler::start_block(std::size_t block) {
+    layout_.push_back(block);
+    current_block_ = block;
+}
+
+void BytecodeCompiler::jump(std::size_t block) {
+    emit(Op::jmp, 0, 0, 0, static_cast<std::int32_t>(block));
+}
+
+void BytecodeCompiler::branch(const Condition &condition, std::size_t block) {
+    emit(
+        condition.op_, 0, condition.b_, condition.c_,
+        static_cast<std::int32_t>(block));
+}
+
+// Lays the blocks out in the order they were started in without the code
+// after the jumps and the returns and the jumps to the next blocks, then
+// the jumps target the instructions
+void BytecodeCompiler::finish_function() {
+    for (std::size_t i = 0; i < layout_.size(); ++i) {
+        auto &code = blocks_[layout_[i]];
+        auto end = std::find_if(
+            code.begin(), code.end(), [](const auto &instruction) {
+                return is_terminator(instruction.op_);
+            });
+        if (end != code.end()) {
+            code.erase(end + 1, code.end());
+        }
+        if (!code.empty() && code.back().op_ == Op::jmp &&
+            i + 1 < layout_.size() &&
+            static_cast<std::size_t>(code.back().imm_) == layout_[i + 1]) {
+            code.pop_back();
+        }
+    }
+
+    std::vector<std::size_t> offsets(blocks_.size());
+    std::size_t size = 0;
+    for (auto block : layout_) {
+        offsets[block] = size;
+        size += blocks_[block].size();
+    }
+    func_.code_.reserve(size);
+    for (auto block : layout_) {
+        for (auto instruction : blocks_[block]) {
+            if (is_jump(instruction.op_)) {
+                instruction.imm_ = static_cast<std::int32_t>(
+                    static_cast<std::int64_t>(offsets[instruction.imm_]) -
+                    static_cast<std::int64_t>(func_.code_.size()));
+            }
+            func_.code_.push_back(instruction);
+        }
+    }
+}
+
+void BytecodeCompiler::push(Value value) {
+    values_.push_back(std::move(value));
+}
+
+BytecodeCompiler::Value BytecodeCompiler::pop() {
+    auto value = std::move(values_.back());
+    values_.pop_back();
+    return value;
+}
+
+BytecodeCompiler::Value BytecodeCompiler::evaluate(Node *node) {
+    node->accept(*this);
+    return pop();
+}
+
+// Declarations leave no value
+void BytecodeCompiler::discard(Node *node) {
+    const auto depth = values_.size();
+    node->accept(*this);
+    values_.resize(depth);
+}
+
+// The temporaries of a statement are dead after it
+void BytecodeCompiler::compile_actions(const Childs &actions) {
+    for (auto *action : actions) {
+        free_temporaries();
+        action->accept(*this);
+    }
+}
+
+// The temporary computed last is computed into the register instead
+void BytecodeCompiler::move(Reg reg, const Value &value) {
+    if (!value.constant_) {
+        auto &code = blocks_[current_block_];
+        if (value.reg_ >= floor_ && !code.empty() &&
+            code.back().a_ == value.reg_ && is_computing(code.back().op_)) {
+            code.back().a_ = reg;
+        } else if (value.reg_ != reg) {
+            emit(Op::mov, reg, value.reg_);
+        }
+        return;
+    }
+    if (fits<std::int32_t>(*value.constant_)) {
+        emit(
+            Op::load_const, reg, 0, 0,
+            static_cast<std::int32_t>(*value.constant_));
+        return;
+    }
+    emit(
+        Op::load_wide, reg, 0, 0,
+        static_cast<std::int32_t>(module_.constants_.size()));
+    module_.constants_.push_back(
+        static_cast<std::uint64_t>(*value.constant_));
+}
+
+BytecodeCompiler::Reg BytecodeCompiler::to_reg(const Value &value) {
+    // A constant variable holds its value already
+    if (!value.constant_ || value.var_ != nullptr) {
+        return value.reg_;
+    }
+    return copy(value).reg_;
+}
+
+BytecodeCompiler::Value BytecodeCompiler::copy(const Value &value) {
+    Value result;
+    result.type_ = value.type_;
+    result.reg_ = make_reg();
+    move(result.reg_, value);
+    return result;
+}
+
+// The narrower integers are sign extended
+BytecodeCompiler::Value BytecodeCompiler::load(
+    const Element &element, Type type) {
+    Value value;
+    value.type_ = type;
+    value.reg_ = make_reg();
+    emit(get_typed(Op::load_i8, type), value.reg_, element.base_,
+         element.index_);
+    return value;
+}
+
+void BytecodeCompiler::access(
+    const Node *node, const Element &element, Type type) {
+    auto it = lvalues_.find(node);
+    if (it == lvalues_.end()) {
+        push(load(element, type));
+        return;
+    }
+    Value value;
+    if (it->second.is_read_) {
+        value = load(element, type);
+    }
+    value.type_ = type;
+    value.element_ = element;
+    push(std::move(value));
+}
+
+void BytecodeCompiler::store(const Value &lvalue, const Value &value) {
+    if (!lvalue.element_) {
+        move(variables_.at(lvalue.var_).reg_, value);
+        return;
+    }
+    emit(get_typed(Op::store_i8, lvalue.type_), to_reg(value),
+         lvalue.element_->base_, lvalue.element_->index_);
+}
+
+// Applies the conversion the type analysis found for the value of the node
+BytecodeCompiler::Value BytecodeCompiler::convert(
+    const Node *node, Value value, Type type) {
+    return emit_conversion(
+        program_.get_expression_type(node).conversion_, std::move(value),
+        type);
+}
+
+BytecodeCompiler::Value BytecodeCompiler::emit_conversion(
+    Conversion conversion, Value value, Type type) {
+    if (conversion == Conversion::none) {
+        return value;
+    }
+    const auto from = value.type_;
+    Value result;
+    result.type_ = type;
+
+    switch (conversion) {
+    // The integers are kept sign extended already and bool is 0 or 1. The
+    // value is still the variable's, an index of it is copied.
+    case Conversion::sign_extend:
+    case Conversion::zero_extend:
+        value.type_ = type;
+        return value;
+    case Conversion::truncate:
+        if (value.constant_) {
+            result.constant_ = wrap(*value.constant_, type);
+            return result;
+        }
+        result.reg_ = make_reg();
+        emit(
+            type == Type::i8        ? Op::trunc_i8
+                : type == Type::i16 ? Op::trunc_i16
+                                    : Op::trunc_i32,
+            result.reg_, value.reg_);
+        return result;
+    case Conversion::float_extend:
+        result.reg_ = make_reg();
+        emit(Op::f32_to_f64, result.reg_, value.reg_);
+        return result;
+    case Conversion::float_truncate:
+        result.reg_ = make_reg();
+        emit(Op::f64_to_f32, result.reg_, value.reg_);
+        return result;
+    case Conversion::int_to_float: {
+        auto src = to_reg(value);
+        result.reg_ = make_reg();
+        emit(
+            type == Type::f32 ? Op::int_to_f32 : Op::int_to_f64, result.reg_,
+            src);
+        return result;
+    }
+    default:
+        result.reg_ = make_reg();
+        emit(
+            from == Type::f32 ? Op::f32_to_int : Op::f64_to_int, result.reg_,
+            value.reg_);
+        if (type == Type::i8 || type == Type::i16) {
+            emit(
+                type == Type::i8 ? Op::trunc_i8 : Op::trunc_i16, result.reg_,
+                result.reg_);
+        }
+        return result;
+    }
+}
+
+BytecodeCompiler::Value BytecodeCompiler::emit_arithmetic(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    Value result;
+    result.type_ = type;
+    const auto first = c_arithmetic.at(oper);
+    if (is_floating(type)) {
+        result.reg_ = make_reg();
+        emit(get_typed(first, type), result.reg_, to_reg(lhs), to_reg(rhs));
+        return result;
+    }
+
+    if (lhs.constant_ && rhs.constant_ &&
+        !((oper == "/" || oper == "%") && *rhs.constant_ == 0)) {
+        auto lhs_value = static_cast<std::uint64_t>(*lhs.constant_);
+        auto rhs_value = static_cast<std::uint64_t>(*rhs.constant_);
+        std::int64_t value = 0;
+        if (oper == "+") {
+            value = static_cast<std::int64_t>(lhs_value + rhs_value);
+        } else if (oper == "-") {
+            value = static_cast<std::int64_t>(lhs_value - rhs_value);
+        } else if (oper == "*") {
+            value = static_cast<std::int64_t>(lhs_value * rhs_value);
+        } else if (oper == "/") {
+            value = *lhs.constant_ / *rhs.constant_;
+        } else {
+            value = *lhs.constant_ % *rhs.constant_;
+        }
+        result.constant_ = wrap(value, type);
+        return result;
+    }
+
+    // Adding or subtracting a constant is one instruction
+    if (oper == "+" && lhs.constant_) {
+        std::swap(lhs, rhs);
+    }
+    if ((oper == "+" || oper == "-") && rhs.constant_ && !lhs.constant_) {
+        auto addend = static_cast<std::uint64_t>(*rhs.constant_);
+        auto imm = static_cast<std::int64_t>(oper == "+" ? addend : -addend);
+        if (fits<std::int32_t>(imm)) {
+            result.reg_ = make_reg();
+            emit(
+                get_typed(Op::addi_i8, type), result.reg_, lhs.reg_, 0,
+                static_cast<std::int32_t>(imm));
+            return result;
+        }
+    }
+
+    result.reg_ = make_reg();
+    emit(get_typed(first, type), result.reg_, to_reg(lhs), to_reg(rhs));
+    return result;
+}
+
+BytecodeCompiler::Value BytecodeCompiler::emit_relational(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    Value result;
+    result.type_ = Type::i1;
+    if (!is_floating(type) && lhs.constant_ && rhs.constant_) {
+        auto lhs_value = *lhs.constant_;
+        auto rhs_value = *rhs.constant_;
+        const bool value = oper == "==" ? lhs_value == rhs_value
+            : oper == "!="             ? lhs_value != rhs_value
+            : oper == "<"              ? lhs_value < rhs_value
+            : oper == "<="             ? lhs_value <= rhs_value
+            : oper == ">"              ? lhs_value > rhs_value
+                                       : lhs_value >= rhs_value;
+        result.constant_ = static_cast<std::int64_t>(value);
+        return result;
+    }
+
+    const auto first = type == Type::f32 ? Op::eq_f32
+        : type == Type::f64             ? Op::eq_f64
+                                        : Op::eq_i64;
+    result.reg_ = make_reg();
+    emit(get_compare(first, oper), result.reg_, to_reg(lhs), to_reg(rhs));
+    return result;
+}
+
+// The constants that fit into 16 bits are compared with in place
+BytecodeCompiler::Condition BytecodeCompiler::emit_compare(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    if (is_floating(type)) {
+        return {
+            get_compare(type == Type::f32 ? Op::jeq_f32 : Op::jeq_f64, oper),
+            to_reg(lhs), to_reg(rhs)};
+    }
+
+    auto index = c_compares.at(oper);
+    if (lhs.constant_ && !rhs.constant_) {
+        std::swap(lhs, rhs);
+        index = c_swapped[static_cast<std::size_t>(index)];
+    }
+    if (rhs.constant_ && fits<std::int16_t>(*rhs.constant_)) {
+        return {
+            get_op(Op::jeqi_i64, index), to_reg(lhs),
+            static_cast<Reg>(static_cast<std::int16_t>(*rhs.constant_))};
+    }
+    return {get_op(Op::jeq_i64, index), to_reg(lhs), to_reg(rhs)};
+}
+
+// A comparison that ends the condition branches by itself, other values
+// are compared with zero
+BytecodeCompiler::Condition BytecodeCompiler::emit_condition(
+    Node *truth_value) {
+    if (auto *operation = dynamic_cast<RvalueOperation *>(truth_value)) {
+        const auto &rpn = operation->rpn();
+        if (auto *relational = dynamic_cast<RelationalOperator *>(rpn.back())) {
+            for (std::size_t i = 0; i + 1 < rpn.size(); ++i) {
+                rpn[i]->accept(*this);
+            }
+            auto rhs = pop();
+            auto lhs = pop();
+            const auto &expression_type =
+                program_.get_expression_type(relational);
+            auto type = get_type(expression_type.operand_type_);
+            lhs = emit_conversion(
+                expression_type.lhs_conversion_, std::move(lhs), type);
+            rhs = emit_conversion(
+                expression_type.rhs_conversion_, std::move(rhs), type);
+            return emit_compare(
+                relational->relational_operator(), std::move(lhs),
+                std::move(rhs), type);
+        }
+    }
+
+    auto value = evaluate(truth_value);
+    if (is_floating(value.type_)) {
+        const auto type = value.type_;
+        Value zero;
+        zero.constant_ = 0;
+        zero = emit_conversion(Conversion::int_to_float, zero, type);
+        return emit_compare("!=", std::move(value), std::move(zero), type);
+    }
+    return {Op::jnz, to_reg(value)};
+}
+
+// The integers compare the opposite way. The unordered floats compare
+// false both ways, so the comparison of the floats is tested for zero.
+BytecodeCompiler::Condition BytecodeCompiler::negate(
+    const Condition &condition) {
+    const auto op = condition.op_;
+    if (op == Op::jz || op == Op::jnz) {
+        return {op == Op::jz ? Op::jnz : Op::jz, condition.b_};
+    }
+    for (auto first : {Op::jeq_i64, Op::jeqi_i64}) {
+        auto index = get_index(op, first);
+        if (index >= 0 && index < 6) {
+            return {
+                get_op(first, c_negated[static_cast<std::size_t>(index)]),
+                condition.b_, condition.c_};
+        }
+    }
+
+    const bool is_double = op >= Op::jeq_f64;
+    auto reg = make_reg();
+    emit(
+        get_op(
+            is_double ? Op::eq_f64 : Op::eq_f32,
+            get_index(op, is_double ? Op::jeq_f64 : Op::jeq_f32)),
+        reg, condition.b_, condition.c_);
+    return {Op::jz, reg};
+}
+
+// The arguments are copied to the registers above all the others, the
+// frame of the callee starts at them
+void BytecodeCompiler::emit_call(
+    Op op, std::int32_t imm, std::vector<Value> args, Type result) {
+    const auto reg = make_reg();
+    const auto first = static_cast<Reg>(next_reg_);
+    for (const auto &arg : args) {
+        move(make_reg(), arg);
+    }
+    emit(op, reg, first, static_cast<Reg>(args.size()), imm);
+
+    Value value;
+    value.type_ = result;
+    if (result == Type::void_) {
+        value.type_ = Type::i32;
+        value.constant_ = 0;
+    } else {
+        value.reg_ = reg;
+    }
+    push(std::move(value));
+}
+
+void BytecodeCompiler::enter_scope() {
+    saved_scopes_.push_back({floor_, std::nullopt});
+}
+
+// Frees the variable length arrays and the registers of the scope
+void BytecodeCompiler::leave_scope() {
+    const auto &scope = saved_scopes_.back();
+    if (scope.saved_stack_) {
+        emit(Op::stack_restore, 0, *scope.saved_stack_);
+    }
+    floor_ = scope.floor_;
+    saved_scopes_.pop_back();
+}
+
+// Frees the variable length arrays of the scopes from the depth on
+void BytecodeCompiler::restore_stack(std::size_t depth) {
+    for (auto i = depth; i < saved_scopes_.size(); ++i) {
+        if (saved_scopes_[i].saved_stack_) {
+            emit(Op::stack_restore, 0, *saved_scopes_[i].saved_stack_);
+            return;
+        }
+    }
+}
+
+} // namespace c::ast
\ No newline at end of file
@@ -0,0 +1,234 @@
+#pragma once
+
+#include <libc/ast/detail/bytecode.hpp>
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/ast/visitor.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast {
+
+// Compiles the analyzed program to the register bytecode of the
+// interpreter. Every scalar variable is one register, the temporaries of a
+// statement are the registers above the variables and are reused by the
+// next one. Arrays of a literal size are objects of the frame, the others
+// are allocated on the stack of the interpreter at their declarations and
+// freed at the ends of their scopes.
+//
+// Loops are emitted rotated, the comparisons that end the conditions
+// branch by themselves.
+class BytecodeCompiler final : public Visitor {
+  public:
+    BytecodeCompiler(const Program &program, symtab::Symtab &symtab)
+        : program_(program), symtab_(symtab) {}
+
+    static detail::BytecodeModule exec(
+        Program &program, symtab::Symtab &symtab);
+
+    void visit(FunctionDefinition &node) override;
+    void visit(LocalScope &node) override;
+
+    // Expressions
+
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+
+    // Statements
+
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+    void visit(ContinueStatement & /*node*/) override;
+    void visit(BreakStatement & /*node*/) override;
+
+    // Array
+
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+
+    // Variable
+
+    void visit(VariableInit &node) override;
+    void visit(VariableUninit &node) override;
+    void visit(VariableAccess &node) override;
+
+    // Operations
+
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+    void visit(AssignmentOperator &node) override;
+    void visit(ArithmeticOperator &node) override;
+    void visit(RelationalOperator &node) override;
+
+    // Literals
+
+    void visit(StringLiteral &node) override;
+    void visit(IntegerLiteral &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+
+    using Reg = detail::BytecodeReg;
+    using Op = detail::Op;
+
+    enum class Type { i1, i8, i16, i32, i64, ptr, f32, f64, void_ };
+
+    // The element of an array or a pointer
+    struct Element {
+        Reg base_;
+        Reg index_;
+    };
+
+    struct Value {
+        // A register or an integer constant
+        Reg reg_{0};
+        std::optional<std::int64_t> constant_;
+        Type type_{Type::i32};
+        // The variable read, or the element read
+        symtab::VariableSymbol *var_{nullptr};
+        std::optional<Element> element_;
+    };
+
+    struct Variable {
+        // The value of a scalar, the address of an array or a pointer
+        Reg reg_{0};
+        Type type_{Type::i32};
+        // Arrays are their first elements as values
+        bool is_array_{false};
+        // Of the elements an array or a pointer indexes
+        Type element_{Type::i32};
+        // Value of a constant initialized with an integer constant
+        std::optional<std::int64_t> constant_;
+    };
+
+    // A jump taken iff the condition holds: j<cond> on b_ and c_, or jz
+    // and jnz on b_
+    struct Condition {
+        Op op_{Op::jnz};
+        Reg b_{0};
+        Reg c_{0};
+    };
+
+    symtab::FunctionSymbol *get_funcsym(const std::string &id);
+    symtab::VariableSymbol *get_varsym(const std::string &id);
+    static Type get_type(const ValueType &type);
+    static Type get_type(symtab::Type *type);
+    static Type get_element_type(symtab::Type *type);
+    static std::size_t get_size(Type type);
+    static std::int64_t wrap(std::int64_t value, Type type);
+    static bool is_floating(Type type) {
+        return type == Type::f32 || type == Type::f64;
+    }
+    // The operation of the type among the ones of i8, i16, i32, i64, f32,
+    // f64 and ptr that follow first
+    static Op get_typed(Op first, Type type);
+    // The comparison among the ones of ==, !=, <, <=, > and >= that follow
+    // first
+    static Op get_compare(Op first, const std::string &oper);
+
+    Reg make_reg();
+    // A register that lives until the end of the scope
+    Reg make_variable_reg();
+    void free_temporaries() {
+        next_reg_ = floor_;
+    }
+    void emit(Op op, Reg a = 0, Reg b = 0, Reg c = 0, std::int32_t imm = 0);
+    std::size_t create_block();
+    void start_block(std::size_t block);
+    void jump(std::size_t block);
+    void branch(const Condition &condition, std::size_t block);
+    void finish_function();
+
+    void push(Value value);
+    Value pop();
+    Value evaluate(Node *node);
+    void discard(Node *node);
+    void compile_actions(const Childs &actions);
+    void move(Reg reg, const Value &value);
+    Reg to_reg(const Value &value);
+    Value copy(const Value &value);
+    Value load(const Element &element, Type type);
+    // Pushes the element read or written by the node
+    void access(const Node *node, const Element &element, Type type);
+    void store(const Value &lvalue, const Value &value);
+    Value convert(const Node *node, Value value, Type type);
+    Value emit_conversion(Conversion conversion, Value value, Type type);
+    Value emit_arithmetic(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    Value emit_relational(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    Condition emit_compare(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    Condition emit_condition(Node *truth_value);
+    Condition negate(const Condition &condition);
+    void emit_call(
+        Op op, std::int32_t imm, std::vector<Value> args, Type result);
+
+    void enter_scope();
+    void leave_scope();
+    void restore_stack(std::size_t depth);
+
+    const Program &program_;
+    symtab::Symtab &symtab_;
+
+    std::stack<symtab::Scope *> scopes_;
+    std::size_t scope_order_{0};
+
+    detail::BytecodeModule module_;
+    std::unordered_map<std::string, std::size_t> function_ids_;
+    std::unordered_map<std::string, std::size_t> string_ids_;
+
+    detail::BytecodeFunction func_;
+    symtab::FunctionSymbol *current_func_{nullptr};
+    // The code of the blocks, the jumps target the blocks until the
+    // function is finished
+    std::vector<std::vector<detail::BytecodeInstruction>> blocks_;
+    // Blocks in the order they were started in
+    std::vector<std::size_t> layout_;
+    std::size_t current_block_{0};
+
+    // The registers below the floor are the ones of the variables
+    std::size_t next_reg_{0};
+    std::size_t floor_{0};
+
+    std::unordered_map<const symtab::VariableSymbol *, Variable> variables_;
+    struct Lvalue {
+        // The compound operators read it
+        bool is_read_{false};
+        // The rest of the assignment may write the variable of its index
+        bool is_index_written_{true};
+    };
+    // Lvalues of the assignments being evaluated
+    std::unordered_map<const Node *, Lvalue> lvalues_;
+    std::vector<Value> values_;
+
+    struct Loop {
+        std::size_t latch_;
+        std::size_t exit_;
+        std::size_t stack_depth_;
+    };
+    // Loops around the current block, innermost last
+    std::vector<Loop> loops_;
+
+    struct Scope {
+        std::size_t floor_;
+        // The stack saved before the first variable length array
+        std::optional<Reg> saved_stack_;
+    };
+    // The scopes around the current point
+    std::vector<Scope> saved_scopes_;
+};
+
+} // namespace c::ast
\ No newline at end of file
@@ -1,7 +1,11 @@
 #include <libc/ast/code_generator.hpp>
+#include <libc/trace.hpp>
 
+#include <algorithm>
 #include <cctype>
+#include <charconv>
 #include <iomanip>
+#include <limits>
 
 namespace c::ast {
 
@@ -36,62 +40,84 @@ const std::unordered_map<std::string, std::string> c_ir_rel_f = {
     {">", "fcmp ogt"},
     {">=", "fcmp oge"}};
 
-const std::unordered_map<std::string, std::size_t> c_ir_type_order = {
-    {"i1", 0},
-    {"i8", 1},
-    {"i16", 2},
-    {"i32", 3},
-    {"i64", 4},
-    {"float", 5},
-    {"double", 6}};
+const std::unordered_map<Conversion, std::string> c_ir_conversions = {
+    {Conversion::sign_extend, "sext"},
+    {Conversion::zero_extend, "zext"},
+    {Conversion::truncate, "trunc"},
+    {Conversion::float_extend, "fpext"},
+    {Conversion::float_truncate, "fptrunc"},
+    {Conversion::int_to_float, "sitofp"},
+    {Conversion::float_to_int, "fptosi"}};
 
 void CodeGenerator::exec(
-    std::ostream &os, Program &program, symtab::Symtab &symtab) {
-    DeclareStr::exec(os, program);
-    CodeGenerator code_generator(os, symtab);
+    std::ostream &os,
+    Program &program,
+    symtab::Symtab &symtab,
+    const CodeGenOptions &options,
+    TimeReport *report) {
+    std::unordered_map<const StringLiteral *, std::string> str_pointers;
+    {
+        TimeReport::Phase phase(report, "string declaration");
+        C_TRACE_SCOPE("pipeline", "string declaration");
+        str_pointers = DeclareStr::exec(os, program);
+    }
+    TimeReport::Phase phase(report, "ir generation");
+    C_TRACE_SCOPE("pipeline", "ir generation");
+    CodeGenerator code_generator(os, program, symtab, options);
+    code_generator.str_pointers_ = std::move(str_pointers);
     for (auto *child : program.get_childs()) {
         child->accept(code_generator);
     }
+    code_generator.print_intrinsics();
+    code_generator.print_profile_writer();
+    code_generator.print_instrumentation();
+    code_generator.print_destructors();
+    os << code_generator.metadata_.str();
+    if (report != nullptr) {
+        report->add_count("ir instructions", code_generator.instructions_);
+    }
 }
 
 void CodeGenerator::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("codegen", node.id());
     auto *func_sym = get_funcsym(node.id());
     scopes_.push(func_sym);
+    current_func_ = func_sym;
+    definitions_[func_sym] = &node;
+
+    ir_.str("");
+    ssa_.reset();
+    hoisted_calls_.clear();
+    allocas_.str("");
+    slots_.clear();
+    wide_vars_.clear();
+    slots_.emplace_back();
+    store_generations_.clear();
 
     cgs_alc_[func_sym].name_ = "@" + func_sym->get_name();
     cgs_alc_[func_sym].type_ = get_ir_type(func_sym->get_type());
-    ir_ << "define " << cgs_alc_[func_sym].type_ << " "
-        << cgs_alc_[func_sym].name_ << "(";
+    ir_ << "define " << get_linkage(*func_sym) << cgs_alc_[func_sym].type_
+        << " " << cgs_alc_[func_sym].name_ << "(";
 
     auto params = func_sym->get_params();
-    {
-        symtab::VariableSymbol *param = nullptr;
-        switch (params.size()) {
-        case 0:
-            break;
-        case 1:
-            param = get_varsym(params[0]->get_name());
-            cgs_alc_[param].name_ = "%" + param->get_name();
-            cgs_alc_[param].type_ = get_ir_type(param->get_type());
-            ir_ << cgs_alc_[param].type_ << " " << cgs_alc_[param].name_;
-            break;
-        default:
-            param = get_varsym(params[0]->get_name());
-            cgs_alc_[param].name_ = "%" + param->get_name();
-            cgs_alc_[param].type_ = get_ir_type(param->get_type());
-            ir_ << cgs_alc_[param].type_ << " " << cgs_alc_[param].name_;
-            for (std::size_t i = 1; i < params.size(); ++i) {
-                param = get_varsym(params[i]->get_name());
-                cgs_alc_[param].name_ = "%" + param->get_name();
-                cgs_alc_[param].type_ = get_ir_type(param->get_type());
-                ir_ << ", " << cgs_alc_[param].type_ << " "
-                    << cgs_alc_[param].name_;
-            }
-        }
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        auto *param = get_varsym(params[i]->get_name());
+        cgs_alc_[param].name_ = "%" + param->get_name();
+        cgs_alc_[param].type_ = get_ir_type(param->get_type());
+        ir_ << (i == 0 ? "" : ", ") << cgs_alc_[param].type_ << " "
+            << get_param_attributes(*func_sym, i) << cgs_alc_[param].name_;
     }
-    ir_ << ") {\nentry:\n";
+    ir_ << ")" << get_function_attributes(*func_sym)
+        << get_profile_attributes(*func_sym) << " {\n";
+    start_block("entry");
+    seal_block("entry");
 
     for (auto *param : params) {
+        if (is_promoted(dynamic_cast<symtab::VariableSymbol *>(param))) {
+            ssa_.write_variable(
+                param, ssa_.get_current_block(), cgs_alc_[param].name_);
+            continue;
+        }
         std::string alloca_name =
             cgs_alc_[param].name_ + ".addr" + std::to_string(addr_num_++);
         ir_ << "\t" << alloca_name << " = alloca " << cgs_alc_[param].type_
@@ -99,16 +125,26 @@ void CodeGenerator::visit(FunctionDefinition &node) {
         ir_ << "\t"
             << "store " << cgs_alc_[param].type_ << " " << cgs_alc_[param].name_
             << ", ";
+        number_store(
+            dynamic_cast<symtab::VariableSymbol *>(param),
+            cgs_alc_[param].type_, alloca_name, cgs_alc_[param].name_);
         cgs_alc_[param].name_ = std::move(alloca_name);
         ir_ << cgs_alc_[param].type_ + "* " << cgs_alc_[param].name_ << "\n";
     }
+    count_profile(0);
+    instrument_entry();
     ir_ << "\n";
 
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
 
-    ir_ << "}\n\n";
+    auto text = ir_.str();
+    if (options_.simplify_cfg_) {
+        ssa_.simplify(text);
+    }
+    instructions_ += ssa_.print(out_, text, allocas_.str());
+    out_ << "}\n\n";
     scopes_.pop();
     scope_order_ = 0;
 }
@@ -118,9 +154,11 @@ void CodeGenerator::visit(LocalScope &node) {
     std::size_t prev_scope_order = scope_order_;
     scope_order_ = 0;
 
+    enter_scope();
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
+    leave_scope();
 
     scope_order_ = prev_scope_order;
     scopes_.pop();
@@ -134,6 +172,15 @@ void CodeGenerator::visit(Expression &node) {
 }
 
 void CodeGenerator::visit(FunctionCall &node) {
+    if (auto it = hoisted_calls_.find(&node); it != hoisted_calls_.end()) {
+        if (is_rvalue_oper_) {
+            calc_expr_.push(it->second);
+            return;
+        }
+        ir_buf_ = it->second;
+        return;
+    }
+
     bool prev_rvalue_oper = is_rvalue_oper_;
     std::vector<IrNode> ir_args;
     for (auto *arg : node.args()) {
@@ -142,17 +189,43 @@ void CodeGenerator::visit(FunctionCall &node) {
         ir_args.push_back(std::move(ir_buf_));
     }
     is_rvalue_oper_ = prev_rvalue_oper;
+    // A comparison in the arguments doesn't make the value of the call i1
+    is_rel_op_last_ = false;
 
     if (node.id() == "printf") {
+        for (std::size_t i = 0; i < ir_args.size(); ++i) {
+            auto type = get_promoted_type(
+                program_.get_expression_type(node.args()[i]).type_);
+            if (type.pointer_level_ == 0) {
+                convert(node.args()[i], ir_args[i], c_ir_types.at(type.name_));
+            }
+        }
         IrNode ir_var("%tmp" + std::to_string(tmp_num_++), "i32");
-        ir_ << "\t" << ir_var.name_
-            << " = call i32 (i8*, ...) @printf(i8* getelementptr ("
-            << ir_args[0].type_ << ", " << ir_args[0].type_ + "* "
-            << ir_args[0].name_ << ", i64 0, i64 0)";
-        for (std::size_t i = 1; i < ir_args.size(); ++i) {
-            ir_ << ", " << ir_args[i].type_ << " " << ir_args[i].name_;
+        ir_ << "\t" << ir_var.name_ << " = call i32 (i8*, ...) @printf(";
+        for (std::size_t i = 0; i < ir_args.size(); ++i) {
+            ir_ << (i == 0 ? "" : ", ") << ir_args[i].type_ << " "
+                << ir_args[i].name_;
         }
         ir_ << ")\n";
+        // %n stores through its argument
+        ++memory_generation_;
+        if (is_rvalue_oper_) {
+            calc_expr_.push(std::move(ir_var));
+            return;
+        }
+        ir_buf_ = std::move(ir_var);
+        return;
+    }
+
+    if (node.id() == "__builtin_expect") {
+        convert(node.args()[0], ir_args[0], "i64");
+        convert(node.args()[1], ir_args[1], "i64");
+        uses_expect_ = true;
+        IrNode ir_var(
+            emit_value(
+                "call i64 @llvm.expect.i64(i64 " + ir_args[0].name_ +
+                ", i64 " + ir_args[1].name_ + ")"),
+            "i64");
         if (is_rvalue_oper_) {
             calc_expr_.push(std::move(ir_var));
             return;
@@ -166,37 +239,51 @@ void CodeGenerator::visit(FunctionCall &node) {
     auto params = func->get_params();
     for (std::size_t i = 0; i < params.size(); ++i) {
         auto *param = dynamic_cast<symtab::VariableSymbol *>(params[i]);
-        auto param_type = get_ir_type(param->get_type());
-        if (param_type != ir_args[i].type_) {
-            cast_to(IrNode("", param_type), ir_args[i]);
+        convert(node.args()[i], ir_args[i], get_ir_type(param->get_type()));
+    }
+
+    if (is_inlinable(*func)) {
+        auto ir_var = inline_call(*func, ir_args);
+        if (is_rvalue_oper_) {
+            calc_expr_.push(std::move(ir_var));
+            return;
         }
+        ir_buf_ = std::move(ir_var);
+        return;
     }
 
+    auto instruction =
+        "call " + cgs_alc_[func].type_ + " " + cgs_alc_[func].name_ + "(";
+    for (std::size_t i = 0; i < ir_args.size(); ++i) {
+        instruction += (i == 0 ? "" : ", ") + ir_args[i].type_ + " " +
+            ir_args[i].name_;
+    }
+    instruction += ")";
+
+    const auto &effects = func->get_effects();
+    // A read-only call gives the same value until the memory it reads
+    // changes
+    auto key = instruction +
+        (effects.reads_memory_ ? " #" + std::to_string(memory_generation_)
+                               : "");
     IrNode ir_var;
     if (cgs_alc_[func].type_ != "void") {
-        ir_var.name_ = "%tmp" + std::to_string(tmp_num_++);
         ir_var.type_ = cgs_alc_[func].type_;
-
-        ir_ << "\t" << ir_var.name_ << " = call " << ir_var.type_ << " "
-            << cgs_alc_[func].name_ << "(";
+        if (auto value = effects.is_readonly() ? find_value(key)
+                                               : std::nullopt) {
+            ir_var.name_ = *value;
+        } else {
+            ir_var.name_ = "%tmp" + std::to_string(tmp_num_++);
+            ir_ << "\t" << ir_var.name_ << " = " << instruction << "\n";
+            if (effects.is_readonly()) {
+                number_value(key, ir_var.name_);
+            }
+        }
     } else {
-        ir_ << "\t"
-            << "call " << cgs_alc_[func].type_ << " " << cgs_alc_[func].name_
-            << "(";
+        ir_ << "\t" << instruction << "\n";
     }
-    switch (ir_args.size()) {
-    case 0:
-        ir_ << ")\n";
-        break;
-    case 1:
-        ir_ << ir_args[0].type_ << " " << ir_args[0].name_ << ")\n";
-        break;
-    default:
-        ir_ << ir_args[0].type_ << " " << ir_args[0].name_;
-        for (std::size_t i = 1; i < ir_args.size(); ++i) {
-            ir_ << ", " << ir_args[i].type_ << " " << ir_args[i].name_;
-        }
-        ir_ << ")\n";
+    if (effects.writes_memory_) {
+        ++memory_generation_;
     }
 
     if (is_rvalue_oper_) {
@@ -218,8 +305,15 @@ void CodeGenerator::visit(DataCreate &node) {
 
 void CodeGenerator::visit(ReturnStatement &node) {
     node.value()->accept(*this);
+    if (!inlines_.empty()) {
+        return_inlined(node);
+        return;
+    }
+    convert(node.value(), ir_buf_, cgs_alc_[current_func_].type_);
+    instrument_exit();
     ir_ << "\t"
         << "ret " << ir_buf_.type_ << " " << ir_buf_.name_ << "\n";
+    start_unreachable_block();
 }
 
 void CodeGenerator::visit(ForStatement &node) {
@@ -227,66 +321,105 @@ void CodeGenerator::visit(ForStatement &node) {
     std::size_t prev_scope_order = scope_order_;
     scope_order_ = 0;
 
-    std::string cmp = "block" + std::to_string(block_num_++);
+    // A rotated loop has no block of the condition, the body is its header
+    const bool is_rotated = options_.rotate_loops_;
+    std::string cmp;
+    if (!is_rotated) {
+        cmp = "block" + std::to_string(block_num_++);
+    }
     std::string scope = "block" + std::to_string(block_num_++);
     std::string skip = "block" + std::to_string(block_num_);
     skip_nums_.push_back(block_num_++);
     std::string loop = "block" + std::to_string(block_num_);
     loop_nums_.push_back(block_num_++);
+    const auto site = get_profile_site(&node);
+    // The guard of a rotated loop is counted apart from its latch too, at
+    // the condition. The counters are there without the rotation, so the
+    // sites of the profile don't depend on it.
+    if (node.truth_value() != nullptr) {
+        get_profile_site(node.truth_value());
+    }
 
+    enter_scope();
     if (node.for_data_using() != nullptr) {
         node.for_data_using()->accept(*this);
     }
-    ir_ << "\t"
-        << "br label %" << cmp << "\n\n";
-
-    ir_ << cmp << ":\n";
-    if (node.truth_value() != nullptr) {
-        is_rel_op_last_ = false;
-        node.truth_value()->accept(*this);
-        if (!is_rel_op_last_) {
-            std::string tmp_name = "%tmp" + std::to_string(tmp_num_++);
-            std::string cmp;
-            std::string zero;
-            if (ir_buf_.type_[0] == 'i') {
-                cmp = "icmp ne";
-                zero = "0";
-            } else {
-                cmp = "fcmp une";
-                zero = "0.0";
-            }
-
-            ir_ << "\t" << tmp_name << " = " << cmp << " " << ir_buf_.type_
-                << " " << ir_buf_.name_ << ", " << zero << "\n";
-
-            ir_buf_.name_ = std::move(tmp_name);
-            ir_buf_.type_ = "i1";
+    auto *counter = widen_counter(node);
+    if (options_.promote_scalars_ || options_.hoist_invariant_calls_) {
+        auto writes = detail::LoopWritesCollector::exec(node);
+        if (options_.hoist_invariant_calls_) {
+            hoist_invariant_calls(node, writes);
         }
-        ir_ << "\t"
-            << "br i1 " << ir_buf_.name_ << ", label %" << scope << ", label %"
-            << skip << "\n\n";
+        if (options_.promote_scalars_) {
+            loops_.push_back({ssa_.get_current_block(), std::move(writes)});
+        }
+    }
+    if (!is_rotated) {
+        branch(cmp);
+        ir_ << "\n";
+        start_block(cmp);
+    }
+    // The guard of a rotated loop doesn't get the loop heuristic, its latch
+    // does
+    if (is_rotated) {
+        loop_condition(
+            node, scope, skip,
+            get_branch_weights(
+                node.truth_value(), node.truth_value(), BranchHint::none),
+            "", true);
     } else {
-        ir_ << "\t"
-            << "br label %" << scope << "\n\n";
+        loop_condition(
+            node, scope, skip,
+            get_branch_weights(&node, node.truth_value(), BranchHint::likely),
+            "");
     }
+    ir_ << "\n";
 
-    ir_ << scope << ":\n";
+    start_block(scope);
+    if (!is_rotated) {
+        seal_block(scope);
+    }
+    count_profile(site + 1);
+    enter_scope();
+    loop_slot_depths_.push_back(slots_.size() - 1);
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
+    leave_scope();
+    loop_slot_depths_.pop_back();
     loop_nums_.pop_back();
     skip_nums_.pop_back();
-    ir_ << "\t"
-        << "br label %" << loop << "\n\n";
+    branch(loop);
+    ir_ << "\n";
 
-    ir_ << loop << ":\n";
+    start_block(loop);
+    seal_block(loop);
     if (node.value() != nullptr) {
         node.value()->accept(*this);
     }
-    ir_ << "\t"
-        << "br label %" << cmp << "\n\n";
+    if (counter != nullptr) {
+        step_wide_counter(counter);
+    }
+    if (is_rotated) {
+        loop_condition(
+            node, scope, skip,
+            get_branch_weights(
+                &node, node.truth_value(), BranchHint::likely,
+                node.truth_value()),
+            get_loop_metadata(node));
+    } else {
+        branch(cmp);
+    }
+    ir_ << "\n";
+    seal_block(is_rotated ? scope : cmp);
+    if (options_.promote_scalars_) {
+        loops_.pop_back();
+    }
+    wide_counters_.erase(counter);
 
-    ir_ << skip << ":\n";
+    start_block(skip);
+    seal_block(skip);
+    leave_scope();
 
     scope_order_ = prev_scope_order;
     scopes_.pop();
@@ -296,56 +429,52 @@ void CodeGenerator::visit(IfStatement &node) {
     scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
     std::size_t prev_scope_order = scope_order_;
     scope_order_ = 0;
+    const auto site = get_profile_site(&node);
 
-    is_rel_op_last_ = false;
-    node.truth_value()->accept(*this);
-    if (!is_rel_op_last_) {
-        std::string tmp_name = "%tmp" + std::to_string(tmp_num_++);
-        std::string cmp;
-        std::string zero;
-        if (ir_buf_.type_ == std::string("double") ||
-            ir_buf_.type_ == std::string("float")) {
-            cmp = "fcmp une";
-            zero = "0.0";
-        } else {
-            cmp = "icmp ne";
-            zero = "0";
-        }
-
-        ir_ << "\t" << tmp_name << " = " << cmp << " " << ir_buf_.type_ << " "
-            << ir_buf_.name_ << ", " << zero << "\n";
-
-        ir_buf_.name_ = std::move(tmp_name);
-        ir_buf_.type_ = "i1";
-    }
+    emit_condition(node.truth_value());
+    count_profile(site);
 
     std::string scope = "block" + std::to_string(block_num_++);
     std::string skip = "block" + std::to_string(block_num_++);
-    ir_ << "\t"
-        << "br i1 " << ir_buf_.name_ << ", label %" << scope << ", label %"
-        << skip << "\n\n";
+    const bool has_return = std::any_of(
+        node.actions().begin(), node.actions().end(), [](const Node *action) {
+            return dynamic_cast<const ReturnStatement *>(action) != nullptr;
+        });
+    cond_branch(
+        ir_buf_.name_, scope, skip,
+        get_branch_weights(
+            &node, node.truth_value(),
+            has_return ? BranchHint::unlikely : BranchHint::none));
+    ir_ << "\n";
 
-    ir_ << scope << ":\n";
+    start_block(scope);
+    seal_block(scope);
+    count_profile(site + 1);
+    enter_scope();
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
-    ir_ << "\t"
-        << "br label %" << skip << "\n\n";
+    leave_scope();
+    branch(skip);
+    ir_ << "\n";
 
-    ir_ << skip << ":\n";
+    start_block(skip);
+    seal_block(skip);
 
     scope_order_ = prev_scope_order;
     scopes_.pop();
 }
 
 void CodeGenerator::visit(ContinueStatement & /*node*/) {
-    ir_ << "\t"
-        << "br label %block" << std::to_string(loop_nums_.back()) << "\n";
+    end_slots(loop_slot_depths_.back());
+    branch("block" + std::to_string(loop_nums_.back()));
+    start_unreachable_block();
 }
 
 void CodeGenerator::visit(BreakStatement & /*node*/) {
-    ir_ << "\t"
-        << "br label %block" << std::to_string(skip_nums_.back()) << "\n";
+    end_slots(loop_slot_depths_.back());
+    branch("block" + std::to_string(skip_nums_.back()));
+    start_unreachable_block();
 }
 
 // Array
@@ -357,52 +486,79 @@ void CodeGenerator::visit(ArrayUninit &node) {
     cgs_alc_[var].type_ = get_ir_type(var->get_type());
 
     node.size()->accept(*this);
-    if (std::string("i64") != ir_buf_.type_) {
-        cast_to(IrNode("", "i64"), ir_buf_);
-    }
+    convert(node.size(), ir_buf_, "i64");
 
-    ir_ << "\t" << cgs_alc_[var].name_ << " = alloca " << cgs_alc_[var].type_
-        << ", i64 " << ir_buf_.name_ << "\n";
+    emit_alloca(cgs_alc_[var].name_, cgs_alc_[var].type_, ir_buf_.name_);
 }
 
 void CodeGenerator::visit(ArrayElementAccess &node) {
-    bool prev_rvalue_oper = is_rvalue_oper_;
-    is_rvalue_oper_ = false;
-    node.idx()->accept(*this);
-    is_rvalue_oper_ = prev_rvalue_oper;
+    if (auto wide = read_wide_counter(node.idx())) {
+        ir_buf_ = IrNode(std::move(*wide), "i64");
+    } else {
+        bool prev_rvalue_oper = is_rvalue_oper_;
+        is_rvalue_oper_ = false;
+        node.idx()->accept(*this);
+        is_rvalue_oper_ = prev_rvalue_oper;
 
-    if (std::string("i64") != ir_buf_.type_) {
-        cast_to(IrNode("", "i64"), ir_buf_);
+        convert(node.idx(), ir_buf_, "i64");
     }
 
     auto *var = get_varsym(node.id());
+    // Indexing out of the bounds of the array is undefined
+    std::string gep =
+        options_.optimize_indexing_ ? "getelementptr inbounds "
+                                    : "getelementptr ";
 
     std::string tmp_name;
     IrNode ir_var;
     if (cgs_alc_[var].type_.back() == '*') {
-        std::string prev_tmp_name = "%tmp" + std::to_string(tmp_num_++);
-        ir_ << "\t" << prev_tmp_name << " = load " << cgs_alc_[var].type_
-            << ", " << cgs_alc_[var].type_ + "* " << cgs_alc_[var].name_
-            << "\n";
-        tmp_name = "%tmp" + std::to_string(tmp_num_++);
-        ir_ << "\t" << tmp_name << " = getelementptr "
-            << cgs_alc_[var].type_.substr(0, cgs_alc_[var].type_.size() - 1)
-            << ", " << cgs_alc_[var].type_ << " " << prev_tmp_name << ", i64 "
-            << ir_buf_.name_ << "\n";
+        std::string prev_tmp_name;
+        if (is_promoted(var)) {
+            prev_tmp_name = read_promoted(var);
+        } else if (auto it = block_pointers_.find(var);
+                   it != block_pointers_.end()) {
+            prev_tmp_name = it->second;
+        } else if (auto value = find_value(get_load_key(
+                       var, cgs_alc_[var].type_, cgs_alc_[var].name_))) {
+            prev_tmp_name = *value;
+        } else {
+            prev_tmp_name = "%tmp" + std::to_string(tmp_num_++);
+            ir_ << "\t" << prev_tmp_name << " = load " << cgs_alc_[var].type_
+                << ", " << cgs_alc_[var].type_ + "* " << cgs_alc_[var].name_
+                << "\n";
+            if (options_.optimize_indexing_) {
+                block_pointers_[var] = prev_tmp_name;
+            }
+            number_value(
+                get_load_key(var, cgs_alc_[var].type_, cgs_alc_[var].name_),
+                prev_tmp_name);
+        }
         ir_var.type_ =
             cgs_alc_[var].type_.substr(0, cgs_alc_[var].type_.size() - 1);
+        tmp_name = gep + ir_var.type_ + ", " + cgs_alc_[var].type_ + " " +
+            prev_tmp_name + ", i64 " + ir_buf_.name_;
     } else {
-        tmp_name = "%tmp" + std::to_string(tmp_num_++);
-        ir_ << "\t" << tmp_name << " = getelementptr " << cgs_alc_[var].type_
-            << ", " << cgs_alc_[var].type_ + "* " << cgs_alc_[var].name_
-            << ", i64 " << ir_buf_.name_ << "\n";
         ir_var.type_ = cgs_alc_[var].type_;
+        tmp_name = gep + ir_var.type_ + ", " + ir_var.type_ + "* " +
+            cgs_alc_[var].name_ + ", i64 " + ir_buf_.name_;
+    }
+    if (auto value = find_value(tmp_name)) {
+        ir_var.alc_name_ = *value;
+    } else {
+        ir_var.alc_name_ = "%tmp" + std::to_string(tmp_num_++);
+        ir_ << "\t" << ir_var.alc_name_ << " = " << tmp_name << "\n";
+        number_value(tmp_name, ir_var.alc_name_);
     }
 
-    ir_var.name_ = "%tmp" + std::to_string(tmp_num_++);
-    ir_var.alc_name_ = std::move(tmp_name);
-    ir_ << "\t" << ir_var.name_ << " = load " << ir_var.type_ << ", "
-        << ir_var.type_ + "* " << ir_var.alc_name_ << "\n";
+    auto key = get_load_key(nullptr, ir_var.type_, ir_var.alc_name_);
+    if (auto value = find_value(key)) {
+        ir_var.name_ = *value;
+    } else {
+        ir_var.name_ = "%tmp" + std::to_string(tmp_num_++);
+        ir_ << "\t" << ir_var.name_ << " = load " << ir_var.type_ << ", "
+            << ir_var.type_ + "* " << ir_var.alc_name_ << "\n";
+        number_value(key, ir_var.name_);
+    }
 
     if (is_rvalue_oper_) {
         calc_expr_.emplace(std::move(ir_var));
@@ -415,40 +571,75 @@ void CodeGenerator::visit(ArrayElementAccess &node) {
 
 void CodeGenerator::visit(VariableInit &node) {
     auto *var = get_varsym(node.id());
+    if (is_promoted(var)) {
+        cgs_alc_[var].type_ = get_ir_type(var->get_type());
+        node.value()->accept(*this);
+        convert(node.value(), ir_buf_, cgs_alc_[var].type_);
+        ssa_.write_variable(var, ssa_.get_current_block(), ir_buf_.name_);
+        return;
+    }
+
     cgs_alc_[var].name_ =
         "%" + var->get_name() + ".addr" + std::to_string(addr_num_++);
     cgs_alc_[var].type_ = get_ir_type(var->get_type());
 
-    ir_ << "\t" << cgs_alc_[var].name_ << " = alloca " << cgs_alc_[var].type_
-        << "\n";
+    emit_alloca(cgs_alc_[var].name_, cgs_alc_[var].type_);
 
     node.value()->accept(*this);
-    if (cgs_alc_[var].type_ != ir_buf_.type_) {
-        cast_to(cgs_alc_[var], ir_buf_);
-    }
+    convert(node.value(), ir_buf_, cgs_alc_[var].type_);
     ir_ << "\t"
         << "store " << cgs_alc_[var].type_ << " " << ir_buf_.name_ << ", "
         << cgs_alc_[var].type_ + "* " << cgs_alc_[var].name_ << "\n";
+    remember_constant(var, ir_buf_);
+    number_store(
+        var, cgs_alc_[var].type_, cgs_alc_[var].name_, ir_buf_.name_);
 }
 
 void CodeGenerator::visit(VariableUninit &node) {
     auto *var = get_varsym(node.id());
+    if (is_promoted(var)) {
+        cgs_alc_[var].type_ = get_ir_type(var->get_type());
+        ssa_.write_variable(var, ssa_.get_current_block(), "undef");
+        return;
+    }
+
     cgs_alc_[var].name_ =
         "%" + var->get_name() + ".addr" + std::to_string(addr_num_++);
     cgs_alc_[var].type_ = get_ir_type(var->get_type());
 
-    ir_ << "\t" << cgs_alc_[var].name_ << " = alloca " << cgs_alc_[var].type_
-        << "\n";
+    emit_alloca(cgs_alc_[var].name_, cgs_alc_[var].type_);
+    block_consts_.erase(var);
+    block_pointers_.erase(var);
+    ++store_generations_[var];
 }
 
 void CodeGenerator::visit(VariableAccess &node) {
     auto *var = get_varsym(node.id());
-    IrNode ir_var(
-        "%tmp" + std::to_string(tmp_num_++),
-        cgs_alc_[var].type_,
-        cgs_alc_[var].name_);
-    ir_ << "\t" << ir_var.name_ << " = load " << ir_var.type_ << ", "
-        << ir_var.type_ + "* " << ir_var.alc_name_ << "\n";
+    if (is_promoted(var)) {
+        IrNode ir_var(read_promoted(var), cgs_alc_[var].type_);
+        ir_var.var_ = var;
+        if (is_rvalue_oper_) {
+            calc_expr_.emplace(std::move(ir_var));
+            return;
+        }
+        ir_buf_ = std::move(ir_var);
+        return;
+    }
+
+    IrNode ir_var("", cgs_alc_[var].type_, cgs_alc_[var].name_);
+    ir_var.var_ = var;
+    if (auto it = block_consts_.find(var); it != block_consts_.end()) {
+        ir_var.name_ = it->second;
+    } else if (auto value = find_value(
+                   get_load_key(var, ir_var.type_, ir_var.alc_name_))) {
+        ir_var.name_ = *value;
+    } else {
+        ir_var.name_ = "%tmp" + std::to_string(tmp_num_++);
+        ir_ << "\t" << ir_var.name_ << " = load " << ir_var.type_ << ", "
+            << ir_var.type_ + "* " << ir_var.alc_name_ << "\n";
+        number_value(
+            get_load_key(var, ir_var.type_, ir_var.alc_name_), ir_var.name_);
+    }
     if (is_rvalue_oper_) {
         calc_expr_.emplace(std::move(ir_var));
         return;
@@ -498,23 +689,32 @@ void CodeGenerator::visit(AssignmentOperator &node) {
     IrNode lhs(std::move(calc_expr_.top()));
     calc_expr_.pop();
 
-    if (lhs.type_ != rhs.type_) {
-        cast_to(lhs, rhs);
+    const auto &expression_type = program_.get_expression_type(&node);
+    if (expression_type.rhs_conversion_ != Conversion::none) {
+        emit_conversion(expression_type.rhs_conversion_, rhs, lhs.type_);
     }
 
     if (node.assign_operator()[0] != '=') {
-        calc_expr_.push(lhs);
-        calc_expr_.push(rhs);
-
-        ArithmeticOperator arth_op(node.assign_operator().substr(0, 1));
-        arth_op.accept(*this);
+        emit_arithmetic(
+            node.assign_operator().substr(0, 1), lhs, rhs,
+            expression_type.operand_type_.is_floating());
 
         rhs = std::move(calc_expr_.top());
         calc_expr_.pop();
     }
+    if (is_promoted(lhs.var_)) {
+        ssa_.write_variable(lhs.var_, ssa_.get_current_block(), rhs.name_);
+        calc_expr_.push(std::move(rhs));
+        return;
+    }
     ir_ << "\t"
         << "store " << lhs.type_ << " " << rhs.name_ << ", " << lhs.type_ + "* "
         << lhs.alc_name_ << "\n";
+    if (lhs.var_ != nullptr) {
+        remember_constant(lhs.var_, rhs);
+        block_pointers_.erase(lhs.var_);
+    }
+    number_store(lhs.var_, lhs.type_, lhs.alc_name_, rhs.name_);
 
     calc_expr_.push(std::move(rhs));
 }
@@ -525,18 +725,11 @@ void CodeGenerator::visit(ArithmeticOperator &node) {
     IrNode lhs(std::move(calc_expr_.top()));
     calc_expr_.pop();
 
-    if (lhs.type_ != rhs.type_) {
-        cast(lhs, rhs);
-    }
-
-    IrNode res("%tmp" + std::to_string(tmp_num_++), lhs.type_);
-    auto inst = lhs.type_[0] == 'i'
-        ? c_ir_arth_i.at(node.arithmetic_operator())
-        : c_ir_arth_f.at(node.arithmetic_operator());
-    ir_ << "\t" << res.name_ << " = " + inst + " " << res.type_ << " "
-        << lhs.name_ << ", " << rhs.name_ << "\n";
-
-    calc_expr_.push(std::move(res));
+    const auto &expression_type = program_.get_expression_type(&node);
+    convert_operands(expression_type, lhs, rhs);
+    emit_arithmetic(
+        node.arithmetic_operator(), std::move(lhs), std::move(rhs),
+        expression_type.operand_type_.is_floating());
 }
 
 void CodeGenerator::visit(RelationalOperator &node) {
@@ -545,32 +738,37 @@ void CodeGenerator::visit(RelationalOperator &node) {
     IrNode lhs(std::move(calc_expr_.top()));
     calc_expr_.pop();
 
-    if (lhs.type_ != rhs.type_) {
-        cast(lhs, rhs);
+    const auto &expression_type = program_.get_expression_type(&node);
+    convert_operands(expression_type, lhs, rhs);
+
+    if (auto lhs_const = get_constant(lhs), rhs_const = get_constant(rhs);
+        lhs_const && rhs_const) {
+        calc_expr_.emplace(
+            make_constant(
+                static_cast<std::int64_t>(fold_relational(
+                    node.relational_operator(), *lhs_const, *rhs_const)),
+                "i1"),
+            "i1");
+        return;
     }
 
-    IrNode res("%tmp" + std::to_string(tmp_num_++), "i1");
-    auto inst = lhs.type_[0] == 'i' ? c_ir_rel_i.at(node.relational_operator())
-                                    : c_ir_rel_f.at(node.relational_operator());
-    ir_ << "\t" << res.name_ << " = " + inst + " " << lhs.type_ << " "
-        << lhs.name_ << ", " << rhs.name_ << "\n";
-
-    calc_expr_.push(std::move(res));
+    auto inst = expression_type.operand_type_.is_floating()
+        ? c_ir_rel_f.at(node.relational_operator())
+        : c_ir_rel_i.at(node.relational_operator());
+    calc_expr_.emplace(
+        emit_value(inst + " " + lhs.type_ + " " + lhs.name_ + ", " + rhs.name_),
+        "i1");
 }
 
 // Literals
 
 void CodeGenerator::visit(StringLiteral &node) {
-    auto str = node.string();
-    std::size_t n = 0;
-    for (auto pos = str.find("\\n"); pos != std::string::npos;
-         pos = str.find("\\n")) {
-        str.replace(pos, 2, "\n");
-        ++n;
+    IrNode ir_var(str_pointers_.at(&node), "i8*");
+    if (is_rvalue_oper_) {
+        calc_expr_.push(std::move(ir_var));
+        return;
     }
-    ir_buf_.name_ = "@.str" + std::to_string(str_num_++);
-    ir_buf_.type_ =
-        "[" + std::to_string(node.string().size() - n + 1) + " x i8]";
+    ir_buf_ = std::move(ir_var);
 }
 
 void CodeGenerator::visit(IntegerLiteral &node) {
@@ -585,6 +783,67 @@ void CodeGenerator::visit(IntegerLiteral &node) {
 
 // private methods
 
+// Every function but main and the exported ones is called only from the
+// module
+std::string CodeGenerator::get_linkage(
+    const symtab::FunctionSymbol &func_sym) const {
+    if (!options_.internalize_) {
+        return "";
+    }
+    const auto &exported = options_.exported_;
+    return func_sym.get_name() == "main" ||
+            std::find(exported.begin(), exported.end(), func_sym.get_name()) !=
+                exported.end()
+        ? "dso_local "
+        : "internal ";
+}
+
+std::string CodeGenerator::get_param_attributes(
+    const symtab::FunctionSymbol &func_sym, std::size_t param) const {
+    auto *var =
+        dynamic_cast<symtab::VariableSymbol *>(func_sym.get_params()[param]);
+    if (!options_.infer_attributes_ ||
+        dynamic_cast<symtab::PointerType *>(var->get_type()) == nullptr) {
+        return "";
+    }
+
+    const auto &effects = func_sym.get_effects();
+
+    std::string attributes;
+    if (effects.noalias_params_[param]) {
+        attributes += "noalias ";
+    }
+    if (!effects.captured_params_[param]) {
+        attributes += "nocapture ";
+    }
+    return attributes;
+}
+
+// The language has no exceptions, so no function unwinds
+std::string CodeGenerator::get_function_attributes(
+    const symtab::FunctionSymbol &func_sym) const {
+    if (!options_.infer_attributes_) {
+        return "";
+    }
+
+    const auto &effects = func_sym.get_effects();
+    std::string attributes = " nounwind";
+    if (!effects.is_recursive_) {
+        attributes += " norecurse";
+    }
+    // The counters are written by every function
+    if (!options_.profile_generate_.empty() ||
+        !options_.instrument_functions_.empty()) {
+        return attributes;
+    }
+    if (effects.is_readnone()) {
+        attributes += " readnone";
+    } else if (effects.is_readonly()) {
+        attributes += " readonly";
+    }
+    return attributes;
+}
+
 symtab::VariableSymbol *CodeGenerator::get_varsym(const std::string &id) {
     return dynamic_cast<symtab::VariableSymbol *>(scopes_.top()->resolve(id));
 }
@@ -613,170 +872,1475 @@ std::string CodeGenerator::get_ir_type(symtab::Type *type) {
     return type_name;
 }
 
-void CodeGenerator::cast(IrNode &lhs, IrNode &rhs) {
-    std::string ir_name = "%tmp" + std::to_string(tmp_num_++);
-    if (lhs.type_[0] == rhs.type_[0]) {
-        if (c_ir_type_order.at(lhs.type_) < c_ir_type_order.at(rhs.type_)) {
-            cast_out(lhs, rhs, ir_name, "sext");
-        } else {
-            cast_out(rhs, lhs, ir_name, "sext");
-        }
-    } else if (
-        (lhs.type_[0] == 'd' && rhs.type_[0] == 'f') ||
-        (lhs.type_[0] == 'f' && rhs.type_[0] == 'd')) {
-        if (c_ir_type_order.at(lhs.type_) < c_ir_type_order.at(rhs.type_)) {
-            cast_out(lhs, rhs, ir_name, "fpext");
-        } else {
-            cast_out(rhs, lhs, ir_name, "fpext");
-        }
-    } else {
-        if (lhs.type_[0] == 'i') {
-            cast_out(lhs, rhs, ir_name, "sitofp");
-        } else {
-            cast_out(rhs, lhs, ir_name, "sitofp");
-        }
+// Applies the conversion the type analysis found for the value of the node
+void CodeGenerator::convert(
+    const Node *node, IrNode &value, const std::string &type) {
+    auto conversion = program_.get_expression_type(node).conversion_;
+    if (conversion != Conversion::none) {
+        emit_conversion(conversion, value, type);
+    }
+}
+
+void CodeGenerator::convert_operands(
+    const ExpressionType &expression_type, IrNode &lhs, IrNode &rhs) {
+    if (expression_type.lhs_conversion_ != Conversion::none) {
+        emit_conversion(expression_type.lhs_conversion_, lhs, rhs.type_);
+    } else if (expression_type.rhs_conversion_ != Conversion::none) {
+        emit_conversion(expression_type.rhs_conversion_, rhs, lhs.type_);
     }
 }
 
-void CodeGenerator::cast_to(const IrNode &to, IrNode &from) {
+void CodeGenerator::emit_conversion(
+    Conversion conversion, IrNode &value, const std::string &type) {
     std::string ir_name = "%tmp" + std::to_string(tmp_num_++);
-    if (to.type_[0] == from.type_[0]) {
-        if (c_ir_type_order.at(to.type_) < c_ir_type_order.at(from.type_)) {
-            cast_out(from, to, ir_name, "trunc");
-        } else {
-            cast_out(from, to, ir_name, "sext");
-        }
-    } else if (
-        (to.type_[0] == 'd' && from.type_[0] == 'f') ||
-        (to.type_[0] == 'f' && from.type_[0] == 'd')) {
-        if (c_ir_type_order.at(to.type_) < c_ir_type_order.at(from.type_)) {
-            cast_out(from, to, ir_name, "fptrunc");
-        } else {
-            cast_out(from, to, ir_name, "fpext");
+    const bool is_to_integer = conversion != Conversion::float_extend &&
+        conversion != Conversion::float_truncate &&
+        conversion != Conversion::int_to_float;
+    if (auto constant = get_constant(value); constant && is_to_integer) {
+        value.name_ = make_constant(*constant, type);
+        value.type_ = type;
+        return;
+    }
+    if (std::isdigit(value.name_[0]) != 0 &&
+        conversion != Conversion::float_to_int) {
+        if (conversion == Conversion::int_to_float) {
+            value.name_ += ".0";
         }
+        value.type_ = type;
+        return;
+    }
+    auto instruction = c_ir_conversions.at(conversion) + " " + value.type_ +
+        " " + value.name_ + " to " + type;
+    if (auto prev = find_value(instruction)) {
+        ir_name = std::move(*prev);
     } else {
-        if (to.type_[0] == 'i') {
-            cast_out(from, to, ir_name, "fptosi");
-        } else {
-            cast_out(from, to, ir_name, "sitofp");
-        }
+        ir_ << "\t" << ir_name << " = " << instruction << "\n";
+        number_value(instruction, ir_name);
     }
+    value.name_ = std::move(ir_name);
+    value.type_ = type;
 }
 
-void CodeGenerator::cast_out(
-    IrNode &from, const IrNode &to, std::string &ir_name, std::string inst) {
-    if (std::isdigit(from.name_[0]) != 0) {
-        if (from.type_[0] != to.type_[0]) {
-            from.name_ += ".0";
+void CodeGenerator::emit_arithmetic(
+    const std::string &oper, IrNode lhs, IrNode rhs, bool is_floating) {
+    if (auto lhs_const = get_constant(lhs), rhs_const = get_constant(rhs);
+        lhs_const && rhs_const) {
+        if (auto value =
+                fold_arithmetic(oper, *lhs_const, *rhs_const, lhs.type_)) {
+            calc_expr_.emplace(make_constant(*value, lhs.type_), lhs.type_);
+            return;
         }
-        from.type_ = to.type_;
-        return;
     }
-    if (from.type_ == std::string("i1")) {
-        if (inst == std::string("sext")) {
-            inst = "zext";
+
+    if (options_.reduce_strength_ && !is_floating) {
+        if (auto value = reduce_strength(oper, lhs, rhs)) {
+            calc_expr_.emplace(std::move(*value), lhs.type_);
+            return;
         }
     }
-    ir_ << "\t" << ir_name << " = " << inst << " " << from.type_ << " "
-        << from.name_ << " to " << to.type_ << "\n";
-    from.name_ = std::move(ir_name);
-    from.type_ = to.type_;
+
+    auto inst = is_floating ? c_ir_arth_f.at(oper) : c_ir_arth_i.at(oper);
+    calc_expr_.emplace(
+        emit_value(inst + " " + lhs.type_ + " " + lhs.name_ + ", " + rhs.name_),
+        lhs.type_);
+}
+
+// Emits the instruction unless the block has computed its value already
+std::string CodeGenerator::emit_value(const std::string &instruction) {
+    if (auto value = find_value(instruction)) {
+        return *value;
+    }
+    auto name = "%tmp" + std::to_string(tmp_num_++);
+    ir_ << "\t" << name << " = " << instruction << "\n";
+    number_value(instruction, name);
+    return name;
 }
 
-// DeclareStr
+namespace {
 
-void DeclareStr::exec(std::ostream &os, Program &program) {
-    DeclareStr declare_str(os);
-    declare_str.ir_ << "target triple = \"x86_64-pc-linux-gnu\"\n\n";
-    for (auto *child : program.get_childs()) {
-        child->accept(declare_str);
+std::size_t get_bits(const std::string &type) {
+    return std::stoul(type.substr(1));
+}
+
+// Keeps the low bits of the value as the integer type of LLVM does
+std::int64_t wrap(std::uint64_t value, const std::string &type) {
+    const auto bits = get_bits(type);
+    if (bits == 1) {
+        return static_cast<std::int64_t>(value & 1U);
     }
-    declare_str.ir_ << "\n";
+    const auto shift = 64 - bits;
+    return static_cast<std::int64_t>(value << shift) >> shift;
 }
 
-void DeclareStr::visit(FunctionDefinition &node) {
-    for (auto *action : node.actions()) {
-        action->accept(*this);
+} // namespace
+
+std::optional<std::int64_t> CodeGenerator::get_constant(
+    const IrNode &node) const {
+    if (!options_.fold_constants_) {
+        return std::nullopt;
     }
+    return parse_constant(node);
 }
 
-void DeclareStr::visit(LocalScope &node) {
-    for (auto *action : node.actions()) {
-        action->accept(*this);
+std::optional<std::int64_t> CodeGenerator::parse_constant(const IrNode &node) {
+    if (node.type_[0] != 'i' || node.type_.back() == '*') {
+        return std::nullopt;
+    }
+    if (node.name_ == "true" || node.name_ == "false") {
+        return node.name_ == "true" ? 1 : 0;
+    }
+
+    std::int64_t value = 0;
+    const auto *end = node.name_.data() + node.name_.size();
+    auto [ptr, ec] = std::from_chars(node.name_.data(), end, value);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    // A literal that doesn't fit is left to the assembler
+    if (wrap(static_cast<std::uint64_t>(value), node.type_) != value) {
+        return std::nullopt;
     }
+    return value;
 }
 
-void DeclareStr::visit(Expression &node) {
-    node.expression()->accept(*this);
+std::string CodeGenerator::make_constant(
+    std::int64_t value, const std::string &type) {
+    if (type == "i1") {
+        return (value & 1) != 0 ? "true" : "false";
+    }
+    return std::to_string(wrap(static_cast<std::uint64_t>(value), type));
 }
 
-void DeclareStr::visit(FunctionCall &node) {
-    if (!is_printf_exist_ && node.id() == "printf") {
-        is_printf_exist_ = true;
-        ir_ << "declare i32 @printf(i8*, ...)\n\n";
+std::optional<std::int64_t> CodeGenerator::fold_arithmetic(
+    const std::string &oper,
+    std::int64_t lhs,
+    std::int64_t rhs,
+    const std::string &type) {
+    const auto ulhs = static_cast<std::uint64_t>(lhs);
+    const auto urhs = static_cast<std::uint64_t>(rhs);
+    switch (oper[0]) {
+    case '+':
+        return wrap(ulhs + urhs, type);
+    case '-':
+        return wrap(ulhs - urhs, type);
+    case '*':
+        return wrap(ulhs * urhs, type);
+    default:
+        break;
     }
-    for (auto *arg : node.args()) {
-        arg->accept(*this);
+
+    // Division by zero and the overflowing division are left to run time
+    const auto min = wrap(std::uint64_t{1} << (get_bits(type) - 1), type);
+    if (rhs == 0 || (rhs == -1 && lhs == min)) {
+        return std::nullopt;
     }
+    return oper[0] == '/' ? lhs / rhs : lhs % rhs;
 }
 
-void DeclareStr::visit(VariableWriting &node) {
-    node.variable_writing()->accept(*this);
+bool CodeGenerator::fold_relational(
+    const std::string &oper, std::int64_t lhs, std::int64_t rhs) {
+    if (oper == "==") {
+        return lhs == rhs;
+    }
+    if (oper == "!=") {
+        return lhs != rhs;
+    }
+    if (oper == "<") {
+        return lhs < rhs;
+    }
+    if (oper == "<=") {
+        return lhs <= rhs;
+    }
+    if (oper == ">") {
+        return lhs > rhs;
+    }
+    return lhs >= rhs;
 }
 
-void DeclareStr::visit(DataCreate &node) {
-    node.data_create()->accept(*this);
+namespace {
+
+std::optional<unsigned> get_power_of_two(std::int64_t value) {
+    if (value <= 0 || (value & (value - 1)) != 0) {
+        return std::nullopt;
+    }
+    unsigned shift = 0;
+    while ((std::int64_t{1} << shift) != value) {
+        ++shift;
+    }
+    return shift;
 }
 
-void DeclareStr::visit(ForStatement &node) {
-    if (node.for_data_using() != nullptr) {
-        node.for_data_using()->accept(*this);
+// The high half of the product of a dividend and the magic number, shifted
+// right, is the quotient rounded toward minus infinity
+struct Magic {
+    std::int64_t multiplier_;
+    unsigned shift_;
+};
+
+// Warren, "Hacker's Delight", 10-4: the divisor is neither 0, 1, -1 nor the
+// minimum of the type
+Magic get_magic(std::int64_t divisor, std::size_t bits) {
+    const std::uint64_t mask =
+        bits == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << bits) - 1;
+    const std::uint64_t min = std::uint64_t{1} << (bits - 1);
+    const auto udivisor = static_cast<std::uint64_t>(divisor);
+    const std::uint64_t magnitude =
+        (divisor < 0 ? 0 - udivisor : udivisor) & mask;
+    const std::uint64_t t = min + (udivisor >> 63U);
+    const std::uint64_t anc = t - 1 - t % magnitude;
+
+    auto p = bits - 1;
+    std::uint64_t q1 = min / anc;
+    std::uint64_t r1 = min - q1 * anc;
+    std::uint64_t q2 = min / magnitude;
+    std::uint64_t r2 = min - q2 * magnitude;
+    std::uint64_t delta = 0;
+    do {
+        ++p;
+        q1 = (2 * q1) & mask;
+        r1 = (2 * r1) & mask;
+        if (r1 >= anc) {
+            q1 = (q1 + 1) & mask;
+            r1 = (r1 - anc) & mask;
+        }
+        q2 = (2 * q2) & mask;
+        r2 = (2 * r2) & mask;
+        if (r2 >= magnitude) {
+            q2 = (q2 + 1) & mask;
+            r2 = (r2 - magnitude) & mask;
+        }
+        delta = (magnitude - r2) & mask;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    auto multiplier = (q2 + 1) & mask;
+    if (divisor < 0) {
+        multiplier = (0 - multiplier) & mask;
     }
+    return {wrap(multiplier, "i" + std::to_string(bits)),
+            static_cast<unsigned>(p - bits)};
+}
 
-    if (node.truth_value() != nullptr) {
-        node.truth_value()->accept(*this);
+} // namespace
+
+// Returns the value of the operation by a constant without the instruction
+// the operator maps to, the constant of + and * may be the left operand
+std::optional<std::string> CodeGenerator::reduce_strength(
+    const std::string &oper, IrNode &lhs, IrNode &rhs) {
+    if ((oper == "+" || oper == "*") && parse_constant(lhs) &&
+        !parse_constant(rhs)) {
+        std::swap(lhs, rhs);
+    }
+    auto constant = parse_constant(rhs);
+    if (!constant) {
+        return std::nullopt;
     }
 
-    if (node.value() != nullptr) {
-        node.value()->accept(*this);
+    const auto &type = lhs.type_;
+    const auto min = wrap(std::uint64_t{1} << (get_bits(type) - 1), type);
+    switch (oper[0]) {
+    case '+':
+    case '-':
+        if (*constant == 0) {
+            return lhs.name_;
+        }
+        return std::nullopt;
+    case '*':
+        if (*constant == 0) {
+            return make_constant(0, type);
+        }
+        if (*constant == 1) {
+            return lhs.name_;
+        }
+        if (*constant == -1) {
+            return emit_value("sub " + type + " 0, " + lhs.name_);
+        }
+        if (auto shift = get_power_of_two(*constant)) {
+            return emit_value(
+                "shl " + type + " " + lhs.name_ + ", " +
+                std::to_string(*shift));
+        }
+        return std::nullopt;
+    default:
+        break;
     }
 
-    for (auto *action : node.actions()) {
-        action->accept(*this);
+    // Division by zero and by the minimum are left to run time
+    if (*constant == 0 || *constant == min) {
+        return std::nullopt;
     }
+    return oper[0] == '/' ? emit_division(lhs.name_, type, *constant)
+                          : emit_remainder(lhs.name_, type, *constant);
 }
 
-void DeclareStr::visit(IfStatement &node) {
-    node.truth_value()->accept(*this);
+// The quotient is rounded toward zero as sdiv does
+std::string CodeGenerator::emit_division(
+    const std::string &value, const std::string &type, std::int64_t divisor) {
+    const auto bits = get_bits(type);
+    const auto magnitude = divisor < 0 ? -divisor : divisor;
+    std::string quotient = value;
+    if (auto shift = get_power_of_two(magnitude); shift && *shift > 0) {
+        quotient = emit_value(
+            "ashr " + type + " " + emit_biased(value, type, *shift) + ", " +
+            std::to_string(*shift));
+    } else if (!shift) {
+        const auto magic = get_magic(divisor, bits);
+        const auto wide = "i" + std::to_string(2 * bits);
+        auto product = emit_value(
+            "mul " + wide + " " +
+            emit_value("sext " + type + " " + value + " to " + wide) + ", " +
+            std::to_string(magic.multiplier_));
+
+        // The multiplier is off by 2^bits when its sign differs from the one
+        // of the divisor
+        const bool is_corrected = (divisor > 0) != (magic.multiplier_ > 0);
+        auto high = emit_value(
+            "ashr " + wide + " " + product + ", " +
+            std::to_string(bits + (is_corrected ? 0 : magic.shift_)));
+        quotient = emit_value("trunc " + wide + " " + high + " to " + type);
+        if (is_corrected) {
+            quotient = emit_value(
+                (divisor > 0 ? "add " : "sub ") + type + " " + quotient +
+                ", " + value);
+            if (magic.shift_ > 0) {
+                quotient = emit_value(
+                    "ashr " + type + " " + quotient + ", " +
+                    std::to_string(magic.shift_));
+            }
+        }
+        // Adds 1 to the negative quotients
+        auto sign = emit_value(
+            "lshr " + type + " " + quotient + ", " + std::to_string(bits - 1));
+        return emit_value("add " + type + " " + quotient + ", " + sign);
+    }
+    return divisor < 0 ? emit_value("sub " + type + " 0, " + quotient)
+                       : quotient;
+}
 
-    for (auto *action : node.actions()) {
-        action->accept(*this);
+// The remainder has the sign of the dividend as srem gives
+std::string CodeGenerator::emit_remainder(
+    const std::string &value, const std::string &type, std::int64_t divisor) {
+    const auto magnitude = divisor < 0 ? -divisor : divisor;
+    if (magnitude == 1) {
+        return "0";
+    }
+    std::string multiple;
+    if (auto shift = get_power_of_two(magnitude)) {
+        multiple = emit_value(
+            "and " + type + " " + emit_biased(value, type, *shift) + ", " +
+            std::to_string(-magnitude));
+    } else {
+        multiple = emit_value(
+            "mul " + type + " " + emit_division(value, type, magnitude) +
+            ", " + std::to_string(magnitude));
     }
+    return emit_value("sub " + type + " " + value + ", " + multiple);
 }
 
-void DeclareStr::visit(VariableInit &node) {
-    node.value()->accept(*this);
+// Adds 2^shift - 1 to a negative value, so the arithmetic shift right rounds
+// it toward zero
+std::string CodeGenerator::emit_biased(
+    const std::string &value, const std::string &type, unsigned shift) {
+    const auto bits = get_bits(type);
+    auto sign = shift == 1
+        ? value
+        : emit_value(
+              "ashr " + type + " " + value + ", " + std::to_string(bits - 1));
+    auto bias = emit_value(
+        "lshr " + type + " " + sign + ", " + std::to_string(bits - shift));
+    return emit_value("add " + type + " " + value + ", " + bias);
 }
 
-void DeclareStr::visit(StringLiteral &node) {
-    auto str = node.string();
-    std::size_t n = 0;
-    for (auto pos = str.find("\\n"); pos != std::string::npos;
-         pos = str.find("\\n")) {
-        str.replace(pos, 2, "\n");
-        ++n;
-    }
-    ir_ << "@.str" + std::to_string(str_num_++)
-        << " = private unnamed_addr constant [" << node.string().size() - n + 1
-        << " x i8] c\"";
-    for (char c : str) {
-        if (c == '\n') {
-            ir_ << "\\0A";
-        } else {
-            ir_ << c;
+void CodeGenerator::remember_constant(
+    const symtab::VariableSymbol *var, const IrNode &value) {
+    if (!options_.fold_constants_) {
+        return;
+    }
+    if (get_constant(value)) {
+        block_consts_[var] = value.name_;
+    } else {
+        block_consts_.erase(var);
+    }
+}
+
+std::optional<std::string> CodeGenerator::find_value(
+    const std::string &key) const {
+    if (!options_.number_values_) {
+        return std::nullopt;
+    }
+    if (auto it = block_values_.find(key); it != block_values_.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+void CodeGenerator::number_value(
+    const std::string &key, const std::string &value) {
+    if (options_.number_values_) {
+        block_values_.insert_or_assign(key, value);
+    }
+}
+
+// Arrays are accessed through their elements, so they are in the memory the
+// element stores change
+std::string CodeGenerator::get_load_key(
+    const symtab::VariableSymbol *var,
+    const std::string &type,
+    const std::string &pointer) const {
+    std::size_t generation = memory_generation_;
+    if (var != nullptr && var->get_type()->get_type() != std::string("[]")) {
+        auto it = store_generations_.find(var);
+        generation = it == store_generations_.end() ? 0 : it->second;
+    }
+    return "load " + type + ", " + type + "* " + pointer + " #" +
+        std::to_string(generation);
+}
+
+// The stored value is forwarded to the loads that follow in the block
+void CodeGenerator::number_store(
+    const symtab::VariableSymbol *var,
+    const std::string &type,
+    const std::string &pointer,
+    const std::string &value) {
+    if (var != nullptr && var->get_type()->get_type() != std::string("[]")) {
+        ++store_generations_[var];
+    } else {
+        ++memory_generation_;
+    }
+    number_value(get_load_key(var, type, pointer), value);
+}
+
+bool CodeGenerator::is_promoted(const symtab::VariableSymbol *var) const {
+    return options_.promote_scalars_ && var != nullptr &&
+        var->get_type()->get_type() != std::string("[]");
+}
+
+// A variable that the enclosing loops don't write keeps the value it had
+// before them, so the read doesn't need the phis of their headers
+std::string CodeGenerator::read_promoted(symtab::VariableSymbol *var) {
+    auto block = ssa_.get_current_block();
+    for (auto it = loops_.rbegin();
+         it != loops_.rend() && it->writes_.names_.count(var->get_name()) == 0;
+         ++it) {
+        block = it->preheader_;
+    }
+    return ssa_.read_variable(var, cgs_alc_[var].type_, block);
+}
+
+bool CodeGenerator::is_inlinable(symtab::FunctionSymbol &func) {
+    if (options_.inline_threshold_ == 0 || !options_.promote_scalars_ ||
+        !options_.instrument_functions_.empty() ||
+        func.get_effects().is_recursive_ || &func == current_func_) {
+        return false;
+    }
+    for (const auto &inlined : inlines_) {
+        if (inlined.func_ == &func) {
+            return false;
+        }
+    }
+    auto definition = definitions_.find(&func);
+    if (definition == definitions_.end()) {
+        return false;
+    }
+    for (auto *param : func.get_params()) {
+        if (!is_promoted(dynamic_cast<symtab::VariableSymbol *>(param))) {
+            return false;
         }
     }
-    ir_ << "\\00\"\n";
+
+    auto [cost, is_new] = inline_costs_.try_emplace(definition->second);
+    if (is_new) {
+        cost->second = detail::InlineCostCollector::exec(*definition->second);
+    }
+    return !cost->second.has_arrays_ &&
+        cost->second.size_ <= options_.inline_threshold_;
+}
+
+// The parameters of the callee get the arguments as promoted variables. A
+// return writes its value into the symbol of the callee and branches to the
+// block after the body, which reads it.
+CodeGenerator::IrNode CodeGenerator::inline_call(
+    symtab::FunctionSymbol &func, const std::vector<IrNode> &args) {
+    auto &definition = *definitions_.at(&func);
+    const auto &cost = inline_costs_.at(&definition);
+    if (options_.inline_report_ != nullptr) {
+        *options_.inline_report_
+            << current_func_->get_name() << ": inlined " << func.get_name()
+            << " (cost " << cost.size_ << ")\n";
+    }
+
+    auto params = func.get_params();
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        auto *param = dynamic_cast<symtab::VariableSymbol *>(params[i]);
+        cgs_alc_[param].type_ = get_ir_type(param->get_type());
+        ssa_.write_variable(param, ssa_.get_current_block(), args[i].name_);
+    }
+
+    const auto &actions = definition.actions();
+    const ReturnStatement *tail = nullptr;
+    if (cost.returns_ == 1 && !actions.empty()) {
+        tail = dynamic_cast<ReturnStatement *>(actions.back());
+    }
+    inlines_.push_back(
+        {&func, tail == nullptr ? "block" + std::to_string(block_num_++) : "",
+         tail, {}});
+    count_profile(0);
+
+    // The body has its own scopes and loops
+    std::vector<Loop> outer_loops;
+    outer_loops.swap(loops_);
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+    bool prev_rvalue_oper = is_rvalue_oper_;
+    is_rvalue_oper_ = false;
+    bool prev_rel_op_last = is_rel_op_last_;
+    scopes_.push(&func);
+
+    for (auto *action : actions) {
+        action->accept(*this);
+    }
+
+    scopes_.pop();
+    is_rel_op_last_ = prev_rel_op_last;
+    is_rvalue_oper_ = prev_rvalue_oper;
+    scope_order_ = prev_scope_order;
+    loops_.swap(outer_loops);
+
+    auto inlined = std::move(inlines_.back());
+    inlines_.pop_back();
+    if (tail != nullptr) {
+        return std::move(inlined.value_);
+    }
+
+    if (!is_unreachable_block()) {
+        branch(inlined.exit_);
+    }
+    ir_ << "\n";
+    start_block(inlined.exit_);
+    seal_block(inlined.exit_);
+
+    const auto &type = cgs_alc_[&func].type_;
+    if (type == "void") {
+        return {};
+    }
+    return {ssa_.read_variable(&func, type, ssa_.get_current_block()), type};
+}
+
+void CodeGenerator::return_inlined(ReturnStatement &node) {
+    auto &inlined = inlines_.back();
+    convert(node.value(), ir_buf_, cgs_alc_[inlined.func_].type_);
+    if (&node == inlined.tail_) {
+        inlined.value_ = std::move(ir_buf_);
+        return;
+    }
+
+    ssa_.write_variable(
+        inlined.func_, ssa_.get_current_block(), ir_buf_.name_);
+    branch(inlined.exit_);
+    start_unreachable_block();
+}
+
+// Leaves the i1 value of the condition in ir_buf_
+void CodeGenerator::emit_condition(Node *truth_value) {
+    is_rel_op_last_ = false;
+    truth_value->accept(*this);
+    if (is_rel_op_last_) {
+        return;
+    }
+
+    std::string tmp_name = "%tmp" + std::to_string(tmp_num_++);
+    std::string cmp;
+    std::string zero;
+    if (program_.get_expression_type(truth_value).type_.is_floating()) {
+        cmp = "fcmp une";
+        zero = "0.0";
+    } else {
+        cmp = "icmp ne";
+        zero = "0";
+    }
+
+    ir_ << "\t" << tmp_name << " = " << cmp << " " << ir_buf_.type_ << " "
+        << ir_buf_.name_ << ", " << zero << "\n";
+
+    ir_buf_.name_ = std::move(tmp_name);
+    ir_buf_.type_ = "i1";
+}
+
+// A loop without a condition runs until a break. The guard of a rotated
+// loop also counts its evaluations and the times it enters the loop, the
+// branch isn't in a block of its own, so the condition is added.
+void CodeGenerator::loop_condition(
+    ForStatement &node,
+    const std::string &scope,
+    const std::string &skip,
+    const std::string &weights,
+    const std::string &metadata,
+    bool is_guard) {
+    if (node.truth_value() == nullptr) {
+        branch(scope);
+        return;
+    }
+    emit_condition(node.truth_value());
+    count_profile(get_profile_site(&node));
+    if (is_guard && !options_.profile_generate_.empty()) {
+        const auto guard_site = get_profile_site(node.truth_value());
+        auto taken = "%tmp" + std::to_string(tmp_num_++);
+        ir_ << "\t" << taken << " = zext i1 " << ir_buf_.name_
+            << " to i64\n";
+        count_profile(guard_site);
+        count_profile(guard_site + 1, taken);
+    }
+    cond_branch(ir_buf_.name_, scope, skip, weights, metadata);
+}
+
+namespace {
+
+// The weights LLVM gives to the branches on __builtin_expect
+const std::pair<int, int> c_expected_weights{2000, 1};
+// The weights of the loop branch and the return heuristics of Ball and
+// Larus in the branch probability analysis of LLVM
+const std::pair<int, int> c_heuristic_weights{124, 4};
+
+// The constant c of a condition __builtin_expect(exp, c)
+std::optional<std::int64_t> get_expected_value(const Node *truth_value) {
+    const auto *call = dynamic_cast<const FunctionCall *>(truth_value);
+    if (call == nullptr || call->id() != "__builtin_expect") {
+        return std::nullopt;
+    }
+    const auto *literal = dynamic_cast<const IntegerLiteral *>(call->args()[1]);
+    if (literal == nullptr) {
+        return std::nullopt;
+    }
+    const auto &text = literal->integer();
+    std::int64_t value = 0;
+    auto [ptr, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+} // namespace
+
+// The !prof metadata of a branch on the condition of the statement. The
+// counts of the profile go before the expected value and the heuristics.
+// The latch of a rotated loop gets the counts of the statement without
+// the ones of its guard.
+std::string CodeGenerator::get_branch_weights(
+    const Node *statement,
+    const Node *truth_value,
+    BranchHint hint,
+    const Node *guard) {
+    if (truth_value == nullptr) {
+        return "";
+    }
+    if (auto counts = get_profile_counts(statement)) {
+        auto [evaluations, taken] = *counts;
+        auto guard_counts =
+            guard != nullptr ? get_profile_counts(guard) : std::nullopt;
+        if (guard_counts && guard_counts->first <= evaluations &&
+            guard_counts->second <= taken) {
+            evaluations -= guard_counts->first;
+            taken -= guard_counts->second;
+        }
+        if (evaluations > 0 && taken <= evaluations) {
+            return make_branch_weights(taken, evaluations - taken);
+        }
+    }
+    if (!options_.branch_weights_) {
+        return "";
+    }
+    std::pair<int, int> weights;
+    if (auto expected = get_expected_value(truth_value)) {
+        weights = c_expected_weights;
+        if (*expected == 0) {
+            std::swap(weights.first, weights.second);
+        }
+    } else if (hint != BranchHint::none) {
+        weights = c_heuristic_weights;
+        if (hint == BranchHint::unlikely) {
+            std::swap(weights.first, weights.second);
+        }
+    } else {
+        return "";
+    }
+    return make_branch_weights(weights.first, weights.second);
+}
+
+// The weights of the true and the false targets, they are i32
+std::string CodeGenerator::make_branch_weights(
+    std::uint64_t taken, std::uint64_t other) {
+    while (taken > std::numeric_limits<std::uint32_t>::max() ||
+           other > std::numeric_limits<std::uint32_t>::max()) {
+        taken >>= 1U;
+        other >>= 1U;
+    }
+    auto key = "i32 " + std::to_string(taken) + ", i32 " +
+        std::to_string(other);
+    auto [it, is_new] = branch_weights_.try_emplace(key);
+    if (is_new) {
+        it->second = "!" + std::to_string(metadata_num_++);
+        metadata_ << it->second << " = !{!\"branch_weights\", " << key
+                  << "}\n";
+    }
+    return it->second;
+}
+
+// The statements of an inlined body are counted for the function they are
+// written in
+const std::string &CodeGenerator::get_profiled_func() const {
+    return inlines_.empty() ? current_func_->get_name()
+                            : inlines_.back().func_->get_name();
+}
+
+// Counter 0 of a function counts its calls
+std::size_t &CodeGenerator::get_profile_size(const std::string &func) {
+    auto [it, is_new] = profile_sizes_.try_emplace(func, 1);
+    if (is_new) {
+        profiled_funcs_.push_back(func);
+    }
+    return it->second;
+}
+
+// The counters of the statement: the evaluations of its condition and the
+// entries into its body
+std::size_t CodeGenerator::get_profile_site(const Node *statement) {
+    if (options_.profile_generate_.empty() &&
+        options_.profile_use_ == nullptr) {
+        return 0;
+    }
+    auto [it, is_new] = profile_sites_.try_emplace(statement);
+    if (is_new) {
+        auto &size = get_profile_size(get_profiled_func());
+        it->second = size;
+        size += 2;
+    }
+    return it->second;
+}
+
+// The evaluations of the condition of the statement and the times it was
+// true in the profile
+std::optional<std::pair<std::uint64_t, std::uint64_t>>
+CodeGenerator::get_profile_counts(const Node *statement) {
+    if (options_.profile_use_ == nullptr) {
+        return std::nullopt;
+    }
+    const auto site = get_profile_site(statement);
+    auto it = options_.profile_use_->find(get_profiled_func());
+    if (it == options_.profile_use_->end() || site + 1 >= it->second.size()) {
+        return std::nullopt;
+    }
+    return std::make_pair(it->second[site], it->second[site + 1]);
+}
+
+void CodeGenerator::count_profile(
+    std::size_t counter, const std::string &step) {
+    if (options_.profile_generate_.empty()) {
+        return;
+    }
+    const auto &func = get_profiled_func();
+    get_profile_size(func);
+    auto global = "@__prof." + func + "." + std::to_string(counter);
+    auto count = "%tmp" + std::to_string(tmp_num_++);
+    auto sum = "%tmp" + std::to_string(tmp_num_++);
+    ir_ << "\t" << count << " = load i64, i64* " << global << "\n"
+        << "\t" << sum << " = add i64 " << count << ", " << step << "\n"
+        << "\tstore i64 " << sum << ", i64* " << global << "\n";
+}
+
+// A function never called in the profiled runs is cold, the ones called at
+// least a tenth as often as the most called one are hot
+std::string CodeGenerator::get_profile_attributes(
+    const symtab::FunctionSymbol &func) {
+    if (options_.profile_use_ == nullptr) {
+        return "";
+    }
+    auto it = options_.profile_use_->find(func.get_name());
+    if (it == options_.profile_use_->end() || it->second.empty()) {
+        return "";
+    }
+    if (max_entry_count_ == 0) {
+        for (const auto &[name, counts] : *options_.profile_use_) {
+            if (!counts.empty()) {
+                max_entry_count_ = std::max(max_entry_count_, counts[0]);
+            }
+        }
+    }
+
+    const auto entries = it->second[0];
+    std::string attributes;
+    if (entries == 0) {
+        attributes = " cold";
+    } else if (entries >= max_entry_count_ / 10) {
+        attributes = " hot";
+    }
+    auto metadata = "!" + std::to_string(metadata_num_++);
+    metadata_ << metadata << " = !{!\"function_entry_count\", i64 " << entries
+              << "}\n";
+    return attributes + " !prof " + metadata;
+}
+
+// The counters are written by a destructor of the module, so the program
+// appends a line per function to the file however main returns
+void CodeGenerator::print_profile_writer() {
+    if (options_.profile_generate_.empty()) {
+        return;
+    }
+    for (const auto &func : profiled_funcs_) {
+        for (std::size_t i = 0; i < profile_sizes_.at(func); ++i) {
+            out_ << "@__prof." << func << "." << i
+                 << " = internal global i64 0\n";
+        }
+    }
+    const std::string mode = "a";
+    detail::StringPool::print_constant(
+        out_, "@__prof.path", options_.profile_generate_);
+    detail::StringPool::print_constant(out_, "@__prof.mode", mode);
+    std::vector<std::string> formats;
+    for (const auto &func : profiled_funcs_) {
+        std::string format = func;
+        for (std::size_t i = 0; i < profile_sizes_.at(func); ++i) {
+            format += " %lu";
+        }
+        formats.push_back(format + "\n");
+        detail::StringPool::print_constant(
+            out_, "@__prof.format." + func, formats.back());
+    }
+
+    out_ << "\ndeclare i8* @fopen(i8*, i8*)\n"
+         << "declare i32 @fprintf(i8*, i8*, ...)\n"
+         << "declare i32 @fclose(i8*)\n\n"
+         << "define internal void @__prof.write() {\n"
+         << "entry:\n"
+         << "\t%file = call i8* @fopen(i8* "
+         << detail::StringPool::get_constant_pointer(
+                "@__prof.path", options_.profile_generate_)
+         << ", i8* "
+         << detail::StringPool::get_constant_pointer("@__prof.mode", mode)
+         << ")\n"
+         << "\t%is_null = icmp eq i8* %file, null\n"
+         << "\tbr i1 %is_null, label %exit, label %write\n\n"
+         << "write:\n";
+    for (std::size_t f = 0; f < profiled_funcs_.size(); ++f) {
+        const auto &func = profiled_funcs_[f];
+        const auto size = profile_sizes_.at(func);
+        for (std::size_t i = 0; i < size; ++i) {
+            out_ << "\t%" << func << "." << i << " = load i64, i64* @__prof."
+                 << func << "." << i << "\n";
+        }
+        out_ << "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* "
+             << detail::StringPool::get_constant_pointer(
+                    "@__prof.format." + func, formats[f]);
+        for (std::size_t i = 0; i < size; ++i) {
+            out_ << ", i64 %" << func << "." << i;
+        }
+        out_ << ")\n";
+    }
+    out_ << "\tcall i32 @fclose(i8* %file)\n"
+         << "\tbr label %exit\n\n"
+         << "exit:\n"
+         << "\tret void\n"
+         << "}\n\n";
+    destructors_.emplace_back("@__prof.write");
+}
+
+void CodeGenerator::instrument_entry() {
+    if (options_.instrument_functions_.empty()) {
+        return;
+    }
+    entry_cycles_ = "%tmp" + std::to_string(tmp_num_++);
+    ir_ << "\t" << entry_cycles_ << " = call i64 @__instr.enter(i64 "
+        << instrumented_funcs_.size() << ")\n";
+    instrumented_funcs_.push_back(current_func_->get_name());
+}
+
+void CodeGenerator::instrument_exit() {
+    if (options_.instrument_functions_.empty()) {
+        return;
+    }
+    // Nothing is inlined, so the current function is the last one entered
+    ir_ << "\tcall void @__instr.exit(i64 " << instrumented_funcs_.size() - 1
+        << ", i64 " << entry_cycles_ << ")\n";
+}
+
+// The runtime of the instrumented functions. The calls into it are inlined
+// even without optimization, so the cost of a call is a couple of counter
+// updates and two reads of the time stamp counter. A recursive function is
+// timed from its outermost call, its nested calls are counted only.
+void CodeGenerator::print_instrumentation() {
+    if (options_.instrument_functions_.empty()) {
+        return;
+    }
+    const auto table = "[" + std::to_string(instrumented_funcs_.size()) +
+        " x i64]";
+    auto get_element = [&table](const std::string &name,
+                                const std::string &index) {
+        return "getelementptr " + table + ", " + table + "* " + name +
+            ", i64 0, i64 " + index;
+    };
+    auto get_constant_element = [&table](const std::string &name,
+                                         std::size_t index) {
+        return "getelementptr (" + table + ", " + table + "* " + name +
+            ", i64 0, i64 " + std::to_string(index) + ")";
+    };
+
+    for (const auto *name : {"calls", "cycles", "depths"}) {
+        out_ << "@__instr." << name << " = internal global " << table
+             << " zeroinitializer\n";
+    }
+    const std::string mode = "w";
+    const std::string header = "     %%time       cycles      calls  "
+                               "cycles/call  name\n";
+    detail::StringPool::print_constant(
+        out_, "@__instr.path", options_.instrument_functions_);
+    detail::StringPool::print_constant(out_, "@__instr.mode", mode);
+    detail::StringPool::print_constant(out_, "@__instr.header", header);
+    std::vector<std::string> formats;
+    for (const auto &func : instrumented_funcs_) {
+        formats.push_back("%10.2f %12lu %10lu %12lu  " + func + "\n");
+        detail::StringPool::print_constant(
+            out_, "@__instr.format." + func, formats.back());
+    }
+
+    out_ << "\ndeclare i64 @llvm.readcyclecounter()\n";
+    if (options_.profile_generate_.empty()) {
+        out_ << "declare i8* @fopen(i8*, i8*)\n"
+             << "declare i32 @fprintf(i8*, i8*, ...)\n"
+             << "declare i32 @fclose(i8*)\n";
+    }
+
+    out_ << "\ndefine internal i64 @__instr.enter(i64 %func) alwaysinline "
+            "nounwind {\n"
+         << "entry:\n"
+         << "\t%depth = " << get_element("@__instr.depths", "%func") << "\n"
+         << "\t%outer = load i64, i64* %depth\n"
+         << "\t%inner = add i64 %outer, 1\n"
+         << "\tstore i64 %inner, i64* %depth\n"
+         << "\t%start = call i64 @llvm.readcyclecounter()\n"
+         << "\tret i64 %start\n"
+         << "}\n\n";
+
+    out_ << "define internal void @__instr.exit(i64 %func, i64 %start) "
+            "alwaysinline nounwind {\n"
+         << "entry:\n"
+         << "\t%end = call i64 @llvm.readcyclecounter()\n"
+         << "\t%calls = " << get_element("@__instr.calls", "%func") << "\n"
+         << "\t%count = load i64, i64* %calls\n"
+         << "\t%next = add i64 %count, 1\n"
+         << "\tstore i64 %next, i64* %calls\n"
+         << "\t%depth = " << get_element("@__instr.depths", "%func") << "\n"
+         << "\t%inner = load i64, i64* %depth\n"
+         << "\t%outer = sub i64 %inner, 1\n"
+         << "\tstore i64 %outer, i64* %depth\n"
+         << "\t%is_outermost = icmp eq i64 %outer, 0\n"
+         << "\tbr i1 %is_outermost, label %time, label %exit\n\n"
+         << "time:\n"
+         << "\t%cycles = " << get_element("@__instr.cycles", "%func") << "\n"
+         << "\t%total = load i64, i64* %cycles\n"
+         << "\t%elapsed = sub i64 %end, %start\n"
+         << "\t%sum = add i64 %total, %elapsed\n"
+         << "\tstore i64 %sum, i64* %cycles\n"
+         << "\tbr label %exit\n\n"
+         << "exit:\n"
+         << "\tret void\n"
+         << "}\n\n";
+
+    // The times are inclusive, so the shares are of the longest function,
+    // main if it has returned
+    out_ << "define internal void @__instr.write() {\n"
+         << "entry:\n"
+         << "\t%file = call i8* @fopen(i8* "
+         << detail::StringPool::get_constant_pointer(
+                "@__instr.path", options_.instrument_functions_)
+         << ", i8* "
+         << detail::StringPool::get_constant_pointer("@__instr.mode", mode)
+         << ")\n"
+         << "\t%is_null = icmp eq i8* %file, null\n"
+         << "\tbr i1 %is_null, label %exit, label %write\n\n"
+         << "write:\n";
+    std::string longest = "1";
+    for (std::size_t i = 0; i < instrumented_funcs_.size(); ++i) {
+        const auto n = std::to_string(i);
+        out_ << "\t%cycles." << n << " = load i64, i64* "
+             << get_constant_element("@__instr.cycles", i) << "\n"
+             << "\t%calls." << n << " = load i64, i64* "
+             << get_constant_element("@__instr.calls", i) << "\n"
+             << "\t%is_longer." << n << " = icmp ugt i64 %cycles." << n
+             << ", " << longest << "\n"
+             << "\t%longest." << n << " = select i1 %is_longer." << n
+             << ", i64 %cycles." << n << ", i64 " << longest << "\n";
+        longest = "%longest." + n;
+    }
+    out_ << "\t%longest = uitofp i64 " << longest << " to double\n"
+         << "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* "
+         << detail::StringPool::get_constant_pointer("@__instr.header", header)
+         << ")\n";
+    for (std::size_t i = 0; i < instrumented_funcs_.size(); ++i) {
+        const auto n = std::to_string(i);
+        out_ << "\t%cycles.f." << n << " = uitofp i64 %cycles." << n
+             << " to double\n"
+             << "\t%percent." << n << " = fmul double %cycles.f." << n
+             << ", 100.0\n"
+             << "\t%share." << n << " = fdiv double %percent." << n
+             << ", %longest\n"
+             << "\t%is_called." << n << " = icmp ne i64 %calls." << n
+             << ", 0\n"
+             << "\t%divisor." << n << " = select i1 %is_called." << n
+             << ", i64 %calls." << n << ", i64 1\n"
+             << "\t%per_call." << n << " = udiv i64 %cycles." << n
+             << ", %divisor." << n << "\n"
+             << "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* "
+             << detail::StringPool::get_constant_pointer(
+                    "@__instr.format." + instrumented_funcs_[i], formats[i])
+             << ", double %share." << n << ", i64 %cycles." << n << ", i64 "
+             << "%calls." << n << ", i64 %per_call." << n << ")\n";
+    }
+    out_ << "\tcall i32 @fclose(i8* %file)\n"
+         << "\tbr label %exit\n\n"
+         << "exit:\n"
+         << "\tret void\n"
+         << "}\n\n";
+    destructors_.emplace_back("@__instr.write");
+}
+
+void CodeGenerator::print_destructors() {
+    if (destructors_.empty()) {
+        return;
+    }
+    const auto type = "[" + std::to_string(destructors_.size()) +
+        " x { i32, void ()*, i8* }]";
+    out_ << "@llvm.global_dtors = appending global " << type << " [";
+    for (std::size_t i = 0; i < destructors_.size(); ++i) {
+        out_ << (i == 0 ? "" : ", ") << "{ i32, void ()*, i8* } { i32 65535, "
+             << "void ()* " << destructors_[i] << ", i8* null }";
+    }
+    out_ << "]\n\n";
+}
+
+namespace {
+
+bool is_constant_expression(const Node *node) {
+    if (dynamic_cast<const IntegerLiteral *>(node) != nullptr) {
+        return true;
+    }
+    const auto *operation = dynamic_cast<const RvalueOperation *>(node);
+    if (operation == nullptr) {
+        return false;
+    }
+    return std::all_of(
+        operation->rpn().begin(), operation->rpn().end(), [](const Node *n) {
+            return dynamic_cast<const IntegerLiteral *>(n) != nullptr ||
+                dynamic_cast<const ArithmeticOperator *>(n) != nullptr ||
+                dynamic_cast<const RelationalOperator *>(n) != nullptr;
+        });
+}
+
+} // namespace
+
+// C11 6.8.5p6: a loop whose condition isn't a constant expression may be
+// assumed to terminate if its body has no side effects, so LLVM may delete
+// it. The loops like for (;;) are left without metadata.
+std::string CodeGenerator::get_loop_metadata(const ForStatement &node) {
+    if (node.truth_value() == nullptr ||
+        is_constant_expression(node.truth_value())) {
+        return "";
+    }
+    if (mustprogress_.empty()) {
+        mustprogress_ = "!" + std::to_string(metadata_num_++);
+        metadata_ << mustprogress_ << " = !{!\"llvm.loop.mustprogress\"}\n";
+    }
+    auto name = "!" + std::to_string(metadata_num_++);
+    metadata_ << name << " = distinct !{" << name << ", " << mustprogress_
+              << "}\n";
+    return name;
+}
+
+// Signed overflow of the int counter is undefined, so its i64 copy stepped
+// in nsw is equal to the sign extended counter in every iteration
+symtab::VariableSymbol *CodeGenerator::widen_counter(ForStatement &node) {
+    if (!options_.optimize_indexing_ || !options_.promote_scalars_) {
+        return nullptr;
+    }
+    auto counter = detail::LoopWritesCollector::find_induction_variable(node);
+    if (!counter) {
+        return nullptr;
+    }
+    auto *var = get_varsym(counter->name_);
+    if (!is_promoted(var) || cgs_alc_[var].type_ != "i32") {
+        return nullptr;
+    }
+
+    wide_vars_.push_back(
+        std::make_unique<symtab::VariableSymbol>(var->get_name() + ".wide"));
+    const auto *wide = wide_vars_.back().get();
+    wide_counters_.insert_or_assign(var, WideCounter{wide, counter->step_});
+
+    IrNode value(read_promoted(var), "i32");
+    emit_conversion(Conversion::sign_extend, value, "i64");
+    ssa_.write_variable(wide, ssa_.get_current_block(), value.name_);
+    return var;
+}
+
+void CodeGenerator::step_wide_counter(const symtab::VariableSymbol *var) {
+    const auto &counter = wide_counters_.at(var);
+    auto value =
+        ssa_.read_variable(counter.var_, "i64", ssa_.get_current_block());
+    auto next = "%tmp" + std::to_string(tmp_num_++);
+    ir_ << "\t" << next << " = add nsw i64 " << value << ", " << counter.step_
+        << "\n";
+    ssa_.write_variable(counter.var_, ssa_.get_current_block(), next);
+}
+
+// The copy of the counter if the index is the counter itself
+std::optional<std::string> CodeGenerator::read_wide_counter(Node *idx) {
+    auto *access = dynamic_cast<VariableAccess *>(idx);
+    if (access == nullptr || wide_counters_.empty()) {
+        return std::nullopt;
+    }
+    auto it = wide_counters_.find(get_varsym(access->id()));
+    if (it == wide_counters_.end()) {
+        return std::nullopt;
+    }
+    return ssa_.read_variable(
+        it->second.var_, "i64", ssa_.get_current_block());
+}
+
+// The condition runs at least once, so the call is evaluated in the
+// preheader where the first evaluation would be
+void CodeGenerator::hoist_invariant_calls(
+    ForStatement &node, const detail::LoopWrites &writes) {
+    auto *condition = dynamic_cast<RvalueOperation *>(node.truth_value());
+    if (condition == nullptr) {
+        return;
+    }
+
+    bool prev_rvalue_oper = is_rvalue_oper_;
+    for (auto *value : condition->rpn()) {
+        auto *call = dynamic_cast<FunctionCall *>(value);
+        if (call == nullptr || call->id() == "printf" ||
+            call->id() == "__builtin_expect") {
+            continue;
+        }
+        const auto &effects = get_funcsym(call->id())->get_effects();
+        if (!effects.is_readonly() ||
+            (effects.reads_memory_ && is_writing_memory(writes))) {
+            continue;
+        }
+        bool is_invariant = true;
+        for (auto *arg : call->args()) {
+            is_invariant = is_invariant &&
+                detail::LoopWritesCollector::is_invariant(arg, writes);
+        }
+        if (!is_invariant) {
+            continue;
+        }
+
+        is_rvalue_oper_ = false;
+        call->accept(*this);
+        // An inlined body is emitted again for every call
+        hoisted_calls_.insert_or_assign(call, std::move(ir_buf_));
+    }
+    is_rvalue_oper_ = prev_rvalue_oper;
+}
+
+bool CodeGenerator::is_writing_memory(const detail::LoopWrites &writes) {
+    if (writes.writes_memory_) {
+        return true;
+    }
+    for (const auto &callee : writes.callees_) {
+        if (callee != "printf" && callee != "__builtin_expect" &&
+            get_funcsym(callee)->get_effects().writes_memory_) {
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+
+std::size_t get_type_size(const std::string &type) {
+    if (type.back() == '*' || type == "double") {
+        return 8;
+    }
+    if (type == "float") {
+        return 4;
+    }
+    return std::stoul(type.substr(1)) / 8;
+}
+
+std::optional<std::size_t> get_count(const std::string &value) {
+    std::size_t count = 0;
+    const auto *end = value.data() + value.size();
+    auto [ptr, ec] = std::from_chars(value.data(), end, count);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return count;
+}
+
+} // namespace
+
+// An alloca outside of the entry block takes new stack space every time it
+// runs, so in a loop the stack grows with every iteration
+void CodeGenerator::emit_alloca(
+    const std::string &name,
+    const std::string &type,
+    const std::string &count) {
+    auto instruction = name + " = alloca " + type;
+    if (!count.empty()) {
+        instruction += ", i64 " + count;
+    }
+    if (!options_.hoist_allocas_) {
+        ir_ << "\t" << instruction << "\n";
+        return;
+    }
+
+    auto size = get_type_size(type);
+    if (!count.empty()) {
+        auto elements = get_count(count);
+        if (!elements) {
+            auto saved = "%tmp" + std::to_string(tmp_num_++);
+            ir_ << "\t" << saved << " = call i8* @llvm.stacksave()\n";
+            ir_ << "\t" << instruction << "\n";
+            slots_.back().push_back({std::move(saved), 0});
+            uses_stacksave_ = true;
+            return;
+        }
+        size *= *elements;
+    }
+
+    allocas_ << "\t" << instruction << "\n";
+    auto pointer = name;
+    if (type != "i8") {
+        pointer = "%tmp" + std::to_string(tmp_num_++);
+        allocas_ << "\t" << pointer << " = bitcast " << type << "* " << name
+                 << " to i8*\n";
+    }
+    ir_ << "\t"
+        << "call void @llvm.lifetime.start.p0i8(i64 " << size << ", i8* "
+        << pointer << ")\n";
+    slots_.back().push_back({std::move(pointer), size});
+    uses_lifetimes_ = true;
+}
+
+void CodeGenerator::enter_scope() {
+    slots_.emplace_back();
+}
+
+void CodeGenerator::leave_scope() {
+    end_slots(slots_.size() - 1);
+    slots_.pop_back();
+}
+
+// Ends the slots of the scopes from the depth on, the last declared first.
+// A return leaves them all, the function has no stack after it.
+void CodeGenerator::end_slots(std::size_t depth) {
+    for (auto scope = slots_.size(); scope > depth; --scope) {
+        const auto &slots = slots_[scope - 1];
+        for (auto it = slots.rbegin(); it != slots.rend(); ++it) {
+            if (it->size_ == 0) {
+                ir_ << "\t"
+                    << "call void @llvm.stackrestore(i8* " << it->pointer_
+                    << ")\n";
+                continue;
+            }
+            ir_ << "\t"
+                << "call void @llvm.lifetime.end.p0i8(i64 " << it->size_
+                << ", i8* " << it->pointer_ << ")\n";
+        }
+    }
+}
+
+void CodeGenerator::print_intrinsics() {
+    if (uses_lifetimes_) {
+        out_ << "declare void @llvm.lifetime.start.p0i8(i64 immarg, i8* "
+                "nocapture)\n"
+             << "declare void @llvm.lifetime.end.p0i8(i64 immarg, i8* "
+                "nocapture)\n";
+    }
+    if (uses_stacksave_) {
+        out_ << "declare i8* @llvm.stacksave()\n"
+             << "declare void @llvm.stackrestore(i8*)\n";
+    }
+    if (uses_expect_) {
+        out_ << "declare i64 @llvm.expect.i64(i64, i64)\n";
+    }
+    if (uses_lifetimes_ || uses_stacksave_ || uses_expect_) {
+        out_ << "\n";
+    }
+}
+
+void CodeGenerator::start_block(const std::string &label) {
+    block_consts_.clear();
+    block_pointers_.clear();
+    block_values_.clear();
+    auto label_pos = static_cast<std::size_t>(ir_.tellp());
+    ir_ << label << ":\n";
+    ssa_.start_block(ssa_.get_block(label), label_pos);
+}
+
+// Code after a terminator gets a block of its own, so the SSA construction
+// sees its branches and the simplification drops it. Otherwise LLVM makes
+// such blocks implicitly.
+void CodeGenerator::start_unreachable_block() {
+    if (!options_.promote_scalars_ && !options_.simplify_cfg_) {
+        return;
+    }
+    auto label = "block" + std::to_string(block_num_++);
+    start_block(label);
+    seal_block(label);
+}
+
+// The block after a terminator that nothing branches to
+bool CodeGenerator::is_unreachable_block() {
+    auto block = ssa_.get_current_block();
+    return block != ssa_.get_block("entry") && !ssa_.has_preds(block);
+}
+
+void CodeGenerator::seal_block(const std::string &label) {
+    ssa_.seal_block(ssa_.get_block(label));
+}
+
+// The branches of the unreachable code are left out of the graph, so the
+// phis get no operands from it
+void CodeGenerator::branch(const std::string &label) {
+    auto target = ssa_.get_block(label);
+    if (!options_.simplify_cfg_ || !is_unreachable_block()) {
+        ssa_.add_jump(
+            ssa_.get_current_block(), target,
+            static_cast<std::size_t>(ir_.tellp()));
+    }
+    ir_ << "\t"
+        << "br label %" << label << "\n";
+}
+
+void CodeGenerator::cond_branch(
+    const std::string &cond,
+    const std::string &if_true,
+    const std::string &if_false,
+    const std::string &weights,
+    const std::string &metadata) {
+    auto true_target = ssa_.get_block(if_true);
+    auto false_target = ssa_.get_block(if_false);
+    if (!options_.simplify_cfg_ || !is_unreachable_block()) {
+        ssa_.add_edge(ssa_.get_current_block(), true_target);
+        ssa_.add_edge(ssa_.get_current_block(), false_target);
+    }
+    ir_ << "\t"
+        << "br i1 " << cond << ", label %" << if_true << ", label %" << if_false;
+    if (!weights.empty()) {
+        ir_ << ", !prof " << weights;
+    }
+    if (!metadata.empty()) {
+        ir_ << ", !llvm.loop " << metadata;
+    }
+    ir_ << "\n";
+}
+
+// DeclareStr
+
+std::unordered_map<const StringLiteral *, std::string> DeclareStr::exec(
+    std::ostream &os, Program &program) {
+    DeclareStr declare_str(os);
+    declare_str.ir_ << "target triple = \"x86_64-pc-linux-gnu\"\n\n";
+    for (auto *child : program.get_childs()) {
+        child->accept(declare_str);
+    }
+    if (declare_str.is_printf_exist_) {
+        declare_str.ir_ << "declare i32 @printf(i8*, ...)\n\n";
+    }
+    declare_str.pool_.build();
+    declare_str.pool_.print(declare_str.ir_);
+    declare_str.ir_ << "\n";
+
+    std::unordered_map<const StringLiteral *, std::string> pointers;
+    for (auto [literal, content] : declare_str.contents_) {
+        pointers.emplace(literal, declare_str.pool_.get_pointer(content));
+    }
+    return pointers;
+}
+
+void DeclareStr::visit(FunctionDefinition &node) {
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeclareStr::visit(LocalScope &node) {
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeclareStr::visit(Expression &node) {
+    node.expression()->accept(*this);
+}
+
+void DeclareStr::visit(FunctionCall &node) {
+    if (node.id() == "printf") {
+        is_printf_exist_ = true;
+    }
+    for (auto *arg : node.args()) {
+        arg->accept(*this);
+    }
+}
+
+void DeclareStr::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void DeclareStr::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+void DeclareStr::visit(ForStatement &node) {
+    if (node.for_data_using() != nullptr) {
+        node.for_data_using()->accept(*this);
+    }
+
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(*this);
+    }
+
+    if (node.value() != nullptr) {
+        node.value()->accept(*this);
+    }
+
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeclareStr::visit(IfStatement &node) {
+    node.truth_value()->accept(*this);
+
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeclareStr::visit(VariableInit &node) {
+    node.value()->accept(*this);
+}
+
+void DeclareStr::visit(ReturnStatement &node) {
+    node.value()->accept(*this);
+}
+
+void DeclareStr::visit(Assignment &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void DeclareStr::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void DeclareStr::visit(StringLiteral &node) {
+    contents_.emplace(&node, pool_.add(node.string()));
 }
 
 } // namespace c::ast
\ No newline at end of file
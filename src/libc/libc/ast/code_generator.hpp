@@ -1,14 +1,89 @@
 #pragma once
 
+#include <libc/ast/detail/inline_cost.hpp>
+#include <libc/ast/detail/loop_writes.hpp>
+#include <libc/ast/detail/ssa_builder.hpp>
+#include <libc/ast/detail/string_pool.hpp>
 #include <libc/ast/symtab/symtab.hpp>
 #include <libc/ast/visitor.hpp>
+#include <libc/profile.hpp>
+#include <libc/time_report.hpp>
 
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <ostream>
+#include <sstream>
 #include <stack>
 #include <unordered_map>
+#include <vector>
 
 namespace c::ast {
 
+struct CodeGenOptions {
+    // Keeps scalar variables in virtual registers with phis at the joins
+    // instead of allocas (mem2reg)
+    bool promote_scalars_{false};
+    // Evaluates operators on integer constants at compile time and forwards
+    // the constants stored into variables to the loads of the same block
+    bool fold_constants_{false};
+    // Calls a read-only function in a loop condition once before the loop if
+    // the loop doesn't change its arguments and the memory it reads
+    bool hoist_invariant_calls_{false};
+    // Gives internal linkage to every function but main and the exported
+    // ones, the module is the whole program
+    bool internalize_{false};
+    // Functions called from outside of the module besides main
+    std::vector<std::string> exported_;
+    // Marks the functions and their pointer parameters with the attributes
+    // that the effect analysis proves
+    bool infer_attributes_{false};
+    // Emits the bodies of the non-recursive functions of at most this size
+    // in place of their calls, 0 turns the inliner off. The parameters of an
+    // inlined body become registers, so it needs promote_scalars_.
+    std::size_t inline_threshold_{0};
+    // Gets a line for every inlined call
+    std::ostream *inline_report_{nullptr};
+    // Drops the code after the terminators, bypasses the blocks that only
+    // branch on and merges the blocks into their only predecessors
+    bool simplify_cfg_{false};
+    // Emits a loop as a guarded do-while: the condition is checked before
+    // the first iteration and again at the bottom of the body. The loops
+    // with a non-constant condition are marked as mustprogress.
+    bool rotate_loops_{false};
+    // Allocates the fixed-size locals in the entry block and starts and ends
+    // their lifetimes with their scopes. Only the variable length arrays are
+    // allocated at their declarations, between stacksave and stackrestore.
+    bool hoist_allocas_{false};
+    // Indexes arrays by i64 copies of the loop counters instead of sign
+    // extending them at every access, with getelementptr inbounds and the
+    // pointers loaded once per block. The copies need promote_scalars_.
+    bool optimize_indexing_{false};
+    // Reuses the values the block has computed already: the same operation
+    // on the same operands, the loads of the memory stored to or loaded
+    // before in the block and the calls of the read-only functions
+    bool number_values_{false};
+    // Multiplies, divides and takes the remainders by integer constants with
+    // shifts, masks and multiplications by magic numbers, and drops the
+    // operations by the identities
+    bool reduce_strength_{false};
+    // Attaches branch weights to the conditional branches: the ones given by
+    // __builtin_expect, otherwise the loops likely iterate again and the ifs
+    // likely skip the bodies that return
+    bool branch_weights_{false};
+    // Counts the calls of the functions and the outcomes of the conditions
+    // of the ifs and loops, every run of the program appends the counts to
+    // this file at exit
+    std::string profile_generate_;
+    // Counts of the previous runs: exact branch weights, the entry counts
+    // of the functions and hot and cold attributes
+    const Profile *profile_use_{nullptr};
+    // Counts the calls of every function and the cycles spent in it, the
+    // flat profile is written to this file at exit. The functions aren't
+    // inlined then.
+    std::string instrument_functions_;
+};
+
 class CodeGenerator final : public Visitor {
   public:
     struct IrNode {
@@ -25,13 +100,14 @@ class CodeGenerator final : public Visitor {
 
         IrNode(IrNode &&other) noexcept
             : name_(std::move(other.name_)), type_(std::move(other.type_)),
-              alc_name_(std::move(other.alc_name_)) {}
+              alc_name_(std::move(other.alc_name_)), var_(other.var_) {}
 
         IrNode &operator=(const IrNode &other) {
             if (this != &other) {
                 name_ = other.name_;
                 type_ = other.type_;
                 alc_name_ = other.alc_name_;
+                var_ = other.var_;
             }
             return *this;
         }
@@ -41,6 +117,7 @@ class CodeGenerator final : public Visitor {
                 name_ = std::move(other.name_);
                 type_ = std::move(other.type_);
                 alc_name_ = std::move(other.alc_name_);
+                var_ = other.var_;
             }
             return *this;
         }
@@ -49,13 +126,23 @@ class CodeGenerator final : public Visitor {
         std::string type_;
 
         std::string alc_name_;
+        // Variable the value was read from
+        symtab::VariableSymbol *var_{nullptr};
     };
 
-    CodeGenerator(std::ostream &ir, symtab::Symtab &symtab)
-        : symtab_(symtab), ir_(ir) {}
+    CodeGenerator(
+        std::ostream &ir,
+        const Program &program,
+        symtab::Symtab &symtab,
+        const CodeGenOptions &options = {})
+        : program_(program), symtab_(symtab), options_(options), out_(ir) {}
 
-    static void
-    exec(std::ostream &os, Program &program, symtab::Symtab &symtab);
+    static void exec(
+        std::ostream &os,
+        Program &program,
+        symtab::Symtab &symtab,
+        const CodeGenOptions &options = {},
+        TimeReport *report = nullptr);
 
     void visit(FunctionDefinition &node) override;
     void visit(LocalScope &node) override;
@@ -114,29 +201,230 @@ class CodeGenerator final : public Visitor {
 
     symtab::FunctionSymbol *get_funcsym(const std::string &id);
     symtab::VariableSymbol *get_varsym(const std::string &id);
+    std::string get_linkage(const symtab::FunctionSymbol &func_sym) const;
+    std::string get_param_attributes(
+        const symtab::FunctionSymbol &func_sym, std::size_t param) const;
+    std::string get_function_attributes(
+        const symtab::FunctionSymbol &func_sym) const;
     std::string get_ir_type(symtab::Type *type);
-    void cast(IrNode &lhs, IrNode &rhs);
-    void cast_to(const IrNode &to, IrNode &from);
-    void cast_out(
-        IrNode &from, const IrNode &to, std::string &ir_name, std::string inst);
-
+    void convert(const Node *node, IrNode &value, const std::string &type);
+    void convert_operands(
+        const ExpressionType &expression_type, IrNode &lhs, IrNode &rhs);
+    void emit_conversion(
+        Conversion conversion, IrNode &value, const std::string &type);
+    void emit_arithmetic(
+        const std::string &oper, IrNode lhs, IrNode rhs, bool is_floating);
+    std::string emit_value(const std::string &instruction);
+    std::optional<std::string> reduce_strength(
+        const std::string &oper, IrNode &lhs, IrNode &rhs);
+    std::string emit_division(
+        const std::string &value,
+        const std::string &type,
+        std::int64_t divisor);
+    std::string emit_remainder(
+        const std::string &value,
+        const std::string &type,
+        std::int64_t divisor);
+    std::string emit_biased(
+        const std::string &value, const std::string &type, unsigned shift);
+
+    std::optional<std::int64_t> get_constant(const IrNode &node) const;
+    static std::optional<std::int64_t> parse_constant(const IrNode &node);
+    static std::string make_constant(
+        std::int64_t value, const std::string &type);
+    static std::optional<std::int64_t> fold_arithmetic(
+        const std::string &oper, std::int64_t lhs, std::int64_t rhs,
+        const std::string &type);
+    static bool fold_relational(
+        const std::string &oper, std::int64_t lhs, std::int64_t rhs);
+    void remember_constant(
+        const symtab::VariableSymbol *var, const IrNode &value);
+
+    std::optional<std::string> find_value(const std::string &key) const;
+    void number_value(const std::string &key, const std::string &value);
+    std::string get_load_key(
+        const symtab::VariableSymbol *var,
+        const std::string &type,
+        const std::string &pointer) const;
+    void number_store(
+        const symtab::VariableSymbol *var,
+        const std::string &type,
+        const std::string &pointer,
+        const std::string &value);
+
+    bool is_promoted(const symtab::VariableSymbol *var) const;
+    std::string read_promoted(symtab::VariableSymbol *var);
+    bool is_inlinable(symtab::FunctionSymbol &func);
+    IrNode inline_call(
+        symtab::FunctionSymbol &func, const std::vector<IrNode> &args);
+    void return_inlined(ReturnStatement &node);
+    void emit_condition(Node *truth_value);
+    enum class BranchHint { none, likely, unlikely };
+    std::string get_branch_weights(
+        const Node *statement,
+        const Node *truth_value,
+        BranchHint hint,
+        const Node *guard = nullptr);
+    std::string make_branch_weights(std::uint64_t taken, std::uint64_t other);
+    const std::string &get_profiled_func() const;
+    std::size_t &get_profile_size(const std::string &func);
+    std::size_t get_profile_site(const Node *statement);
+    std::optional<std::pair<std::uint64_t, std::uint64_t>> get_profile_counts(
+        const Node *statement);
+    void count_profile(std::size_t counter, const std::string &step = "1");
+    std::string get_profile_attributes(const symtab::FunctionSymbol &func);
+    void print_profile_writer();
+    void instrument_entry();
+    void instrument_exit();
+    void print_instrumentation();
+    void print_destructors();
+    void loop_condition(
+        ForStatement &node,
+        const std::string &scope,
+        const std::string &skip,
+        const std::string &weights,
+        const std::string &metadata,
+        bool is_guard = false);
+    std::string get_loop_metadata(const ForStatement &node);
+    symtab::VariableSymbol *widen_counter(ForStatement &node);
+    void step_wide_counter(const symtab::VariableSymbol *var);
+    std::optional<std::string> read_wide_counter(Node *idx);
+    void hoist_invariant_calls(
+        ForStatement &node, const detail::LoopWrites &writes);
+    bool is_writing_memory(const detail::LoopWrites &writes);
+    void emit_alloca(
+        const std::string &name,
+        const std::string &type,
+        const std::string &count = "");
+    void enter_scope();
+    void leave_scope();
+    void end_slots(std::size_t depth);
+    void print_intrinsics();
+    void start_block(const std::string &label);
+    void start_unreachable_block();
+    bool is_unreachable_block();
+    void seal_block(const std::string &label);
+    void branch(const std::string &label);
+    void cond_branch(
+        const std::string &cond,
+        const std::string &if_true,
+        const std::string &if_false,
+        const std::string &weights = "",
+        const std::string &metadata = "");
+
+    const Program &program_;
     symtab::Symtab &symtab_;
+    CodeGenOptions options_;
 
     std::stack<symtab::Scope *> scopes_;
     std::size_t scope_order_{0};
 
-    std::ostream &ir_;
+    std::ostream &out_;
+    // Text of the current function, printed when it's finished
+    std::ostringstream ir_;
+    detail::SsaBuilder ssa_;
+    // Reachable instructions of the functions of the program printed so far
+    std::size_t instructions_{0};
+    struct Loop {
+        std::size_t preheader_;
+        detail::LoopWrites writes_;
+    };
+    // Loops around the current block, innermost last
+    std::vector<Loop> loops_;
+    struct WideCounter {
+        const symtab::VariableSymbol *var_;
+        std::int64_t step_;
+    };
+    // i64 copies of the counters of the loops around the current block
+    std::unordered_map<const symtab::VariableSymbol *, WideCounter>
+        wide_counters_;
+    // The copies are promoted variables of the function, the SSA builder
+    // tells them apart by the address
+    std::vector<std::unique_ptr<symtab::VariableSymbol>> wide_vars_;
+
+    // Fixed-size allocas of the current function, printed in its entry
+    std::ostringstream allocas_;
+    struct StackSlot {
+        // i8* of the alloca, or the stack pointer saved before a VLA
+        std::string pointer_;
+        // Bytes of a fixed-size alloca, 0 for a VLA
+        std::size_t size_;
+    };
+    // Slots declared in the scopes around the current point, innermost last
+    std::vector<std::vector<StackSlot>> slots_;
+    // Depths of slots_ at the bodies of the loops, continue and break leave
+    // the deeper scopes
+    std::vector<std::size_t> loop_slot_depths_;
+    bool uses_lifetimes_{false};
+    bool uses_stacksave_{false};
+    bool uses_expect_{false};
+
+    symtab::FunctionSymbol *current_func_{nullptr};
+    std::unordered_map<const symtab::FunctionSymbol *, FunctionDefinition *>
+        definitions_;
+    std::unordered_map<const FunctionDefinition *, detail::InlineCost>
+        inline_costs_;
+    struct Inline {
+        symtab::FunctionSymbol *func_;
+        // The block after the body, the returns branch to it
+        std::string exit_;
+        // The only return if it ends the body, it just gives the value
+        const ReturnStatement *tail_;
+        IrNode value_;
+    };
+    // Inlined calls being emitted, innermost last
+    std::vector<Inline> inlines_;
 
     std::size_t tmp_num_{0};
     std::size_t block_num_{0};
-    std::size_t str_num_{0};
+    // i8* constant expressions of the declared string literals
+    std::unordered_map<const StringLiteral *, std::string> str_pointers_;
     std::size_t addr_num_{0};
     std::vector<std::size_t> loop_nums_;
     std::vector<std::size_t> skip_nums_;
+    // Module level metadata of the loops, printed after the functions
+    std::ostringstream metadata_;
+    std::size_t metadata_num_{0};
+    std::string mustprogress_;
+    // Metadata of the branch weights by the weights
+    std::unordered_map<std::string, std::string> branch_weights_;
+
+    // The first profile counter of every if and for, the counters of the
+    // function number them from 1 in the order of the first visits
+    std::unordered_map<const Node *, std::size_t> profile_sites_;
+    std::unordered_map<std::string, std::size_t> profile_sizes_;
+    std::vector<std::string> profiled_funcs_;
+    std::uint64_t max_entry_count_{0};
+
+    // The instrumented functions by their numbers in the runtime tables
+    std::vector<std::string> instrumented_funcs_;
+    // Cycle counter read at the entry of the current function
+    std::string entry_cycles_;
+    // Functions run at exit
+    std::vector<std::string> destructors_;
 
     IrNode ir_buf_;
     std::unordered_map<symtab::Symbol *, IrNode> cgs_alc_;
 
+    // Constants stored into the variables in memory in the current block
+    std::unordered_map<const symtab::VariableSymbol *, std::string>
+        block_consts_;
+    // Pointers loaded from the variables in memory in the current block
+    std::unordered_map<const symtab::VariableSymbol *, std::string>
+        block_pointers_;
+
+    // Values computed in the current block by their instructions. A load is
+    // keyed with the store generation of its variable, or of all the memory
+    // the pointers point to for an element, so the stores make the previous
+    // loads unreachable.
+    std::unordered_map<std::string, std::string> block_values_;
+    std::unordered_map<const symtab::VariableSymbol *, std::size_t>
+        store_generations_;
+    std::size_t memory_generation_{0};
+
+    // Values of the calls evaluated before their loops
+    std::unordered_map<const FunctionCall *, IrNode> hoisted_calls_;
+
     std::stack<IrNode> calc_expr_;
     bool is_rvalue_oper_{false};
 
@@ -147,7 +435,9 @@ class DeclareStr final : public Visitor {
   public:
     explicit DeclareStr(std::ostream &os) : ir_(os) {}
 
-    static void exec(std::ostream &os, Program &program);
+    // Returns the i8* constant expressions of the string literals
+    static std::unordered_map<const StringLiteral *, std::string> exec(
+        std::ostream &os, Program &program);
 
     void visit(FunctionDefinition &node) override;
 
@@ -167,19 +457,22 @@ class DeclareStr final : public Visitor {
 
     void visit(VariableInit &node) override;
 
+    void visit(ReturnStatement &node) override;
+
+    void visit(Assignment &node) override;
+
+    void visit(RvalueOperation &node) override;
+
     void visit(StringLiteral &node) override;
 
   private:
     void visit(HeaderFile & /*node*/) override {}
-    void visit(ReturnStatement & /*node*/) override {}
     void visit(ContinueStatement & /*node*/) override {}
     void visit(BreakStatement & /*node*/) override {}
     void visit(VariableUninit & /*node*/) override {}
     void visit(VariableAccess & /*node*/) override {}
     void visit(ArrayUninit & /*node*/) override {}
     void visit(ArrayElementAccess & /*node*/) override {}
-    void visit(Assignment & /*node*/) override {}
-    void visit(RvalueOperation & /*node*/) override {}
     void visit(AssignmentOperator & /*node*/) override {}
     void visit(ArithmeticOperator & /*node*/) override {}
     void visit(RelationalOperator & /*node*/) override {}
@@ -196,7 +489,9 @@ class DeclareStr final : public Visitor {
     void visit(IntegerLiteral & /*node*/) override {}
 
     std::ostream &ir_;
-    std::size_t str_num_{0};
+    detail::StringPool pool_;
+    // Content of every literal in the pool
+    std::unordered_map<const StringLiteral *, std::size_t> contents_;
     bool is_printf_exist_{false};
 };
 
@@ -0,0 +1,141 @@
+#include <libc/ast/dead_function_eliminator.hpp>
+
+#include <unordered_set>
+
+namespace c::ast {
+
+std::size_t DeadFunctionEliminator::exec(
+    Program &program, const std::vector<std::string> &roots) {
+    DeadFunctionEliminator eliminator;
+    for (auto *child : program.get_childs()) {
+        child->accept(eliminator);
+    }
+
+    std::unordered_set<std::string> reachable;
+    std::vector<std::string> stack;
+    for (const auto &root : roots) {
+        if (eliminator.callees_.count(root) > 0 &&
+            reachable.insert(root).second) {
+            stack.push_back(root);
+        }
+    }
+    if (reachable.empty()) {
+        return 0;
+    }
+    while (!stack.empty()) {
+        auto func = std::move(stack.back());
+        stack.pop_back();
+        for (const auto &callee : eliminator.callees_.at(func)) {
+            // printf and the other declared functions have no definition
+            if (eliminator.callees_.count(callee) > 0 &&
+                reachable.insert(callee).second) {
+                stack.push_back(callee);
+            }
+        }
+    }
+
+    Childs childs;
+    for (auto *child : program.get_childs()) {
+        auto *definition = dynamic_cast<FunctionDefinition *>(child);
+        if (definition == nullptr || reachable.count(definition->id()) > 0) {
+            childs.push_back(child);
+        }
+    }
+    auto removed = program.get_childs().size() - childs.size();
+    program.set_childs(std::move(childs));
+    return removed;
+}
+
+void DeadFunctionEliminator::visit(FunctionDefinition &node) {
+    current_callees_ = &callees_[node.id()];
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeadFunctionEliminator::visit(LocalScope &node) {
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+// Expressions
+
+void DeadFunctionEliminator::visit(Expression &node) {
+    node.expression()->accept(*this);
+}
+
+void DeadFunctionEliminator::visit(FunctionCall &node) {
+    current_callees_->push_back(node.id());
+    for (auto *arg : node.args()) {
+        arg->accept(*this);
+    }
+}
+
+void DeadFunctionEliminator::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void DeadFunctionEliminator::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+// Statements
+
+void DeadFunctionEliminator::visit(ReturnStatement &node) {
+    node.value()->accept(*this);
+}
+
+void DeadFunctionEliminator::visit(ForStatement &node) {
+    if (node.for_data_using() != nullptr) {
+        node.for_data_using()->accept(*this);
+    }
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(*this);
+    }
+    if (node.value() != nullptr) {
+        node.value()->accept(*this);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void DeadFunctionEliminator::visit(IfStatement &node) {
+    node.truth_value()->accept(*this);
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+// Array
+
+void DeadFunctionEliminator::visit(ArrayUninit &node) {
+    node.size()->accept(*this);
+}
+
+void DeadFunctionEliminator::visit(ArrayElementAccess &node) {
+    node.idx()->accept(*this);
+}
+
+// Variable
+
+void DeadFunctionEliminator::visit(VariableInit &node) {
+    node.value()->accept(*this);
+}
+
+// Operations
+
+void DeadFunctionEliminator::visit(Assignment &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void DeadFunctionEliminator::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+} // namespace c::ast
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <libc/ast/visitor.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast {
+
+// Removes the definitions of the functions that can't be called from the
+// roots, so the later phases neither analyze nor generate them. The calls
+// are found by the names of the callees: a function can't be hidden by a
+// local name at a call.
+class DeadFunctionEliminator final : public Visitor {
+  public:
+    // Returns the number of the removed functions. If the program defines
+    // none of the roots, it's kept as it is.
+    static std::size_t exec(
+        Program &program, const std::vector<std::string> &roots);
+
+    void visit(FunctionDefinition &node) override;
+    void visit(LocalScope &node) override;
+
+    // Expressions
+
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+
+    // Statements
+
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+
+    // Array
+
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+
+    // Variable
+
+    void visit(VariableInit &node) override;
+
+    // Operations
+
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(ContinueStatement & /*node*/) override {}
+    void visit(BreakStatement & /*node*/) override {}
+    void visit(VariableUninit & /*node*/) override {}
+    void visit(VariableAccess & /*node*/) override {}
+    void visit(AssignmentOperator & /*node*/) override {}
+    void visit(ArithmeticOperator & /*node*/) override {}
+    void visit(RelationalOperator & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+    void visit(StringLiteral & /*node*/) override {}
+    void visit(IntegerLiteral & /*node*/) override {}
+
+    // The names the function calls
+    std::unordered_map<std::string, std::vector<std::string>> callees_;
+    std::vector<std::string> *current_callees_{nullptr};
+};
+
+} // namespace c::ast
\ No newline at end of file
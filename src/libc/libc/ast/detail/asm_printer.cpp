@@ -0,0 +1,368 @@
+#include <libc/ast/detail/asm_printer.hpp>
+
+#include <array>
+#include <vector>
+
+namespace c::ast::detail {
+
+namespace {
+
+const std::array<std::array<const char *, 16>, 4> c_reg_names = {{
+    {"al",
+     "cl",
+     "dl",
+     "bl",
+     "spl",
+     "bpl",
+     "sil",
+     "dil",
+     "r8b",
+     "r9b",
+     "r10b",
+     "r11b",
+     "r12b",
+     "r13b",
+     "r14b",
+     "r15b"},
+    {"ax",
+     "cx",
+     "dx",
+     "bx",
+     "sp",
+     "bp",
+     "si",
+     "di",
+     "r8w",
+     "r9w",
+     "r10w",
+     "r11w",
+     "r12w",
+     "r13w",
+     "r14w",
+     "r15w"},
+    {"eax",
+     "ecx",
+     "edx",
+     "ebx",
+     "esp",
+     "ebp",
+     "esi",
+     "edi",
+     "r8d",
+     "r9d",
+     "r10d",
+     "r11d",
+     "r12d",
+     "r13d",
+     "r14d",
+     "r15d"},
+    {"rax",
+     "rcx",
+     "rdx",
+     "rbx",
+     "rsp",
+     "rbp",
+     "rsi",
+     "rdi",
+     "r8",
+     "r9",
+     "r10",
+     "r11",
+     "r12",
+     "r13",
+     "r14",
+     "r15"},
+}};
+
+const std::array<const char *, 16> c_cond_names = {
+    "o",
+    "no",
+    "b",
+    "ae",
+    "e",
+    "ne",
+    "be",
+    "a",
+    "s",
+    "ns",
+    "p",
+    "np",
+    "l",
+    "ge",
+    "le",
+    "g"};
+
+const char *get_ptr(Width width) {
+    switch (width) {
+    case Width::b8:
+        return "BYTE PTR ";
+    case Width::b16:
+        return "WORD PTR ";
+    case Width::b32:
+    case Width::f32:
+        return "DWORD PTR ";
+    default:
+        return "QWORD PTR ";
+    }
+}
+
+// The suffix of the scalar SSE instructions
+const char *get_suffix(Width width) {
+    return width == Width::f32 ? "ss" : "sd";
+}
+
+std::string get_mnemonic(const Instruction &instruction) {
+    switch (instruction.opcode_) {
+    case Opcode::mov:
+        return "mov";
+    case Opcode::movsx:
+        return instruction.src_width_ == Width::b32 ? "movsxd" : "movsx";
+    case Opcode::movzx:
+        return "movzx";
+    case Opcode::lea:
+        return "lea";
+    case Opcode::add:
+        return "add";
+    case Opcode::sub:
+        return "sub";
+    case Opcode::imul:
+        return "imul";
+    case Opcode::and_:
+        return "and";
+    case Opcode::or_:
+        return "or";
+    case Opcode::neg:
+        return "neg";
+    case Opcode::cmp:
+        return "cmp";
+    case Opcode::test:
+        return "test";
+    case Opcode::setcc:
+        return std::string("set") + c_cond_names[static_cast<std::size_t>(
+                                        instruction.cond_)];
+    case Opcode::jcc:
+        return std::string("j") + c_cond_names[static_cast<std::size_t>(
+                                      instruction.cond_)];
+    case Opcode::jmp:
+        return "jmp";
+    case Opcode::cdq:
+        return instruction.width_ == Width::b64 ? "cqo" : "cdq";
+    case Opcode::idiv:
+        return "idiv";
+    case Opcode::push:
+        return "push";
+    case Opcode::pop:
+        return "pop";
+    case Opcode::call:
+        return "call";
+    case Opcode::ret:
+        return "ret";
+    case Opcode::movs:
+        return std::string("mov") + get_suffix(instruction.width_);
+    case Opcode::movaps:
+        return "movaps";
+    case Opcode::adds:
+        return std::string("add") + get_suffix(instruction.width_);
+    case Opcode::subs:
+        return std::string("sub") + get_suffix(instruction.width_);
+    case Opcode::muls:
+        return std::string("mul") + get_suffix(instruction.width_);
+    case Opcode::divs:
+        return std::string("div") + get_suffix(instruction.width_);
+    case Opcode::ucomis:
+        return std::string("ucomi") + get_suffix(instruction.width_);
+    case Opcode::xorps:
+        return "xorps";
+    case Opcode::cvtsi2s:
+        return std::string("cvtsi2") + get_suffix(instruction.width_);
+    case Opcode::cvtts2si:
+        return std::string("cvtt") + get_suffix(instruction.src_width_) +
+            "2si";
+    case Opcode::cvts2s:
+        return std::string("cvt") + get_suffix(instruction.src_width_) + "2" +
+            get_suffix(instruction.width_);
+    default:
+        return "";
+    }
+}
+
+bool is_printable(char c) {
+    return c >= ' ' && c <= '~' && c != '"' && c != '\\';
+}
+
+} // namespace
+
+AsmPrinter::AsmPrinter(std::ostream &out, const MachineModule &module)
+    : out_(out), module_(module) {
+    for (const auto &func : module_.functions_) {
+        defined_.insert(func.name_);
+    }
+}
+
+void AsmPrinter::exec(std::ostream &out, const MachineModule &module) {
+    AsmPrinter printer(out, module);
+    out << "\t.intel_syntax noprefix\n";
+    out << "\t.text\n";
+    for (std::size_t i = 0; i < module.functions_.size(); ++i) {
+        printer.print_function(module.functions_[i], i);
+    }
+    printer.print_strings();
+    out << "\t.section .note.GNU-stack,\"\",@progbits\n";
+}
+
+void AsmPrinter::print_function(
+    const MachineFunction &func, std::size_t index) {
+    func_index_ = index;
+
+    // Only the blocks that are jumped to get labels
+    std::vector<bool> is_target(func.blocks_.size());
+    for (const auto &block : func.blocks_) {
+        for (const auto &instruction : block.instructions_) {
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::jcc) {
+                is_target[instruction.dst_.imm_] = true;
+            }
+        }
+    }
+
+    out_ << "\n";
+    if (func.is_exported_) {
+        out_ << "\t.globl " << func.name_ << "\n";
+    }
+    out_ << "\t.p2align 4\n";
+    out_ << "\t.type " << func.name_ << ", @function\n";
+    out_ << func.name_ << ":\n";
+    for (std::size_t i = 0; i < func.blocks_.size(); ++i) {
+        if (is_target[i]) {
+            out_ << ".LBB" << func_index_ << "_" << i << ":\n";
+        }
+        for (const auto &instruction : func.blocks_[i].instructions_) {
+            print_instruction(instruction);
+        }
+    }
+    out_ << "\t.size " << func.name_ << ", .-" << func.name_ << "\n";
+}
+
+void AsmPrinter::print_instruction(const Instruction &instruction) {
+    out_ << "\t" << get_mnemonic(instruction);
+
+    auto dst_width = instruction.width_;
+    auto src_width = instruction.width_;
+    switch (instruction.opcode_) {
+    case Opcode::movsx:
+    case Opcode::movzx:
+    case Opcode::cvtsi2s:
+    case Opcode::cvtts2si:
+    case Opcode::cvts2s:
+        src_width = instruction.src_width_;
+        break;
+    case Opcode::setcc:
+        dst_width = Width::b8;
+        break;
+    default:
+        break;
+    }
+    // The addresses are computed in 64 bits
+    if (instruction.opcode_ == Opcode::lea) {
+        dst_width = Width::b64;
+    }
+
+    if (instruction.dst_.kind_ == Operand::Kind::none) {
+        out_ << "\n";
+        return;
+    }
+    out_ << "\t";
+    print_operand(instruction.dst_, dst_width);
+    if (instruction.opcode_ == Opcode::imul &&
+        instruction.src_.kind_ == Operand::Kind::imm) {
+        out_ << ", ";
+        print_operand(instruction.dst_, dst_width);
+    }
+    if (instruction.src_.kind_ != Operand::Kind::none) {
+        out_ << ", ";
+        print_operand(
+            instruction.src_, src_width,
+            instruction.opcode_ != Opcode::lea);
+    }
+    out_ << "\n";
+}
+
+void AsmPrinter::print_operand(
+    const Operand &operand, Width width, bool is_sized) {
+    switch (operand.kind_) {
+    case Operand::Kind::reg:
+        if (is_xmm(operand.reg_)) {
+            out_ << "xmm" << operand.reg_ - x86::xmm0;
+        } else {
+            auto size = width == Width::f32 || width == Width::f64
+                ? static_cast<std::size_t>(Width::b64)
+                : static_cast<std::size_t>(width);
+            out_ << c_reg_names[size][operand.reg_];
+        }
+        return;
+    case Operand::Kind::imm:
+        out_ << operand.imm_;
+        return;
+    case Operand::Kind::label:
+        out_ << ".LBB" << func_index_ << "_" << operand.imm_;
+        return;
+    case Operand::Kind::symbol:
+        out_ << operand.symbol_;
+        if (defined_.count(operand.symbol_) == 0) {
+            out_ << "@PLT";
+        }
+        return;
+    case Operand::Kind::mem: {
+        const auto &mem = operand.mem_;
+        // lea takes no size of the memory
+        if (is_sized) {
+            out_ << get_ptr(width);
+        }
+        out_ << "[";
+        if (!mem.symbol_.empty()) {
+            out_ << "rip + " << mem.symbol_;
+        } else {
+            out_ << c_reg_names[3][mem.base_];
+            if (mem.index_ != c_no_reg) {
+                out_ << " + " << c_reg_names[3][mem.index_];
+                if (mem.scale_ != 1) {
+                    out_ << "*" << static_cast<int>(mem.scale_);
+                }
+            }
+        }
+        if (mem.disp_ > 0) {
+            out_ << " + " << mem.disp_;
+        } else if (mem.disp_ < 0) {
+            out_ << " - " << -static_cast<std::int64_t>(mem.disp_);
+        }
+        out_ << "]";
+        return;
+    }
+    default:
+        return;
+    }
+}
+
+// Escapes the bytes the assembler doesn't take literally in octal
+void AsmPrinter::print_strings() {
+    if (module_.strings_.empty()) {
+        return;
+    }
+    out_ << "\n\t.section .rodata\n";
+    for (std::size_t i = 0; i < module_.strings_.size(); ++i) {
+        out_ << ".L.str" << i << ":\n\t.asciz \"";
+        for (auto c : module_.strings_[i]) {
+            if (is_printable(c)) {
+                out_ << c;
+                continue;
+            }
+            auto byte = static_cast<unsigned char>(c);
+            out_ << '\\' << static_cast<char>('0' + (byte >> 6)) <<
+                static_cast<char>('0' + ((byte >> 3) & 7)) <<
+                static_cast<char>('0' + (byte & 7));
+        }
+        out_ << "\"\n";
+    }
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <libc/ast/detail/machine_code.hpp>
+
+#include <ostream>
+#include <set>
+#include <string>
+
+namespace c::ast::detail {
+
+// Prints the allocated machine code as the Intel syntax of the GNU
+// assembler. The functions that aren't defined by the module are called
+// through the PLT.
+class AsmPrinter final {
+  public:
+    static void exec(std::ostream &out, const MachineModule &module);
+
+  private:
+    AsmPrinter(std::ostream &out, const MachineModule &module);
+
+    void print_function(const MachineFunction &func, std::size_t index);
+    void print_instruction(const Instruction &instruction);
+    void print_operand(
+        const Operand &operand, Width width, bool is_sized = true);
+    void print_strings();
+
+    std::ostream &out_;
+    const MachineModule &module_;
+    std::set<std::string> defined_;
+    // Of the function being printed
+    std::size_t func_index_{0};
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -9,6 +9,10 @@ std::any Builder::visitProgram(CParser::ProgramContext *context) {
         childs.push_back(std::any_cast<Node *>(visitChildren(element)));
     }
     program_.set_childs(childs);
+    if (report_ != nullptr) {
+        report_->add_nested_time(
+            "precedence building", precedence_time_, expressions_);
+    }
     return childs;
 }
 
@@ -269,7 +273,7 @@ std::any Builder::visitAssignment(CParser::AssignmentContext *context) {
         expression.push_back(std::any_cast<Node *>(visit(child)));
     }
 
-    Childs rpn = PrecedenceBuilder::exec(expression);
+    Childs rpn = build_rpn(expression);
 
     return static_cast<Node *>(
         program_.create_node<Assignment>(expression, rpn));
@@ -282,7 +286,7 @@ Builder::visitRvalue_operation(CParser::Rvalue_operationContext *context) {
         expression.push_back(std::any_cast<Node *>(visit(child)));
     }
 
-    Childs rpn = PrecedenceBuilder::exec(expression);
+    Childs rpn = build_rpn(expression);
 
     return static_cast<Node *>(
         program_.create_node<RvalueOperation>(expression, rpn));
@@ -398,4 +402,15 @@ Builder::visitInteger_literal(CParser::Integer_literalContext *context) {
     return static_cast<Node *>(program_.create_node<IntegerLiteral>(integer));
 }
 
+Childs Builder::build_rpn(const Childs &expression) {
+    if (report_ == nullptr) {
+        return PrecedenceBuilder::exec(expression);
+    }
+    const auto start = std::chrono::steady_clock::now();
+    auto rpn = PrecedenceBuilder::exec(expression);
+    precedence_time_ += std::chrono::steady_clock::now() - start;
+    ++expressions_;
+    return rpn;
+}
+
 } // namespace c::ast::detail
\ No newline at end of file
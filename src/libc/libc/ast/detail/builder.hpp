@@ -1,16 +1,20 @@
 #pragma once
 
 #include <libc/ast/ast.hpp>
+#include <libc/time_report.hpp>
 
 #include <CParserBaseVisitor.h>
 
 #include <any>
+#include <chrono>
+#include <cstddef>
 
 namespace c::ast::detail {
 
 class Builder final : public CParserBaseVisitor {
   public:
-    explicit Builder(ast::Program &program) : program_(program) {}
+    explicit Builder(ast::Program &program, TimeReport *report = nullptr)
+        : program_(program), report_(report) {}
 
     std::any visitProgram(CParser::ProgramContext *context) override;
 
@@ -106,7 +110,13 @@ class Builder final : public CParserBaseVisitor {
     visitInteger_literal(CParser::Integer_literalContext *context) override;
 
   private:
+    Childs build_rpn(const Childs &expression);
+
     Program &program_;
+    TimeReport *report_;
+    // A Phase per expression would cost more than the precedence building
+    std::chrono::steady_clock::duration precedence_time_{};
+    std::size_t expressions_{0};
 };
 
 } // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <libc/ast/detail/bytecode.hpp>
+
+#include <array>
+
+namespace c::ast::detail {
+
+namespace {
+
+const std::array<const char *, static_cast<std::size_t>(Op::count_)>
+    c_op_names = {
+#define C_BYTECODE_OP(name) #name,
+        C_BYTECODE_OPS(C_BYTECODE_OP)
+#undef C_BYTECODE_OP
+};
+
+bool is_printable(char c) {
+    return c >= ' ' && c <= '~' && c != '"' && c != '\\';
+}
+
+} // namespace
+
+const char *get_name(Op op) {
+    return c_op_names[static_cast<std::size_t>(op)];
+}
+
+void print(std::ostream &out, const BytecodeModule &module) {
+    for (std::size_t i = 0; i < module.functions_.size(); ++i) {
+        const auto &func = module.functions_[i];
+        out << (i == 0 ? "" : "\n") << "function " << i << " " << func.name_
+            << " (params " << func.num_params_ << ", regs " << func.num_regs_
+            << ", frame " << func.frame_size_ << ")\n";
+        for (std::size_t j = 0; j < func.code_.size(); ++j) {
+            const auto &instruction = func.code_[j];
+            const auto op = instruction.op_;
+            out << "  " << j << "\t" << get_name(op) << "\tr" << instruction.a_
+                << ", r" << instruction.b_ << ", "
+                << (op >= Op::jeqi_i64 && op <= Op::jgei_i64
+                        ? static_cast<std::int16_t>(instruction.c_)
+                        : instruction.c_)
+                << ", ";
+            if (op >= Op::jmp && op <= Op::jge_f64) {
+                out << "-> " << static_cast<std::int64_t>(j) + instruction.imm_;
+            } else {
+                out << instruction.imm_;
+            }
+            out << "\n";
+        }
+    }
+    for (std::size_t i = 0; i < module.strings_.size(); ++i) {
+        out << "string " << i << " \"";
+        for (auto c : module.strings_[i]) {
+            if (is_printable(c)) {
+                out << c;
+                continue;
+            }
+            auto byte = static_cast<unsigned char>(c);
+            out << '\\' << static_cast<char>('0' + (byte >> 6))
+                << static_cast<char>('0' + ((byte >> 3) & 7))
+                << static_cast<char>('0' + (byte & 7));
+        }
+        out << "\"\n";
+    }
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
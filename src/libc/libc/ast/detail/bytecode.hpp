@@ -0,0 +1,187 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Registers of the bytecode are the 64-bit slots of the frame of the
+// function. The integers narrower than 64 bits are kept in them sign
+// extended, so they are compared as 64-bit ones and the arithmetic of a
+// type wraps its result around. Floats are kept as floats.
+using BytecodeReg = std::uint16_t;
+
+// The operations, their operands are described by BytecodeInstruction. The
+// suffix is the type operated on, ptr is a pointer.
+//
+// A superinstruction of the common sequences: j<cond> compares and
+// branches, j<cond>i compares with the constant in c_ and branches, addi
+// adds the constant.
+#define C_BYTECODE_OPS(X)                                                      \
+    X(mov)                                                                     \
+    X(load_const)                                                              \
+    X(load_wide)                                                               \
+    X(load_string)                                                             \
+    X(frame_address)                                                           \
+    X(allocate)                                                                \
+    X(stack_save)                                                              \
+    X(stack_restore)                                                           \
+    X(add_i8)                                                                  \
+    X(add_i16)                                                                 \
+    X(add_i32)                                                                 \
+    X(add_i64)                                                                 \
+    X(add_f32)                                                                 \
+    X(add_f64)                                                                 \
+    X(sub_i8)                                                                  \
+    X(sub_i16)                                                                 \
+    X(sub_i32)                                                                 \
+    X(sub_i64)                                                                 \
+    X(sub_f32)                                                                 \
+    X(sub_f64)                                                                 \
+    X(mul_i8)                                                                  \
+    X(mul_i16)                                                                 \
+    X(mul_i32)                                                                 \
+    X(mul_i64)                                                                 \
+    X(mul_f32)                                                                 \
+    X(mul_f64)                                                                 \
+    X(div_i8)                                                                  \
+    X(div_i16)                                                                 \
+    X(div_i32)                                                                 \
+    X(div_i64)                                                                 \
+    X(div_f32)                                                                 \
+    X(div_f64)                                                                 \
+    X(rem_i8)                                                                  \
+    X(rem_i16)                                                                 \
+    X(rem_i32)                                                                 \
+    X(rem_i64)                                                                 \
+    X(addi_i8)                                                                 \
+    X(addi_i16)                                                                \
+    X(addi_i32)                                                                \
+    X(addi_i64)                                                                \
+    X(trunc_i8)                                                                \
+    X(trunc_i16)                                                               \
+    X(trunc_i32)                                                               \
+    X(int_to_f32)                                                              \
+    X(int_to_f64)                                                              \
+    X(f32_to_int)                                                              \
+    X(f64_to_int)                                                              \
+    X(f32_to_f64)                                                              \
+    X(f64_to_f32)                                                              \
+    X(eq_i64)                                                                  \
+    X(ne_i64)                                                                  \
+    X(lt_i64)                                                                  \
+    X(le_i64)                                                                  \
+    X(gt_i64)                                                                  \
+    X(ge_i64)                                                                  \
+    X(eq_f32)                                                                  \
+    X(ne_f32)                                                                  \
+    X(lt_f32)                                                                  \
+    X(le_f32)                                                                  \
+    X(gt_f32)                                                                  \
+    X(ge_f32)                                                                  \
+    X(eq_f64)                                                                  \
+    X(ne_f64)                                                                  \
+    X(lt_f64)                                                                  \
+    X(le_f64)                                                                  \
+    X(gt_f64)                                                                  \
+    X(ge_f64)                                                                  \
+    X(jmp)                                                                     \
+    X(jz)                                                                      \
+    X(jnz)                                                                     \
+    X(jeq_i64)                                                                 \
+    X(jne_i64)                                                                 \
+    X(jlt_i64)                                                                 \
+    X(jle_i64)                                                                 \
+    X(jgt_i64)                                                                 \
+    X(jge_i64)                                                                 \
+    X(jeqi_i64)                                                                \
+    X(jnei_i64)                                                                \
+    X(jlti_i64)                                                                \
+    X(jlei_i64)                                                                \
+    X(jgti_i64)                                                                \
+    X(jgei_i64)                                                                \
+    X(jeq_f32)                                                                 \
+    X(jne_f32)                                                                 \
+    X(jlt_f32)                                                                 \
+    X(jle_f32)                                                                 \
+    X(jgt_f32)                                                                 \
+    X(jge_f32)                                                                 \
+    X(jeq_f64)                                                                 \
+    X(jne_f64)                                                                 \
+    X(jlt_f64)                                                                 \
+    X(jle_f64)                                                                 \
+    X(jgt_f64)                                                                 \
+    X(jge_f64)                                                                 \
+    X(load_i8)                                                                 \
+    X(load_i16)                                                                \
+    X(load_i32)                                                                \
+    X(load_i64)                                                                \
+    X(load_f32)                                                                \
+    X(load_f64)                                                                \
+    X(load_ptr)                                                                \
+    X(store_i8)                                                                \
+    X(store_i16)                                                               \
+    X(store_i32)                                                               \
+    X(store_i64)                                                               \
+    X(store_f32)                                                               \
+    X(store_f64)                                                               \
+    X(store_ptr)                                                               \
+    X(call)                                                                    \
+    X(call_printf)                                                             \
+    X(ret)
+
+enum class Op : std::uint16_t {
+#define C_BYTECODE_OP(name) name,
+    C_BYTECODE_OPS(C_BYTECODE_OP)
+#undef C_BYTECODE_OP
+        count_
+};
+
+const char *get_name(Op op);
+
+// a_ is the result, b_ and c_ the operands:
+//   load_const  a = imm_
+//   load_wide   a = constants_[imm_]
+//   load_string a = strings_[imm_]
+//   frame_address a = the objects of the frame + imm_ bytes
+//   allocate    a = b bytes on the stack, freed by stack_restore
+//   addi        a = b + imm_
+//   load        a = b[c]
+//   store       b[c] = a
+//   jmp, jz b, j<cond> b, c jump by imm_ instructions
+//   call        a = functions_[imm_](b, b + 1, ...)
+//   call_printf a = printf(b, b + 1, ..., b + c - 1)
+//   ret         returns a
+// The arguments of a call are the last registers of the caller, they
+// become the first ones of the callee.
+struct BytecodeInstruction {
+    Op op_{Op::ret};
+    BytecodeReg a_{0};
+    BytecodeReg b_{0};
+    BytecodeReg c_{0};
+    std::int32_t imm_{0};
+};
+
+struct BytecodeFunction {
+    std::string name_;
+    std::vector<BytecodeInstruction> code_;
+    std::size_t num_params_{0};
+    std::size_t num_regs_{0};
+    // Bytes of the arrays of a constant size
+    std::size_t frame_size_{0};
+};
+
+struct BytecodeModule {
+    std::vector<BytecodeFunction> functions_;
+    // Bits of the constants that don't fit into imm_
+    std::vector<std::uint64_t> constants_;
+    std::vector<std::string> strings_;
+};
+
+// One instruction per line, the jumps show the numbers of their targets
+void print(std::ostream &out, const BytecodeModule &module);
+
+} // namespace c::ast::detail
\ No newline at end of file
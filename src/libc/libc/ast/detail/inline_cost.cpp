@@ -0,0 +1,130 @@
+#include <libc/ast/detail/inline_cost.hpp>
+
+namespace c::ast::detail {
+
+InlineCost InlineCostCollector::exec(FunctionDefinition &node) {
+    InlineCostCollector collector;
+    for (auto *action : node.actions()) {
+        action->accept(collector);
+    }
+    return collector.cost_;
+}
+
+void InlineCostCollector::visit(LocalScope &node) {
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(Expression &node) {
+    node.expression()->accept(*this);
+}
+
+void InlineCostCollector::visit(FunctionCall &node) {
+    ++cost_.size_;
+    for (auto *arg : node.args()) {
+        arg->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void InlineCostCollector::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+void InlineCostCollector::visit(ReturnStatement &node) {
+    ++cost_.size_;
+    ++cost_.returns_;
+    node.value()->accept(*this);
+}
+
+void InlineCostCollector::visit(ForStatement &node) {
+    ++cost_.size_;
+    if (node.for_data_using() != nullptr) {
+        node.for_data_using()->accept(*this);
+    }
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(*this);
+    }
+    if (node.value() != nullptr) {
+        node.value()->accept(*this);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(IfStatement &node) {
+    ++cost_.size_;
+    node.truth_value()->accept(*this);
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(ContinueStatement & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(BreakStatement & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(ArrayUninit &node) {
+    ++cost_.size_;
+    cost_.has_arrays_ = true;
+    node.size()->accept(*this);
+}
+
+void InlineCostCollector::visit(ArrayElementAccess &node) {
+    ++cost_.size_;
+    node.idx()->accept(*this);
+}
+
+void InlineCostCollector::visit(VariableInit &node) {
+    ++cost_.size_;
+    node.value()->accept(*this);
+}
+
+void InlineCostCollector::visit(VariableUninit & /*node*/) {}
+
+void InlineCostCollector::visit(VariableAccess & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(Assignment &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void InlineCostCollector::visit(AssignmentOperator & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(ArithmeticOperator & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(RelationalOperator & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(StringLiteral & /*node*/) {
+    ++cost_.size_;
+}
+
+void InlineCostCollector::visit(IntegerLiteral & /*node*/) {
+    ++cost_.size_;
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
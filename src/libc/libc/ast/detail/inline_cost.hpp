@@ -0,0 +1,57 @@
+#pragma once
+
+#include <libc/ast/visitor.hpp>
+
+#include <cstddef>
+
+namespace c::ast::detail {
+
+// What an inlined call of the function would add to its caller
+struct InlineCost {
+    // Statements, operands and operators of the body
+    std::size_t size_{0};
+    std::size_t returns_{0};
+    // The arrays would be allocated again on every call
+    bool has_arrays_{false};
+};
+
+class InlineCostCollector final : public Visitor {
+  public:
+    static InlineCost exec(FunctionDefinition &node);
+
+    void visit(LocalScope &node) override;
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+    void visit(ContinueStatement &node) override;
+    void visit(BreakStatement &node) override;
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+    void visit(VariableInit &node) override;
+    void visit(VariableUninit &node) override;
+    void visit(VariableAccess &node) override;
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+    void visit(AssignmentOperator &node) override;
+    void visit(ArithmeticOperator &node) override;
+    void visit(RelationalOperator &node) override;
+    void visit(StringLiteral &node) override;
+    void visit(IntegerLiteral &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(FunctionDefinition & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+
+    InlineCost cost_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,476 @@
+#include <libc/ast/detail/interpreter.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace c::ast::detail {
+
+namespace {
+
+// 8 MiB of registers and 8 MiB of stack
+constexpr std::size_t c_num_regs = std::size_t{1} << 20;
+constexpr std::size_t c_stack_words = std::size_t{1} << 20;
+
+// The frames keep the stack aligned for any object
+std::size_t align(std::size_t size) {
+    return (size + 15) & ~std::size_t{15};
+}
+
+std::uint64_t to_unsigned(std::int64_t value) {
+    return static_cast<std::uint64_t>(value);
+}
+
+// The result wraps around as in the integer of the type and is sign
+// extended again
+template <typename T>
+std::int64_t wrap(std::uint64_t value) {
+    return static_cast<T>(value);
+}
+
+std::uint8_t *get_element(void *base, std::int64_t index, std::size_t size) {
+    return static_cast<std::uint8_t *>(base) +
+        index * static_cast<std::int64_t>(size);
+}
+
+template <typename T>
+int print_integer(
+    std::FILE *out, const std::string &spec, std::int64_t value,
+    bool is_signed) {
+    if (is_signed) {
+        return std::fprintf(out, spec.c_str(), static_cast<T>(value));
+    }
+    return std::fprintf(
+        out, spec.c_str(), static_cast<std::make_unsigned_t<T>>(value));
+}
+
+} // namespace
+
+// The registers and the stack aren't initialized, a run only touches the
+// part of them it uses
+Interpreter::Interpreter(const BytecodeModule &module, std::FILE *out)
+    : module_(module),
+      out_(out),
+      strings_(module.strings_),
+      regs_(new Slot[c_num_regs]),
+      stack_(new std::uint64_t[c_stack_words]) {}
+
+int Interpreter::exec(
+    const BytecodeModule &module,
+    const std::vector<std::string> &args,
+    std::FILE *out) {
+    const auto &functions = module.functions_;
+    auto main = std::find_if(
+        functions.begin(), functions.end(),
+        [](const auto &func) { return func.name_ == "main"; });
+    if (main == functions.end()) {
+        throw std::runtime_error("The program has no main");
+    }
+
+    auto strings = args;
+    std::vector<char *> argv;
+    for (auto &string : strings) {
+        argv.push_back(string.data());
+    }
+    argv.push_back(nullptr);
+
+    Interpreter interpreter(module, out);
+    const int code = interpreter.run(
+        static_cast<std::size_t>(main - functions.begin()),
+        static_cast<int>(strings.size()), argv.data());
+    std::fflush(out);
+    return code;
+}
+
+// Taking the addresses of the labels is an extension of GCC and Clang
+#if defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#endif
+
+int Interpreter::run(std::size_t main, int argc, char **argv) {
+    const auto &functions = module_.functions_;
+    const auto *constants = module_.constants_.data();
+    Slot *const regs_end = regs_.get() + c_num_regs;
+    auto *const stack_end =
+        reinterpret_cast<std::uint8_t *>(stack_.get() + c_stack_words);
+
+    Slot *r = regs_.get();
+    auto *objects = reinterpret_cast<std::uint8_t *>(stack_.get());
+    auto *stack = objects + align(functions[main].frame_size_);
+    if (functions[main].num_params_ > 0) {
+        r[0].i_ = argc;
+    }
+    if (functions[main].num_params_ > 1) {
+        r[1].ptr_ = argv;
+    }
+    const BytecodeInstruction *pc = functions[main].code_.data();
+
+// The registers of the operands
+#define C_A r[pc->a_]
+#define C_B r[pc->b_]
+#define C_C r[pc->c_]
+
+#if defined(__GNUC__)
+    static const void *const c_labels[] = {
+#define C_BYTECODE_OP(name) &&op_##name,
+        C_BYTECODE_OPS(C_BYTECODE_OP)
+#undef C_BYTECODE_OP
+    };
+#define C_OP(name) op_##name:
+#define C_DISPATCH() goto *c_labels[static_cast<std::size_t>(pc->op_)]
+    C_DISPATCH();
+#else
+#define C_OP(name) case Op::name:
+#define C_DISPATCH() continue
+    for (;;) {
+        switch (pc->op_) {
+#endif
+
+#define C_NEXT()                                                               \
+    ++pc;                                                                      \
+    C_DISPATCH()
+
+#define C_INTEGER_OPS(suffix, type)                                            \
+    C_OP(add_##suffix) {                                                       \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_) + to_unsigned(C_C.i_));        \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(sub_##suffix) {                                                       \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_) - to_unsigned(C_C.i_));        \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(mul_##suffix) {                                                       \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_) * to_unsigned(C_C.i_));        \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(div_##suffix) {                                                       \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_ / C_C.i_));                     \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(rem_##suffix) {                                                       \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_ % C_C.i_));                     \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(addi_##suffix) {                                                      \
+        C_A.i_ = wrap<type>(to_unsigned(C_B.i_) + to_unsigned(pc->imm_));      \
+        C_NEXT();                                                              \
+    }
+
+#define C_FLOAT_OPS(suffix, member)                                            \
+    C_OP(add_##suffix) {                                                       \
+        C_A.member = C_B.member + C_C.member;                                  \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(sub_##suffix) {                                                       \
+        C_A.member = C_B.member - C_C.member;                                  \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(mul_##suffix) {                                                       \
+        C_A.member = C_B.member * C_C.member;                                  \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(div_##suffix) {                                                       \
+        C_A.member = C_B.member / C_C.member;                                  \
+        C_NEXT();                                                              \
+    }
+
+// The comparison as a value and as a branch
+#define C_COMPARE_OP(name, oper, suffix, member)                               \
+    C_OP(name##_##suffix) {                                                    \
+        C_A.i_ = C_B.member oper C_C.member;                                   \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(j##name##_##suffix) {                                                 \
+        pc += C_B.member oper C_C.member ? pc->imm_ : 1;                       \
+        C_DISPATCH();                                                          \
+    }
+
+#define C_COMPARE_OPS(suffix, member)                                          \
+    C_COMPARE_OP(eq, ==, suffix, member)                                       \
+    C_COMPARE_OP(ne, !=, suffix, member)                                       \
+    C_COMPARE_OP(lt, <, suffix, member)                                        \
+    C_COMPARE_OP(le, <=, suffix, member)                                       \
+    C_COMPARE_OP(gt, >, suffix, member)                                        \
+    C_COMPARE_OP(ge, >=, suffix, member)
+
+#define C_COMPARE_IMMEDIATE_OP(name, oper)                                     \
+    C_OP(j##name##i_i64) {                                                     \
+        pc += C_B.i_ oper static_cast<std::int16_t>(pc->c_) ? pc->imm_ : 1;    \
+        C_DISPATCH();                                                          \
+    }
+
+#define C_MEMORY_OPS(suffix, type, member)                                     \
+    C_OP(load_##suffix) {                                                      \
+        type value;                                                            \
+        std::memcpy(                                                           \
+            &value, get_element(C_B.ptr_, C_C.i_, sizeof(type)),               \
+            sizeof(type));                                                     \
+        C_A.member = value;                                                    \
+        C_NEXT();                                                              \
+    }                                                                          \
+    C_OP(store_##suffix) {                                                     \
+        auto value = static_cast<type>(C_A.member);                            \
+        std::memcpy(                                                           \
+            get_element(C_B.ptr_, C_C.i_, sizeof(type)), &value,               \
+            sizeof(type));                                                     \
+        C_NEXT();                                                              \
+    }
+
+    C_OP(mov) {
+        C_A = C_B;
+        C_NEXT();
+    }
+    C_OP(load_const) {
+        C_A.i_ = pc->imm_;
+        C_NEXT();
+    }
+    C_OP(load_wide) {
+        C_A.i_ = static_cast<std::int64_t>(constants[pc->imm_]);
+        C_NEXT();
+    }
+    C_OP(load_string) {
+        C_A.ptr_ = strings_[static_cast<std::size_t>(pc->imm_)].data();
+        C_NEXT();
+    }
+    C_OP(frame_address) {
+        C_A.ptr_ = objects + pc->imm_;
+        C_NEXT();
+    }
+    C_OP(allocate) {
+        auto bytes = align(static_cast<std::size_t>(C_B.i_));
+        if (bytes > static_cast<std::size_t>(stack_end - stack)) {
+            throw std::runtime_error("Stack overflow");
+        }
+        C_A.ptr_ = stack;
+        stack += bytes;
+        C_NEXT();
+    }
+    C_OP(stack_save) {
+        C_A.ptr_ = stack;
+        C_NEXT();
+    }
+    C_OP(stack_restore) {
+        stack = static_cast<std::uint8_t *>(C_B.ptr_);
+        C_NEXT();
+    }
+
+    C_INTEGER_OPS(i8, std::int8_t)
+    C_INTEGER_OPS(i16, std::int16_t)
+    C_INTEGER_OPS(i32, std::int32_t)
+    C_INTEGER_OPS(i64, std::int64_t)
+    C_FLOAT_OPS(f32, f32_)
+    C_FLOAT_OPS(f64, f64_)
+
+    C_OP(trunc_i8) {
+        C_A.i_ = static_cast<std::int8_t>(C_B.i_);
+        C_NEXT();
+    }
+    C_OP(trunc_i16) {
+        C_A.i_ = static_cast<std::int16_t>(C_B.i_);
+        C_NEXT();
+    }
+    C_OP(trunc_i32) {
+        C_A.i_ = static_cast<std::int32_t>(C_B.i_);
+        C_NEXT();
+    }
+    C_OP(int_to_f32) {
+        C_A.f32_ = static_cast<float>(C_B.i_);
+        C_NEXT();
+    }
+    C_OP(int_to_f64) {
+        C_A.f64_ = static_cast<double>(C_B.i_);
+        C_NEXT();
+    }
+    C_OP(f32_to_int) {
+        C_A.i_ = static_cast<std::int64_t>(C_B.f32_);
+        C_NEXT();
+    }
+    C_OP(f64_to_int) {
+        C_A.i_ = static_cast<std::int64_t>(C_B.f64_);
+        C_NEXT();
+    }
+    C_OP(f32_to_f64) {
+        C_A.f64_ = static_cast<double>(C_B.f32_);
+        C_NEXT();
+    }
+    C_OP(f64_to_f32) {
+        C_A.f32_ = static_cast<float>(C_B.f64_);
+        C_NEXT();
+    }
+
+    C_COMPARE_OPS(i64, i_)
+    C_COMPARE_OPS(f32, f32_)
+    C_COMPARE_OPS(f64, f64_)
+    C_COMPARE_IMMEDIATE_OP(eq, ==)
+    C_COMPARE_IMMEDIATE_OP(ne, !=)
+    C_COMPARE_IMMEDIATE_OP(lt, <)
+    C_COMPARE_IMMEDIATE_OP(le, <=)
+    C_COMPARE_IMMEDIATE_OP(gt, >)
+    C_COMPARE_IMMEDIATE_OP(ge, >=)
+
+    C_OP(jmp) {
+        pc += pc->imm_;
+        C_DISPATCH();
+    }
+    C_OP(jz) {
+        pc += C_B.i_ == 0 ? pc->imm_ : 1;
+        C_DISPATCH();
+    }
+    C_OP(jnz) {
+        pc += C_B.i_ != 0 ? pc->imm_ : 1;
+        C_DISPATCH();
+    }
+
+    C_MEMORY_OPS(i8, std::int8_t, i_)
+    C_MEMORY_OPS(i16, std::int16_t, i_)
+    C_MEMORY_OPS(i32, std::int32_t, i_)
+    C_MEMORY_OPS(i64, std::int64_t, i_)
+    C_MEMORY_OPS(f32, float, f32_)
+    C_MEMORY_OPS(f64, double, f64_)
+    C_MEMORY_OPS(ptr, void *, ptr_)
+
+    C_OP(call) {
+        const auto &callee = functions[static_cast<std::size_t>(pc->imm_)];
+        auto *callee_regs = r + pc->b_;
+        const auto frame_size = align(callee.frame_size_);
+        if (callee.num_regs_ >
+                static_cast<std::size_t>(regs_end - callee_regs) ||
+            frame_size > static_cast<std::size_t>(stack_end - stack)) {
+            throw std::runtime_error("Stack overflow");
+        }
+        frames_.push_back({pc + 1, r, objects, stack, pc->a_});
+        r = callee_regs;
+        objects = stack;
+        stack += frame_size;
+        pc = callee.code_.data();
+        C_DISPATCH();
+    }
+    C_OP(call_printf) {
+        C_A.i_ = print(out_, r + pc->b_, pc->c_);
+        C_NEXT();
+    }
+    C_OP(ret) {
+        const auto result = C_A;
+        if (frames_.empty()) {
+            return static_cast<int>(result.i_);
+        }
+        const auto frame = frames_.back();
+        frames_.pop_back();
+        pc = frame.return_;
+        r = frame.regs_;
+        objects = frame.objects_;
+        stack = frame.stack_;
+        r[frame.result_] = result;
+        C_DISPATCH();
+    }
+
+#if !defined(__GNUC__)
+        default:
+            throw std::logic_error("Unknown bytecode operation");
+        }
+    }
+#endif
+
+#undef C_MEMORY_OPS
+#undef C_COMPARE_IMMEDIATE_OP
+#undef C_COMPARE_OPS
+#undef C_COMPARE_OP
+#undef C_FLOAT_OPS
+#undef C_INTEGER_OPS
+#undef C_NEXT
+#undef C_DISPATCH
+#undef C_OP
+#undef C_C
+#undef C_B
+#undef C_A
+}
+
+#if defined(__GNUC__)
+#pragma GCC diagnostic pop
+#endif
+
+// Formats one conversion at a time by the host printf with the argument of
+// the type it takes: the integers by their length modifiers, the floats are
+// doubles. The widths and the precisions taken from the arguments aren't
+// supported, such conversions are printed as they are.
+int Interpreter::print(std::FILE *out, const Slot *args, std::size_t count) {
+    const auto *format = static_cast<const char *>(args[0].ptr_);
+    std::size_t next = 1;
+    int written = 0;
+    std::string spec;
+    while (*format != '\0') {
+        if (*format != '%') {
+            const auto length = std::strcspn(format, "%");
+            written += static_cast<int>(std::fwrite(format, 1, length, out));
+            format += length;
+            continue;
+        }
+        const auto length =
+            1 + std::strspn(format + 1, "-+ #0123456789.hlLjzt");
+        if (format[length] == '\0') {
+            written += static_cast<int>(std::fwrite(format, 1, length, out));
+            break;
+        }
+        spec.assign(format, length + 1);
+        const auto conversion = format[length];
+        format += length + 1;
+
+        Slot arg{};
+        if (conversion != '%' && next < count) {
+            arg = args[next++];
+        }
+        int result = 0;
+        switch (conversion) {
+        case 'd':
+        case 'i':
+        case 'c':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X': {
+            const bool is_signed =
+                conversion == 'd' || conversion == 'i' || conversion == 'c';
+            if (spec.find("ll") != std::string::npos ||
+                spec.find_first_of("jzt") != std::string::npos) {
+                result =
+                    print_integer<long long>(out, spec, arg.i_, is_signed);
+            } else if (spec.find('l') != std::string::npos) {
+                result = print_integer<long>(out, spec, arg.i_, is_signed);
+            } else {
+                result = print_integer<int>(out, spec, arg.i_, is_signed);
+            }
+            break;
+        }
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            result = std::fprintf(out, spec.c_str(), arg.f64_);
+            break;
+        case 's':
+            result = std::fprintf(
+                out, spec.c_str(), static_cast<const char *>(arg.ptr_));
+            break;
+        case 'p':
+            result = std::fprintf(out, spec.c_str(), arg.ptr_);
+            break;
+        case '%':
+            result = std::fputc('%', out) == EOF ? 0 : 1;
+            break;
+        default:
+            result = static_cast<int>(
+                std::fwrite(spec.data(), 1, spec.size(), out));
+            break;
+        }
+        written += std::max(result, 0);
+    }
+    return written;
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
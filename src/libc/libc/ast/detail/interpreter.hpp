@@ -0,0 +1,59 @@
+#pragma once
+
+#include <libc/ast/detail/bytecode.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Runs the bytecode by threaded dispatch: built by GCC or Clang, the code
+// of every instruction jumps to the code of the next one through a table of
+// label addresses, a switch in a loop otherwise. The registers of all the
+// frames are one array and a callee's frame begins at the arguments of its
+// call, the objects of the frames and the variable length arrays are on a
+// stack of their own.
+class Interpreter final {
+  public:
+    // Calls main with the arguments, the first one is the name of the
+    // program, and returns its exit code. printf writes to out.
+    static int exec(
+        const BytecodeModule &module,
+        const std::vector<std::string> &args,
+        std::FILE *out);
+
+  private:
+    union Slot {
+        std::int64_t i_;
+        float f32_;
+        double f64_;
+        void *ptr_;
+    };
+
+    // The state of the caller during a call
+    struct Frame {
+        const BytecodeInstruction *return_;
+        Slot *regs_;
+        std::uint8_t *objects_;
+        std::uint8_t *stack_;
+        BytecodeReg result_;
+    };
+
+    Interpreter(const BytecodeModule &module, std::FILE *out);
+
+    int run(std::size_t main, int argc, char **argv);
+    static int print(std::FILE *out, const Slot *args, std::size_t count);
+
+    const BytecodeModule &module_;
+    std::FILE *out_;
+    std::vector<std::string> strings_;
+    std::unique_ptr<Slot[]> regs_;
+    std::unique_ptr<std::uint64_t[]> stack_;
+    std::vector<Frame> frames_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include <libc/ast/detail/loop_writes.hpp>
+
+#include <charconv>
+
+namespace c::ast::detail {
+
+namespace {
+
+// Statements may be wrapped into an Expression
+Node *unwrap(Node *node) {
+    auto *expression = dynamic_cast<Expression *>(node);
+    return expression == nullptr ? node : expression->expression();
+}
+
+} // namespace
+
+LoopWrites LoopWritesCollector::exec(ForStatement &node) {
+    LoopWritesCollector collector;
+    // The initialization runs once before the loop
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(collector);
+    }
+    if (node.value() != nullptr) {
+        node.value()->accept(collector);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(collector);
+    }
+    return std::move(collector.writes_);
+}
+
+std::optional<InductionVariable> LoopWritesCollector::find_induction_variable(
+    ForStatement &node) {
+    auto *create = dynamic_cast<DataCreate *>(unwrap(node.for_data_using()));
+    auto *step = dynamic_cast<VariableWriting *>(unwrap(node.value()));
+    if (create == nullptr || step == nullptr) {
+        return std::nullopt;
+    }
+    auto *init = dynamic_cast<VariableInit *>(create->data_create());
+    auto *assignment = dynamic_cast<Assignment *>(step->variable_writing());
+    if (init == nullptr || assignment == nullptr ||
+        assignment->rpn().size() != 3) {
+        return std::nullopt;
+    }
+
+    const auto &rpn = assignment->rpn();
+    auto *var = dynamic_cast<VariableAccess *>(rpn[0]);
+    auto *literal = dynamic_cast<IntegerLiteral *>(rpn[1]);
+    auto *oper = dynamic_cast<AssignmentOperator *>(rpn[2]);
+    if (var == nullptr || var->id() != init->id() || literal == nullptr ||
+        oper == nullptr ||
+        (oper->assign_operator() != "+=" && oper->assign_operator() != "-=")) {
+        return std::nullopt;
+    }
+    std::int64_t step_value = 0;
+    const auto &text = literal->integer();
+    auto [ptr, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), step_value);
+    if (ec != std::errc() || ptr != text.data() + text.size()) {
+        return std::nullopt;
+    }
+
+    LoopWritesCollector collector;
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(collector);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(collector);
+    }
+    if (collector.writes_.names_.count(init->id()) != 0) {
+        return std::nullopt;
+    }
+    return InductionVariable{
+        init->id(),
+        oper->assign_operator() == "+=" ? step_value : -step_value};
+}
+
+bool LoopWritesCollector::is_invariant(Node *node, const LoopWrites &writes) {
+    if (auto *rvalue = dynamic_cast<RvalueOperation *>(node);
+        rvalue != nullptr) {
+        for (auto *value : rvalue->rpn()) {
+            if (!is_invariant(value, writes)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (auto *var = dynamic_cast<VariableAccess *>(node); var != nullptr) {
+        return writes.names_.count(var->id()) == 0;
+    }
+    return dynamic_cast<IntegerLiteral *>(node) != nullptr ||
+        dynamic_cast<StringLiteral *>(node) != nullptr ||
+        dynamic_cast<ArithmeticOperator *>(node) != nullptr ||
+        dynamic_cast<RelationalOperator *>(node) != nullptr;
+}
+
+void LoopWritesCollector::visit(LocalScope &node) {
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void LoopWritesCollector::visit(Expression &node) {
+    node.expression()->accept(*this);
+}
+
+void LoopWritesCollector::visit(FunctionCall &node) {
+    writes_.callees_.insert(node.id());
+    for (auto *arg : node.args()) {
+        arg->accept(*this);
+    }
+}
+
+void LoopWritesCollector::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void LoopWritesCollector::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+void LoopWritesCollector::visit(ReturnStatement &node) {
+    node.value()->accept(*this);
+}
+
+void LoopWritesCollector::visit(ForStatement &node) {
+    if (node.for_data_using() != nullptr) {
+        node.for_data_using()->accept(*this);
+    }
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(*this);
+    }
+    if (node.value() != nullptr) {
+        node.value()->accept(*this);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void LoopWritesCollector::visit(IfStatement &node) {
+    node.truth_value()->accept(*this);
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+}
+
+void LoopWritesCollector::visit(ArrayUninit &node) {
+    writes_.names_.insert(node.id());
+    node.size()->accept(*this);
+}
+
+void LoopWritesCollector::visit(ArrayElementAccess &node) {
+    node.idx()->accept(*this);
+}
+
+void LoopWritesCollector::visit(VariableInit &node) {
+    writes_.names_.insert(node.id());
+    node.value()->accept(*this);
+}
+
+void LoopWritesCollector::visit(VariableUninit &node) {
+    writes_.names_.insert(node.id());
+}
+
+// Replays the evaluation of the RPN to find the left operands of the
+// assignment operators
+void LoopWritesCollector::visit(Assignment &node) {
+    Childs operands;
+    for (auto *value : node.rpn()) {
+        if (dynamic_cast<AssignmentOperator *>(value) != nullptr) {
+            operands.pop_back();
+            if (auto *var = dynamic_cast<VariableAccess *>(operands.back());
+                var != nullptr) {
+                writes_.names_.insert(var->id());
+            } else {
+                writes_.writes_memory_ = true;
+            }
+            operands.back() = nullptr;
+        } else if (
+            dynamic_cast<ArithmeticOperator *>(value) != nullptr ||
+            dynamic_cast<RelationalOperator *>(value) != nullptr) {
+            operands.pop_back();
+            operands.back() = nullptr;
+        } else {
+            value->accept(*this);
+            operands.push_back(value);
+        }
+    }
+}
+
+void LoopWritesCollector::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void LoopWritesCollector::visit(StringLiteral &node) {
+    if (node.string().find("%n") != std::string::npos) {
+        writes_.writes_memory_ = true;
+    }
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <libc/ast/visitor.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_set>
+
+namespace c::ast::detail {
+
+// What the condition, the step and the body of a loop may change
+struct LoopWrites {
+    // Variables the loop declares or assigns. A name may refer to different
+    // variables, so it's an over-approximation of the written ones.
+    std::unordered_set<std::string> names_;
+    // Functions the loop calls, their stores aren't known here
+    std::unordered_set<std::string> callees_;
+    // Assignments to array elements and printf with %n
+    bool writes_memory_{false};
+};
+
+// A counter the loop declares that only the step changes, by a constant
+struct InductionVariable {
+    std::string name_;
+    std::int64_t step_{0};
+};
+
+class LoopWritesCollector final : public Visitor {
+  public:
+    static LoopWrites exec(ForStatement &node);
+
+    // The counter of for (T i = ...; ...; i += c) or i -= c if neither the
+    // condition nor the body writes it
+    static std::optional<InductionVariable> find_induction_variable(
+        ForStatement &node);
+
+    // The value of the expression is the same in every iteration if it reads
+    // only the variables the loop doesn't write
+    static bool is_invariant(Node *node, const LoopWrites &writes);
+
+    void visit(LocalScope &node) override;
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+    void visit(VariableInit &node) override;
+    void visit(VariableUninit &node) override;
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+    void visit(StringLiteral &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(FunctionDefinition & /*node*/) override {}
+    void visit(ContinueStatement & /*node*/) override {}
+    void visit(BreakStatement & /*node*/) override {}
+    void visit(VariableAccess & /*node*/) override {}
+    void visit(AssignmentOperator & /*node*/) override {}
+    void visit(ArithmeticOperator & /*node*/) override {}
+    void visit(RelationalOperator & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+    void visit(IntegerLiteral & /*node*/) override {}
+
+    LoopWrites writes_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
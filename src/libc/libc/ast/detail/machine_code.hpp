@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Registers of x86-64 are numbered as in the encoding of the instructions,
+// the xmm ones after the general purpose ones. The instruction selection
+// numbers its virtual registers from c_first_virtual on.
+using Reg = std::uint32_t;
+
+namespace x86 {
+enum : Reg {
+    rax,
+    rcx,
+    rdx,
+    rbx,
+    rsp,
+    rbp,
+    rsi,
+    rdi,
+    r8,
+    r9,
+    r10,
+    r11,
+    r12,
+    r13,
+    r14,
+    r15,
+    xmm0,
+    xmm1,
+    xmm2,
+    xmm3,
+    xmm4,
+    xmm5,
+    xmm6,
+    xmm7,
+    xmm8,
+    xmm9,
+    xmm10,
+    xmm11,
+    xmm12,
+    xmm13,
+    xmm14,
+    xmm15
+};
+} // namespace x86
+
+constexpr Reg c_no_reg = static_cast<Reg>(-1);
+constexpr Reg c_first_virtual = 32;
+
+inline bool is_xmm(Reg reg) {
+    return reg >= x86::xmm0 && reg <= x86::xmm15;
+}
+
+// Size of the operands. The integers of 8, 16 and 32 bits are kept in the
+// registers sign extended to 32 bits, so they are operated on as b32.
+enum class Width : std::uint8_t { b8, b16, b32, b64, f32, f64 };
+
+// Condition codes in the order of their encoding, the opposite of a
+// condition differs in the lowest bit
+enum class Cond : std::uint8_t {
+    o,
+    no,
+    b,
+    ae,
+    e,
+    ne,
+    be,
+    a,
+    s,
+    ns,
+    p,
+    np,
+    l,
+    ge,
+    le,
+    g
+};
+
+inline Cond negate(Cond cond) {
+    return static_cast<Cond>(static_cast<std::uint8_t>(cond) ^ 1U);
+}
+
+// [base + index * scale + disp]. The base is either a register, a stack
+// object of the function or the rip-relative address of a symbol.
+struct Address {
+    static constexpr std::size_t no_object = static_cast<std::size_t>(-1);
+
+    Reg base_{c_no_reg};
+    Reg index_{c_no_reg};
+    std::uint8_t scale_{1};
+    std::int32_t disp_{0};
+    std::size_t frame_object_{no_object};
+    std::string symbol_;
+};
+
+struct Operand {
+    enum class Kind : std::uint8_t { none, reg, imm, mem, label, symbol };
+
+    static Operand make_reg(Reg reg) {
+        Operand operand;
+        operand.kind_ = Kind::reg;
+        operand.reg_ = reg;
+        return operand;
+    }
+    static Operand make_imm(std::int64_t imm) {
+        Operand operand;
+        operand.kind_ = Kind::imm;
+        operand.imm_ = imm;
+        return operand;
+    }
+    static Operand make_mem(Address mem) {
+        Operand operand;
+        operand.kind_ = Kind::mem;
+        operand.mem_ = std::move(mem);
+        return operand;
+    }
+    // A block of the function
+    static Operand make_label(std::size_t block) {
+        Operand operand;
+        operand.kind_ = Kind::label;
+        operand.imm_ = static_cast<std::int64_t>(block);
+        return operand;
+    }
+    // A function or the address of a string constant
+    static Operand make_symbol(std::string symbol) {
+        Operand operand;
+        operand.kind_ = Kind::symbol;
+        operand.symbol_ = std::move(symbol);
+        return operand;
+    }
+
+    bool is_reg() const {
+        return kind_ == Kind::reg;
+    }
+
+    Kind kind_{Kind::none};
+    Reg reg_{c_no_reg};
+    std::int64_t imm_{0};
+    Address mem_;
+    std::string symbol_;
+};
+
+enum class Opcode : std::uint8_t {
+    mov,
+    // Sign and zero extension from src_width_
+    movsx,
+    movzx,
+    lea,
+    add,
+    sub,
+    // With an immediate: dst = dst * imm
+    imul,
+    and_,
+    or_,
+    neg,
+    cmp,
+    test,
+    setcc,
+    jcc,
+    jmp,
+    // cdq or cqo: the sign of rax into rdx
+    cdq,
+    idiv,
+    push,
+    pop,
+    call,
+    ret,
+
+    // SSE of the width f32 or f64
+    movs,
+    movaps,
+    adds,
+    subs,
+    muls,
+    divs,
+    ucomis,
+    xorps,
+    // From the integer of src_width_
+    cvtsi2s,
+    // To the integer of the width from the float of src_width_
+    cvtts2si,
+    // From the float of src_width_
+    cvts2s,
+
+    // Pseudo instructions of the selection, the register allocation
+    // expands them by the calling convention.
+    // Defines the registers of args_ by the parameters.
+    params,
+    // Calls symbol of src_ with args_, the result goes to dst_. Variadic
+    // calls set al to the number of vector registers.
+    call_args,
+    // Returns src_ if it isn't none
+    ret_value
+};
+
+struct Instruction {
+    explicit Instruction(Opcode opcode) : opcode_(opcode) {}
+
+    Opcode opcode_;
+    Width width_{Width::b64};
+    Width src_width_{Width::b64};
+    Cond cond_{Cond::e};
+    Operand dst_;
+    Operand src_;
+    std::vector<Operand> args_;
+    bool is_variadic_{false};
+};
+
+struct MachineBlock {
+    std::vector<Instruction> instructions_;
+};
+
+struct FrameObject {
+    std::size_t size_;
+};
+
+struct MachineFunction {
+    // The register is of the xmm class
+    bool is_float(Reg reg) const {
+        return reg >= c_first_virtual ? is_float_[reg - c_first_virtual]
+                                      : is_xmm(reg);
+    }
+
+    std::string name_;
+    bool is_exported_{false};
+    std::vector<MachineBlock> blocks_;
+    // For every virtual register
+    std::vector<bool> is_float_;
+    std::vector<FrameObject> frame_objects_;
+
+    // Set by the register allocation: the callee-saved registers pushed
+    // after rbp and the size of the frame below them
+    std::vector<Reg> saved_regs_;
+    std::size_t frame_size_{0};
+};
+
+struct MachineModule {
+    std::vector<MachineFunction> functions_;
+    // Contents of the string constants .str<N> without the terminating zero
+    std::vector<std::string> strings_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,800 @@
+#include <libc/ast/detail/register_allocator.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+namespace c::ast::detail {
+
+namespace {
+
+constexpr std::size_t c_no_position = std::numeric_limits<std::size_t>::max();
+constexpr std::size_t c_no_slot = std::numeric_limits<std::size_t>::max();
+
+const std::vector<Reg> c_int_arg_regs = {
+    x86::rdi, x86::rsi, x86::rdx, x86::rcx, x86::r8, x86::r9};
+const std::vector<Reg> c_float_arg_regs = {
+    x86::xmm0,
+    x86::xmm1,
+    x86::xmm2,
+    x86::xmm3,
+    x86::xmm4,
+    x86::xmm5,
+    x86::xmm6,
+    x86::xmm7};
+
+// rax and rdx are taken by idiv and the return values, rsp and rbp by the
+// frame, r10, r11, xmm14 and xmm15 are the scratch registers. The
+// caller-saved registers go first, they don't have to be saved.
+const std::vector<Reg> c_int_regs = {
+    x86::rcx,
+    x86::rsi,
+    x86::rdi,
+    x86::r8,
+    x86::r9,
+    x86::rbx,
+    x86::r12,
+    x86::r13,
+    x86::r14,
+    x86::r15};
+const std::vector<Reg> c_callee_saved_regs = {
+    x86::rbx, x86::r12, x86::r13, x86::r14, x86::r15};
+const std::vector<Reg> c_float_regs = {
+    x86::xmm0,
+    x86::xmm1,
+    x86::xmm2,
+    x86::xmm3,
+    x86::xmm4,
+    x86::xmm5,
+    x86::xmm6,
+    x86::xmm7,
+    x86::xmm8,
+    x86::xmm9,
+    x86::xmm10,
+    x86::xmm11,
+    x86::xmm12,
+    x86::xmm13};
+// No xmm register is callee-saved
+const std::vector<Reg> c_no_regs;
+
+// An instruction takes at most three integer registers: the base and the
+// index of an address and a value. rax is free then, it's only taken
+// between the instructions of a division.
+const std::vector<Reg> c_int_scratch = {x86::r11, x86::r10, x86::rax};
+const std::vector<Reg> c_float_scratch = {x86::xmm15, x86::xmm14};
+
+// Calls visit(reg, is_use, is_def) for every register of the instruction,
+// the uses go before the defs. xorps of a register with itself doesn't
+// read it.
+template <class Visit>
+void for_each_reg(Instruction &instruction, Visit visit) {
+    for (auto *operand : {&instruction.dst_, &instruction.src_}) {
+        if (operand->kind_ == Operand::Kind::mem) {
+            if (operand->mem_.base_ != c_no_reg) {
+                visit(operand->mem_.base_, true, false);
+            }
+            if (operand->mem_.index_ != c_no_reg) {
+                visit(operand->mem_.index_, true, false);
+            }
+        }
+    }
+
+    switch (instruction.opcode_) {
+    case Opcode::params:
+        for (auto &arg : instruction.args_) {
+            visit(arg.reg_, false, true);
+        }
+        return;
+    case Opcode::call_args:
+        for (auto &arg : instruction.args_) {
+            if (arg.is_reg()) {
+                visit(arg.reg_, true, false);
+            }
+        }
+        if (instruction.dst_.is_reg()) {
+            visit(instruction.dst_.reg_, false, true);
+        }
+        return;
+    default:
+        break;
+    }
+
+    const bool is_zeroing = instruction.opcode_ == Opcode::xorps &&
+        instruction.src_.reg_ == instruction.dst_.reg_;
+    if (instruction.src_.is_reg()) {
+        visit(instruction.src_.reg_, !is_zeroing, false);
+    }
+    if (!instruction.dst_.is_reg()) {
+        return;
+    }
+    bool is_use = false;
+    bool is_def = false;
+    switch (instruction.opcode_) {
+    case Opcode::mov:
+    case Opcode::movsx:
+    case Opcode::movzx:
+    case Opcode::lea:
+    case Opcode::setcc:
+    case Opcode::pop:
+    case Opcode::movs:
+    case Opcode::movaps:
+    case Opcode::cvtsi2s:
+    case Opcode::cvtts2si:
+    case Opcode::cvts2s:
+        is_def = true;
+        break;
+    case Opcode::cmp:
+    case Opcode::test:
+    case Opcode::ucomis:
+    case Opcode::idiv:
+    case Opcode::push:
+    case Opcode::ret_value:
+        is_use = true;
+        break;
+    default:
+        is_use = !is_zeroing;
+        is_def = true;
+        break;
+    }
+    visit(instruction.dst_.reg_, is_use, is_def);
+}
+
+bool is_jump(const Instruction &instruction) {
+    return instruction.opcode_ == Opcode::jmp ||
+        instruction.opcode_ == Opcode::jcc;
+}
+
+bool is_same(const Operand &lhs, const Operand &rhs) {
+    if (lhs.kind_ != rhs.kind_) {
+        return false;
+    }
+    switch (lhs.kind_) {
+    case Operand::Kind::reg:
+        return lhs.reg_ == rhs.reg_;
+    case Operand::Kind::mem:
+        return lhs.mem_.base_ == rhs.mem_.base_ &&
+            lhs.mem_.index_ == rhs.mem_.index_ &&
+            lhs.mem_.disp_ == rhs.mem_.disp_ &&
+            lhs.mem_.symbol_ == rhs.mem_.symbol_;
+    default:
+        return false;
+    }
+}
+
+// A set of virtual registers
+using RegSet = std::vector<std::uint64_t>;
+
+bool contains(const RegSet &set, std::size_t index) {
+    return ((set[index / 64] >> (index % 64)) & 1U) != 0;
+}
+
+void insert(RegSet &set, std::size_t index) {
+    set[index / 64] |= std::uint64_t{1} << (index % 64);
+}
+
+template <class Visit> void for_each_index(const RegSet &set, Visit visit) {
+    for (std::size_t word = 0; word < set.size(); ++word) {
+        for (auto bits = set[word]; bits != 0; bits &= bits - 1) {
+            visit(word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits)));
+        }
+    }
+}
+
+} // namespace
+
+void RegisterAllocator::exec(MachineFunction &func) {
+    RegisterAllocator allocator(func);
+    allocator.build_intervals();
+    allocator.scan();
+    allocator.lay_out_frame();
+    allocator.rewrite();
+}
+
+// Positions: the uses of the instruction i are at 2i, its defs at 2i + 1
+void RegisterAllocator::build_intervals() {
+    const auto count = func_.is_float_.size();
+    const auto words = (count + 63) / 64;
+    auto &blocks = func_.blocks_;
+
+    intervals_.resize(count);
+    hints_.assign(count, c_no_reg);
+    for (std::size_t i = 0; i < count; ++i) {
+        intervals_[i] = {
+            c_first_virtual + static_cast<Reg>(i), c_no_position, 0};
+    }
+    auto extend = [this](std::size_t index, std::size_t position) {
+        auto &interval = intervals_[index];
+        interval.start_ = std::min(interval.start_, position);
+        interval.end_ = std::max(interval.end_, position);
+    };
+    auto hint = [this](Reg reg, Reg other) {
+        if (reg >= c_first_virtual && hints_[get_index(reg)] == c_no_reg) {
+            hints_[get_index(reg)] = other;
+        }
+    };
+
+    std::vector<RegSet> uses(blocks.size(), RegSet(words));
+    std::vector<RegSet> defs(blocks.size(), RegSet(words));
+    std::vector<std::size_t> firsts(blocks.size());
+    std::vector<std::vector<std::size_t>> succs(blocks.size());
+    std::vector<std::size_t> calls;
+    std::size_t position = 0;
+    for (std::size_t block = 0; block < blocks.size(); ++block) {
+        firsts[block] = position;
+        bool is_falling_through = true;
+        for (auto &instruction : blocks[block].instructions_) {
+            for_each_reg(
+                instruction, [&](Reg &reg, bool is_use, bool is_def) {
+                    if (reg < c_first_virtual) {
+                        return;
+                    }
+                    auto index = get_index(reg);
+                    if (is_use) {
+                        if (!contains(defs[block], index)) {
+                            insert(uses[block], index);
+                        }
+                        extend(index, 2 * position);
+                    }
+                    if (is_def) {
+                        insert(defs[block], index);
+                        extend(index, 2 * position + 1);
+                    }
+                });
+
+            if (is_jump(instruction)) {
+                succs[block].push_back(
+                    static_cast<std::size_t>(instruction.dst_.imm_));
+            }
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::ret_value) {
+                is_falling_through = false;
+            }
+            if (instruction.opcode_ == Opcode::call_args) {
+                calls.push_back(position);
+            }
+
+            // The moves get the registers of each other, the arguments the
+            // ones they are passed in
+            if ((instruction.opcode_ == Opcode::mov ||
+                 instruction.opcode_ == Opcode::movaps) &&
+                instruction.dst_.is_reg() && instruction.src_.is_reg()) {
+                hint(instruction.dst_.reg_, instruction.src_.reg_);
+                hint(instruction.src_.reg_, instruction.dst_.reg_);
+            }
+            if (instruction.opcode_ == Opcode::params ||
+                instruction.opcode_ == Opcode::call_args) {
+                std::size_t ints = 0;
+                std::size_t floats = 0;
+                for (const auto &arg : instruction.args_) {
+                    if (!arg.is_reg()) {
+                        ++ints;
+                    } else if (func_.is_float(arg.reg_)) {
+                        if (floats < c_float_arg_regs.size()) {
+                            hint(arg.reg_, c_float_arg_regs[floats]);
+                        }
+                        ++floats;
+                    } else {
+                        if (ints < c_int_arg_regs.size()) {
+                            hint(arg.reg_, c_int_arg_regs[ints]);
+                        }
+                        ++ints;
+                    }
+                }
+            }
+            ++position;
+        }
+        if (is_falling_through && block + 1 < blocks.size()) {
+            succs[block].push_back(block + 1);
+        }
+    }
+
+    std::vector<RegSet> live_ins(blocks.size(), RegSet(words));
+    std::vector<RegSet> live_outs(blocks.size(), RegSet(words));
+    for (bool is_changed = true; is_changed;) {
+        is_changed = false;
+        for (auto block = blocks.size(); block-- > 0;) {
+            auto &live_out = live_outs[block];
+            for (auto succ : succs[block]) {
+                for (std::size_t word = 0; word < words; ++word) {
+                    live_out[word] |= live_ins[succ][word];
+                }
+            }
+            for (std::size_t word = 0; word < words; ++word) {
+                auto live_in =
+                    uses[block][word] | (live_out[word] & ~defs[block][word]);
+                if (live_in != live_ins[block][word]) {
+                    live_ins[block][word] = live_in;
+                    is_changed = true;
+                }
+            }
+        }
+    }
+
+    for (std::size_t block = 0; block < blocks.size(); ++block) {
+        const auto first = 2 * firsts[block];
+        const auto size = blocks[block].instructions_.size();
+        const auto last = size == 0 ? first : first + 2 * size - 1;
+        for_each_index(live_ins[block], [&](std::size_t index) {
+            extend(index, first);
+        });
+        for_each_index(live_outs[block], [&](std::size_t index) {
+            extend(index, last);
+        });
+    }
+
+    for (auto &interval : intervals_) {
+        auto call = std::upper_bound(
+            calls.begin(), calls.end(), interval.start_,
+            [](std::size_t start, std::size_t call) {
+                return start < 2 * call;
+            });
+        interval.crosses_call_ =
+            call != calls.end() && 2 * *call + 1 < interval.end_;
+    }
+}
+
+void RegisterAllocator::scan() {
+    std::vector<const Interval *> order;
+    for (const auto &interval : intervals_) {
+        if (interval.start_ != c_no_position) {
+            order.push_back(&interval);
+        }
+    }
+    std::sort(order.begin(), order.end(), [](const auto *lhs, const auto *rhs) {
+        return lhs->start_ != rhs->start_ ? lhs->start_ < rhs->start_
+                                          : lhs->reg_ < rhs->reg_;
+    });
+
+    assigned_.assign(intervals_.size(), c_no_reg);
+    slots_.assign(intervals_.size(), c_no_slot);
+    std::vector<bool> is_free(c_first_virtual);
+    for (auto reg : c_int_regs) {
+        is_free[reg] = true;
+    }
+    for (auto reg : c_float_regs) {
+        is_free[reg] = true;
+    }
+
+    // Intervals that have registers at the current position
+    std::vector<const Interval *> active;
+    for (const auto *interval : order) {
+        active.erase(
+            std::remove_if(
+                active.begin(), active.end(),
+                [&](const Interval *other) {
+                    if (other->end_ >= interval->start_) {
+                        return false;
+                    }
+                    is_free[assigned_[get_index(other->reg_)]] = true;
+                    return true;
+                }),
+            active.end());
+
+        const auto &candidates = get_candidates(*interval);
+        auto is_candidate = [&candidates](Reg reg) {
+            return std::find(candidates.begin(), candidates.end(), reg) !=
+                candidates.end();
+        };
+        auto choice = c_no_reg;
+        auto hint = hints_[get_index(interval->reg_)];
+        if (hint != c_no_reg && hint >= c_first_virtual) {
+            hint = assigned_[get_index(hint)];
+        }
+        if (hint != c_no_reg && is_free[hint] && is_candidate(hint)) {
+            choice = hint;
+        } else {
+            for (auto reg : candidates) {
+                if (is_free[reg]) {
+                    choice = reg;
+                    break;
+                }
+            }
+        }
+
+        if (choice == c_no_reg) {
+            // The interval that ends last gives up its register
+            auto victim = active.end();
+            auto end = interval->end_;
+            for (auto it = active.begin(); it != active.end(); ++it) {
+                if ((*it)->end_ > end &&
+                    is_candidate(assigned_[get_index((*it)->reg_)])) {
+                    victim = it;
+                    end = (*it)->end_;
+                }
+            }
+            if (victim == active.end()) {
+                spill(interval->reg_);
+                continue;
+            }
+            choice = assigned_[get_index((*victim)->reg_)];
+            spill((*victim)->reg_);
+            active.erase(victim);
+        }
+        assigned_[get_index(interval->reg_)] = choice;
+        is_free[choice] = false;
+        active.push_back(interval);
+    }
+}
+
+const std::vector<Reg> &RegisterAllocator::get_candidates(
+    const Interval &interval) const {
+    if (func_.is_float(interval.reg_)) {
+        return interval.crosses_call_ ? c_no_regs : c_float_regs;
+    }
+    return interval.crosses_call_ ? c_callee_saved_regs : c_int_regs;
+}
+
+void RegisterAllocator::spill(Reg reg) {
+    assigned_[get_index(reg)] = c_no_reg;
+    slots_[get_index(reg)] = func_.frame_objects_.size();
+    func_.frame_objects_.push_back({8});
+}
+
+// The frame from rbp down: the saved registers, the frame objects and the
+// padding that aligns the stack to 16 bytes for the calls
+void RegisterAllocator::lay_out_frame() {
+    for (auto reg : c_callee_saved_regs) {
+        if (std::find(assigned_.begin(), assigned_.end(), reg) !=
+            assigned_.end()) {
+            func_.saved_regs_.push_back(reg);
+        }
+    }
+
+    const auto saved_size = 8 * func_.saved_regs_.size();
+    auto offset = saved_size;
+    for (const auto &object : func_.frame_objects_) {
+        offset += (object.size_ + 7) / 8 * 8;
+        offsets_.push_back(offset);
+    }
+    func_.frame_size_ = (offset + 15) / 16 * 16 - saved_size;
+}
+
+void RegisterAllocator::rewrite() {
+    auto &blocks = func_.blocks_;
+    for (std::size_t block = 0; block < blocks.size(); ++block) {
+        std::vector<Instruction> instructions;
+        out_ = &instructions;
+
+        if (block == 0) {
+            emit(Opcode::push, Width::b64, Operand::make_reg(x86::rbp));
+            emit(
+                Opcode::mov, Width::b64, Operand::make_reg(x86::rbp),
+                Operand::make_reg(x86::rsp));
+            for (auto reg : func_.saved_regs_) {
+                emit(Opcode::push, Width::b64, Operand::make_reg(reg));
+            }
+            if (func_.frame_size_ > 0) {
+                emit(
+                    Opcode::sub, Width::b64, Operand::make_reg(x86::rsp),
+                    Operand::make_imm(
+                        static_cast<std::int64_t>(func_.frame_size_)));
+            }
+        }
+
+        for (auto &instruction : blocks[block].instructions_) {
+            switch (instruction.opcode_) {
+            case Opcode::params:
+                expand_params(instruction);
+                break;
+            case Opcode::call_args:
+                expand_call(instruction);
+                break;
+            case Opcode::ret_value:
+                expand_ret(instruction);
+                break;
+            default:
+                if (!rewrite_move(instruction)) {
+                    rewrite_instruction(std::move(instruction));
+                }
+                break;
+            }
+        }
+        blocks[block].instructions_ = std::move(instructions);
+    }
+    out_ = nullptr;
+}
+
+Address RegisterAllocator::get_slot(std::size_t frame_object) const {
+    Address address;
+    address.base_ = x86::rbp;
+    address.disp_ = -static_cast<std::int32_t>(offsets_[frame_object]);
+    return address;
+}
+
+// The register or the stack slot of a virtual register
+Operand RegisterAllocator::locate(const Operand &operand) const {
+    if (!operand.is_reg() || operand.reg_ < c_first_virtual) {
+        return operand;
+    }
+    auto index = get_index(operand.reg_);
+    if (assigned_[index] != c_no_reg) {
+        return Operand::make_reg(assigned_[index]);
+    }
+    return Operand::make_mem(get_slot(slots_[index]));
+}
+
+// Addresses the frame objects from rbp
+void RegisterAllocator::resolve(Operand &operand) const {
+    if (operand.kind_ != Operand::Kind::mem ||
+        operand.mem_.frame_object_ == Address::no_object) {
+        return;
+    }
+    operand.mem_.base_ = x86::rbp;
+    operand.mem_.disp_ -=
+        static_cast<std::int32_t>(offsets_[operand.mem_.frame_object_]);
+    operand.mem_.frame_object_ = Address::no_object;
+}
+
+void RegisterAllocator::rewrite_instruction(Instruction instruction) {
+    struct Scratch {
+        Reg vreg_;
+        Reg reg_;
+        bool is_loaded_;
+        bool is_stored_;
+    };
+    std::vector<Scratch> scratches;
+    std::size_t ints = 0;
+    std::size_t floats = 0;
+    for_each_reg(instruction, [&](Reg &reg, bool is_use, bool is_def) {
+        if (reg < c_first_virtual) {
+            return;
+        }
+        auto index = get_index(reg);
+        if (assigned_[index] != c_no_reg) {
+            reg = assigned_[index];
+            return;
+        }
+        auto it = std::find_if(
+            scratches.begin(), scratches.end(),
+            [reg](const Scratch &scratch) { return scratch.vreg_ == reg; });
+        if (it == scratches.end()) {
+            auto scratch = func_.is_float(reg) ? c_float_scratch[floats++]
+                                               : c_int_scratch[ints++];
+            scratches.push_back({reg, scratch, false, false});
+            it = std::prev(scratches.end());
+        }
+        it->is_loaded_ = it->is_loaded_ || is_use;
+        it->is_stored_ = it->is_stored_ || is_def;
+        reg = it->reg_;
+    });
+    resolve(instruction.dst_);
+    resolve(instruction.src_);
+
+    for (const auto &scratch : scratches) {
+        if (scratch.is_loaded_) {
+            emit_move(
+                Operand::make_reg(scratch.reg_),
+                Operand::make_mem(get_slot(slots_[get_index(scratch.vreg_)])),
+                is_xmm(scratch.reg_));
+        }
+    }
+    out_->push_back(std::move(instruction));
+    for (const auto &scratch : scratches) {
+        if (scratch.is_stored_) {
+            emit_move(
+                Operand::make_mem(get_slot(slots_[get_index(scratch.vreg_)])),
+                Operand::make_reg(scratch.reg_), is_xmm(scratch.reg_));
+        }
+    }
+}
+
+// A copy between the registers reads or writes the stack slot directly,
+// it's dropped if both got the same register
+bool RegisterAllocator::rewrite_move(const Instruction &instruction) {
+    if ((instruction.opcode_ != Opcode::mov &&
+         instruction.opcode_ != Opcode::movaps) ||
+        !instruction.dst_.is_reg() ||
+        (!instruction.src_.is_reg() &&
+         instruction.src_.kind_ != Operand::Kind::imm)) {
+        return false;
+    }
+    const bool is_float = instruction.opcode_ == Opcode::movaps;
+    auto dst = locate(instruction.dst_);
+    auto src = locate(instruction.src_);
+    if (dst.is_reg() && src.is_reg()) {
+        if (dst.reg_ != src.reg_) {
+            emit(instruction.opcode_, instruction.width_, dst, src);
+        }
+    } else if (dst.is_reg()) {
+        emit(
+            is_float ? Opcode::movs : Opcode::mov,
+            is_float ? Width::f64 : instruction.width_, dst, src);
+    } else {
+        emit_move(dst, src, is_float);
+    }
+    return true;
+}
+
+void RegisterAllocator::expand_params(const Instruction &instruction) {
+    std::vector<Move> moves;
+    std::size_t ints = 0;
+    std::size_t floats = 0;
+    std::int32_t stack_offset = 16;
+    for (const auto &arg : instruction.args_) {
+        const bool is_float = func_.is_float(arg.reg_);
+        Operand src;
+        if (is_float && floats < c_float_arg_regs.size()) {
+            src = Operand::make_reg(c_float_arg_regs[floats++]);
+        } else if (!is_float && ints < c_int_arg_regs.size()) {
+            src = Operand::make_reg(c_int_arg_regs[ints++]);
+        } else {
+            Address address;
+            address.base_ = x86::rbp;
+            address.disp_ = stack_offset;
+            stack_offset += 8;
+            src = Operand::make_mem(address);
+        }
+        moves.push_back({locate(arg), std::move(src), is_float});
+    }
+    emit_moves(std::move(moves));
+}
+
+// The arguments that don't fit into the registers are pushed in reverse,
+// the stack stays aligned to 16 bytes at the call
+void RegisterAllocator::expand_call(const Instruction &instruction) {
+    std::vector<Move> moves;
+    std::vector<Operand> stack_args;
+    std::size_t ints = 0;
+    std::size_t floats = 0;
+    for (const auto &arg : instruction.args_) {
+        const bool is_float = arg.is_reg() && func_.is_float(arg.reg_);
+        if (is_float && floats < c_float_arg_regs.size()) {
+            moves.push_back(
+                {Operand::make_reg(c_float_arg_regs[floats++]), locate(arg),
+                 true});
+        } else if (!is_float && ints < c_int_arg_regs.size()) {
+            moves.push_back(
+                {Operand::make_reg(c_int_arg_regs[ints++]), locate(arg),
+                 false});
+        } else {
+            stack_args.push_back(locate(arg));
+        }
+    }
+
+    const auto rsp = Operand::make_reg(x86::rsp);
+    std::int64_t stack_size = 8 * static_cast<std::int64_t>(stack_args.size());
+    if (stack_args.size() % 2 != 0) {
+        stack_size += 8;
+        emit(Opcode::sub, Width::b64, rsp, Operand::make_imm(8));
+    }
+    for (auto it = stack_args.rbegin(); it != stack_args.rend(); ++it) {
+        if (it->is_reg() && is_xmm(it->reg_)) {
+            emit(Opcode::sub, Width::b64, rsp, Operand::make_imm(8));
+            Address top;
+            top.base_ = x86::rsp;
+            emit(Opcode::movs, Width::f64, Operand::make_mem(top), *it);
+        } else {
+            emit(Opcode::push, Width::b64, *it);
+        }
+    }
+    emit_moves(std::move(moves));
+
+    // al holds the number of the vector registers of a variadic call
+    if (instruction.is_variadic_) {
+        emit(
+            Opcode::mov, Width::b32, Operand::make_reg(x86::rax),
+            Operand::make_imm(static_cast<std::int64_t>(floats)));
+    }
+    emit(Opcode::call, Width::b64, instruction.src_);
+    if (stack_size > 0) {
+        emit(Opcode::add, Width::b64, rsp, Operand::make_imm(stack_size));
+    }
+
+    if (instruction.dst_.is_reg()) {
+        const bool is_float = func_.is_float(instruction.dst_.reg_);
+        emit_move(
+            locate(instruction.dst_),
+            Operand::make_reg(is_float ? x86::xmm0 : x86::rax), is_float);
+    }
+}
+
+void RegisterAllocator::expand_ret(const Instruction &instruction) {
+    if (instruction.src_.kind_ != Operand::Kind::none) {
+        const bool is_float = instruction.width_ == Width::f32 ||
+            instruction.width_ == Width::f64;
+        emit_move(
+            Operand::make_reg(is_float ? x86::xmm0 : x86::rax),
+            locate(instruction.src_), is_float);
+    }
+
+    const auto rsp = Operand::make_reg(x86::rsp);
+    const auto rbp = Operand::make_reg(x86::rbp);
+    if (func_.saved_regs_.empty()) {
+        emit(Opcode::mov, Width::b64, rsp, rbp);
+    } else {
+        Address saved;
+        saved.base_ = x86::rbp;
+        saved.disp_ =
+            -8 * static_cast<std::int32_t>(func_.saved_regs_.size());
+        emit(Opcode::lea, Width::b64, rsp, Operand::make_mem(saved));
+        for (auto it = func_.saved_regs_.rbegin();
+             it != func_.saved_regs_.rend(); ++it) {
+            emit(Opcode::pop, Width::b64, Operand::make_reg(*it));
+        }
+    }
+    emit(Opcode::pop, Width::b64, rbp);
+    emit(Opcode::ret, Width::b64, {});
+}
+
+// Performs the moves as if at once. The stack slots are written first,
+// while the registers hold their values, then the registers are moved
+// among each other in an order that reads every register before it's
+// written, a cycle goes through a scratch register. The registers that
+// are loaded from the memory or get constants are written last.
+void RegisterAllocator::emit_moves(std::vector<Move> moves) {
+    moves.erase(
+        std::remove_if(
+            moves.begin(), moves.end(),
+            [](const Move &move) { return is_same(move.dst_, move.src_); }),
+        moves.end());
+
+    std::vector<Move> pending;
+    std::vector<Move> loads;
+    for (auto &move : moves) {
+        if (!move.dst_.is_reg()) {
+            emit_move(move.dst_, move.src_, move.is_float_);
+        } else if (move.src_.is_reg()) {
+            pending.push_back(std::move(move));
+        } else {
+            loads.push_back(std::move(move));
+        }
+    }
+
+    while (!pending.empty()) {
+        auto ready = std::find_if(
+            pending.begin(), pending.end(), [&pending](const Move &move) {
+                return std::none_of(
+                    pending.begin(), pending.end(), [&move](const Move &other) {
+                        return &other != &move &&
+                            other.src_.reg_ == move.dst_.reg_;
+                    });
+            });
+        if (ready == pending.end()) {
+            auto &move = pending.front();
+            auto scratch = Operand::make_reg(
+                move.is_float_ ? c_float_scratch[0] : c_int_scratch[0]);
+            emit_move(scratch, move.src_, move.is_float_);
+            move.src_ = scratch;
+            continue;
+        }
+        emit_move(ready->dst_, ready->src_, ready->is_float_);
+        pending.erase(ready);
+    }
+
+    for (const auto &move : loads) {
+        emit_move(move.dst_, move.src_, move.is_float_);
+    }
+}
+
+// Moves all of the 64 bits, between the memory through a scratch register
+void RegisterAllocator::emit_move(
+    const Operand &dst, const Operand &src, bool is_float) {
+    if (is_same(dst, src)) {
+        return;
+    }
+    if (dst.kind_ == Operand::Kind::mem && src.kind_ == Operand::Kind::mem) {
+        auto scratch = Operand::make_reg(
+            is_float ? c_float_scratch[0] : c_int_scratch[0]);
+        emit_move(scratch, src, is_float);
+        emit_move(dst, scratch, is_float);
+        return;
+    }
+    if (!is_float) {
+        emit(Opcode::mov, Width::b64, dst, src);
+    } else if (dst.is_reg() && src.is_reg()) {
+        emit(Opcode::movaps, Width::f64, dst, src);
+    } else {
+        emit(Opcode::movs, Width::f64, dst, src);
+    }
+}
+
+void RegisterAllocator::emit(
+    Opcode opcode, Width width, Operand dst, Operand src) {
+    Instruction instruction{opcode};
+    instruction.width_ = width;
+    instruction.dst_ = std::move(dst);
+    instruction.src_ = std::move(src);
+    out_->push_back(std::move(instruction));
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <libc/ast/detail/machine_code.hpp>
+
+#include <cstddef>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Assigns the physical registers to the virtual ones of a function by
+// linear scan (Poletto and Sarkar, "Linear Scan Register Allocation") and
+// expands the pseudo instructions by the System V calling convention.
+//
+// A live interval spans the positions of the instructions, in the order of
+// the blocks, from the first to the last one where the register is live.
+// The intervals that are live across a call only get the callee-saved
+// registers. When there are no free registers, the interval that ends last
+// lives in a stack slot for its whole range: its values are loaded into
+// the scratch registers before the instructions and stored after them.
+class RegisterAllocator final {
+  public:
+    static void exec(MachineFunction &func);
+
+  private:
+    struct Interval {
+        Reg reg_;
+        std::size_t start_;
+        std::size_t end_;
+        bool crosses_call_{false};
+    };
+
+    // A move of the parallel moves of the calling convention
+    struct Move {
+        Operand dst_;
+        Operand src_;
+        bool is_float_;
+    };
+
+    explicit RegisterAllocator(MachineFunction &func) : func_(func) {}
+
+    void build_intervals();
+    void scan();
+    const std::vector<Reg> &get_candidates(const Interval &interval) const;
+    void spill(Reg reg);
+    void lay_out_frame();
+    void rewrite();
+
+    std::size_t get_index(Reg reg) const {
+        return reg - c_first_virtual;
+    }
+    Address get_slot(std::size_t frame_object) const;
+    Operand locate(const Operand &operand) const;
+    void resolve(Operand &operand) const;
+
+    void rewrite_instruction(Instruction instruction);
+    bool rewrite_move(const Instruction &instruction);
+    void expand_params(const Instruction &instruction);
+    void expand_call(const Instruction &instruction);
+    void expand_ret(const Instruction &instruction);
+    void emit_moves(std::vector<Move> moves);
+    void emit_move(const Operand &dst, const Operand &src, bool is_float);
+    void emit(
+        Opcode opcode, Width width, Operand dst, Operand src = {});
+
+    MachineFunction &func_;
+    std::vector<Interval> intervals_;
+    // For every virtual register: the physical one, c_no_reg if spilled
+    std::vector<Reg> assigned_;
+    // For every spilled virtual register: its frame object
+    std::vector<std::size_t> slots_;
+    // For every virtual register: the register it's moved from or to
+    std::vector<Reg> hints_;
+    // Byte offsets of the frame objects below rbp
+    std::vector<std::size_t> offsets_;
+    std::vector<Instruction> *out_{nullptr};
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,438 @@
+#include <libc/ast/detail/ssa_builder.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace c::ast::detail {
+
+namespace {
+
+// C identifiers can't contain a dot, so this can't be a parameter name
+const std::string_view c_phi_prefix = "%phi.";
+const std::string_view c_label_prefix = "label %";
+
+bool is_whitespace(std::string_view text) {
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c)) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// The instructions of a block up to its terminator, the code after it is
+// unreachable
+std::size_t count_instructions(std::string_view body) {
+    std::size_t count = 0;
+    for (std::size_t pos = 0; pos < body.size();) {
+        auto end = std::min(body.find('\n', pos), body.size());
+        auto line = body.substr(pos, end - pos);
+        pos = end + 1;
+        if (line.empty() || line.front() != '\t') {
+            continue;
+        }
+        ++count;
+        line.remove_prefix(1);
+        for (std::string_view terminator : {"ret ", "br ", "unreachable"}) {
+            if (line.substr(0, terminator.size()) == terminator) {
+                return count;
+            }
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+void SsaBuilder::reset() {
+    blocks_.clear();
+    block_ids_.clear();
+    block_order_.clear();
+    current_block_ = no_block;
+    phis_.clear();
+    has_replaced_phis_ = false;
+    label_targets_.clear();
+}
+
+std::size_t SsaBuilder::get_block(const std::string &label) {
+    auto [it, is_inserted] = block_ids_.emplace(label, blocks_.size());
+    if (is_inserted) {
+        blocks_.emplace_back();
+        blocks_.back().label_ = label;
+        blocks_.back().tail_ = it->second;
+    }
+    return it->second;
+}
+
+void SsaBuilder::start_block(std::size_t block, std::size_t label_pos) {
+    blocks_[block].is_started_ = true;
+    blocks_[block].label_pos_ = label_pos;
+    block_order_.push_back(block);
+    current_block_ = block;
+}
+
+void SsaBuilder::add_edge(std::size_t from, std::size_t to) {
+    blocks_[to].preds_.push_back(from);
+    blocks_[from].succs_.push_back(to);
+}
+
+void SsaBuilder::add_jump(
+    std::size_t from, std::size_t to, std::size_t jump_pos) {
+    add_edge(from, to);
+    blocks_[from].jump_pos_ = jump_pos;
+}
+
+void SsaBuilder::seal_block(std::size_t block) {
+    auto incomplete_phis = std::move(blocks_[block].incomplete_phis_);
+    for (auto [var, phi] : incomplete_phis) {
+        add_phi_operands(var, phi);
+    }
+    blocks_[block].is_sealed_ = true;
+}
+
+void SsaBuilder::write_variable(
+    const symtab::Symbol *var, std::size_t block, std::string value) {
+    blocks_[block].defs_[var] = std::move(value);
+}
+
+std::string SsaBuilder::read_variable(
+    const symtab::Symbol *var, const std::string &type, std::size_t block) {
+    const auto &defs = blocks_[block].defs_;
+    if (auto it = defs.find(var); it != defs.end()) {
+        return std::string(resolve(it->second));
+    }
+    return read_variable_recursive(var, type, block);
+}
+
+void SsaBuilder::simplify(std::string_view text) {
+    for (std::size_t i = 1; i < block_order_.size(); ++i) {
+        auto &block = blocks_[block_order_[i]];
+        block.is_dropped_ = block.preds_.empty();
+    }
+
+    for (std::size_t i = 1; i < block_order_.size(); ++i) {
+        if (!blocks_[block_order_[i]].is_dropped_ && is_forwarding(i, text)) {
+            bypass(block_order_[i]);
+        }
+    }
+
+    // The block printed last, the ones merged into it included
+    auto prev = block_order_.front();
+    for (std::size_t i = 1; i < block_order_.size(); ++i) {
+        auto block = block_order_[i];
+        if (blocks_[block].is_dropped_) {
+            continue;
+        }
+        const auto &preds = blocks_[block].preds_;
+        const auto &prev_succs = blocks_[prev].succs_;
+        if (preds.size() == 1 && preds.front() == prev &&
+            prev_succs.size() == 1 &&
+            blocks_[blocks_[prev].tail_].jump_pos_ != no_pos &&
+            !has_live_phis(block)) {
+            merge(prev, block);
+            continue;
+        }
+        prev = block;
+    }
+}
+
+std::size_t SsaBuilder::print(
+    std::ostream &os, std::string_view text, std::string_view entry_code)
+    const {
+    if (block_order_.empty()) {
+        print_resolved(os, text);
+        return count_instructions(text);
+    }
+
+    std::size_t instructions = count_instructions(entry_code);
+    print_resolved(os, text.substr(0, blocks_[block_order_[0]].label_pos_));
+    for (std::size_t i = 0; i < block_order_.size(); ++i) {
+        const auto &block = blocks_[block_order_[i]];
+        if (block.is_dropped_) {
+            continue;
+        }
+
+        const bool is_reachable = i == 0 || !block.preds_.empty();
+        auto body_pos = text.find('\n', block.label_pos_) + 1;
+        if (!block.is_merged_ && !is_droppable(i, text)) {
+            os << text.substr(block.label_pos_, body_pos - block.label_pos_);
+            for (auto phi_idx : block.phis_) {
+                const auto &phi = phis_[phi_idx];
+                if (!phi.replacement_.empty()) {
+                    continue;
+                }
+                os << "\t" << phi.name_ << " = phi " << phi.type_ << " ";
+                for (std::size_t j = 0; j < phi.operands_.size(); ++j) {
+                    const auto &[value, pred] = phi.operands_[j];
+                    os << (j == 0 ? "[ " : ", [ ") << resolve(value) << ", %"
+                       << blocks_[pred].label_ << " ]";
+                }
+                os << "\n";
+                instructions += is_reachable ? 1 : 0;
+            }
+        }
+        if (i == 0) {
+            os << entry_code;
+        }
+
+        auto body_end = get_body_end(i, text.size());
+        if (is_reachable) {
+            // The dropped jump is the terminator of the block
+            instructions +=
+                count_instructions(
+                    text.substr(body_pos, body_end - body_pos)) -
+                (block.is_jump_dropped_ ? 1 : 0);
+        }
+        if (block.is_jump_dropped_) {
+            auto jump_end = text.find('\n', block.jump_pos_) + 1;
+            print_resolved(
+                os, text.substr(body_pos, block.jump_pos_ - body_pos));
+            print_resolved(os, text.substr(jump_end, body_end - jump_end));
+        } else {
+            print_resolved(os, text.substr(body_pos, body_end - body_pos));
+        }
+    }
+    return instructions;
+}
+
+// private methods
+
+std::string SsaBuilder::read_variable_recursive(
+    const symtab::Symbol *var, const std::string &type, std::size_t block) {
+    std::string value;
+    if (!blocks_[block].is_sealed_) {
+        auto phi = create_phi(type, block);
+        blocks_[block].incomplete_phis_.emplace_back(var, phi);
+        value = phis_[phi].name_;
+    } else if (blocks_[block].preds_.size() == 1) {
+        value = read_variable(var, type, blocks_[block].preds_.front());
+    } else if (blocks_[block].preds_.empty()) {
+        value = "undef";
+    } else {
+        // The phi breaks cycles of the lookup through the loops
+        auto phi = create_phi(type, block);
+        write_variable(var, block, phis_[phi].name_);
+        value = add_phi_operands(var, phi);
+    }
+    write_variable(var, block, value);
+    return value;
+}
+
+std::size_t SsaBuilder::create_phi(const std::string &type, std::size_t block) {
+    auto phi = phis_.size();
+    phis_.push_back(Phi{
+        std::string(c_phi_prefix) + std::to_string(phi), type, block, {}, {},
+        {}});
+    blocks_[block].phis_.push_back(phi);
+    return phi;
+}
+
+std::string SsaBuilder::add_phi_operands(
+    const symtab::Symbol *var, std::size_t phi) {
+    const auto type = phis_[phi].type_;
+    const auto preds = blocks_[phis_[phi].block_].preds_;
+    for (auto pred : preds) {
+        auto value = read_variable(var, type, pred);
+        if (auto operand = get_phi_index(value); operand != phis_.size()) {
+            phis_[operand].users_.push_back(phi);
+        }
+        phis_[phi].operands_.emplace_back(std::move(value), pred);
+    }
+    return try_remove_trivial_phi(phi);
+}
+
+std::string SsaBuilder::try_remove_trivial_phi(std::size_t phi) {
+    std::string same;
+    for (const auto &operand : phis_[phi].operands_) {
+        auto value = resolve(operand.first);
+        if (value == same || value == phis_[phi].name_) {
+            continue;
+        }
+        if (!same.empty()) {
+            return phis_[phi].name_;
+        }
+        same = value;
+    }
+    if (same.empty()) {
+        same = "undef";
+    }
+
+    phis_[phi].replacement_ = same;
+    has_replaced_phis_ = true;
+
+    const auto users = phis_[phi].users_;
+    for (auto user : users) {
+        if (user != phi && phis_[user].replacement_.empty()) {
+            try_remove_trivial_phi(user);
+        }
+    }
+    return same;
+}
+
+std::size_t SsaBuilder::get_phi_index(std::string_view value) const {
+    if (value.substr(0, c_phi_prefix.size()) != c_phi_prefix) {
+        return phis_.size();
+    }
+    std::size_t idx = 0;
+    for (char c : value.substr(c_phi_prefix.size())) {
+        idx = idx * 10 + static_cast<std::size_t>(c - '0');
+    }
+    return idx;
+}
+
+std::string_view SsaBuilder::resolve(std::string_view value) const {
+    for (auto idx = get_phi_index(value);
+         idx != phis_.size() && !phis_[idx].replacement_.empty();
+         idx = get_phi_index(value)) {
+        value = phis_[idx].replacement_;
+    }
+    return value;
+}
+
+void SsaBuilder::print_resolved(std::ostream &os, std::string_view text) const {
+    if (!has_replaced_phis_ && label_targets_.empty()) {
+        os << text;
+        return;
+    }
+
+    for (;;) {
+        auto phi_pos = has_replaced_phis_ ? text.find(c_phi_prefix)
+                                          : std::string_view::npos;
+        auto label_pos = label_targets_.empty() ? std::string_view::npos
+                                                : text.find(c_label_prefix);
+        if (phi_pos == std::string_view::npos &&
+            label_pos == std::string_view::npos) {
+            break;
+        }
+
+        if (phi_pos < label_pos) {
+            auto end = phi_pos + c_phi_prefix.size();
+            while (end < text.size() &&
+                   std::isdigit(static_cast<unsigned char>(text[end])) != 0) {
+                ++end;
+            }
+            os << text.substr(0, phi_pos)
+               << resolve(text.substr(phi_pos, end - phi_pos));
+            text.remove_prefix(end);
+        } else {
+            auto begin = label_pos + c_label_prefix.size();
+            auto end = begin;
+            while (end < text.size() &&
+                   std::isalnum(static_cast<unsigned char>(text[end])) != 0) {
+                ++end;
+            }
+            os << text.substr(0, begin)
+               << resolve_label(std::string(text.substr(begin, end - begin)));
+            text.remove_prefix(end);
+        }
+    }
+    os << text;
+}
+
+// An unreachable block that got no code, e.g. the one after the last return
+bool SsaBuilder::is_droppable(std::size_t order_idx, std::string_view text)
+    const {
+    const auto &block = blocks_[block_order_[order_idx]];
+    if (order_idx == 0 || !block.preds_.empty()) {
+        return false;
+    }
+    auto body_pos = text.find('\n', block.label_pos_) + 1;
+    auto end = order_idx + 1 < block_order_.size()
+        ? blocks_[block_order_[order_idx + 1]].label_pos_
+        : text.size();
+    return is_whitespace(text.substr(body_pos, end - body_pos));
+}
+
+std::size_t SsaBuilder::get_body_end(
+    std::size_t order_idx, std::size_t text_size) const {
+    return order_idx + 1 < block_order_.size()
+        ? blocks_[block_order_[order_idx + 1]].label_pos_
+        : text_size;
+}
+
+bool SsaBuilder::has_live_phis(std::size_t block) const {
+    const auto &block_phis = blocks_[block].phis_;
+    return std::any_of(
+        block_phis.begin(), block_phis.end(),
+        [this](std::size_t phi) { return phis_[phi].replacement_.empty(); });
+}
+
+// The block has nothing but a jump to another one
+bool SsaBuilder::is_forwarding(std::size_t order_idx, std::string_view text)
+    const {
+    auto block_idx = block_order_[order_idx];
+    const auto &block = blocks_[block_idx];
+    if (block.jump_pos_ == no_pos || block.succs_.size() != 1 ||
+        block.succs_.front() == block_idx || has_live_phis(block_idx)) {
+        return false;
+    }
+    auto body_pos = text.find('\n', block.label_pos_) + 1;
+    auto jump_end = text.find('\n', block.jump_pos_) + 1;
+    return is_whitespace(text.substr(body_pos, block.jump_pos_ - body_pos)) &&
+        is_whitespace(text.substr(
+            jump_end, get_body_end(order_idx, text.size()) - jump_end));
+}
+
+// The predecessors branch to the target of the block instead. If the target
+// has phis, the only predecessor takes the place of the block in them.
+void SsaBuilder::bypass(std::size_t block) {
+    auto target = blocks_[block].succs_.front();
+    auto preds = blocks_[block].preds_;
+    auto &target_preds = blocks_[target].preds_;
+    if (has_live_phis(target)) {
+        if (preds.size() != 1 ||
+            std::find(target_preds.begin(), target_preds.end(),
+                      preds.front()) != target_preds.end()) {
+            return;
+        }
+        replace_pred(target, block, preds.front());
+    } else {
+        target_preds.erase(
+            std::remove(target_preds.begin(), target_preds.end(), block),
+            target_preds.end());
+        target_preds.insert(target_preds.end(), preds.begin(), preds.end());
+    }
+
+    for (auto pred : preds) {
+        auto &succs = blocks_[pred].succs_;
+        std::replace(succs.begin(), succs.end(), block, target);
+    }
+    label_targets_[blocks_[block].label_] = blocks_[target].label_;
+    blocks_[block].is_dropped_ = true;
+}
+
+// The block follows the predecessor in the text, so its body continues the
+// one of the predecessor without the jump
+void SsaBuilder::merge(std::size_t pred, std::size_t block) {
+    blocks_[blocks_[pred].tail_].is_jump_dropped_ = true;
+    blocks_[block].is_merged_ = true;
+    blocks_[pred].tail_ = blocks_[block].tail_;
+    blocks_[pred].succs_ = blocks_[block].succs_;
+    for (auto succ : blocks_[block].succs_) {
+        replace_pred(succ, block, pred);
+    }
+}
+
+void SsaBuilder::replace_pred(
+    std::size_t block, std::size_t from, std::size_t to) {
+    auto &preds = blocks_[block].preds_;
+    std::replace(preds.begin(), preds.end(), from, to);
+    for (auto phi : blocks_[block].phis_) {
+        for (auto &operand : phis_[phi].operands_) {
+            if (operand.second == from) {
+                operand.second = to;
+            }
+        }
+    }
+}
+
+const std::string &SsaBuilder::resolve_label(const std::string &label) const {
+    const auto *resolved = &label;
+    for (auto it = label_targets_.find(*resolved); it != label_targets_.end();
+         it = label_targets_.find(*resolved)) {
+        resolved = &it->second;
+    }
+    return *resolved;
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
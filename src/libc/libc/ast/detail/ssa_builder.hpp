@@ -0,0 +1,134 @@
+#pragma once
+
+#include <libc/ast/symtab/symbols.hpp>
+
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Tracks the basic blocks of the function being emitted and builds SSA form
+// of the promoted variables on the fly, as in Braun et al. "Simple and
+// Efficient Construction of Static Single Assignment Form".
+//
+// The text of the function stays with the code generator. Blocks only know
+// where their label and body start in it, so phis are inserted and the
+// trivial ones are replaced by their values when the function is printed.
+//
+// The control flow graph can be simplified before the printing: the blocks
+// without predecessors are dropped, the blocks that only branch on are
+// bypassed, and a block is merged into its only predecessor that jumps to
+// it and precedes it in the text.
+class SsaBuilder final {
+  public:
+    static constexpr std::size_t no_block = static_cast<std::size_t>(-1);
+    static constexpr std::size_t no_pos = static_cast<std::size_t>(-1);
+
+    void reset();
+
+    // Creates the block on the first use of its label
+    std::size_t get_block(const std::string &label);
+    void start_block(std::size_t block, std::size_t label_pos);
+    std::size_t get_current_block() const {
+        return current_block_;
+    }
+
+    void add_edge(std::size_t from, std::size_t to);
+    // The unconditional branch that ends the block, it's at the position in
+    // the text
+    void add_jump(std::size_t from, std::size_t to, std::size_t jump_pos);
+    bool has_preds(std::size_t block) const {
+        return !blocks_[block].preds_.empty();
+    }
+    // All predecessors of the block are known
+    void seal_block(std::size_t block);
+
+    void write_variable(
+        const symtab::Symbol *var, std::size_t block, std::string value);
+    std::string read_variable(
+        const symtab::Symbol *var, const std::string &type, std::size_t block);
+
+    // The block that started a function is its entry, every other block
+    // has to get its predecessors before it's emitted. So the blocks
+    // without them are unreachable.
+    void simplify(std::string_view text);
+
+    // Prints the text of the function with phis after the labels, the entry
+    // code goes first into the entry block. Returns the number of the
+    // printed instructions, the unreachable ones aren't counted.
+    std::size_t print(
+        std::ostream &os,
+        std::string_view text,
+        std::string_view entry_code = {}) const;
+
+  private:
+    struct Phi {
+        std::string name_;
+        std::string type_;
+        std::size_t block_;
+        std::vector<std::pair<std::string, std::size_t>> operands_;
+        // Phis that take this one as an operand
+        std::vector<std::size_t> users_;
+        // Value of a trivial phi, it isn't printed
+        std::string replacement_;
+    };
+
+    struct Block {
+        std::string label_;
+        std::size_t label_pos_{0};
+        bool is_started_{false};
+        bool is_sealed_{false};
+        std::vector<std::size_t> preds_;
+        std::vector<std::size_t> succs_;
+        std::size_t jump_pos_{no_pos};
+        // The jump to the block merged into this one isn't printed
+        bool is_jump_dropped_{false};
+        // Neither the label nor the body is printed
+        bool is_dropped_{false};
+        // Only the body is printed, after the one of the previous block
+        bool is_merged_{false};
+        // The last block merged into this one, it has the terminator
+        std::size_t tail_{no_block};
+        std::unordered_map<const symtab::Symbol *, std::string> defs_;
+        std::vector<std::pair<const symtab::Symbol *, std::size_t>>
+            incomplete_phis_;
+        std::vector<std::size_t> phis_;
+    };
+
+    std::string read_variable_recursive(
+        const symtab::Symbol *var, const std::string &type, std::size_t block);
+    std::size_t create_phi(const std::string &type, std::size_t block);
+    std::string add_phi_operands(const symtab::Symbol *var, std::size_t phi);
+    std::string try_remove_trivial_phi(std::size_t phi);
+
+    std::size_t get_phi_index(std::string_view value) const;
+    std::string_view resolve(std::string_view value) const;
+    void print_resolved(std::ostream &os, std::string_view text) const;
+    bool is_droppable(std::size_t order_idx, std::string_view text) const;
+
+    std::size_t get_body_end(std::size_t order_idx, std::size_t text_size)
+        const;
+    bool has_live_phis(std::size_t block) const;
+    bool is_forwarding(std::size_t order_idx, std::string_view text) const;
+    void bypass(std::size_t block);
+    void merge(std::size_t pred, std::size_t block);
+    void replace_pred(std::size_t block, std::size_t from, std::size_t to);
+    const std::string &resolve_label(const std::string &label) const;
+
+    std::vector<Block> blocks_;
+    std::unordered_map<std::string, std::size_t> block_ids_;
+    // Started blocks in the order of their labels in the text
+    std::vector<std::size_t> block_order_;
+    std::size_t current_block_{no_block};
+
+    std::vector<Phi> phis_;
+    bool has_replaced_phis_{false};
+
+    // Labels of the bypassed blocks and the blocks the branches go to instead
+    std::unordered_map<std::string, std::string> label_targets_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
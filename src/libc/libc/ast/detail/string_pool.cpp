@@ -0,0 +1,147 @@
+#include <libc/ast/detail/string_pool.hpp>
+
+#include <algorithm>
+
+namespace c::ast::detail {
+
+namespace {
+
+const std::string_view c_hex_digits = "0123456789ABCDEF";
+
+char decode_escape(char c) {
+    switch (c) {
+    case 'n':
+        return '\n';
+    case 't':
+        return '\t';
+    case 'r':
+        return '\r';
+    case '0':
+        return '\0';
+    case 'a':
+        return '\a';
+    case 'b':
+        return '\b';
+    case 'f':
+        return '\f';
+    case 'v':
+        return '\v';
+    default:
+        // \\, \" and \'
+        return c;
+    }
+}
+
+std::string get_array_type(const std::string &content) {
+    return "[" + std::to_string(content.size() + 1) + " x i8]";
+}
+
+} // namespace
+
+std::size_t StringPool::add(std::string_view literal) {
+    auto [it, is_inserted] =
+        content_ids_.emplace(decode(literal), contents_.size());
+    if (is_inserted) {
+        contents_.push_back(it->first);
+    }
+    return it->second;
+}
+
+// With the reversed contents sorted, a content ends another one iff it's a
+// prefix of the next reversed content. The longest one of such a chain owns
+// the constant.
+void StringPool::build() {
+    std::vector<std::string> reversed;
+    reversed.reserve(contents_.size());
+    for (const auto &content : contents_) {
+        reversed.emplace_back(content.rbegin(), content.rend());
+    }
+    std::vector<std::size_t> order(contents_.size());
+    for (std::size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&reversed](auto lhs, auto rhs) {
+        return reversed[lhs] < reversed[rhs];
+    });
+
+    owners_.assign(contents_.size(), 0);
+    offsets_.assign(contents_.size(), 0);
+    for (std::size_t i = order.size(); i-- > 0;) {
+        auto content = order[i];
+        owners_[content] = content;
+        if (i + 1 < order.size()) {
+            const auto &next = reversed[order[i + 1]];
+            if (next.compare(0, reversed[content].size(), reversed[content]) ==
+                0) {
+                owners_[content] = owners_[order[i + 1]];
+            }
+        }
+        offsets_[content] =
+            contents_[owners_[content]].size() - contents_[content].size();
+    }
+
+    numbers_.assign(contents_.size(), 0);
+    constants_.clear();
+    std::vector<bool> is_numbered(contents_.size());
+    for (auto owner : owners_) {
+        if (!is_numbered[owner]) {
+            is_numbered[owner] = true;
+            numbers_[owner] = constants_.size();
+            constants_.push_back(owner);
+        }
+    }
+}
+
+std::string StringPool::get_pointer(std::size_t content) const {
+    auto owner = owners_[content];
+    auto type = get_array_type(contents_[owner]);
+    return "getelementptr (" + type + ", " + type + "* @.str" +
+        std::to_string(numbers_[owner]) + ", i64 0, i64 " +
+        std::to_string(offsets_[content]) + ")";
+}
+
+void StringPool::print(std::ostream &os) const {
+    for (std::size_t number = 0; number < constants_.size(); ++number) {
+        print_constant(
+            os, "@.str" + std::to_string(number),
+            contents_[constants_[number]]);
+    }
+}
+
+void StringPool::print_constant(
+    std::ostream &os, const std::string &name, const std::string &content) {
+    os << name << " = private unnamed_addr constant "
+       << get_array_type(content) << " c\"";
+    for (char c : content) {
+        auto byte = static_cast<unsigned char>(c);
+        if (byte >= ' ' && byte <= '~' && c != '"' && c != '\\') {
+            os << c;
+        } else {
+            os << '\\' << c_hex_digits[byte >> 4U]
+               << c_hex_digits[byte & 0xFU];
+        }
+    }
+    os << "\\00\"\n";
+}
+
+std::string StringPool::get_constant_pointer(
+    const std::string &name, const std::string &content) {
+    auto type = get_array_type(content);
+    return "getelementptr (" + type + ", " + type + "* " + name +
+        ", i64 0, i64 0)";
+}
+
+std::string StringPool::decode(std::string_view literal) {
+    std::string content;
+    content.reserve(literal.size());
+    for (std::size_t i = 0; i < literal.size(); ++i) {
+        if (literal[i] == '\\' && i + 1 < literal.size()) {
+            content.push_back(decode_escape(literal[++i]));
+        } else {
+            content.push_back(literal[i]);
+        }
+    }
+    return content;
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
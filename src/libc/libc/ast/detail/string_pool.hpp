@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast::detail {
+
+// The distinct string literals of a module. Every content is emitted once
+// and a literal that ends another one points into it, e.g. "lo\n" into
+// "hello\n".
+class StringPool final {
+  public:
+    // Returns the id of the content of the literal, the same for equal
+    // contents. The escapes are decoded here, once.
+    std::size_t add(std::string_view literal);
+
+    // Places the contents into the constants, after the last add
+    void build();
+
+    // i8* constant expression that points to the content
+    std::string get_pointer(std::size_t content) const;
+
+    // The constants in the order of the first use of their contents
+    void print(std::ostream &os) const;
+
+    static std::string decode(std::string_view literal);
+    // A private i8 array constant of the content with the terminating zero
+    static void print_constant(
+        std::ostream &os, const std::string &name, const std::string &content);
+    // i8* constant expression that points to such a constant
+    static std::string get_constant_pointer(
+        const std::string &name, const std::string &content);
+
+  private:
+    std::vector<std::string> contents_;
+    std::unordered_map<std::string, std::size_t> content_ids_;
+
+    // For every content: the content of the constant and the offset in it
+    std::vector<std::size_t> owners_;
+    std::vector<std::size_t> offsets_;
+    // For every content that owns a constant: its number
+    std::vector<std::size_t> numbers_;
+    // Contents that own constants, in the order of the numbers
+    std::vector<std::size_t> constants_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,527 @@
+#include <libc/ast/detail/x86_encoder.hpp>
+
+#include <limits>
+
+namespace c::ast::detail {
+
+namespace {
+
+constexpr std::uint8_t c_operand_size_prefix = 0x66;
+constexpr std::uint8_t c_rex = 0x40;
+constexpr std::uint8_t c_int3 = 0xCC;
+constexpr std::size_t c_function_alignment = 16;
+
+const std::string c_string_prefix = ".L.str";
+
+bool is_int8(std::int64_t value) {
+    return value >= std::numeric_limits<std::int8_t>::min() &&
+        value <= std::numeric_limits<std::int8_t>::max();
+}
+
+bool is_int32(std::int64_t value) {
+    return value >= std::numeric_limits<std::int32_t>::min() &&
+        value <= std::numeric_limits<std::int32_t>::max();
+}
+
+std::uint8_t get_number(Reg reg) {
+    return static_cast<std::uint8_t>(is_xmm(reg) ? reg - x86::xmm0 : reg);
+}
+
+std::uint8_t get_low(Reg reg) {
+    return get_number(reg) & 7U;
+}
+
+std::uint8_t get_high(Reg reg) {
+    return (get_number(reg) >> 3U) & 1U;
+}
+
+// Without a REX prefix the byte registers 4 to 7 are ah to bh, not spl to
+// dil
+bool needs_rex(Reg reg) {
+    return reg >= x86::rsp && reg <= x86::rdi;
+}
+
+std::uint8_t get_prefix(Width width) {
+    return width == Width::b16 ? c_operand_size_prefix : 0;
+}
+
+// The mandatory prefix of the scalar SSE instructions
+std::uint8_t get_sse_prefix(Width width) {
+    return width == Width::f32 ? 0xF3 : 0xF2;
+}
+
+std::size_t get_imm_size(Width width) {
+    switch (width) {
+    case Width::b8:
+        return 1;
+    case Width::b16:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+std::uint8_t get_cond(Cond cond) {
+    return static_cast<std::uint8_t>(cond);
+}
+
+void write_rel32(
+    std::vector<std::uint8_t> &bytes, std::size_t position, std::int64_t rel) {
+    for (std::size_t i = 0; i < 4; ++i) {
+        bytes[position + i] = static_cast<std::uint8_t>(
+            static_cast<std::uint64_t>(rel) >> (8 * i));
+    }
+}
+
+} // namespace
+
+X86Encoder::X86Encoder(const MachineModule &module) : module_(module) {
+    for (const auto &func : module_.functions_) {
+        functions_[func.name_] = 0;
+    }
+}
+
+X86Encoder::Image X86Encoder::exec(const MachineModule &module) {
+    X86Encoder encoder(module);
+    for (const auto &func : module.functions_) {
+        encoder.encode_function(func);
+    }
+    return encoder.link();
+}
+
+void X86Encoder::encode_function(const MachineFunction &func) {
+    while (bytes_.size() % c_function_alignment != 0) {
+        emit_byte(c_int3);
+    }
+    functions_[func.name_] = bytes_.size();
+
+    block_offsets_.assign(func.blocks_.size(), 0);
+    jump_fixups_.clear();
+    for (std::size_t i = 0; i < func.blocks_.size(); ++i) {
+        block_offsets_[i] = bytes_.size();
+        for (const auto &instruction : func.blocks_[i].instructions_) {
+            encode(instruction);
+        }
+    }
+
+    for (const auto &fixup : jump_fixups_) {
+        write_rel32(
+            bytes_, fixup.position_,
+            static_cast<std::int64_t>(block_offsets_[fixup.block_]) -
+                static_cast<std::int64_t>(fixup.position_ + 4));
+    }
+}
+
+void X86Encoder::encode(const Instruction &instruction) {
+    const auto &dst = instruction.dst_;
+    const auto &src = instruction.src_;
+    const auto width = instruction.width_;
+    const auto prefix = get_prefix(width);
+    const bool rex_w = width == Width::b64;
+
+    switch (instruction.opcode_) {
+    case Opcode::mov:
+        encode_mov(instruction);
+        return;
+    case Opcode::movsx:
+        if (instruction.src_width_ == Width::b32) {
+            emit_rm(0, true, {0x63}, dst.reg_, src);
+        } else {
+            const bool is_byte = instruction.src_width_ == Width::b8;
+            emit_rm(
+                0, rex_w,
+                {0x0F, static_cast<std::uint8_t>(is_byte ? 0xBE : 0xBF)},
+                dst.reg_, src, is_byte);
+        }
+        return;
+    case Opcode::movzx: {
+        const bool is_byte = instruction.src_width_ == Width::b8;
+        emit_rm(
+            0, rex_w, {0x0F, static_cast<std::uint8_t>(is_byte ? 0xB6 : 0xB7)},
+            dst.reg_, src, is_byte);
+        return;
+    }
+    case Opcode::lea:
+        emit_rm(0, true, {0x8D}, dst.reg_, src);
+        return;
+    case Opcode::add:
+        encode_alu(instruction, 0);
+        return;
+    case Opcode::or_:
+        encode_alu(instruction, 1);
+        return;
+    case Opcode::and_:
+        encode_alu(instruction, 4);
+        return;
+    case Opcode::sub:
+        encode_alu(instruction, 5);
+        return;
+    case Opcode::cmp:
+        encode_alu(instruction, 7);
+        return;
+    case Opcode::imul:
+        if (src.kind_ == Operand::Kind::imm) {
+            const auto size = is_int8(src.imm_) ? 1 : get_imm_size(width);
+            emit_rm(
+                prefix, rex_w,
+                {static_cast<std::uint8_t>(size == 1 ? 0x6B : 0x69)}, dst.reg_,
+                dst, false, size);
+            emit_imm(src.imm_, size);
+        } else {
+            emit_rm(prefix, rex_w, {0x0F, 0xAF}, dst.reg_, src);
+        }
+        return;
+    case Opcode::neg:
+        emit_rm(prefix, rex_w, {0xF7}, 3, dst, width == Width::b8);
+        return;
+    case Opcode::test: {
+        const bool is_byte = width == Width::b8;
+        emit_rm(
+            prefix, rex_w, {static_cast<std::uint8_t>(is_byte ? 0x84 : 0x85)},
+            src.reg_, dst, is_byte);
+        return;
+    }
+    case Opcode::setcc:
+        emit_rm(
+            0, false,
+            {0x0F,
+             static_cast<std::uint8_t>(0x90 + get_cond(instruction.cond_))},
+            0, dst, true);
+        return;
+    case Opcode::jcc:
+        emit_byte(0x0F);
+        emit_byte(
+            static_cast<std::uint8_t>(0x80 + get_cond(instruction.cond_)));
+        jump_fixups_.push_back(
+            {bytes_.size(), static_cast<std::size_t>(dst.imm_)});
+        emit_imm(0, 4);
+        return;
+    case Opcode::jmp:
+        emit_byte(0xE9);
+        jump_fixups_.push_back(
+            {bytes_.size(), static_cast<std::size_t>(dst.imm_)});
+        emit_imm(0, 4);
+        return;
+    case Opcode::cdq:
+        if (rex_w) {
+            emit_byte(c_rex | 0x08U);
+        }
+        emit_byte(0x99);
+        return;
+    case Opcode::idiv:
+        emit_rm(prefix, rex_w, {0xF7}, 7, dst);
+        return;
+    case Opcode::push:
+        if (dst.is_reg()) {
+            emit_plus_reg(0, false, 0x50, dst.reg_);
+        } else if (dst.kind_ == Operand::Kind::imm) {
+            const bool is_byte = is_int8(dst.imm_);
+            emit_byte(is_byte ? 0x6A : 0x68);
+            emit_imm(dst.imm_, is_byte ? 1 : 4);
+        } else {
+            emit_rm(0, false, {0xFF}, 6, dst);
+        }
+        return;
+    case Opcode::pop:
+        emit_plus_reg(0, false, 0x58, dst.reg_);
+        return;
+    case Opcode::call:
+        // The imported functions are called through their slots
+        if (functions_.count(dst.symbol_) > 0) {
+            emit_byte(0xE8);
+            emit_rel32(dst.symbol_);
+        } else {
+            Address slot;
+            slot.symbol_ = dst.symbol_;
+            emit_rm(0, false, {0xFF}, 2, Operand::make_mem(slot));
+        }
+        return;
+    case Opcode::ret:
+        emit_byte(0xC3);
+        return;
+    case Opcode::movs:
+        if (dst.kind_ == Operand::Kind::mem) {
+            emit_rm(
+                get_sse_prefix(width), false, {0x0F, 0x11}, src.reg_, dst);
+        } else {
+            emit_rm(
+                get_sse_prefix(width), false, {0x0F, 0x10}, dst.reg_, src);
+        }
+        return;
+    case Opcode::movaps:
+        emit_rm(0, false, {0x0F, 0x28}, dst.reg_, src);
+        return;
+    case Opcode::adds:
+        encode_sse(instruction, 0x58, width);
+        return;
+    case Opcode::muls:
+        encode_sse(instruction, 0x59, width);
+        return;
+    case Opcode::subs:
+        encode_sse(instruction, 0x5C, width);
+        return;
+    case Opcode::divs:
+        encode_sse(instruction, 0x5E, width);
+        return;
+    case Opcode::ucomis:
+        emit_rm(
+            width == Width::f64 ? c_operand_size_prefix : 0, false,
+            {0x0F, 0x2E}, dst.reg_, src);
+        return;
+    case Opcode::xorps:
+        emit_rm(0, false, {0x0F, 0x57}, dst.reg_, src);
+        return;
+    case Opcode::cvtsi2s:
+        emit_rm(
+            get_sse_prefix(width), instruction.src_width_ == Width::b64,
+            {0x0F, 0x2A}, dst.reg_, src);
+        return;
+    case Opcode::cvtts2si:
+        encode_sse(instruction, 0x2C, instruction.src_width_);
+        return;
+    case Opcode::cvts2s:
+        encode_sse(instruction, 0x5A, instruction.src_width_);
+        return;
+    default:
+        // The register allocation expands the pseudo instructions
+        return;
+    }
+}
+
+void X86Encoder::encode_mov(const Instruction &instruction) {
+    const auto &dst = instruction.dst_;
+    const auto &src = instruction.src_;
+    const auto width = instruction.width_;
+    const auto prefix = get_prefix(width);
+    const bool rex_w = width == Width::b64;
+    const bool is_byte = width == Width::b8;
+
+    if (src.kind_ != Operand::Kind::imm) {
+        if (src.is_reg()) {
+            emit_rm(
+                prefix, rex_w,
+                {static_cast<std::uint8_t>(is_byte ? 0x88 : 0x89)}, src.reg_,
+                dst, is_byte);
+        } else {
+            emit_rm(
+                prefix, rex_w,
+                {static_cast<std::uint8_t>(is_byte ? 0x8A : 0x8B)}, dst.reg_,
+                src, is_byte);
+        }
+        return;
+    }
+
+    if (!dst.is_reg()) {
+        const auto size = get_imm_size(width);
+        emit_rm(
+            prefix, rex_w, {static_cast<std::uint8_t>(is_byte ? 0xC6 : 0xC7)},
+            0, dst, is_byte, size);
+        emit_imm(src.imm_, size);
+        return;
+    }
+
+    // Writing the 32-bit register clears the upper half
+    if (rex_w && src.imm_ >= 0 &&
+        src.imm_ <= std::numeric_limits<std::uint32_t>::max()) {
+        emit_plus_reg(0, false, 0xB8, dst.reg_);
+        emit_imm(src.imm_, 4);
+    } else if (rex_w && is_int32(src.imm_)) {
+        emit_rm(0, true, {0xC7}, 0, dst, false, 4);
+        emit_imm(src.imm_, 4);
+    } else if (rex_w) {
+        emit_plus_reg(0, true, 0xB8, dst.reg_);
+        emit_imm(src.imm_, 8);
+    } else {
+        emit_plus_reg(prefix, false, is_byte ? 0xB0 : 0xB8, dst.reg_, is_byte);
+        emit_imm(src.imm_, get_imm_size(width));
+    }
+}
+
+// The group of add, or, and, sub and cmp told apart by the extension
+void X86Encoder::encode_alu(
+    const Instruction &instruction, std::uint8_t extension) {
+    const auto &dst = instruction.dst_;
+    const auto &src = instruction.src_;
+    const auto width = instruction.width_;
+    const auto prefix = get_prefix(width);
+    const bool rex_w = width == Width::b64;
+    const bool is_byte = width == Width::b8;
+
+    if (src.kind_ == Operand::Kind::imm) {
+        const auto size =
+            is_byte || is_int8(src.imm_) ? 1 : get_imm_size(width);
+        std::uint8_t opcode = 0x81;
+        if (is_byte) {
+            opcode = 0x80;
+        } else if (size == 1) {
+            opcode = 0x83;
+        }
+        emit_rm(prefix, rex_w, {opcode}, extension, dst, is_byte, size);
+        emit_imm(src.imm_, size);
+    } else if (src.is_reg()) {
+        emit_rm(
+            prefix, rex_w,
+            {static_cast<std::uint8_t>(8 * extension + (is_byte ? 0 : 1))},
+            src.reg_, dst, is_byte);
+    } else {
+        emit_rm(
+            prefix, rex_w,
+            {static_cast<std::uint8_t>(8 * extension + (is_byte ? 2 : 3))},
+            dst.reg_, src, is_byte);
+    }
+}
+
+// The scalar instructions with the prefix of the precision, REX.W selects
+// the 64-bit integer of the conversions to them
+void X86Encoder::encode_sse(
+    const Instruction &instruction, std::uint8_t opcode, Width precision) {
+    emit_rm(
+        get_sse_prefix(precision), instruction.width_ == Width::b64,
+        {0x0F, opcode}, instruction.dst_.reg_, instruction.src_);
+}
+
+// Places the table of the imports and the strings after the code and
+// resolves the relative addresses
+X86Encoder::Image X86Encoder::link() {
+    Image image;
+    while (bytes_.size() % 8 != 0) {
+        emit_byte(c_int3);
+    }
+
+    std::unordered_map<std::string, std::size_t> targets;
+    for (const auto &[name, offset] : functions_) {
+        targets[name] = offset;
+    }
+    image.imports_offset_ = bytes_.size();
+    for (const auto &fixup : fixups_) {
+        const bool is_string =
+            fixup.symbol_.compare(0, c_string_prefix.size(), c_string_prefix) ==
+            0;
+        if (targets.count(fixup.symbol_) > 0 || is_string) {
+            continue;
+        }
+        targets[fixup.symbol_] = bytes_.size();
+        image.imports_.push_back(fixup.symbol_);
+        bytes_.resize(bytes_.size() + 8);
+    }
+    for (std::size_t i = 0; i < module_.strings_.size(); ++i) {
+        targets[c_string_prefix + std::to_string(i)] = bytes_.size();
+        bytes_.insert(
+            bytes_.end(), module_.strings_[i].begin(),
+            module_.strings_[i].end());
+        emit_byte(0);
+    }
+
+    for (const auto &fixup : fixups_) {
+        write_rel32(
+            bytes_, fixup.position_,
+            static_cast<std::int64_t>(targets.at(fixup.symbol_)) -
+                static_cast<std::int64_t>(fixup.end_));
+    }
+
+    image.bytes_ = std::move(bytes_);
+    image.functions_ = std::move(functions_);
+    return image;
+}
+
+void X86Encoder::emit_imm(std::int64_t imm, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        emit_byte(static_cast<std::uint8_t>(
+            static_cast<std::uint64_t>(imm) >> (8 * i)));
+    }
+}
+
+void X86Encoder::emit_rm(
+    std::uint8_t prefix,
+    bool rex_w,
+    std::vector<std::uint8_t> opcode,
+    Reg reg,
+    const Operand &rm,
+    bool is_byte,
+    std::size_t trailing) {
+    if (prefix != 0) {
+        emit_byte(prefix);
+    }
+
+    std::uint8_t rex = (rex_w ? 0x08U : 0U) | (get_high(reg) << 2U);
+    bool is_rex_needed = is_byte && needs_rex(reg);
+    if (rm.is_reg()) {
+        rex |= get_high(rm.reg_);
+        is_rex_needed = is_rex_needed || (is_byte && needs_rex(rm.reg_));
+    } else if (rm.mem_.symbol_.empty()) {
+        rex |= get_high(rm.mem_.base_);
+        if (rm.mem_.index_ != c_no_reg) {
+            rex |= get_high(rm.mem_.index_) << 1U;
+        }
+    }
+    if (rex != 0 || is_rex_needed) {
+        emit_byte(c_rex | rex);
+    }
+    for (auto byte : opcode) {
+        emit_byte(byte);
+    }
+
+    const auto reg_bits = static_cast<std::uint8_t>(get_low(reg) << 3U);
+    if (rm.is_reg()) {
+        emit_byte(0xC0U | reg_bits | get_low(rm.reg_));
+        return;
+    }
+
+    const auto &mem = rm.mem_;
+    if (!mem.symbol_.empty()) {
+        emit_byte(reg_bits | 0x05U);
+        fixups_.push_back(
+            {bytes_.size(), bytes_.size() + 4 + trailing, mem.symbol_});
+        emit_imm(0, 4);
+        return;
+    }
+
+    // rbp and r13 as the base always take a displacement, rsp and r12 a SIB
+    std::uint8_t mod = 0x80;
+    if (mem.disp_ == 0 && get_low(mem.base_) != 5) {
+        mod = 0x00;
+    } else if (is_int8(mem.disp_)) {
+        mod = 0x40;
+    }
+    if (mem.index_ != c_no_reg || get_low(mem.base_) == 4) {
+        std::uint8_t scale = 0;
+        while ((1U << scale) < mem.scale_) {
+            ++scale;
+        }
+        const auto index = mem.index_ != c_no_reg ? get_low(mem.index_) : 4;
+        emit_byte(mod | reg_bits | 0x04U);
+        emit_byte(
+            static_cast<std::uint8_t>(scale << 6U) |
+            static_cast<std::uint8_t>(index << 3U) | get_low(mem.base_));
+    } else {
+        emit_byte(mod | reg_bits | get_low(mem.base_));
+    }
+    if (mod == 0x40) {
+        emit_imm(mem.disp_, 1);
+    } else if (mod == 0x80) {
+        emit_imm(mem.disp_, 4);
+    }
+}
+
+void X86Encoder::emit_plus_reg(
+    std::uint8_t prefix,
+    bool rex_w,
+    std::uint8_t opcode,
+    Reg reg,
+    bool is_byte) {
+    if (prefix != 0) {
+        emit_byte(prefix);
+    }
+    const std::uint8_t rex = (rex_w ? 0x08U : 0U) | get_high(reg);
+    if (rex != 0 || (is_byte && needs_rex(reg))) {
+        emit_byte(c_rex | rex);
+    }
+    emit_byte(opcode + get_low(reg));
+}
+
+void X86Encoder::emit_rel32(std::string symbol) {
+    fixups_.push_back({bytes_.size(), bytes_.size() + 4, std::move(symbol)});
+    emit_imm(0, 4);
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
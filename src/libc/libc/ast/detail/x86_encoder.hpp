@@ -0,0 +1,89 @@
+#pragma once
+
+#include <libc/ast/detail/machine_code.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Encodes the allocated machine code into x86-64 bytes that run at any
+// address: the calls, the jumps and the strings are addressed relative to
+// the instructions. The functions the module doesn't define are called
+// through a table of their addresses after the code, the loader fills it.
+class X86Encoder final {
+  public:
+    // The code, the table of the imported functions, the strings
+    struct Image {
+        std::vector<std::uint8_t> bytes_;
+        std::unordered_map<std::string, std::size_t> functions_;
+        // Slot i of the table is at imports_offset_ + 8 * i
+        std::vector<std::string> imports_;
+        std::size_t imports_offset_{0};
+    };
+
+    static Image exec(const MachineModule &module);
+
+  private:
+    // A rel32 field of the instruction ending at end_
+    struct Fixup {
+        std::size_t position_;
+        std::size_t end_;
+        std::string symbol_;
+    };
+
+    struct JumpFixup {
+        std::size_t position_;
+        std::size_t block_;
+    };
+
+    explicit X86Encoder(const MachineModule &module);
+
+    void encode_function(const MachineFunction &func);
+    void encode(const Instruction &instruction);
+    void encode_mov(const Instruction &instruction);
+    void encode_alu(const Instruction &instruction, std::uint8_t extension);
+    void encode_sse(
+        const Instruction &instruction,
+        std::uint8_t opcode,
+        Width precision);
+    Image link();
+
+    void emit_byte(std::uint8_t byte) {
+        bytes_.push_back(byte);
+    }
+    void emit_imm(std::int64_t imm, std::size_t size);
+    // The optional mandatory prefix, REX, the opcode and ModRM with the
+    // reg field and the r/m operand. trailing is the size of the
+    // immediate that follows, the rip-relative displacements end after it.
+    void emit_rm(
+        std::uint8_t prefix,
+        bool rex_w,
+        std::vector<std::uint8_t> opcode,
+        Reg reg,
+        const Operand &rm,
+        bool is_byte = false,
+        std::size_t trailing = 0);
+    // An opcode with the register in its low bits
+    void emit_plus_reg(
+        std::uint8_t prefix,
+        bool rex_w,
+        std::uint8_t opcode,
+        Reg reg,
+        bool is_byte = false);
+    void emit_rel32(std::string symbol);
+
+    const MachineModule &module_;
+    std::vector<std::uint8_t> bytes_;
+    std::unordered_map<std::string, std::size_t> functions_;
+    std::vector<Fixup> fixups_;
+
+    // Of the function being encoded
+    std::vector<std::size_t> block_offsets_;
+    std::vector<JumpFixup> jump_fixups_;
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include <libc/ast/detail/xml_writer.hpp>
+
+#include <cassert>
+
+namespace c::ast::detail {
+
+XmlWriter::XmlWriter(std::ostream &out, std::string indent)
+    : out_(out), indent_(std::move(indent)) {
+    out_ << "<?xml version=\"1.0\"?>\n";
+}
+
+void XmlWriter::start_element(const char *name) {
+    close_start_tag();
+    write_indent();
+    out_ << '<' << name;
+    elements_.push_back(Element{name, false});
+    need_newline_ = true;
+    need_indent_ = true;
+}
+
+void XmlWriter::end_element() {
+    assert(!elements_.empty());
+    auto element = elements_.back();
+    elements_.pop_back();
+    if (!element.is_start_tag_closed_) {
+        out_ << " />";
+    } else {
+        write_indent();
+        out_ << "</" << element.name_ << '>';
+    }
+    need_newline_ = true;
+    need_indent_ = true;
+}
+
+void XmlWriter::append_attribute(const char *name, const char *value) {
+    assert(!elements_.empty() && !elements_.back().is_start_tag_closed_);
+    out_ << ' ' << name << "=\"";
+    write_escaped(value, true);
+    out_ << '"';
+}
+
+void XmlWriter::append_text(const char *text) {
+    close_start_tag();
+    write_escaped(text, false);
+    need_newline_ = false;
+    need_indent_ = false;
+}
+
+void XmlWriter::finish() {
+    assert(elements_.empty());
+    if (need_newline_) {
+        out_ << '\n';
+    }
+    need_newline_ = false;
+}
+
+void XmlWriter::close_start_tag() {
+    if (!elements_.empty() && !elements_.back().is_start_tag_closed_) {
+        out_ << '>';
+        elements_.back().is_start_tag_closed_ = true;
+    }
+}
+
+void XmlWriter::write_indent() {
+    if (need_newline_) {
+        out_ << '\n';
+    }
+    if (need_indent_) {
+        for (std::size_t i = 0; i < elements_.size(); ++i) {
+            out_ << indent_;
+        }
+    }
+}
+
+void XmlWriter::write_escaped(const char *str, bool is_attribute) {
+    const char *begin = str;
+    for (; *str != '\0'; ++str) {
+        const char *escaped = nullptr;
+        switch (*str) {
+        case '&':
+            escaped = "&amp;";
+            break;
+        case '<':
+            escaped = "&lt;";
+            break;
+        case '>':
+            escaped = is_attribute ? nullptr : "&gt;";
+            break;
+        case '"':
+            escaped = is_attribute ? "&quot;" : nullptr;
+            break;
+        default:
+            break;
+        }
+
+        const auto ch = static_cast<unsigned char>(*str);
+        const bool is_control = ch < ' ' &&
+            (is_attribute || (ch != '\t' && ch != '\n' && ch != '\r'));
+        if (escaped == nullptr && !is_control) {
+            continue;
+        }
+
+        out_.write(begin, str - begin);
+        begin = str + 1;
+        if (escaped != nullptr) {
+            out_ << escaped;
+        } else {
+            out_ << "&#" << static_cast<char>('0' + ch / 10)
+                 << static_cast<char>('0' + ch % 10) << ';';
+        }
+    }
+    out_.write(begin, str - begin);
+}
+
+} // namespace c::ast::detail
\ No newline at end of file
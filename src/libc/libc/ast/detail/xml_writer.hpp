@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace c::ast::detail {
+
+// Writes XML straight into the stream while the document is being traversed.
+// The layout repeats the one produced by pugixml with format_indent, so the
+// output is byte-identical to the former DOM-based serialization.
+class XmlWriter final {
+  public:
+    XmlWriter(std::ostream &out, std::string indent);
+
+    void start_element(const char *name);
+    void end_element();
+    // Attributes must be appended before any child or text of the element
+    void append_attribute(const char *name, const char *value);
+    void append_text(const char *text);
+
+    void finish();
+
+  private:
+    struct Element {
+        const char *name_;
+        bool is_start_tag_closed_;
+    };
+
+    void close_start_tag();
+    void write_indent();
+    void write_escaped(const char *str, bool is_attribute);
+
+    std::ostream &out_;
+    std::string indent_;
+    std::vector<Element> elements_;
+
+    bool need_newline_{false};
+    bool need_indent_{true};
+};
+
+} // namespace c::ast::detail
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include <libc/ast/effect_analyzer.hpp>
+#include <libc/trace.hpp>
+
+#include <algorithm>
+
+namespace c::ast {
+
+namespace {
+
+// Returns true if the callee adds an effect
+bool merge(
+    symtab::FunctionEffects &effects,
+    const symtab::FunctionEffects &callee_effects) {
+    const bool is_changed =
+        (callee_effects.reads_memory_ && !effects.reads_memory_) ||
+        (callee_effects.writes_memory_ && !effects.writes_memory_) ||
+        (callee_effects.has_io_ && !effects.has_io_);
+    effects.reads_memory_ =
+        effects.reads_memory_ || callee_effects.reads_memory_;
+    effects.writes_memory_ =
+        effects.writes_memory_ || callee_effects.writes_memory_;
+    effects.has_io_ = effects.has_io_ || callee_effects.has_io_;
+    return is_changed;
+}
+
+} // namespace
+
+void EffectAnalyzer::exec(Program &program, symtab::Symtab &symtab) {
+    EffectAnalyzer effect_analyzer(symtab);
+
+    for (auto *child : program.get_childs()) {
+        child->accept(effect_analyzer);
+    }
+    effect_analyzer.propagate();
+}
+
+void EffectAnalyzer::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("effect analysis", node.id());
+    auto *func_sym = get_funcsym(node.id());
+    summary_ids_.emplace(func_sym, summaries_.size());
+    summaries_.push_back({func_sym, {}, {}, {}, false});
+    scopes_.push(func_sym);
+    params_ = func_sym->get_params();
+    summaries_.back().effects_.captured_params_.resize(params_.size());
+
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+
+    scope_order_ = 0;
+    scopes_.pop();
+}
+
+void EffectAnalyzer::visit(LocalScope &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+// Expressions
+
+void EffectAnalyzer::visit(Expression &node) {
+    node.expression()->accept(*this);
+}
+
+void EffectAnalyzer::visit(FunctionCall &node) {
+    symtab::FunctionSymbol *callee = nullptr;
+    if (node.id() == "printf") {
+        summaries_.back().effects_.has_io_ = true;
+        // %s reads the memory of the argument
+        summaries_.back().effects_.reads_memory_ = true;
+    } else if (node.id() != "__builtin_expect") {
+        callee = get_funcsym(node.id());
+        summaries_.back().callees_.push_back(callee);
+    }
+
+    const auto &args = node.args();
+    for (std::size_t i = 0; i < args.size(); ++i) {
+        // A parameter passed on is captured only if the callee captures it,
+        // printf never does
+        auto *var = dynamic_cast<VariableAccess *>(args[i]);
+        if (auto param = var == nullptr ? params_.size()
+                                        : get_param_index(var->id());
+            param != params_.size()) {
+            if (callee != nullptr) {
+                summaries_.back().passes_.push_back({callee, i, param});
+            }
+            continue;
+        }
+        args[i]->accept(*this);
+    }
+}
+
+void EffectAnalyzer::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void EffectAnalyzer::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+// Statements
+
+void EffectAnalyzer::visit(ReturnStatement &node) {
+    node.value()->accept(*this);
+}
+
+void EffectAnalyzer::visit(ForStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    if (node.for_data_using() != nullptr) {
+        node.for_data_using()->accept(*this);
+    }
+    if (node.truth_value() != nullptr) {
+        node.truth_value()->accept(*this);
+    }
+    if (node.value() != nullptr) {
+        node.value()->accept(*this);
+    }
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+void EffectAnalyzer::visit(IfStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    node.truth_value()->accept(*this);
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+// Array
+
+void EffectAnalyzer::visit(ArrayUninit &node) {
+    node.size()->accept(*this);
+}
+
+void EffectAnalyzer::visit(ArrayElementAccess &node) {
+    node.idx()->accept(*this);
+    if (is_pointer(node.id())) {
+        summaries_.back().effects_.reads_memory_ = true;
+    }
+}
+
+// Variable
+
+void EffectAnalyzer::visit(VariableInit &node) {
+    node.value()->accept(*this);
+    if (is_pointer(node.id())) {
+        summaries_.back().has_pointer_locals_ = true;
+    }
+}
+
+void EffectAnalyzer::visit(VariableUninit &node) {
+    if (is_pointer(node.id())) {
+        summaries_.back().has_pointer_locals_ = true;
+    }
+}
+
+// The value of the parameter may be stored, returned or offset
+void EffectAnalyzer::visit(VariableAccess &node) {
+    if (auto param = get_param_index(node.id()); param != params_.size()) {
+        summaries_.back().effects_.captured_params_[param] = true;
+    }
+}
+
+// Operations
+
+// Replays the evaluation of the RPN to tell the stores from the loads
+void EffectAnalyzer::visit(Assignment &node) {
+    std::vector<ArrayElementAccess *> stores;
+    Childs operands;
+    for (auto *value : node.rpn()) {
+        if (auto *assign = dynamic_cast<AssignmentOperator *>(value);
+            assign != nullptr) {
+            operands.pop_back();
+            if (auto *element =
+                    dynamic_cast<ArrayElementAccess *>(operands.back());
+                element != nullptr && is_pointer(element->id())) {
+                stores.push_back(element);
+                auto &effects = summaries_.back().effects_;
+                effects.writes_memory_ = true;
+                effects.reads_memory_ = effects.reads_memory_ ||
+                    assign->assign_operator() != "=";
+            }
+            operands.back() = nullptr;
+        } else if (
+            dynamic_cast<ArithmeticOperator *>(value) != nullptr ||
+            dynamic_cast<RelationalOperator *>(value) != nullptr) {
+            operands.pop_back();
+            operands.back() = nullptr;
+        } else {
+            operands.push_back(value);
+        }
+    }
+
+    for (auto *value : node.rpn()) {
+        if (std::find(stores.begin(), stores.end(), value) != stores.end()) {
+            dynamic_cast<ArrayElementAccess *>(value)->idx()->accept(*this);
+        } else {
+            value->accept(*this);
+        }
+    }
+}
+
+void EffectAnalyzer::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+// Literals
+
+void EffectAnalyzer::visit(StringLiteral &node) {
+    if (node.string().find("%n") != std::string::npos) {
+        summaries_.back().effects_.writes_memory_ = true;
+    }
+}
+
+// private methods
+
+symtab::FunctionSymbol *EffectAnalyzer::get_funcsym(const std::string &id) {
+    symtab::FunctionSymbol *func_sym = nullptr;
+    for (auto *stack_node = symtab_.find_sym(id); stack_node != nullptr;
+         stack_node = stack_node->prev_) {
+        if (func_sym =
+                dynamic_cast<symtab::FunctionSymbol *>(stack_node->sym_.get());
+            func_sym != nullptr) {
+            return func_sym;
+        }
+    }
+    return func_sym;
+}
+
+std::size_t EffectAnalyzer::get_param_index(const std::string &id) const {
+    auto *sym = scopes_.top()->resolve(id);
+    for (std::size_t i = 0; i < params_.size(); ++i) {
+        if (params_[i] == sym) {
+            return i;
+        }
+    }
+    return params_.size();
+}
+
+bool EffectAnalyzer::is_pointer(const std::string &id) const {
+    auto *var = dynamic_cast<symtab::VariableSymbol *>(
+        scopes_.top()->resolve(id));
+    return var != nullptr &&
+        var->get_type()->get_type() == std::string("*");
+}
+
+void EffectAnalyzer::propagate() {
+    for (bool is_changed = true; is_changed;) {
+        is_changed = false;
+        for (auto &summary : summaries_) {
+            auto &effects = summary.effects_;
+            for (auto *callee : summary.callees_) {
+                const auto &callee_effects =
+                    summaries_[summary_ids_.at(callee)].effects_;
+                if (merge(effects, callee_effects)) {
+                    is_changed = true;
+                }
+            }
+        }
+    }
+
+    for (bool is_changed = true; is_changed;) {
+        is_changed = false;
+        for (auto &summary : summaries_) {
+            auto &captured = summary.effects_.captured_params_;
+            for (const auto &pass : summary.passes_) {
+                const auto &callee_captured =
+                    summaries_[summary_ids_.at(pass.callee_)]
+                        .effects_.captured_params_;
+                if (!captured[pass.param_] &&
+                    (pass.arg_ >= callee_captured.size() ||
+                     callee_captured[pass.arg_])) {
+                    captured[pass.param_] = true;
+                    is_changed = true;
+                }
+            }
+        }
+    }
+
+    for (auto &summary : summaries_) {
+        find_noalias_params(summary);
+        // Keeps the order of the first calls
+        std::vector<symtab::FunctionSymbol *> callees;
+        for (auto *callee : summary.callees_) {
+            if (std::find(callees.begin(), callees.end(), callee) ==
+                callees.end()) {
+                callees.push_back(callee);
+            }
+        }
+        summary.callees_ = std::move(callees);
+    }
+    for (auto &summary : summaries_) {
+        summary.effects_.is_recursive_ = is_reachable(summary.func_, summary);
+        summary.func_->set_effects(summary.effects_);
+        summary.func_->set_callees(summary.callees_);
+    }
+}
+
+// Without globals a function reaches the memory of its callers only through
+// the parameters. If there is a single one and it points to non-pointers,
+// every pointer of the function is based on it or on a local array.
+void EffectAnalyzer::find_noalias_params(Summary &summary) {
+    auto params = summary.func_->get_params();
+    std::size_t pointer_params = 0;
+    for (auto *param : params) {
+        if (get_level(param) > 0) {
+            ++pointer_params;
+        }
+    }
+
+    auto &noalias = summary.effects_.noalias_params_;
+    noalias.resize(params.size());
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        noalias[i] = pointer_params == 1 && get_level(params[i]) == 1 &&
+            !summary.has_pointer_locals_;
+    }
+}
+
+std::size_t EffectAnalyzer::get_level(symtab::Symbol *sym) {
+    auto *var = dynamic_cast<symtab::VariableSymbol *>(sym);
+    auto *type = dynamic_cast<symtab::PointerType *>(var->get_type());
+    return type == nullptr ? 0 : type->get_level();
+}
+
+bool EffectAnalyzer::is_reachable(
+    symtab::FunctionSymbol *target, const Summary &from) const {
+    std::vector<const Summary *> stack{&from};
+    std::vector<bool> is_visited(summaries_.size());
+    while (!stack.empty()) {
+        const auto *summary = stack.back();
+        stack.pop_back();
+        for (auto *callee : summary->callees_) {
+            if (callee == target) {
+                return true;
+            }
+            auto id = summary_ids_.at(callee);
+            if (!is_visited[id]) {
+                is_visited[id] = true;
+                stack.push_back(&summaries_[id]);
+            }
+        }
+    }
+    return false;
+}
+
+} // namespace c::ast
\ No newline at end of file
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/ast/visitor.hpp>
+
+#include <stack>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast {
+
+// Finds what every function may do to the memory of its callers and sets
+// the effects and the callees of its FunctionSymbol. The effects of the
+// callees are merged over the call graph until nothing changes, so
+// recursion is handled.
+//
+// The local arrays aren't visible to the callers, only the stores and loads
+// through pointers count.
+class EffectAnalyzer final : public Visitor {
+  public:
+    explicit EffectAnalyzer(symtab::Symtab &symtab) : symtab_(symtab) {}
+
+    static void exec(Program &program, symtab::Symtab &symtab);
+
+    void visit(FunctionDefinition &node) override;
+    void visit(LocalScope &node) override;
+
+    // Expressions
+
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+
+    // Statements
+
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+
+    // Array
+
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+
+    // Variable
+
+    void visit(VariableInit &node) override;
+    void visit(VariableUninit &node) override;
+    void visit(VariableAccess &node) override;
+
+    // Operations
+
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+
+    // Literals
+
+    void visit(StringLiteral &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(ContinueStatement & /*node*/) override {}
+    void visit(BreakStatement & /*node*/) override {}
+    void visit(AssignmentOperator & /*node*/) override {}
+    void visit(ArithmeticOperator & /*node*/) override {}
+    void visit(RelationalOperator & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+    void visit(IntegerLiteral & /*node*/) override {}
+
+    // A parameter passed on as an argument
+    struct Pass {
+        symtab::FunctionSymbol *callee_;
+        std::size_t arg_;
+        std::size_t param_;
+    };
+
+    struct Summary {
+        symtab::FunctionSymbol *func_;
+        symtab::FunctionEffects effects_;
+        std::vector<symtab::FunctionSymbol *> callees_;
+        std::vector<Pass> passes_;
+        bool has_pointer_locals_;
+    };
+
+    symtab::FunctionSymbol *get_funcsym(const std::string &id);
+    std::size_t get_param_index(const std::string &id) const;
+    bool is_pointer(const std::string &id) const;
+    void propagate();
+    static void find_noalias_params(Summary &summary);
+    static std::size_t get_level(symtab::Symbol *sym);
+    bool is_reachable(
+        symtab::FunctionSymbol *target, const Summary &from) const;
+
+    symtab::Symtab &symtab_;
+
+    std::stack<symtab::Scope *> scopes_;
+    std::size_t scope_order_{0};
+    std::vector<symtab::Symbol *> params_;
+
+    // In the order of the definitions
+    std::vector<Summary> summaries_;
+    std::unordered_map<symtab::FunctionSymbol *, std::size_t> summary_ids_;
+};
+
+} // namespace c::ast
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace c::ast {
+
+// Implicit conversion of a value from one arithmetic type to another
+enum class Conversion {
+    none,
+    sign_extend,
+    zero_extend,
+    truncate,
+    float_extend,
+    float_truncate,
+    int_to_float,
+    float_to_int
+};
+
+struct ValueType {
+    bool operator==(const ValueType &other) const {
+        return name_ == other.name_ && pointer_level_ == other.pointer_level_;
+    }
+    bool operator!=(const ValueType &other) const {
+        return !(*this == other);
+    }
+
+    bool is_floating() const {
+        return pointer_level_ == 0 && (name_ == "float" || name_ == "double");
+    }
+
+    // An arithmetic type, bool for the relational operators, or the type
+    // pointed to
+    std::string name_;
+    std::size_t pointer_level_{0};
+};
+
+// The type a variadic argument is passed as: float is promoted to double,
+// the integers narrower than int to int
+inline ValueType get_promoted_type(ValueType type) {
+    if (type.pointer_level_ > 0) {
+        return type;
+    }
+    if (type.name_ == "float") {
+        type.name_ = "double";
+    } else if (
+        type.name_ == "bool" || type.name_ == "char" || type.name_ == "short") {
+        type.name_ = "int";
+    }
+    return type;
+}
+
+// What the type analysis found for an expression node. The code generator
+// emits the conversions as they are and never compares the types itself.
+struct ExpressionType {
+    ValueType type_;
+    // To the type of the variable, parameter, return value or array index
+    // that takes the value, or to the promoted type of a variadic argument
+    Conversion conversion_{Conversion::none};
+
+    // Operators: both operands are converted to this type first, at most one
+    // of them needs a conversion
+    ValueType operand_type_;
+    Conversion lhs_conversion_{Conversion::none};
+    Conversion rhs_conversion_{Conversion::none};
+};
+
+} // namespace c::ast
\ No newline at end of file
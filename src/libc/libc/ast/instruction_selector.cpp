@@ -0,0 +1,1189 @@
+#include <libc/ast/instruction_selector.hpp>
+
+#include <libc/ast/detail/string_pool.hpp>
+#include <libc/trace.hpp>
+
+#include <limits>
+
+namespace c::ast {
+
+using detail::Address;
+using detail::Cond;
+using detail::Instruction;
+using detail::Opcode;
+using detail::Operand;
+using detail::Reg;
+using detail::Width;
+
+namespace {
+
+const std::unordered_map<std::string, Cond> c_int_conds = {
+    {"==", Cond::e},
+    {"!=", Cond::ne},
+    {"<", Cond::l},
+    {"<=", Cond::le},
+    {">", Cond::g},
+    {">=", Cond::ge}};
+
+const std::unordered_map<std::string, Opcode> c_int_opcodes = {
+    {"+", Opcode::add}, {"-", Opcode::sub}, {"*", Opcode::imul}};
+
+const std::unordered_map<std::string, Opcode> c_float_opcodes = {
+    {"+", Opcode::adds},
+    {"-", Opcode::subs},
+    {"*", Opcode::muls},
+    {"/", Opcode::divs}};
+
+// The same comparison with the operands swapped
+Cond swap_operands(Cond cond) {
+    switch (cond) {
+    case Cond::l:
+        return Cond::g;
+    case Cond::le:
+        return Cond::ge;
+    case Cond::g:
+        return Cond::l;
+    case Cond::ge:
+        return Cond::le;
+    default:
+        return cond;
+    }
+}
+
+bool is_imm32(std::int64_t value) {
+    return value >= std::numeric_limits<std::int32_t>::min() &&
+        value <= std::numeric_limits<std::int32_t>::max();
+}
+
+Operand make_memory(Address address) {
+    return Operand::make_mem(std::move(address));
+}
+
+} // namespace
+
+detail::MachineModule InstructionSelector::exec(
+    Program &program, symtab::Symtab &symtab) {
+    InstructionSelector selector(program, symtab);
+    for (auto *child : program.get_childs()) {
+        child->accept(selector);
+    }
+    return std::move(selector.module_);
+}
+
+void InstructionSelector::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("instruction selection", node.id());
+    auto *func_sym = get_funcsym(node.id());
+    scopes_.push(func_sym);
+    current_func_ = func_sym;
+
+    func_ = detail::MachineFunction();
+    func_.name_ = node.id();
+    func_.is_exported_ = node.id() == "main";
+    layout_.clear();
+    variables_.clear();
+    saved_stacks_.assign(1, detail::c_no_reg);
+    start_block(create_block());
+
+    Instruction params{Opcode::params};
+    for (auto *param : func_sym->get_params()) {
+        auto *var = dynamic_cast<symtab::VariableSymbol *>(param);
+        Variable variable;
+        variable.type_ = get_type(var->get_type());
+        variable.element_ = get_element_type(var->get_type());
+        variable.reg_ = make_reg(variable.type_);
+        params.args_.push_back(Operand::make_reg(variable.reg_));
+        variables_[var] = variable;
+    }
+    emit(std::move(params));
+
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+    // Falling off the end of main returns 0
+    Instruction ret{Opcode::ret_value};
+    if (func_.is_exported_) {
+        ret.width_ = Width::b32;
+        ret.src_ = Operand::make_imm(0);
+    }
+    emit(std::move(ret));
+
+    finish_function();
+    module_.functions_.push_back(std::move(func_));
+    scopes_.pop();
+    scope_order_ = 0;
+}
+
+void InstructionSelector::visit(LocalScope &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    enter_scope();
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+    leave_scope();
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+// Expressions
+
+void InstructionSelector::visit(Expression &node) {
+    discard(node.expression());
+}
+
+void InstructionSelector::visit(FunctionCall &node) {
+    std::vector<Value> args;
+    for (auto *arg : node.args()) {
+        args.push_back(evaluate(arg));
+    }
+
+    if (node.id() == "printf") {
+        for (std::size_t i = 0; i < args.size(); ++i) {
+            auto type = get_promoted_type(
+                program_.get_expression_type(node.args()[i]).type_);
+            args[i] = convert(
+                node.args()[i], std::move(args[i]), get_type(type));
+        }
+        emit_call("printf", std::move(args), Type::i32, true);
+        return;
+    }
+
+    // The hint only matters to the LLVM backend
+    if (node.id() == "__builtin_expect") {
+        push(convert(node.args()[0], std::move(args[0]), Type::i64));
+        return;
+    }
+
+    auto *func = get_funcsym(node.id());
+    auto params = func->get_params();
+    for (std::size_t i = 0; i < params.size(); ++i) {
+        auto *param = dynamic_cast<symtab::VariableSymbol *>(params[i]);
+        args[i] = convert(
+            node.args()[i], std::move(args[i]), get_type(param->get_type()));
+    }
+    emit_call(node.id(), std::move(args), get_type(func->get_type()), false);
+}
+
+void InstructionSelector::visit(VariableWriting &node) {
+    node.variable_writing()->accept(*this);
+}
+
+void InstructionSelector::visit(DataCreate &node) {
+    node.data_create()->accept(*this);
+}
+
+// Statements
+
+void InstructionSelector::visit(ReturnStatement &node) {
+    auto type = get_type(current_func_->get_type());
+    auto value = convert(node.value(), evaluate(node.value()), type);
+    Instruction ret{Opcode::ret_value};
+    ret.width_ = get_width(type);
+    ret.src_ = std::move(value.operand_);
+    emit(std::move(ret));
+    start_block(create_block());
+}
+
+void InstructionSelector::visit(ForStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    enter_scope();
+    if (node.for_data_using() != nullptr) {
+        discard(node.for_data_using());
+    }
+    const auto body = create_block();
+    const auto latch = create_block();
+    const auto cond = create_block();
+    const auto exit = create_block();
+    jump(cond);
+
+    start_block(body);
+    loops_.push_back({latch, exit, saved_stacks_.size()});
+    enter_scope();
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+    leave_scope();
+    loops_.pop_back();
+
+    start_block(latch);
+    if (node.value() != nullptr) {
+        discard(node.value());
+    }
+
+    start_block(cond);
+    if (node.truth_value() != nullptr) {
+        branch(emit_condition(node.truth_value()), body);
+    } else {
+        jump(body);
+    }
+
+    start_block(exit);
+    leave_scope();
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+void InstructionSelector::visit(IfStatement &node) {
+    scopes_.push(scopes_.top()->get_nested_scopes()[scope_order_++].get());
+    std::size_t prev_scope_order = scope_order_;
+    scope_order_ = 0;
+
+    const auto skip = create_block();
+    branch(negate(emit_condition(node.truth_value())), skip);
+
+    start_block(create_block());
+    enter_scope();
+    for (auto *action : node.actions()) {
+        action->accept(*this);
+    }
+    leave_scope();
+
+    start_block(skip);
+
+    scope_order_ = prev_scope_order;
+    scopes_.pop();
+}
+
+void InstructionSelector::visit(ContinueStatement & /*node*/) {
+    restore_stack(loops_.back().stack_depth_);
+    jump(loops_.back().latch_);
+    start_block(create_block());
+}
+
+void InstructionSelector::visit(BreakStatement & /*node*/) {
+    restore_stack(loops_.back().stack_depth_);
+    jump(loops_.back().exit_);
+    start_block(create_block());
+}
+
+// Array
+
+void InstructionSelector::visit(ArrayUninit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.is_array_ = true;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = variable.type_;
+    const auto element_size = get_size(variable.element_);
+
+    auto count = convert(node.size(), evaluate(node.size()), Type::i64);
+    if (count.operand_.kind_ == Operand::Kind::imm) {
+        auto size = static_cast<std::size_t>(
+            std::max<std::int64_t>(count.operand_.imm_, 1));
+        variable.address_.frame_object_ = func_.frame_objects_.size();
+        func_.frame_objects_.push_back({size * element_size});
+        variables_[var] = variable;
+        return;
+    }
+
+    // Rounded up to keep the stack aligned for the calls
+    auto size = copy(count);
+    auto bytes = Operand::make_reg(size.operand_.reg_);
+    emit(
+        Opcode::imul, Width::b64, bytes,
+        Operand::make_imm(static_cast<std::int64_t>(element_size)));
+    emit(Opcode::add, Width::b64, bytes, Operand::make_imm(15));
+    emit(Opcode::and_, Width::b64, bytes, Operand::make_imm(-16));
+    if (saved_stacks_.back() == detail::c_no_reg) {
+        saved_stacks_.back() = make_reg(Type::ptr);
+        emit(
+            Opcode::mov, Width::b64,
+            Operand::make_reg(saved_stacks_.back()),
+            Operand::make_reg(detail::x86::rsp));
+    }
+    emit(
+        Opcode::sub, Width::b64, Operand::make_reg(detail::x86::rsp), bytes);
+    variable.address_.base_ = make_reg(Type::ptr);
+    emit(
+        Opcode::mov, Width::b64, Operand::make_reg(variable.address_.base_),
+        Operand::make_reg(detail::x86::rsp));
+    variables_[var] = variable;
+}
+
+void InstructionSelector::visit(ArrayElementAccess &node) {
+    auto index = convert(node.idx(), evaluate(node.idx()), Type::i64);
+
+    auto *var = get_varsym(node.id());
+    const auto &variable = variables_.at(var);
+    Address address;
+    if (variable.is_array_) {
+        address = variable.address_;
+    } else {
+        address.base_ = variable.reg_;
+    }
+    const auto element_size = get_size(variable.element_);
+    auto it = lvalues_.find(&node);
+    if (index.operand_.kind_ == Operand::Kind::imm) {
+        address.disp_ += static_cast<std::int32_t>(
+            index.operand_.imm_ * static_cast<std::int64_t>(element_size));
+    } else {
+        // The rest of the assignment may change the variable before the
+        // element is stored
+        if (it != lvalues_.end() && index.var_ != nullptr) {
+            index = copy(index);
+        }
+        address.index_ = index.operand_.reg_;
+        address.scale_ = static_cast<std::uint8_t>(element_size);
+    }
+
+    if (it == lvalues_.end()) {
+        push(load(address, variable.element_));
+        return;
+    }
+    Value value;
+    if (it->second) {
+        value = load(address, variable.element_);
+    }
+    value.type_ = variable.element_;
+    value.address_ = std::move(address);
+    push(std::move(value));
+}
+
+// Variable
+
+void InstructionSelector::visit(VariableInit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = get_element_type(var->get_type());
+    variable.reg_ = make_reg(variable.type_);
+
+    auto value =
+        convert(node.value(), evaluate(node.value()), variable.type_);
+    // The constants are used in place of their variables
+    if (var->get_type()->is_const() &&
+        value.operand_.kind_ == Operand::Kind::imm) {
+        variable.constant_ = value.operand_.imm_;
+    }
+    variables_[var] = variable;
+
+    Value lvalue;
+    lvalue.type_ = variable.type_;
+    lvalue.var_ = var;
+    store(lvalue, value);
+}
+
+void InstructionSelector::visit(VariableUninit &node) {
+    auto *var = get_varsym(node.id());
+    Variable variable;
+    variable.type_ = get_type(var->get_type());
+    variable.element_ = get_element_type(var->get_type());
+    variable.reg_ = make_reg(variable.type_);
+    variables_[var] = variable;
+}
+
+void InstructionSelector::visit(VariableAccess &node) {
+    auto *var = get_varsym(node.id());
+    const auto &variable = variables_.at(var);
+    auto it = lvalues_.find(&node);
+
+    if (variable.is_array_) {
+        if (it == lvalues_.end()) {
+            push(load(variable.address_, variable.element_));
+            return;
+        }
+        Value value;
+        if (it->second) {
+            value = load(variable.address_, variable.element_);
+        }
+        value.type_ = variable.element_;
+        value.address_ = variable.address_;
+        push(std::move(value));
+        return;
+    }
+
+    Value value;
+    value.operand_ = variable.constant_
+        ? Operand::make_imm(*variable.constant_)
+        : Operand::make_reg(variable.reg_);
+    value.type_ = variable.type_;
+    value.var_ = var;
+    push(std::move(value));
+}
+
+// Operations
+
+void InstructionSelector::visit(Assignment &node) {
+    const auto &expression = node.expression();
+    for (std::size_t i = 0; i + 1 < expression.size(); i += 2) {
+        auto *oper = dynamic_cast<AssignmentOperator *>(expression[i + 1]);
+        lvalues_[expression[i]] = oper->assign_operator() != "=";
+    }
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+    for (std::size_t i = 0; i + 1 < expression.size(); i += 2) {
+        lvalues_.erase(expression[i]);
+    }
+}
+
+void InstructionSelector::visit(RvalueOperation &node) {
+    for (auto *value : node.rpn()) {
+        value->accept(*this);
+    }
+}
+
+void InstructionSelector::visit(AssignmentOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = lhs.type_;
+    if (expression_type.rhs_conversion_ != Conversion::none) {
+        rhs = emit_conversion(
+            expression_type.rhs_conversion_, std::move(rhs), type);
+    }
+    if (node.assign_operator()[0] != '=') {
+        Value value;
+        value.operand_ = lhs.operand_;
+        value.type_ = type;
+        rhs = emit_arithmetic(
+            node.assign_operator().substr(0, 1), std::move(value),
+            std::move(rhs), type);
+    }
+    store(lhs, rhs);
+
+    rhs.var_ = nullptr;
+    rhs.address_.reset();
+    push(std::move(rhs));
+}
+
+void InstructionSelector::visit(ArithmeticOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = get_type(expression_type.operand_type_);
+    lhs = emit_conversion(
+        expression_type.lhs_conversion_, std::move(lhs), type);
+    rhs = emit_conversion(
+        expression_type.rhs_conversion_, std::move(rhs), type);
+    push(emit_arithmetic(
+        node.arithmetic_operator(), std::move(lhs), std::move(rhs), type));
+}
+
+void InstructionSelector::visit(RelationalOperator &node) {
+    auto rhs = pop();
+    auto lhs = pop();
+
+    const auto &expression_type = program_.get_expression_type(&node);
+    auto type = get_type(expression_type.operand_type_);
+    lhs = emit_conversion(
+        expression_type.lhs_conversion_, std::move(lhs), type);
+    rhs = emit_conversion(
+        expression_type.rhs_conversion_, std::move(rhs), type);
+    push(emit_relational(
+        node.relational_operator(), std::move(lhs), std::move(rhs), type));
+}
+
+// Literals
+
+void InstructionSelector::visit(StringLiteral &node) {
+    auto content = detail::StringPool::decode(node.string());
+    auto [it, is_inserted] =
+        string_ids_.emplace(std::move(content), module_.strings_.size());
+    if (is_inserted) {
+        module_.strings_.push_back(it->first);
+    }
+
+    Address address;
+    address.symbol_ = ".L.str" + std::to_string(it->second);
+    Value value;
+    value.type_ = Type::ptr;
+    value.operand_ = Operand::make_reg(make_reg(Type::ptr));
+    emit(Opcode::lea, Width::b64, value.operand_, make_memory(address));
+    push(std::move(value));
+}
+
+void InstructionSelector::visit(IntegerLiteral &node) {
+    Value value;
+    value.operand_ = Operand::make_imm(std::stoll(node.integer()));
+    value.type_ = Type::i32;
+    push(std::move(value));
+}
+
+// private methods
+
+symtab::VariableSymbol *InstructionSelector::get_varsym(const std::string &id) {
+    return dynamic_cast<symtab::VariableSymbol *>(scopes_.top()->resolve(id));
+}
+
+symtab::FunctionSymbol *InstructionSelector::get_funcsym(
+    const std::string &id) {
+    for (auto *stack_node = symtab_.find_sym(id); stack_node != nullptr;
+         stack_node = stack_node->prev_) {
+        if (auto *func_sym =
+                dynamic_cast<symtab::FunctionSymbol *>(stack_node->sym_.get());
+            func_sym != nullptr) {
+            return func_sym;
+        }
+    }
+    return nullptr;
+}
+
+InstructionSelector::Type InstructionSelector::get_type(const ValueType &type) {
+    if (type.pointer_level_ > 0) {
+        return Type::ptr;
+    }
+    static const std::unordered_map<std::string, Type> c_types = {
+        {"bool", Type::i1},
+        {"char", Type::i8},
+        {"short", Type::i16},
+        {"int", Type::i32},
+        {"long", Type::i64},
+        {"float", Type::f32},
+        {"double", Type::f64},
+        {"void", Type::void_}};
+    return c_types.at(type.name_);
+}
+
+// An array is its element as a value
+InstructionSelector::Type InstructionSelector::get_type(symtab::Type *type) {
+    return get_type(ValueType{
+        type->get_name(),
+        type->get_type() == std::string("*") ? std::size_t{1} : 0});
+}
+
+InstructionSelector::Type InstructionSelector::get_element_type(
+    symtab::Type *type) {
+    auto *pointer_type = dynamic_cast<symtab::PointerType *>(type);
+    return get_type(ValueType{
+        type->get_name(),
+        pointer_type == nullptr ? 0 : pointer_type->get_level() - 1});
+}
+
+Width InstructionSelector::get_width(Type type) {
+    switch (type) {
+    case Type::i64:
+    case Type::ptr:
+        return Width::b64;
+    case Type::f32:
+        return Width::f32;
+    case Type::f64:
+        return Width::f64;
+    default:
+        return Width::b32;
+    }
+}
+
+Width InstructionSelector::get_memory_width(Type type) {
+    switch (type) {
+    case Type::i8:
+        return Width::b8;
+    case Type::i16:
+        return Width::b16;
+    default:
+        return get_width(type);
+    }
+}
+
+std::size_t InstructionSelector::get_size(Type type) {
+    switch (get_memory_width(type)) {
+    case Width::b8:
+        return 1;
+    case Width::b16:
+        return 2;
+    case Width::b32:
+    case Width::f32:
+        return 4;
+    default:
+        return 8;
+    }
+}
+
+// The value wraps around as in the integer of the type
+std::int64_t InstructionSelector::wrap(std::int64_t value, Type type) {
+    switch (type) {
+    case Type::i8:
+        return static_cast<std::int8_t>(value);
+    case Type::i16:
+        return static_cast<std::int16_t>(value);
+    case Type::i1:
+    case Type::i32:
+        return static_cast<std::int32_t>(value);
+    default:
+        return value;
+    }
+}
+
+Reg InstructionSelector::make_reg(Type type) {
+    auto reg =
+        detail::c_first_virtual + static_cast<Reg>(func_.is_float_.size());
+    func_.is_float_.push_back(is_floating(type));
+    return reg;
+}
+
+void InstructionSelector::emit(Instruction instruction) {
+    func_.blocks_[current_block_].instructions_.push_back(
+        std::move(instruction));
+}
+
+void InstructionSelector::emit(
+    Opcode opcode, Width width, Operand dst, Operand src) {
+    Instruction instruction{opcode};
+    instruction.width_ = width;
+    instruction.dst_ = std::move(dst);
+    instruction.src_ = std::move(src);
+    emit(std::move(instruction));
+}
+
+std::size_t InstructionSelector::create_block() {
+    func_.blocks_.emplace_back();
+    return func_.blocks_.size() - 1;
+}
+
+// The previous block falls through to the started one
+void InstructionSelector::start_block(std::size_t block) {
+    layout_.push_back(block);
+    current_block_ = block;
+}
+
+void InstructionSelector::jump(std::size_t block) {
+    emit(Opcode::jmp, Width::b64, Operand::make_label(block));
+}
+
+// Ends the block, the next one has to be started right after
+void InstructionSelector::branch(Cond cond, std::size_t block) {
+    Instruction jcc{Opcode::jcc};
+    jcc.cond_ = cond;
+    jcc.dst_ = Operand::make_label(block);
+    emit(std::move(jcc));
+}
+
+// Lays the blocks out in the order they were started in, drops the ones
+// that can't be reached and the jumps to the next blocks
+void InstructionSelector::finish_function() {
+    auto &blocks = func_.blocks_;
+    std::vector<std::size_t> positions(blocks.size(), layout_.size());
+    for (std::size_t i = 0; i < layout_.size(); ++i) {
+        positions[layout_[i]] = i;
+    }
+
+    std::vector<bool> is_reachable(layout_.size());
+    std::vector<std::size_t> worklist = {0};
+    is_reachable[0] = true;
+    auto reach = [&](std::size_t position) {
+        if (!is_reachable[position]) {
+            is_reachable[position] = true;
+            worklist.push_back(position);
+        }
+    };
+    while (!worklist.empty()) {
+        auto position = worklist.back();
+        worklist.pop_back();
+        const auto &instructions = blocks[layout_[position]].instructions_;
+        bool is_falling_through = true;
+        for (const auto &instruction : instructions) {
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::jcc) {
+                reach(positions[instruction.dst_.imm_]);
+            }
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::ret_value) {
+                is_falling_through = false;
+                break;
+            }
+        }
+        if (is_falling_through && position + 1 < layout_.size()) {
+            reach(position + 1);
+        }
+    }
+
+    std::vector<std::size_t> numbers(blocks.size());
+    std::vector<detail::MachineBlock> laid_out;
+    for (std::size_t i = 0; i < layout_.size(); ++i) {
+        if (is_reachable[i]) {
+            numbers[layout_[i]] = laid_out.size();
+            laid_out.push_back(std::move(blocks[layout_[i]]));
+        }
+    }
+    for (std::size_t i = 0; i < laid_out.size(); ++i) {
+        auto &instructions = laid_out[i].instructions_;
+        for (auto &instruction : instructions) {
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::jcc) {
+                instruction.dst_.imm_ = static_cast<std::int64_t>(
+                    numbers[instruction.dst_.imm_]);
+            }
+        }
+        // The code after a return or a jump isn't reachable
+        for (std::size_t j = 0; j < instructions.size(); ++j) {
+            if (instructions[j].opcode_ == Opcode::jmp ||
+                instructions[j].opcode_ == Opcode::ret_value) {
+                instructions.erase(
+                    instructions.begin() + static_cast<std::ptrdiff_t>(j) + 1,
+                    instructions.end());
+                break;
+            }
+        }
+        if (!instructions.empty() &&
+            instructions.back().opcode_ == Opcode::jmp &&
+            instructions.back().dst_.imm_ ==
+                static_cast<std::int64_t>(i + 1)) {
+            instructions.pop_back();
+        }
+    }
+
+    // A branch over a block that only jumps branches to the target of the
+    // jump by the opposite condition, the block isn't reached anymore
+    std::vector<bool> is_target(laid_out.size());
+    for (const auto &block : laid_out) {
+        for (const auto &instruction : block.instructions_) {
+            if (instruction.opcode_ == Opcode::jmp ||
+                instruction.opcode_ == Opcode::jcc) {
+                is_target[instruction.dst_.imm_] = true;
+            }
+        }
+    }
+    for (std::size_t i = 0; i + 2 < laid_out.size(); ++i) {
+        auto &instructions = laid_out[i].instructions_;
+        auto &over = laid_out[i + 1].instructions_;
+        if (!instructions.empty() &&
+            instructions.back().opcode_ == Opcode::jcc &&
+            instructions.back().dst_.imm_ ==
+                static_cast<std::int64_t>(i + 2) &&
+            !is_target[i + 1] && over.size() == 1 &&
+            over.back().opcode_ == Opcode::jmp) {
+            auto &jcc = instructions.back();
+            jcc.cond_ = detail::negate(jcc.cond_);
+            jcc.dst_ = over.back().dst_;
+            over.clear();
+        }
+    }
+    blocks = std::move(laid_out);
+}
+
+void InstructionSelector::push(Value value) {
+    values_.push_back(std::move(value));
+}
+
+InstructionSelector::Value InstructionSelector::pop() {
+    auto value = std::move(values_.back());
+    values_.pop_back();
+    return value;
+}
+
+InstructionSelector::Value InstructionSelector::evaluate(Node *node) {
+    node->accept(*this);
+    return pop();
+}
+
+// Declarations leave no value
+void InstructionSelector::discard(Node *node) {
+    const auto depth = values_.size();
+    node->accept(*this);
+    values_.resize(depth);
+}
+
+Reg InstructionSelector::to_reg(const Value &value) {
+    if (value.operand_.is_reg()) {
+        return value.operand_.reg_;
+    }
+    return copy(value).operand_.reg_;
+}
+
+InstructionSelector::Value InstructionSelector::copy(const Value &value) {
+    Value result;
+    result.type_ = value.type_;
+    result.operand_ = Operand::make_reg(make_reg(value.type_));
+    emit(
+        is_floating(value.type_) ? Opcode::movaps : Opcode::mov,
+        get_width(value.type_), result.operand_, value.operand_);
+    return result;
+}
+
+// The narrower integers are sign extended
+InstructionSelector::Value InstructionSelector::load(
+    const Address &address, Type type) {
+    Value value;
+    value.type_ = type;
+    value.operand_ = Operand::make_reg(make_reg(type));
+    Instruction instruction{Opcode::mov};
+    instruction.width_ = get_width(type);
+    instruction.src_width_ = get_memory_width(type);
+    if (is_floating(type)) {
+        instruction.opcode_ = Opcode::movs;
+    } else if (instruction.src_width_ != instruction.width_) {
+        instruction.opcode_ = Opcode::movsx;
+    }
+    instruction.dst_ = value.operand_;
+    instruction.src_ = make_memory(address);
+    emit(std::move(instruction));
+    return value;
+}
+
+void InstructionSelector::store(const Value &lvalue, const Value &value) {
+    const bool is_float = is_floating(lvalue.type_);
+    if (lvalue.var_ != nullptr && !lvalue.address_) {
+        emit(
+            is_float ? Opcode::movaps : Opcode::mov, get_width(lvalue.type_),
+            Operand::make_reg(variables_.at(lvalue.var_).reg_),
+            value.operand_);
+        return;
+    }
+    auto src = value.operand_;
+    if (src.kind_ == Operand::Kind::imm && !is_imm32(src.imm_)) {
+        src = Operand::make_reg(to_reg(value));
+    }
+    emit(
+        is_float ? Opcode::movs : Opcode::mov, get_memory_width(lvalue.type_),
+        make_memory(*lvalue.address_), std::move(src));
+}
+
+// Applies the conversion the type analysis found for the value of the node
+InstructionSelector::Value InstructionSelector::convert(
+    const Node *node, Value value, Type type) {
+    return emit_conversion(
+        program_.get_expression_type(node).conversion_, std::move(value),
+        type);
+}
+
+InstructionSelector::Value InstructionSelector::emit_conversion(
+    Conversion conversion, Value value, Type type) {
+    if (conversion == Conversion::none) {
+        return value;
+    }
+    const auto from = value.type_;
+    const bool is_constant = value.operand_.kind_ == Operand::Kind::imm;
+    Value result;
+    result.type_ = type;
+
+    switch (conversion) {
+    case Conversion::sign_extend:
+    case Conversion::zero_extend:
+        if (is_constant || get_width(type) == get_width(from)) {
+            value.type_ = type;
+            value.var_ = nullptr;
+            return value;
+        }
+        result.operand_ = Operand::make_reg(make_reg(type));
+        // Writing the 32-bit register clears the upper half
+        if (conversion == Conversion::zero_extend) {
+            emit(Opcode::mov, Width::b32, result.operand_, value.operand_);
+        } else {
+            Instruction movsx{Opcode::movsx};
+            movsx.width_ = Width::b64;
+            movsx.src_width_ = Width::b32;
+            movsx.dst_ = result.operand_;
+            movsx.src_ = value.operand_;
+            emit(std::move(movsx));
+        }
+        return result;
+    case Conversion::truncate: {
+        if (is_constant) {
+            result.operand_ =
+                Operand::make_imm(wrap(value.operand_.imm_, type));
+            return result;
+        }
+        result.operand_ = Operand::make_reg(make_reg(type));
+        Instruction instruction{Opcode::mov};
+        instruction.width_ = Width::b32;
+        instruction.src_width_ = get_memory_width(type);
+        if (instruction.src_width_ != Width::b32) {
+            instruction.opcode_ = Opcode::movsx;
+        }
+        instruction.dst_ = result.operand_;
+        instruction.src_ = value.operand_;
+        emit(std::move(instruction));
+        return result;
+    }
+    case Conversion::float_extend:
+    case Conversion::float_truncate: {
+        result.operand_ = Operand::make_reg(make_reg(type));
+        Instruction cvt{Opcode::cvts2s};
+        cvt.width_ = get_width(type);
+        cvt.src_width_ = get_width(from);
+        cvt.dst_ = result.operand_;
+        cvt.src_ = value.operand_;
+        emit(std::move(cvt));
+        return result;
+    }
+    case Conversion::int_to_float: {
+        auto src = to_reg(value);
+        result.operand_ = Operand::make_reg(make_reg(type));
+        Instruction cvt{Opcode::cvtsi2s};
+        cvt.width_ = get_width(type);
+        cvt.src_width_ = get_width(from);
+        cvt.dst_ = result.operand_;
+        cvt.src_ = Operand::make_reg(src);
+        emit(std::move(cvt));
+        return result;
+    }
+    default: {
+        result.operand_ = Operand::make_reg(make_reg(type));
+        Instruction cvt{Opcode::cvtts2si};
+        cvt.width_ = get_width(type);
+        cvt.src_width_ = get_width(from);
+        cvt.dst_ = result.operand_;
+        cvt.src_ = value.operand_;
+        emit(std::move(cvt));
+        if (get_memory_width(type) != get_width(type)) {
+            Instruction movsx{Opcode::movsx};
+            movsx.width_ = Width::b32;
+            movsx.src_width_ = get_memory_width(type);
+            movsx.dst_ = result.operand_;
+            movsx.src_ = result.operand_;
+            emit(std::move(movsx));
+        }
+        return result;
+    }
+    }
+}
+
+InstructionSelector::Value InstructionSelector::emit_arithmetic(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    if (is_floating(type)) {
+        auto result = copy(lhs);
+        emit(c_float_opcodes.at(oper), get_width(type), result.operand_,
+             rhs.operand_);
+        return result;
+    }
+
+    if (lhs.operand_.kind_ == Operand::Kind::imm &&
+        rhs.operand_.kind_ == Operand::Kind::imm &&
+        !((oper == "/" || oper == "%") && rhs.operand_.imm_ == 0)) {
+        auto lhs_value = static_cast<std::uint64_t>(lhs.operand_.imm_);
+        auto rhs_value = static_cast<std::uint64_t>(rhs.operand_.imm_);
+        std::int64_t value = 0;
+        if (oper == "+") {
+            value = static_cast<std::int64_t>(lhs_value + rhs_value);
+        } else if (oper == "-") {
+            value = static_cast<std::int64_t>(lhs_value - rhs_value);
+        } else if (oper == "*") {
+            value = static_cast<std::int64_t>(lhs_value * rhs_value);
+        } else if (oper == "/") {
+            value = lhs.operand_.imm_ / rhs.operand_.imm_;
+        } else {
+            value = lhs.operand_.imm_ % rhs.operand_.imm_;
+        }
+        Value result;
+        result.type_ = type;
+        result.operand_ = Operand::make_imm(wrap(value, type));
+        return result;
+    }
+
+    Value result;
+    if (oper == "/" || oper == "%") {
+        result = emit_division(oper, lhs, std::move(rhs), type);
+    } else {
+        if (oper != "-" && lhs.operand_.kind_ == Operand::Kind::imm) {
+            std::swap(lhs, rhs);
+        }
+        result = copy(lhs);
+        result.type_ = type;
+        auto src = rhs.operand_;
+        if (src.kind_ == Operand::Kind::imm && !is_imm32(src.imm_)) {
+            src = Operand::make_reg(to_reg(rhs));
+        }
+        emit(c_int_opcodes.at(oper), get_width(type), result.operand_, src);
+    }
+
+    if (get_memory_width(type) != get_width(type)) {
+        Instruction movsx{Opcode::movsx};
+        movsx.width_ = Width::b32;
+        movsx.src_width_ = get_memory_width(type);
+        movsx.dst_ = result.operand_;
+        movsx.src_ = result.operand_;
+        emit(std::move(movsx));
+    }
+    return result;
+}
+
+// idiv takes the dividend in rdx:rax and leaves the quotient in rax and
+// the remainder in rdx
+InstructionSelector::Value InstructionSelector::emit_division(
+    const std::string &oper, const Value &lhs, Value rhs, Type type) {
+    const auto width = get_width(type);
+    auto divisor = to_reg(rhs);
+    emit(Opcode::mov, width, Operand::make_reg(detail::x86::rax), lhs.operand_);
+    emit(Opcode::cdq, width, {});
+    emit(Opcode::idiv, width, Operand::make_reg(divisor));
+
+    Value result;
+    result.type_ = type;
+    result.operand_ = Operand::make_reg(make_reg(type));
+    emit(
+        Opcode::mov, width, result.operand_,
+        Operand::make_reg(oper == "/" ? detail::x86::rax : detail::x86::rdx));
+    return result;
+}
+
+// Sets the flags, the comparison holds iff the returned condition does.
+// The unordered floats compare false: ucomis sets CF, ZF and PF for them,
+// so only a and ae are used.
+Cond InstructionSelector::emit_compare(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    if (is_floating(type)) {
+        if (oper[0] == '<') {
+            std::swap(lhs, rhs);
+        }
+        emit(Opcode::ucomis, get_width(type), lhs.operand_, rhs.operand_);
+        return oper.size() == 1 ? Cond::a : Cond::ae;
+    }
+
+    auto cond = c_int_conds.at(oper);
+    if (lhs.operand_.kind_ == Operand::Kind::imm) {
+        std::swap(lhs, rhs);
+        cond = swap_operands(cond);
+    }
+    auto src = rhs.operand_;
+    if (src.kind_ == Operand::Kind::imm && !is_imm32(src.imm_)) {
+        src = Operand::make_reg(to_reg(rhs));
+    }
+    emit(
+        Opcode::cmp, get_width(type), Operand::make_reg(to_reg(lhs)),
+        std::move(src));
+    return cond;
+}
+
+InstructionSelector::Value InstructionSelector::emit_relational(
+    const std::string &oper, Value lhs, Value rhs, Type type) {
+    Value result;
+    result.type_ = Type::i1;
+    if (!is_floating(type) && lhs.operand_.kind_ == Operand::Kind::imm &&
+        rhs.operand_.kind_ == Operand::Kind::imm) {
+        auto lhs_value = lhs.operand_.imm_;
+        auto rhs_value = rhs.operand_.imm_;
+        const bool value = oper == "==" ? lhs_value == rhs_value
+            : oper == "!="             ? lhs_value != rhs_value
+            : oper == "<"              ? lhs_value < rhs_value
+            : oper == "<="             ? lhs_value <= rhs_value
+            : oper == ">"              ? lhs_value > rhs_value
+                                       : lhs_value >= rhs_value;
+        result.operand_ = Operand::make_imm(static_cast<std::int64_t>(value));
+        return result;
+    }
+
+    result.operand_ = Operand::make_reg(make_reg(Type::i1));
+    auto setcc = [this, &result](Cond cond, const Operand &dst) {
+        Instruction instruction{Opcode::setcc};
+        instruction.width_ = Width::b8;
+        instruction.cond_ = cond;
+        instruction.dst_ = dst;
+        emit(std::move(instruction));
+    };
+    // Equal floats are ordered, the unequal ones may be unordered
+    if (is_floating(type) && (oper == "==" || oper == "!=")) {
+        emit(Opcode::ucomis, get_width(type), lhs.operand_, rhs.operand_);
+        auto parity = Operand::make_reg(make_reg(Type::i1));
+        const bool is_equal = oper == "==";
+        setcc(is_equal ? Cond::e : Cond::ne, result.operand_);
+        setcc(is_equal ? Cond::np : Cond::p, parity);
+        emit(is_equal ? Opcode::and_ : Opcode::or_, Width::b8, result.operand_,
+             parity);
+    } else {
+        setcc(emit_compare(oper, std::move(lhs), std::move(rhs), type),
+              result.operand_);
+    }
+    Instruction movzx{Opcode::movzx};
+    movzx.width_ = Width::b32;
+    movzx.src_width_ = Width::b8;
+    movzx.dst_ = result.operand_;
+    movzx.src_ = result.operand_;
+    emit(std::move(movzx));
+    return result;
+}
+
+// A comparison that ends the condition sets the flags for the branch,
+// other values are compared with zero
+Cond InstructionSelector::emit_condition(Node *truth_value) {
+    if (auto *operation = dynamic_cast<RvalueOperation *>(truth_value)) {
+        const auto &rpn = operation->rpn();
+        auto *relational = dynamic_cast<RelationalOperator *>(rpn.back());
+        const auto &oper =
+            relational == nullptr ? "" : relational->relational_operator();
+        if (relational != nullptr &&
+            !(program_.get_expression_type(relational)
+                  .operand_type_.is_floating() &&
+              (oper == "==" || oper == "!="))) {
+            for (std::size_t i = 0; i + 1 < rpn.size(); ++i) {
+                rpn[i]->accept(*this);
+            }
+            auto rhs = pop();
+            auto lhs = pop();
+            const auto &expression_type =
+                program_.get_expression_type(relational);
+            auto type = get_type(expression_type.operand_type_);
+            lhs = emit_conversion(
+                expression_type.lhs_conversion_, std::move(lhs), type);
+            rhs = emit_conversion(
+                expression_type.rhs_conversion_, std::move(rhs), type);
+            return emit_compare(oper, std::move(lhs), std::move(rhs), type);
+        }
+    }
+
+    auto value = evaluate(truth_value);
+    if (is_floating(value.type_)) {
+        Value zero;
+        zero.type_ = value.type_;
+        zero.operand_ = Operand::make_reg(make_reg(value.type_));
+        emit(Opcode::xorps, get_width(value.type_), zero.operand_,
+             zero.operand_);
+        value = emit_relational("!=", std::move(value), std::move(zero),
+                                value.type_);
+    }
+    auto reg = Operand::make_reg(to_reg(value));
+    emit(Opcode::test, get_width(value.type_), reg, reg);
+    return Cond::ne;
+}
+
+void InstructionSelector::emit_call(
+    const std::string &symbol,
+    std::vector<Value> args,
+    Type result,
+    bool is_variadic) {
+    Instruction call{Opcode::call_args};
+    call.src_ = Operand::make_symbol(symbol);
+    call.is_variadic_ = is_variadic;
+    for (auto &arg : args) {
+        call.args_.push_back(std::move(arg.operand_));
+    }
+
+    Value value;
+    value.type_ = result;
+    if (result == Type::void_) {
+        value.type_ = Type::i32;
+        value.operand_ = Operand::make_imm(0);
+    } else {
+        value.operand_ = Operand::make_reg(make_reg(result));
+        call.width_ = get_width(result);
+        call.dst_ = value.operand_;
+    }
+    emit(std::move(call));
+    push(std::move(value));
+}
+
+void InstructionSelector::enter_scope() {
+    saved_stacks_.push_back(detail::c_no_reg);
+}
+
+// Frees the variable length arrays of the scope
+void InstructionSelector::leave_scope() {
+    if (saved_stacks_.back() != detail::c_no_reg) {
+        emit(
+            Opcode::mov, Width::b64, Operand::make_reg(detail::x86::rsp),
+            Operand::make_reg(saved_stacks_.back()));
+    }
+    saved_stacks_.pop_back();
+}
+
+// Frees the variable length arrays of the scopes from the depth on
+void InstructionSelector::restore_stack(std::size_t depth) {
+    for (auto i = depth; i < saved_stacks_.size(); ++i) {
+        if (saved_stacks_[i] != detail::c_no_reg) {
+            emit(
+                Opcode::mov, Width::b64, Operand::make_reg(detail::x86::rsp),
+                Operand::make_reg(saved_stacks_[i]));
+            return;
+        }
+    }
+}
+
+} // namespace c::ast
\ No newline at end of file
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <libc/ast/detail/machine_code.hpp>
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/ast/visitor.hpp>
+
+#include <cstdint>
+#include <optional>
+#include <stack>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c::ast {
+
+// Lowers the analyzed program to x86-64 instructions on virtual registers.
+// Every scalar variable is one register, the language takes no addresses
+// of them. Arrays of a literal size are objects of the frame, the others
+// are allocated on the stack at their declarations and freed at the ends
+// of their scopes.
+//
+// The integers narrower than 64 bits are kept sign extended to 32 bits, so
+// they are operated on as 32-bit values and the results of char and short
+// are extended again. Loops are emitted rotated: the condition follows the
+// body and branches back to it.
+class InstructionSelector final : public Visitor {
+  public:
+    InstructionSelector(const Program &program, symtab::Symtab &symtab)
+        : program_(program), symtab_(symtab) {}
+
+    static detail::MachineModule exec(
+        Program &program, symtab::Symtab &symtab);
+
+    void visit(FunctionDefinition &node) override;
+    void visit(LocalScope &node) override;
+
+    // Expressions
+
+    void visit(Expression &node) override;
+    void visit(FunctionCall &node) override;
+    void visit(VariableWriting &node) override;
+    void visit(DataCreate &node) override;
+
+    // Statements
+
+    void visit(ReturnStatement &node) override;
+    void visit(ForStatement &node) override;
+    void visit(IfStatement &node) override;
+    void visit(ContinueStatement & /*node*/) override;
+    void visit(BreakStatement & /*node*/) override;
+
+    // Array
+
+    void visit(ArrayUninit &node) override;
+    void visit(ArrayElementAccess &node) override;
+
+    // Variable
+
+    void visit(VariableInit &node) override;
+    void visit(VariableUninit &node) override;
+    void visit(VariableAccess &node) override;
+
+    // Operations
+
+    void visit(Assignment &node) override;
+    void visit(RvalueOperation &node) override;
+    void visit(AssignmentOperator &node) override;
+    void visit(ArithmeticOperator &node) override;
+    void visit(RelationalOperator &node) override;
+
+    // Literals
+
+    void visit(StringLiteral &node) override;
+    void visit(IntegerLiteral &node) override;
+
+  private:
+    void visit(HeaderFile & /*node*/) override {}
+    void visit(ArrayType & /*node*/) override {}
+    void visit(PointerType & /*node*/) override {}
+    void visit(DataType & /*node*/) override {}
+    void visit(BaseType & /*node*/) override {}
+    void visit(VoidType & /*node*/) override {}
+
+    enum class Type { i1, i8, i16, i32, i64, ptr, f32, f64, void_ };
+
+    struct Value {
+        // A register or an integer constant
+        detail::Operand operand_;
+        Type type_{Type::i32};
+        // The variable read, or the address of the element read
+        symtab::VariableSymbol *var_{nullptr};
+        std::optional<detail::Address> address_;
+    };
+
+    struct Variable {
+        // The value of a scalar or a pointer
+        detail::Reg reg_{detail::c_no_reg};
+        Type type_{Type::i32};
+        // Arrays are their first elements as values
+        bool is_array_{false};
+        detail::Address address_;
+        // Of the elements an array or a pointer indexes
+        Type element_{Type::i32};
+        // Value of a constant initialized with an integer constant
+        std::optional<std::int64_t> constant_;
+    };
+
+    symtab::FunctionSymbol *get_funcsym(const std::string &id);
+    symtab::VariableSymbol *get_varsym(const std::string &id);
+    static Type get_type(const ValueType &type);
+    static Type get_type(symtab::Type *type);
+    static Type get_element_type(symtab::Type *type);
+    static detail::Width get_width(Type type);
+    static detail::Width get_memory_width(Type type);
+    static std::size_t get_size(Type type);
+    static std::int64_t wrap(std::int64_t value, Type type);
+    static bool is_floating(Type type) {
+        return type == Type::f32 || type == Type::f64;
+    }
+
+    detail::Reg make_reg(Type type);
+    void emit(detail::Instruction instruction);
+    void emit(
+        detail::Opcode opcode,
+        detail::Width width,
+        detail::Operand dst,
+        detail::Operand src = {});
+    std::size_t create_block();
+    void start_block(std::size_t block);
+    void jump(std::size_t block);
+    void branch(detail::Cond cond, std::size_t block);
+    void finish_function();
+
+    void push(Value value);
+    Value pop();
+    Value evaluate(Node *node);
+    void discard(Node *node);
+    detail::Reg to_reg(const Value &value);
+    Value copy(const Value &value);
+    Value load(const detail::Address &address, Type type);
+    void store(const Value &lvalue, const Value &value);
+    Value convert(const Node *node, Value value, Type type);
+    Value emit_conversion(Conversion conversion, Value value, Type type);
+    Value emit_arithmetic(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    Value emit_division(
+        const std::string &oper, const Value &lhs, Value rhs, Type type);
+    detail::Cond emit_compare(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    Value emit_relational(
+        const std::string &oper, Value lhs, Value rhs, Type type);
+    detail::Cond emit_condition(Node *truth_value);
+    void emit_call(
+        const std::string &symbol,
+        std::vector<Value> args,
+        Type result,
+        bool is_variadic);
+
+    void enter_scope();
+    void leave_scope();
+    void restore_stack(std::size_t depth);
+
+    const Program &program_;
+    symtab::Symtab &symtab_;
+
+    std::stack<symtab::Scope *> scopes_;
+    std::size_t scope_order_{0};
+
+    detail::MachineModule module_;
+    std::unordered_map<std::string, std::size_t> string_ids_;
+
+    detail::MachineFunction func_;
+    symtab::FunctionSymbol *current_func_{nullptr};
+    // Blocks in the order they were started in
+    std::vector<std::size_t> layout_;
+    std::size_t current_block_{0};
+
+    std::unordered_map<const symtab::VariableSymbol *, Variable> variables_;
+    // Lvalues of the assignments being evaluated, true for the ones of the
+    // compound operators that read them
+    std::unordered_map<const Node *, bool> lvalues_;
+    std::vector<Value> values_;
+
+    struct Loop {
+        std::size_t latch_;
+        std::size_t exit_;
+        std::size_t stack_depth_;
+    };
+    // Loops around the current block, innermost last
+    std::vector<Loop> loops_;
+    // For every scope around the current point: the stack pointer saved
+    // before its first variable length array, c_no_reg before that
+    std::vector<detail::Reg> saved_stacks_;
+};
+
+} // namespace c::ast
\ No newline at end of file
@@ -1,6 +1,8 @@
 // #include <libc/ast/symtab/detail/builder.hpp>
 #include "builder.hpp"
 
+#include <libc/trace.hpp>
+
 namespace c::ast::symtab::detail {
 
 void Builder::visit(Program &node) {
@@ -10,6 +12,7 @@ void Builder::visit(Program &node) {
 }
 
 void Builder::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("symtab", node.id());
     for (auto *stack_node = symtab_.find_sym(node.id()); stack_node != nullptr;
          stack_node = stack_node->prev_) {
         if (dynamic_cast<FunctionSymbol *>(stack_node->sym_.get()) != nullptr) {
@@ -63,7 +66,7 @@ void Builder::visit(Expression &node) {
 }
 
 void Builder::visit(FunctionCall &node) {
-    if (node.id() != "printf") {
+    if (node.id() != "printf" && node.id() != "__builtin_expect") {
         auto *stack_node = symtab_.find_sym(node.id());
         for (; stack_node != nullptr; stack_node = stack_node->prev_) {
             if (dynamic_cast<FunctionSymbol *>(stack_node->sym_.get()) !=
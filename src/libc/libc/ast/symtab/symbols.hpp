@@ -119,6 +119,32 @@ class TypedSymbol {
 
 class SymbolWithScope : public Scope, public Symbol {};
 
+// What a call of the function may do besides computing its value, the
+// callees included
+struct FunctionEffects {
+    bool is_readonly() const {
+        return !writes_memory_ && !has_io_;
+    }
+    bool is_readnone() const {
+        return is_readonly() && !reads_memory_;
+    }
+
+    // Loads through pointers
+    bool reads_memory_{false};
+    // Stores through pointers
+    bool writes_memory_{false};
+    // printf
+    bool has_io_{false};
+    // Calls itself directly or through other functions
+    bool is_recursive_{false};
+
+    // For every parameter: its pointer value may outlive the call
+    std::vector<bool> captured_params_;
+    // For every parameter: the memory it points to isn't accessed through
+    // the pointers that aren't based on it
+    std::vector<bool> noalias_params_;
+};
+
 class FunctionSymbol : public SymbolWithScope, public TypedSymbol {
   public:
     explicit FunctionSymbol(std::string name) : name_(std::move(name)) {
@@ -158,10 +184,27 @@ class FunctionSymbol : public SymbolWithScope, public TypedSymbol {
         return name_;
     }
 
+    void set_effects(const FunctionEffects &effects) {
+        effects_ = effects;
+    }
+    const FunctionEffects &get_effects() const {
+        return effects_;
+    }
+
+    void set_callees(std::vector<FunctionSymbol *> callees) {
+        callees_ = std::move(callees);
+    }
+    // The functions it calls, every one once
+    const std::vector<FunctionSymbol *> &get_callees() const {
+        return callees_;
+    }
+
   protected:
     std::string name_;
     std::unique_ptr<Type> type_{nullptr};
     std::size_t param_num_{0};
+    FunctionEffects effects_;
+    std::vector<FunctionSymbol *> callees_;
 };
 
 class VariableSymbol : public Symbol, public TypedSymbol {
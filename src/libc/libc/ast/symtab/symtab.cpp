@@ -64,7 +64,7 @@ StackNode *Symtab::find_sym(const std::string &name) {
     if (table_.at(hash) != nullptr) {
         if (table_.at(hash)->sym_->get_name() != name) {
             auto initial_hash = hash;
-            while (++hash != initial_hash) {
+            while (++hash != initial_hash && table_.at(hash) != nullptr) {
                 if (table_.at(hash)->sym_->get_name() == name) {
                     return table_.at(hash);
                 }
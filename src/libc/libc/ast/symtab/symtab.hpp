@@ -42,6 +42,9 @@ class Symtab {
     const StackNode *top() const {
         return &symbols_.top();
     }
+    std::size_t get_number_of_symbols() const {
+        return symbols_.size();
+    }
 
   private:
     std::uint8_t hash_code(const std::string &name);
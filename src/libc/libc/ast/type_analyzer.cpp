@@ -1,17 +1,22 @@
 #include <libc/ast/type_analyzer.hpp>
+#include <libc/trace.hpp>
 
 namespace c::ast {
 
 const std::unordered_map<std::string, std::size_t> c_type_orders = {
-    {"char", 0},
-    {"short", 1},
-    {"int", 2},
-    {"long", 3},
-    {"float", 4},
-    {"double", 5}};
+    {"bool", 0},
+    {"char", 1},
+    {"short", 2},
+    {"int", 3},
+    {"long", 4},
+    {"float", 5},
+    {"double", 6}};
+
+const ValueType c_bool_type{"bool", 0};
+const ValueType c_index_type{"long", 0};
 
 void TypeAnalyzer::exec(Program &program, symtab::Symtab &symtab) {
-    TypeAnalyzer type_analyzer(symtab);
+    TypeAnalyzer type_analyzer(program, symtab);
 
     for (auto *child : program.get_childs()) {
         child->accept(type_analyzer);
@@ -19,6 +24,7 @@ void TypeAnalyzer::exec(Program &program, symtab::Symtab &symtab) {
 }
 
 void TypeAnalyzer::visit(FunctionDefinition &node) {
+    C_TRACE_SCOPE("type analysis", node.id());
     symtab::FunctionSymbol *func_sym = nullptr;
     for (auto *stack_node = symtab_.find_sym(node.id()); stack_node != nullptr;
          stack_node = stack_node->prev_) {
@@ -68,6 +74,29 @@ void TypeAnalyzer::visit(Expression &node) {
 
 void TypeAnalyzer::visit(FunctionCall &node) {
     if (node.id() == "printf") {
+        for (auto *arg : node.args()) {
+            arg->accept(*this);
+            annotate_conversion(
+                arg,
+                get_promoted_type(program_.get_expression_type(arg).type_));
+        }
+        type_buf_ = &int_l_;
+        annotate(&node, get_value_type(type_buf_));
+        return;
+    }
+    // long __builtin_expect(long exp, long c) of GCC: the value of exp is
+    // likely to be c
+    if (node.id() == "__builtin_expect") {
+        if (node.args().size() != 2) {
+            throw Exception(node.id() + " call: wrong number of parameters");
+        }
+        for (auto *arg : node.args()) {
+            arg->accept(*this);
+            is_possible_type_conversion(type_buf_, &long_l_);
+            annotate_conversion(arg, get_value_type(&long_l_));
+        }
+        type_buf_ = &long_l_;
+        annotate(&node, get_value_type(type_buf_));
         return;
     }
 
@@ -100,9 +129,11 @@ void TypeAnalyzer::visit(FunctionCall &node) {
                 params[i]->get_name());
         }
         is_possible_type_conversion(type_buf_, param->get_type());
+        annotate_conversion(args[i], get_value_type(param->get_type()));
     }
 
     type_buf_ = func_sym->get_type();
+    annotate(&node, get_value_type(type_buf_));
 }
 
 void TypeAnalyzer::visit(VariableWriting &node) {
@@ -127,6 +158,7 @@ void TypeAnalyzer::visit(ReturnStatement &node) {
         }
         node.value()->accept(*this);
         is_possible_type_conversion(type_buf_, return_type_);
+        annotate_conversion(node.value(), get_value_type(return_type_));
     }
     have_return_ = true;
 }
@@ -198,17 +230,20 @@ void TypeAnalyzer::visit(BreakStatement & /*node*/) {
 void TypeAnalyzer::visit(ArrayUninit &node) {
     node.size()->accept(*this);
     valid_array_size_type_check(type_buf_);
+    annotate_conversion(node.size(), c_index_type);
 }
 
 void TypeAnalyzer::visit(ArrayElementAccess &node) {
     node.idx()->accept(*this);
     valid_array_size_type_check(type_buf_);
+    annotate_conversion(node.idx(), c_index_type);
     auto *var = dynamic_cast<symtab::VariableSymbol *>(
         scopes_.top()->resolve(node.id()));
     if (var == nullptr) {
         throw Exception("fail dynamic cast " + node.id());
     }
     type_buf_ = var->get_type();
+    annotate(&node, get_element_type(type_buf_));
 }
 
 // Variable
@@ -221,6 +256,7 @@ void TypeAnalyzer::visit(VariableInit &node) {
         throw Exception("fail dynamic cast " + node.id());
     }
     is_possible_type_conversion(type_buf_, var->get_type());
+    annotate_conversion(node.value(), get_value_type(var->get_type()));
 }
 
 void TypeAnalyzer::visit(VariableAccess &node) {
@@ -230,6 +266,7 @@ void TypeAnalyzer::visit(VariableAccess &node) {
         throw Exception("fail dynamic cast " + node.id());
     }
     type_buf_ = var->get_type();
+    annotate(&node, get_value_type(type_buf_));
 }
 
 // Operations
@@ -256,6 +293,7 @@ void TypeAnalyzer::visit(Assignment &node) {
         // }
         rhs = type_buf_;
     }
+    annotate(&node, annotate_rpn(node.rpn()));
 }
 
 void TypeAnalyzer::visit(RvalueOperation &node) {
@@ -309,6 +347,7 @@ void TypeAnalyzer::visit(RvalueOperation &node) {
         }
     }
     type_buf_ = to;
+    annotate(&node, annotate_rpn(node.rpn()));
 }
 
 // void TypeAnalyzer::visit(PrefixIncrement &node) {
@@ -345,12 +384,14 @@ void TypeAnalyzer::visit(RvalueOperation &node) {
 
 // Literals
 
-void TypeAnalyzer::visit(StringLiteral & /*node*/) {
+void TypeAnalyzer::visit(StringLiteral &node) {
     type_buf_ = &str_l_;
+    annotate(&node, get_value_type(type_buf_));
 }
 
-void TypeAnalyzer::visit(IntegerLiteral & /*node*/) {
+void TypeAnalyzer::visit(IntegerLiteral &node) {
     type_buf_ = &int_l_;
+    annotate(&node, get_value_type(type_buf_));
 }
 
 void TypeAnalyzer::is_possible_type_conversion(
@@ -373,4 +414,118 @@ void TypeAnalyzer::valid_array_size_type_check(symtab::Type *type) {
     }
 }
 
+// An array is its element in the operations, as the code generator keeps it
+ValueType TypeAnalyzer::get_value_type(symtab::Type *type) {
+    auto *pointer_type = dynamic_cast<symtab::PointerType *>(type);
+    return {
+        type->get_name(),
+        pointer_type == nullptr ? 0 : pointer_type->get_level()};
+}
+
+ValueType TypeAnalyzer::get_element_type(symtab::Type *type) {
+    auto value_type = get_value_type(type);
+    if (value_type.pointer_level_ > 0) {
+        --value_type.pointer_level_;
+    }
+    return value_type;
+}
+
+// The value is converted to the type of the variable, parameter, return
+// value or index. Pointers are never converted.
+Conversion TypeAnalyzer::get_conversion(
+    const ValueType &from, const ValueType &to) {
+    if (from == to || from.pointer_level_ > 0 || to.pointer_level_ > 0 ||
+        from.name_ == "void" || to.name_ == "void") {
+        return Conversion::none;
+    }
+    const bool is_narrowing =
+        c_type_orders.at(to.name_) < c_type_orders.at(from.name_);
+    if (from.is_floating() && to.is_floating()) {
+        return is_narrowing ? Conversion::float_truncate
+                            : Conversion::float_extend;
+    }
+    if (from.is_floating()) {
+        return Conversion::float_to_int;
+    }
+    if (to.is_floating()) {
+        return Conversion::int_to_float;
+    }
+    if (is_narrowing) {
+        return Conversion::truncate;
+    }
+    return from.name_ == c_bool_type.name_ ? Conversion::zero_extend
+                                           : Conversion::sign_extend;
+}
+
+// The operand of the lower type is converted to the type of the other one
+Conversion TypeAnalyzer::get_promotion(
+    const ValueType &from, const ValueType &to) {
+    if (from.is_floating() == to.is_floating()) {
+        if (from.is_floating()) {
+            return Conversion::float_extend;
+        }
+        return from.name_ == c_bool_type.name_ ? Conversion::zero_extend
+                                               : Conversion::sign_extend;
+    }
+    return Conversion::int_to_float;
+}
+
+void TypeAnalyzer::annotate(const Node *node, ValueType type) {
+    ExpressionType expression_type;
+    expression_type.type_ = std::move(type);
+    program_.set_expression_type(node, std::move(expression_type));
+}
+
+void TypeAnalyzer::annotate_conversion(const Node *node, const ValueType &to) {
+    auto expression_type = program_.get_expression_type(node);
+    expression_type.conversion_ = get_conversion(expression_type.type_, to);
+    program_.set_expression_type(node, std::move(expression_type));
+}
+
+// Evaluates the types of the operators in the order the code generator
+// emits them, the operands are annotated by now
+ValueType TypeAnalyzer::annotate_rpn(const Childs &rpn) {
+    std::vector<ValueType> values;
+    for (auto *node : rpn) {
+        const bool is_assignment =
+            dynamic_cast<AssignmentOperator *>(node) != nullptr;
+        const bool is_relational =
+            dynamic_cast<RelationalOperator *>(node) != nullptr;
+        if (!is_assignment && !is_relational &&
+            dynamic_cast<ArithmeticOperator *>(node) == nullptr) {
+            values.push_back(program_.get_expression_type(node).type_);
+            continue;
+        }
+
+        ExpressionType expression_type;
+        auto rhs = std::move(values.back());
+        values.pop_back();
+        auto lhs = std::move(values.back());
+        values.pop_back();
+
+        if (is_assignment) {
+            expression_type.operand_type_ = lhs;
+            expression_type.rhs_conversion_ = get_conversion(rhs, lhs);
+        } else if (
+            lhs == rhs || lhs.pointer_level_ > 0 || rhs.pointer_level_ > 0) {
+            expression_type.operand_type_ = lhs;
+        } else if (
+            lhs.is_floating() != rhs.is_floating()
+                ? rhs.is_floating()
+                : c_type_orders.at(lhs.name_) < c_type_orders.at(rhs.name_)) {
+            expression_type.operand_type_ = rhs;
+            expression_type.lhs_conversion_ = get_promotion(lhs, rhs);
+        } else {
+            expression_type.operand_type_ = lhs;
+            expression_type.rhs_conversion_ = get_promotion(rhs, lhs);
+        }
+        expression_type.type_ =
+            is_relational ? c_bool_type : expression_type.operand_type_;
+
+        values.push_back(expression_type.type_);
+        program_.set_expression_type(node, std::move(expression_type));
+    }
+    return values.back();
+}
+
 } // namespace c::ast
\ No newline at end of file
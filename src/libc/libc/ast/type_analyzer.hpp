@@ -12,7 +12,8 @@ class TypeAnalyzer : public Visitor {
         using std::runtime_error::runtime_error;
     };
 
-    explicit TypeAnalyzer(symtab::Symtab &symtab) : symtab_(symtab) {}
+    TypeAnalyzer(Program &program, symtab::Symtab &symtab)
+        : program_(program), symtab_(symtab) {}
 
     static void exec(Program &program, symtab::Symtab &symtab);
 
@@ -74,6 +75,17 @@ class TypeAnalyzer : public Visitor {
     void is_possible_type_conversion(symtab::Type *from, symtab::Type * /*to*/);
     void valid_array_size_type_check(symtab::Type *type);
 
+    static ValueType get_value_type(symtab::Type *type);
+    static ValueType get_element_type(symtab::Type *type);
+    static Conversion
+    get_conversion(const ValueType &from, const ValueType &to);
+    static Conversion
+    get_promotion(const ValueType &from, const ValueType &to);
+    void annotate(const Node *node, ValueType type);
+    void annotate_conversion(const Node *node, const ValueType &to);
+    ValueType annotate_rpn(const Childs &rpn);
+
+    Program &program_;
     symtab::Symtab &symtab_;
 
     std::stack<symtab::Scope *> scopes_;
@@ -85,6 +97,7 @@ class TypeAnalyzer : public Visitor {
     symtab::Type *type_buf_{nullptr};
     symtab::PointerType str_l_{"char", 1, false};
     symtab::PrimitiveType int_l_{"int", false};
+    symtab::PrimitiveType long_l_{"long", false};
 
     bool for_scope_{false};
 };
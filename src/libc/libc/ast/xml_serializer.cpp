@@ -3,48 +3,44 @@
 namespace c::ast {
 
 void XmlSerializer::exec(Program &program, std::ostream &out) {
-    XmlSerializer xml_serializer;
-    xml_serializer.nodes_.push(xml_serializer.doc_.append_child("Program"));
+    XmlSerializer xml_serializer(out);
+    xml_serializer.start_element("Program");
     for (auto *child : program.get_childs()) {
         child->accept(xml_serializer);
     }
-    xml_serializer.doc_.save(out, "  ");
+    xml_serializer.end_element();
+    xml_serializer.writer_.finish();
 }
 
 void XmlSerializer::visit(HeaderFile &node) {
-    auto header_file = append_child("header-file");
-    nodes_.push(header_file);
+    start_element("header-file");
     append_text(node.file_name().c_str());
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(FunctionDefinition &node) {
-    auto function_definition = append_child("function");
-    nodes_.push(function_definition);
+    start_element("function");
     node.return_type()->accept(*this);
     append_attribute("name", node.id().c_str());
     for (auto *args_declaration : node.args_declarations()) {
-        auto arg_declaration = append_child("arg");
-        nodes_.push(arg_declaration);
+        start_element("arg");
         args_declaration->accept(*this);
-        nodes_.pop();
+        end_element();
     }
-    auto actions_node = append_child("actions");
-    nodes_.push(actions_node);
+    start_element("actions");
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
-    nodes_.pop();
-    nodes_.pop();
+    end_element();
+    end_element();
 }
 
 void XmlSerializer::visit(LocalScope &node) {
-    auto local_scope_node = append_child("local-scope");
-    nodes_.push(local_scope_node);
+    start_element("local-scope");
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
-    nodes_.pop();
+    end_element();
 }
 
 // Expressions
@@ -54,107 +50,93 @@ void XmlSerializer::visit(Expression &node) {
 }
 
 void XmlSerializer::visit(FunctionCall &node) {
-    auto function_call = append_child("call");
-    nodes_.push(function_call);
+    start_element("call");
     append_attribute("name", node.id().c_str());
     for (auto *arg : node.args()) {
-        auto arg_node = append_child("arg");
-        nodes_.push(arg_node);
+        start_element("arg");
         arg->accept(*this);
-        nodes_.pop();
+        end_element();
     }
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(VariableWriting &node) {
-    auto variable_writing_node = append_child("variable-writing");
-    nodes_.push(variable_writing_node);
+    start_element("variable-writing");
     node.variable_writing()->accept(*this);
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(DataCreate &node) {
-    auto data_create_node = append_child("data-create");
-    nodes_.push(data_create_node);
+    start_element("data-create");
     node.data_create()->accept(*this);
-    nodes_.pop();
+    end_element();
 }
 
 // Statements
 
 void XmlSerializer::visit(ReturnStatement &node) {
-    auto return_statement = append_child("return");
-    nodes_.push(return_statement);
+    start_element("return");
     node.value()->accept(*this);
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(ForStatement &node) {
-    auto for_statement = append_child("for");
-    nodes_.push(for_statement);
+    start_element("for");
     if (node.for_data_using() != nullptr) {
         node.for_data_using()->accept(*this);
     }
     if (node.truth_value() != nullptr) {
-        auto truth_value_node = append_child("truth-value");
-        nodes_.push(truth_value_node);
+        start_element("truth-value");
         node.truth_value()->accept(*this);
-        nodes_.pop();
+        end_element();
     }
     if (node.value() != nullptr) {
-        auto value_node = append_child("value");
-        nodes_.push(value_node);
+        start_element("value");
         node.value()->accept(*this);
-        nodes_.pop();
+        end_element();
     }
-    auto actions_node = append_child("actions");
-    nodes_.push(actions_node);
+    start_element("actions");
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
-    nodes_.pop();
-    nodes_.pop();
+    end_element();
+    end_element();
 }
 
 void XmlSerializer::visit(IfStatement &node) {
-    auto if_node = append_child("if");
-    nodes_.push(if_node);
+    start_element("if");
 
-    auto truth_value_node = append_child("truth-value");
-    nodes_.push(truth_value_node);
+    start_element("truth-value");
     node.truth_value()->accept(*this);
-    nodes_.pop();
+    end_element();
 
-    auto actions_node = append_child("actions");
-    nodes_.push(actions_node);
+    start_element("actions");
     for (auto *action : node.actions()) {
         action->accept(*this);
     }
-    nodes_.pop();
+    end_element();
 
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(ContinueStatement & /*node*/) {
-    append_child("continue");
+    append_empty_element("continue");
 }
 
 void XmlSerializer::visit(BreakStatement & /*node*/) {
-    append_child("break");
+    append_empty_element("break");
 }
 
 // // Struct
 
 // void XmlSerializer::visit(StructDeclaration &node) {
-//     auto struct_declaration_node = append_child("struct-declaration");
-//     nodes_.push(struct_declaration_node);
+//     start_element("struct-declaration");
 //     append_attribute("name", (node.id()).c_str());
-//     nodes_.pop();
+//     end_element();
 // }
 
 // void XmlSerializer::visit(StructDefinition &node) {
-//     auto struct_definition_node = append_child("struct-definition");
-//     nodes_.push(struct_definition_node);
+//     start_element("struct-definition");
 
 //     append_attribute("name", (node.id()).c_str());
 
@@ -163,13 +145,12 @@ void XmlSerializer::visit(BreakStatement & /*node*/) {
 //     }
 
 //     for (auto *child : node.data_uninit()) {
-//         auto member_node = append_child("member");
-//         nodes_.push(member_node);
+//         start_element("member");
 //         child->accept(*this);
-//         nodes_.pop();
+//         end_element();
 //     }
 
-//     nodes_.pop();
+//     end_element();
 // }
 
 // void XmlSerializer::visit(StructInit &node) {
@@ -177,10 +158,9 @@ void XmlSerializer::visit(BreakStatement & /*node*/) {
 //     append_attribute("name", node.id().c_str());
 
 //     for (auto *value : node.values()) {
-//         auto value_node = append_child("value");
-//         nodes_.push(value_node);
+//         start_element("value");
 //         value->accept(*this);
-//         nodes_.pop();
+//         end_element();
 //     }
 // }
 
@@ -212,10 +192,9 @@ void XmlSerializer::visit(ArrayUninit &node) {
     node.type()->accept(*this);
     append_attribute("name", node.id().c_str());
 
-    auto size_node = append_child("size");
-    nodes_.push(size_node);
+    start_element("size");
     node.size()->accept(*this);
-    nodes_.pop();
+    end_element();
 }
 
 void XmlSerializer::visit(ArrayElementAccess &node) {
@@ -345,15 +324,24 @@ void XmlSerializer::visit(IntegerLiteral &node) {
     append_text(node.integer().c_str());
 }
 
-pugi::xml_node XmlSerializer::append_child(const char *name) {
-    return nodes_.top().append_child(name);
+void XmlSerializer::start_element(const char *name) {
+    writer_.start_element(name);
+}
+
+void XmlSerializer::end_element() {
+    writer_.end_element();
+}
+
+void XmlSerializer::append_empty_element(const char *name) {
+    writer_.start_element(name);
+    writer_.end_element();
 }
 
 void XmlSerializer::append_text(const char *text) {
-    nodes_.top().append_child(pugi::node_pcdata).set_value(text);
+    writer_.append_text(text);
 }
 
 void XmlSerializer::append_attribute(const char *name, const char *value) {
-    nodes_.top().append_attribute(name).set_value(value);
+    writer_.append_attribute(name, value);
 }
 } // namespace c::ast
\ No newline at end of file
@@ -1,16 +1,16 @@
 #pragma once
 
+#include <libc/ast/detail/xml_writer.hpp>
 #include <libc/ast/visitor.hpp>
 
-#include <pugixml.hpp>
-
 #include <ostream>
-#include <stack>
 
 namespace c::ast {
 
 class XmlSerializer final : public Visitor {
   public:
+    explicit XmlSerializer(std::ostream &out) : writer_(out, "  ") {}
+
     static void exec(Program &program, std::ostream &out);
 
     void visit(HeaderFile &node) override;
@@ -80,12 +80,13 @@ class XmlSerializer final : public Visitor {
     void visit(IntegerLiteral &node) override;
 
   private:
-    pugi::xml_node append_child(const char *name);
+    void start_element(const char *name);
+    void end_element();
+    void append_empty_element(const char *name);
     void append_text(const char *text);
     void append_attribute(const char *name, const char *value);
 
-    pugi::xml_document doc_;
-    std::stack<pugi::xml_node> nodes_;
+    detail::XmlWriter writer_;
 };
 
 } // namespace c::ast
\ No newline at end of file
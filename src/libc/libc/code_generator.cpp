@@ -5,8 +5,12 @@
 namespace c {
 
 void generate(
-    std::ostream &ir, ast::Program &program, ast::symtab::Symtab &symtab) {
-    c::ast::CodeGenerator::exec(ir, program, symtab);
+    std::ostream &ir,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const ast::CodeGenOptions &options,
+    TimeReport *report) {
+    c::ast::CodeGenerator::exec(ir, program, symtab, options, report);
 }
 
 } // namespace c
\ No newline at end of file
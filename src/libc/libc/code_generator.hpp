@@ -1,9 +1,15 @@
 #include <libc/ast/ast.hpp>
+#include <libc/ast/code_generator.hpp>
 #include <libc/ast/symtab/symtab.hpp>
+#include <libc/time_report.hpp>
 
 namespace c {
 
 void generate(
-    std::ostream &ir, ast::Program &program, ast::symtab::Symtab &symtab);
+    std::ostream &ir,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const ast::CodeGenOptions &options = {},
+    TimeReport *report = nullptr);
 
 } // namespace c
\ No newline at end of file
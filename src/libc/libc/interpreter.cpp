@@ -0,0 +1,50 @@
+#include <libc/interpreter.hpp>
+
+#include <libc/ast/bytecode_compiler.hpp>
+#include <libc/ast/detail/interpreter.hpp>
+
+namespace c {
+
+namespace {
+
+ast::detail::BytecodeModule compile(
+    ast::Program &program, ast::symtab::Symtab &symtab, TimeReport *report) {
+    ast::detail::BytecodeModule module;
+    {
+        TimeReport::Phase phase(report, "bytecode compilation");
+        module = ast::BytecodeCompiler::exec(program, symtab);
+    }
+    if (report != nullptr) {
+        std::size_t instructions = 0;
+        for (const auto &func : module.functions_) {
+            instructions += func.code_.size();
+        }
+        report->add_count("bytecode instructions", instructions);
+    }
+    return module;
+}
+
+} // namespace
+
+int interpret(
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const std::vector<std::string> &args,
+    std::FILE *out,
+    TimeReport *report) {
+    auto module = compile(program, symtab, report);
+
+    TimeReport::Phase phase(report, "execution");
+    return ast::detail::Interpreter::exec(module, args, out);
+}
+
+void dump_bytecode(
+    std::ostream &out,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    TimeReport *report) {
+    auto module = compile(program, symtab, report);
+    ast::detail::print(out, module);
+}
+
+} // namespace c
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <libc/ast/ast.hpp>
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/time_report.hpp>
+
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace c {
+
+// Compiles the analyzed program to bytecode and interprets it: calls main
+// with the arguments, the first one is the name of the program, and returns
+// its exit code. printf of the program writes to out.
+int interpret(
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const std::vector<std::string> &args,
+    std::FILE *out = stdout,
+    TimeReport *report = nullptr);
+
+// Prints the bytecode of the analyzed program
+void dump_bytecode(
+    std::ostream &out,
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    TimeReport *report = nullptr);
+
+} // namespace c
\ No newline at end of file
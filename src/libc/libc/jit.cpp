@@ -0,0 +1,122 @@
+#include <libc/jit.hpp>
+
+#include <libc/ast/detail/register_allocator.hpp>
+#include <libc/ast/detail/x86_encoder.hpp>
+#include <libc/ast/instruction_selector.hpp>
+
+#include <sys/mman.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace c {
+
+namespace {
+
+using Main = int (*)(int, char **);
+
+const std::unordered_map<std::string, std::uintptr_t> c_host_functions = {
+    {"printf", reinterpret_cast<std::uintptr_t>(&std::printf)}};
+
+// Anonymous pages that are writable while the code is loaded and then
+// executable, never both at once
+class ExecutableMemory final {
+  public:
+    explicit ExecutableMemory(const std::vector<std::uint8_t> &bytes)
+        : size_(bytes.size()) {
+        memory_ = mmap(
+            nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0);
+        if (memory_ == MAP_FAILED) {
+            throw std::runtime_error("Unable to map memory for the code");
+        }
+        std::memcpy(memory_, bytes.data(), size_);
+    }
+
+    ~ExecutableMemory() {
+        munmap(memory_, size_);
+    }
+
+    ExecutableMemory(const ExecutableMemory &) = delete;
+    ExecutableMemory(ExecutableMemory &&) = delete;
+    ExecutableMemory &operator=(const ExecutableMemory &) = delete;
+    ExecutableMemory &operator=(ExecutableMemory &&) = delete;
+
+    void protect() {
+        if (mprotect(memory_, size_, PROT_READ | PROT_EXEC) != 0) {
+            throw std::runtime_error("Unable to make the code executable");
+        }
+    }
+
+    std::uint8_t *data() {
+        return static_cast<std::uint8_t *>(memory_);
+    }
+
+  private:
+    void *memory_;
+    std::size_t size_;
+};
+
+} // namespace
+
+int run(
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const std::vector<std::string> &args,
+    TimeReport *report) {
+    ast::detail::MachineModule module;
+    {
+        TimeReport::Phase phase(report, "instruction selection");
+        module = ast::InstructionSelector::exec(program, symtab);
+    }
+    {
+        TimeReport::Phase phase(report, "register allocation");
+        for (auto &func : module.functions_) {
+            ast::detail::RegisterAllocator::exec(func);
+        }
+    }
+    ast::detail::X86Encoder::Image image;
+    {
+        TimeReport::Phase phase(report, "machine code encoding");
+        image = ast::detail::X86Encoder::exec(module);
+    }
+    if (report != nullptr) {
+        report->add_count("code bytes", image.bytes_.size());
+    }
+
+    auto main = image.functions_.find("main");
+    if (main == image.functions_.end()) {
+        throw std::runtime_error("The program has no main");
+    }
+
+    ExecutableMemory memory(image.bytes_);
+    for (std::size_t i = 0; i < image.imports_.size(); ++i) {
+        auto function = c_host_functions.find(image.imports_[i]);
+        if (function == c_host_functions.end()) {
+            throw std::runtime_error(
+                "Unresolved function - " + image.imports_[i]);
+        }
+        std::memcpy(
+            memory.data() + image.imports_offset_ + 8 * i, &function->second,
+            sizeof(function->second));
+    }
+    memory.protect();
+
+    auto strings = args;
+    std::vector<char *> argv;
+    for (auto &string : strings) {
+        argv.push_back(string.data());
+    }
+    argv.push_back(nullptr);
+
+    TimeReport::Phase phase(report, "execution");
+    auto entry = reinterpret_cast<Main>(memory.data() + main->second);
+    const int code = entry(static_cast<int>(strings.size()), argv.data());
+    std::fflush(stdout);
+    return code;
+}
+
+} // namespace c
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <libc/ast/ast.hpp>
+#include <libc/ast/symtab/symtab.hpp>
+#include <libc/time_report.hpp>
+
+#include <string>
+#include <vector>
+
+namespace c {
+
+// Compiles the analyzed program to x86-64 machine code in the memory of the
+// process and calls its main with the arguments, the first one is the name
+// of the program. Returns the exit code of main. The program may only call
+// the functions of the host libc it declares, printf.
+int run(
+    ast::Program &program,
+    ast::symtab::Symtab &symtab,
+    const std::vector<std::string> &args,
+    TimeReport *report = nullptr);
+
+} // namespace c
\ No newline at end of file
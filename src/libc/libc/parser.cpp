@@ -2,6 +2,7 @@
 
 #include <libc/ast/detail/builder.hpp>
 #include <libc/ast/xml_serializer.hpp>
+#include <libc/trace.hpp>
 
 #include <CLexer.h>
 #include <CParser.h>
@@ -32,17 +33,30 @@ class StreamErrorListener : public antlr4::BaseErrorListener {
 
 } // namespace
 
-ParseResult parse(std::istream &in) {
+ParseResult parse(std::istream &in, TimeReport *report) {
     antlr4::ANTLRInputStream stream(in);
     CLexer lexer(&stream);
     antlr4::CommonTokenStream tokens(&lexer);
+    {
+        TimeReport::Phase phase(report, "lexing");
+        C_TRACE_SCOPE("pipeline", "lexing");
+        tokens.fill();
+    }
+    if (report != nullptr) {
+        report->add_count("tokens", tokens.size());
+    }
     CParser parser(&tokens);
 
     StreamErrorListener error_listener;
     parser.removeErrorListeners();
     parser.addErrorListener(&error_listener);
 
-    auto *program_parse_tree = parser.program();
+    CParser::ProgramContext *program_parse_tree = nullptr;
+    {
+        TimeReport::Phase phase(report, "parsing");
+        C_TRACE_SCOPE("pipeline", "parsing");
+        program_parse_tree = parser.program();
+    }
 
     const auto &errors = error_listener.errors();
     if (!errors.empty()) {
@@ -50,8 +64,15 @@ ParseResult parse(std::istream &in) {
     }
 
     ast::Program program;
-    ast::detail::Builder builder(program);
-    builder.visit(program_parse_tree);
+    {
+        TimeReport::Phase phase(report, "ast building");
+        C_TRACE_SCOPE("pipeline", "ast building");
+        ast::detail::Builder builder(program, report);
+        builder.visit(program_parse_tree);
+    }
+    if (report != nullptr) {
+        report->add_count("ast nodes", program.get_number_of_nodes());
+    }
 
     return ParseResult::program(std::move(program));
 }
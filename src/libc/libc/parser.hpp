@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libc/ast/ast.hpp>
+#include <libc/time_report.hpp>
 
 #include <iosfwd>
 
@@ -31,7 +32,7 @@ struct ParseResult {
     Errors errors_;
 };
 
-ParseResult parse(std::istream &in);
+ParseResult parse(std::istream &in, TimeReport *report = nullptr);
 
 void dump_ast(ast::Program &program, std::ostream &out);
 void dump_errors(const Errors &errors, std::ostream &out);
@@ -0,0 +1,46 @@
+#include <libc/profile.hpp>
+
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+
+namespace c {
+
+Profile read_profile(std::istream &in) {
+    Profile profile;
+    std::string line;
+    for (std::size_t line_num = 1; std::getline(in, line); ++line_num) {
+        std::istringstream fields(line);
+        std::string name;
+        if (!(fields >> name)) {
+            continue;
+        }
+
+        std::vector<std::uint64_t> counts;
+        for (std::uint64_t count = 0; fields >> count;) {
+            counts.push_back(count);
+        }
+        if (!fields.eof() || counts.empty()) {
+            throw std::runtime_error(
+                "profile:" + std::to_string(line_num) +
+                ": expected the counts of " + name);
+        }
+
+        auto [it, is_new] = profile.try_emplace(name, counts);
+        if (is_new) {
+            continue;
+        }
+        if (it->second.size() != counts.size()) {
+            throw std::runtime_error(
+                "profile:" + std::to_string(line_num) + ": " + name +
+                " has " + std::to_string(counts.size()) + " counts instead of " +
+                std::to_string(it->second.size()));
+        }
+        for (std::size_t i = 0; i < counts.size(); ++i) {
+            it->second[i] += counts[i];
+        }
+    }
+    return profile;
+}
+
+} // namespace c
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace c {
+
+// Counts of the runs of a program built with --profile-generate by the names
+// of its functions. The first count of a function is the number of its
+// calls. Then every if and for of its body, in the order of the source, has
+// two: the evaluations of the condition and the entries into the body.
+using Profile = std::unordered_map<std::string, std::vector<std::uint64_t>>;
+
+// Every run appends a line "<function> <counts>..." for every function to
+// the file, the counts of the lines of a function are summed up.
+// Throws std::runtime_error on a malformed line.
+Profile read_profile(std::istream &in);
+
+} // namespace c
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <libc/time_report.hpp>
+
+#include <sys/resource.h>
+
+#include <iomanip>
+
+namespace c {
+
+namespace {
+
+long get_peak_rss_kib() {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_maxrss;
+}
+
+double to_ms(std::clock_t ticks) {
+    return 1000.0 * static_cast<double>(ticks) / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+TimeReport::Phase::Phase(TimeReport *report, const char *name)
+    : report_(report) {
+    if (report_ == nullptr) {
+        return;
+    }
+    index_ = report_->find_phase(name);
+    report_->active_.emplace_back();
+    rss_start_ = get_peak_rss_kib();
+    cpu_start_ = std::clock();
+    wall_start_ = std::chrono::steady_clock::now();
+}
+
+TimeReport::Phase::~Phase() {
+    if (report_ == nullptr) {
+        return;
+    }
+    const std::chrono::duration<double, std::milli> wall =
+        std::chrono::steady_clock::now() - wall_start_;
+    const double cpu = to_ms(std::clock() - cpu_start_);
+    const long rss = get_peak_rss_kib() - rss_start_;
+
+    const auto nested = report_->active_.back();
+    report_->active_.pop_back();
+    if (!report_->active_.empty()) {
+        report_->active_.back().wall_ms_ += wall.count();
+        report_->active_.back().cpu_ms_ += cpu;
+    }
+
+    auto &phase = report_->phases_[index_];
+    phase.wall_ms_ += wall.count() - nested.wall_ms_;
+    phase.cpu_ms_ += cpu - nested.cpu_ms_;
+    phase.rss_delta_kib_ += rss;
+    ++phase.calls_;
+}
+
+void TimeReport::add_nested_time(
+    const char *name,
+    std::chrono::steady_clock::duration wall,
+    std::size_t calls) {
+    const double ms =
+        std::chrono::duration<double, std::milli>(wall).count();
+    if (!active_.empty()) {
+        active_.back().wall_ms_ += ms;
+        active_.back().cpu_ms_ += ms;
+    }
+
+    auto &phase = phases_[find_phase(name)];
+    phase.wall_ms_ += ms;
+    phase.cpu_ms_ += ms;
+    phase.calls_ += calls;
+}
+
+void TimeReport::add_count(const char *name, std::size_t count) {
+    for (auto &cnt : counts_) {
+        if (cnt.name_ == name) {
+            cnt.count_ += count;
+            return;
+        }
+    }
+    counts_.push_back(Count{name, count});
+}
+
+void TimeReport::print(std::ostream &os) const {
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+
+    double total_wall = 0;
+    double total_cpu = 0;
+    os << "===--------------------------------------------------------===\n"
+       << "                  Compiler phase time report\n"
+       << "===--------------------------------------------------------===\n"
+       << std::setw(12) << "Wall (ms)" << std::setw(12) << "CPU (ms)"
+       << std::setw(12) << "RSS (KiB)" << std::setw(8) << "Calls"
+       << "  Phase\n";
+    os << std::fixed << std::setprecision(3);
+    for (const auto &phase : phases_) {
+        os << std::setw(12) << phase.wall_ms_ << std::setw(12)
+           << phase.cpu_ms_ << std::setw(12) << phase.rss_delta_kib_
+           << std::setw(8) << phase.calls_ << "  " << phase.name_ << "\n";
+        total_wall += phase.wall_ms_;
+        total_cpu += phase.cpu_ms_;
+    }
+    os << std::setw(12) << total_wall << std::setw(12) << total_cpu
+       << std::setw(12) << get_peak_rss_kib() << std::setw(8) << ""
+       << "  Total (RSS column is the peak)\n";
+
+    if (!counts_.empty()) {
+        os << "\n";
+        for (const auto &cnt : counts_) {
+            os << std::setw(12) << cnt.count_ << "  " << cnt.name_ << "\n";
+        }
+    }
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+void TimeReport::print_json(std::ostream &os) const {
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+
+    os << std::fixed << std::setprecision(3) << "{\"phases\": [";
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        const auto &phase = phases_[i];
+        os << (i == 0 ? "" : ", ") << "{\"name\": \"" << phase.name_
+           << "\", \"wall_ms\": " << phase.wall_ms_
+           << ", \"cpu_ms\": " << phase.cpu_ms_
+           << ", \"peak_rss_delta_kib\": " << phase.rss_delta_kib_
+           << ", \"calls\": " << phase.calls_ << "}";
+    }
+    os << "], \"peak_rss_kib\": " << get_peak_rss_kib() << ", \"counts\": {";
+    for (std::size_t i = 0; i < counts_.size(); ++i) {
+        os << (i == 0 ? "" : ", ") << "\"" << counts_[i].name_
+           << "\": " << counts_[i].count_;
+    }
+    os << "}}\n";
+
+    os.flags(flags);
+    os.precision(precision);
+}
+
+std::size_t TimeReport::find_phase(const char *name) {
+    for (std::size_t i = 0; i < phases_.size(); ++i) {
+        if (phases_[i].name_ == name) {
+            return i;
+        }
+    }
+    phases_.push_back(PhaseData{name});
+    return phases_.size() - 1;
+}
+
+} // namespace c
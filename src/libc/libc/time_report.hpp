@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace c {
+
+// Collects wall time, CPU time and peak RSS growth of compiler phases.
+// Phases may nest, in which case the time of the inner phase is excluded
+// from the outer one. Repeated phases with the same name are accumulated.
+class TimeReport {
+  public:
+    class Phase {
+      public:
+        Phase(TimeReport *report, const char *name);
+        ~Phase();
+
+        Phase(const Phase &) = delete;
+        Phase(Phase &&) = delete;
+        Phase &operator=(const Phase &) = delete;
+        Phase &operator=(Phase &&) = delete;
+
+      private:
+        TimeReport *report_;
+        std::size_t index_{0};
+        std::chrono::steady_clock::time_point wall_start_;
+        std::clock_t cpu_start_{0};
+        long rss_start_{0};
+    };
+
+    // Adds the time of a phase too short to be timed by a Phase every
+    // time, the caller sums the steady clock over its calls. The time is
+    // excluded from the current phase and, the work being single threaded,
+    // counts as CPU time too.
+    void add_nested_time(
+        const char *name,
+        std::chrono::steady_clock::duration wall,
+        std::size_t calls);
+
+    void add_count(const char *name, std::size_t count);
+
+    void print(std::ostream &os) const;
+    void print_json(std::ostream &os) const;
+
+  private:
+    struct PhaseData {
+        std::string name_;
+        double wall_ms_{0};
+        double cpu_ms_{0};
+        long rss_delta_kib_{0};
+        std::size_t calls_{0};
+    };
+
+    struct Nested {
+        double wall_ms_{0};
+        double cpu_ms_{0};
+    };
+
+    struct Count {
+        std::string name_;
+        std::size_t count_{0};
+    };
+
+    std::size_t find_phase(const char *name);
+
+    std::vector<PhaseData> phases_;
+    std::vector<Nested> active_;
+    std::vector<Count> counts_;
+};
+
+} // namespace c
@@ -0,0 +1,117 @@
+#include <libc/trace.hpp>
+
+#ifdef C_ENABLE_TRACING
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <vector>
+
+namespace c::trace {
+
+namespace {
+
+struct Event {
+    const char *category_;
+    std::string name_;
+    double start_us_;
+    double duration_us_;
+};
+
+struct Tracer {
+    bool is_active_{false};
+    std::string path_;
+    std::chrono::steady_clock::time_point origin_;
+    std::vector<Event> events_;
+};
+
+Tracer &tracer() {
+    static Tracer instance;
+    return instance;
+}
+
+double now_us() {
+    const std::chrono::duration<double, std::micro> since_origin =
+        std::chrono::steady_clock::now() - tracer().origin_;
+    return since_origin.count();
+}
+
+void write_json_string(std::ostream &os, const std::string &str) {
+    os << '"';
+    for (char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            os << '\\';
+        }
+        os << ch;
+    }
+    os << '"';
+}
+
+} // namespace
+
+bool start(const std::string &path) {
+    auto &instance = tracer();
+    instance.is_active_ = true;
+    instance.path_ = path;
+    instance.origin_ = std::chrono::steady_clock::now();
+    instance.events_.clear();
+    return true;
+}
+
+void stop() {
+    auto &instance = tracer();
+    if (!instance.is_active_) {
+        return;
+    }
+    instance.is_active_ = false;
+
+    // Fixed microseconds keep the nanoseconds of long traces, the default
+    // precision rounds them to tens of microseconds past a second
+    std::ofstream out(instance.path_);
+    out << std::fixed << std::setprecision(3)
+        << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    for (std::size_t i = 0; i < instance.events_.size(); ++i) {
+        const auto &event = instance.events_[i];
+        out << (i == 0 ? "\n" : ",\n") << "{\"ph\": \"X\", \"pid\": 1, "
+            << "\"tid\": 1, \"cat\": ";
+        write_json_string(out, event.category_);
+        out << ", \"name\": ";
+        write_json_string(out, event.name_);
+        out << ", \"ts\": " << event.start_us_
+            << ", \"dur\": " << event.duration_us_ << "}";
+    }
+    out << "\n]}\n";
+    instance.events_.clear();
+}
+
+Scope::Scope(const char *category, std::string name)
+    : category_(category), name_(std::move(name)) {
+    if (tracer().is_active_) {
+        start_us_ = now_us();
+    }
+}
+
+Scope::~Scope() {
+    auto &instance = tracer();
+    if (!instance.is_active_) {
+        return;
+    }
+    instance.events_.push_back(
+        Event{category_, std::move(name_), start_us_, now_us() - start_us_});
+}
+
+} // namespace c::trace
+
+#else
+
+namespace c::trace {
+
+bool start(const std::string & /*path*/) {
+    return false;
+}
+
+void stop() {}
+
+} // namespace c::trace
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+// Chrome trace-event instrumentation. Scopes are compiled in only when the
+// c library is configured with -DC_ENABLE_TRACING=ON, otherwise the macros
+// expand to nothing and the pipeline carries no tracing code at all.
+
+#define C_TRACE_CONCAT_IMPL(a, b) a##b
+#define C_TRACE_CONCAT(a, b) C_TRACE_CONCAT_IMPL(a, b)
+
+#ifdef C_ENABLE_TRACING
+#define C_TRACE_SCOPE(category, name)                                          \
+    ::c::trace::Scope C_TRACE_CONCAT(c_trace_scope_, __LINE__)(category, name)
+#else
+#define C_TRACE_SCOPE(category, name) static_cast<void>(0)
+#endif
+
+namespace c::trace {
+
+// Starts collecting events, returns false if tracing isn't compiled in
+bool start(const std::string &path);
+// Writes collected events to the file passed to start()
+void stop();
+
+#ifdef C_ENABLE_TRACING
+class Scope {
+  public:
+    Scope(const char *category, std::string name);
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope(Scope &&) = delete;
+    Scope &operator=(const Scope &) = delete;
+    Scope &operator=(Scope &&) = delete;
+
+  private:
+    const char *category_;
+    std::string name_;
+    double start_us_{0};
+};
+#endif
+
+} // namespace c::trace
\ No newline at end of file
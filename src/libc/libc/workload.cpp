@@ -0,0 +1,453 @@
+#include <libc/workload.hpp>
+
+#include <array>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace c {
+
+namespace {
+
+// Functions, variables, "data", "main", "printf", "argc", "argv", "k" and
+// "r" have to fit into the hash table of the symtab
+const std::size_t c_max_names = 200;
+
+const std::size_t c_array_size = 16;
+
+// The stored values are reduced into (-c_value_bound, c_value_bound) and
+// the expressions multiply only by small constants, so no value overflows
+const std::size_t c_value_bound = 1000;
+
+const std::array<const char *, 16> c_words = {
+    "alpha", "beta",   "gamma", "delta", "sum",  "value", "index", "loop",
+    "array", "result", "left",  "right", "node", "count", "total", "step"};
+
+class Generator final {
+  public:
+    Generator(std::ostream &out, const WorkloadOptions &options)
+        : out_(out), options_(options), state_(options.seed_),
+          declarations_(options.identifiers_),
+          position_(options.identifiers_) {}
+
+    void generate() {
+        out_ << "#include <stdio.h>\n\n";
+        for (std::size_t index = 0; index < options_.functions_; ++index) {
+            function(index);
+        }
+        out_ << "int main(int argc, char **argv) {\n"
+             << "    int r = f" << options_.functions_ - 1 << "(argc, 2);\n"
+             << "    printf(\"%d\\n\", r);\n"
+             << "    return 0;\n"
+             << "}\n";
+    }
+
+  private:
+    static constexpr std::size_t no_name = static_cast<std::size_t>(-1);
+
+    struct Scope {
+        std::vector<std::size_t> declared_;
+        // Names read or written in the scope or in the nested ones
+        std::vector<bool> used_;
+    };
+
+    // splitmix64: unlike the standard distributions it gives the same
+    // sequence with every standard library
+    std::uint64_t next() {
+        std::uint64_t z = (state_ += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30U)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27U)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31U);
+    }
+
+    std::size_t uniform(std::size_t bound) {
+        return bound == 0 ? 0 : static_cast<std::size_t>(next() % bound);
+    }
+
+    bool chance(double probability) {
+        const double unit = 0x1p-53;
+        return static_cast<double>(next() >> 11U) * unit < probability;
+    }
+
+    void function(std::size_t index) {
+        function_index_ = index;
+
+        out_ << "int f" << index << "(int v0, int v1) {\n";
+        push_scope();
+        declare(0, true);
+        declare(1, true);
+        out_ << "    int data[" << c_array_size << "];\n"
+             << "    for (int k = 0; k < " << c_array_size << "; k += 1) {\n"
+             << "        data[k] = 0;\n"
+             << "    }\n";
+
+        block(1, options_.statements_);
+
+        out_ << "    int r = ";
+        expression(no_name);
+        out_ << ";\n    return r % " << c_value_bound << ";\n}\n\n";
+        pop_scope();
+    }
+
+    void block(std::size_t depth, std::size_t budget) {
+        while (budget > 0) {
+            statement(depth, budget);
+        }
+    }
+
+    void statement(std::size_t depth, std::size_t &budget) {
+        --budget;
+
+        if (chance(options_.string_volume_)) {
+            string_output(depth);
+            return;
+        }
+
+        const auto kind = uniform(100);
+        const bool can_nest = depth <= options_.nesting_depth_ && budget > 0;
+        if (can_nest && kind < 10) {
+            const auto inner = take(budget);
+            // The condition is a part of the scope of the if
+            push_scope();
+            indent(depth);
+            out_ << "if (";
+            condition();
+            out_ << ") {\n";
+            block_end(depth, inner);
+            pop_scope();
+        } else if (can_nest && kind < 18) {
+            const auto inner = take(budget);
+            loop(depth, inner);
+        } else if (can_nest && kind < 22) {
+            const auto inner = take(budget);
+            indent(depth);
+            out_ << "{\n";
+            nested_block(depth, inner);
+        } else if (kind < 44) {
+            declaration(depth);
+        } else if (kind < 52 && function_index_ > 0) {
+            indent(depth);
+            call(no_name);
+            out_ << ";\n";
+        } else if (kind < 60 && has_counter()) {
+            const auto counter = use(loop_counters_.back());
+            indent(depth);
+            out_ << "data[v" << counter << "] = ";
+            expression(no_name);
+            out_ << ";\n";
+            reduce(depth, "data[v" + std::to_string(counter) + "]");
+        } else {
+            assignment(depth);
+        }
+    }
+
+    // Budget of the statements nested into a compound one
+    std::size_t take(std::size_t &budget) {
+        const auto inner = 1 + uniform((budget + 1) / 2);
+        budget -= inner;
+        return inner;
+    }
+
+    void nested_block(std::size_t depth, std::size_t budget) {
+        push_scope();
+        block_end(depth, budget);
+        pop_scope();
+    }
+
+    void block_end(std::size_t depth, std::size_t budget) {
+        block(depth + 1, budget);
+        indent(depth);
+        out_ << "}\n";
+    }
+
+    void loop(std::size_t depth, std::size_t budget) {
+        const auto counter = pick_declarable();
+        if (counter == no_name) {
+            indent(depth);
+            out_ << "{\n";
+            nested_block(depth, budget);
+            return;
+        }
+
+        indent(depth);
+        out_ << "for (int v" << counter << " = 0; v" << counter << " < "
+             << 1 + uniform(c_array_size) << "; v" << counter
+             << " += 1) {\n";
+
+        // The counter shares the scope with the body of the loop
+        push_scope();
+        declare(counter, false);
+        loop_counters_.push_back(counter);
+        block_end(depth, budget);
+
+        loop_counters_.pop_back();
+        pop_scope();
+    }
+
+    void declaration(std::size_t depth) {
+        const auto name = pick_declarable();
+        if (name == no_name) {
+            assignment(depth);
+            return;
+        }
+
+        indent(depth);
+        out_ << "int v" << name << " = ";
+        // The variable is visible in its own initializer, so the value must
+        // not read the name even if it refers to a variable of outer scope
+        expression(name);
+        out_ << ";\n";
+        declare(name, true);
+        reduce(depth, "v" + std::to_string(use(name)));
+    }
+
+    void assignment(std::size_t depth) {
+        const auto name = pick_writable();
+        if (name == no_name) {
+            string_output(depth);
+            return;
+        }
+
+        indent(depth);
+        out_ << "v" << use(name) << (chance(0.25) ? " += " : " = ");
+        expression(no_name);
+        out_ << ";\n";
+        reduce(depth, "v" + std::to_string(name));
+    }
+
+    // The grammar has no parentheses, so the value is reduced after it is
+    // stored
+    void reduce(std::size_t depth, const std::string &lvalue) {
+        indent(depth);
+        out_ << lvalue << " %= " << c_value_bound << ";\n";
+    }
+
+    void string_output(std::size_t depth) {
+        indent(depth);
+        out_ << "printf(\"";
+        for (std::size_t length = 0; length < options_.string_length_;) {
+            const auto *word = c_words.at(uniform(c_words.size()));
+            out_ << word << ' ';
+            length += std::char_traits<char>::length(word) + 1;
+        }
+        if (chance(0.5)) {
+            out_ << "%d\\n\", ";
+            expression(no_name);
+            out_ << ");\n";
+        } else {
+            out_ << "\\n\");\n";
+        }
+    }
+
+    void condition() {
+        static const std::array<const char *, 6> relations = {
+            " < ", " > ", " <= ", " >= ", " == ", " != "};
+        expression(no_name);
+        out_ << relations.at(uniform(relations.size()));
+        expression(no_name);
+    }
+
+    void call(std::size_t excluded) {
+        out_ << "f" << uniform(function_index_) << "(";
+        for (std::size_t arg = 0; arg < 2; ++arg) {
+            out_ << (arg == 0 ? "" : ", ");
+            operand(excluded, false);
+        }
+        out_ << ")";
+    }
+
+    void expression(std::size_t excluded) {
+        const auto mean = options_.expression_length_;
+        const auto length = mean == 0 ? 1 : 1 + uniform(2 * mean - 1);
+
+        operand(excluded, true);
+        // A term is multiplied once at most
+        bool is_scaled = false;
+        for (std::size_t i = 1; i < length; ++i) {
+            auto kind = uniform(5);
+            if (kind == 2 && is_scaled) {
+                kind = 0;
+            }
+            switch (kind) {
+            case 0:
+                is_scaled = false;
+                out_ << " + ";
+                break;
+            case 1:
+                is_scaled = false;
+                out_ << " - ";
+                break;
+            case 2:
+                is_scaled = true;
+                out_ << " * " << 2 + uniform(8);
+                continue;
+            case 3:
+                // Constant divisors never divide by zero
+                out_ << " / " << 1 + uniform(9);
+                continue;
+            default:
+                out_ << " % " << 2 + uniform(8);
+                continue;
+            }
+            operand(excluded, true);
+        }
+    }
+
+    void operand(std::size_t excluded, bool can_call) {
+        const auto kind = uniform(100);
+        if (kind < 20) {
+            out_ << uniform(100);
+            return;
+        }
+        if (kind < 30 && can_call && function_index_ > 0) {
+            call(excluded);
+            return;
+        }
+        if (kind < 40 && has_counter() && loop_counters_.back() != excluded) {
+            out_ << "data[v" << use(loop_counters_.back()) << "]";
+            return;
+        }
+
+        const auto name = pick_visible(excluded);
+        if (name == no_name) {
+            out_ << uniform(100);
+        } else {
+            out_ << "v" << use(name);
+        }
+    }
+
+    // Indexing is in bounds only while the name still refers to a counter
+    bool has_counter() const {
+        return !loop_counters_.empty() &&
+            !declarations_.at(loop_counters_.back()).back();
+    }
+
+    std::size_t use(std::size_t name) {
+        for (auto &scope : scopes_) {
+            scope.used_.at(name) = true;
+        }
+        return name;
+    }
+
+    std::size_t pick_visible(std::size_t excluded) {
+        if (visible_.empty() ||
+            (visible_.size() == 1 && visible_.front() == excluded)) {
+            return no_name;
+        }
+        for (;;) {
+            const auto name = visible_.at(uniform(visible_.size()));
+            if (name != excluded) {
+                return name;
+            }
+        }
+    }
+
+    std::size_t pick_writable() {
+        std::vector<std::size_t> candidates;
+        for (auto name : visible_) {
+            if (declarations_.at(name).back()) {
+                candidates.push_back(name);
+            }
+        }
+        return candidates.empty() ? no_name
+                                  : candidates.at(uniform(candidates.size()));
+    }
+
+    // A name that isn't declared in the current scope. With the shadowing
+    // density it hides a variable of an outer scope.
+    //
+    // The code generator resolves a name by the whole scope, so a variable
+    // of outer scope can't be hidden after the current scope has read it.
+    std::size_t pick_declarable() {
+        const bool is_shadowing = scopes_.size() > 1 &&
+            chance(options_.shadowing_density_);
+
+        std::vector<std::size_t> candidates;
+        for (std::size_t name = 0; name < options_.identifiers_; ++name) {
+            const bool is_visible = !declarations_.at(name).empty();
+            if (is_visible == is_shadowing &&
+                !scopes_.back().used_.at(name) &&
+                !is_declared_in_scope(name, scopes_.back())) {
+                candidates.push_back(name);
+            }
+        }
+        return candidates.empty() ? no_name
+                                  : candidates.at(uniform(candidates.size()));
+    }
+
+    static bool is_declared_in_scope(std::size_t name, const Scope &scope) {
+        for (auto declared : scope.declared_) {
+            if (declared == name) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void declare(std::size_t name, bool is_writable) {
+        auto &declarations = declarations_.at(name);
+        if (declarations.empty()) {
+            position_.at(name) = visible_.size();
+            visible_.push_back(name);
+        }
+        declarations.push_back(is_writable);
+        scopes_.back().declared_.push_back(name);
+    }
+
+    void push_scope() {
+        scopes_.push_back({{}, std::vector<bool>(options_.identifiers_)});
+    }
+
+    void pop_scope() {
+        for (auto name : scopes_.back().declared_) {
+            auto &declarations = declarations_.at(name);
+            declarations.pop_back();
+            if (declarations.empty()) {
+                const auto last = visible_.back();
+                visible_.at(position_.at(name)) = last;
+                position_.at(last) = position_.at(name);
+                visible_.pop_back();
+            }
+        }
+        scopes_.pop_back();
+    }
+
+    void indent(std::size_t depth) {
+        for (std::size_t i = 0; i < depth; ++i) {
+            out_ << "    ";
+        }
+    }
+
+    std::ostream &out_;
+    const WorkloadOptions &options_;
+    std::uint64_t state_;
+
+    std::size_t function_index_{0};
+    std::vector<Scope> scopes_;
+    // Writability of every visible declaration of a name, innermost last
+    std::vector<std::vector<bool>> declarations_;
+    std::vector<std::size_t> visible_;
+    std::vector<std::size_t> position_;
+    std::vector<std::size_t> loop_counters_;
+};
+
+} // namespace
+
+void generate_workload(std::ostream &out, const WorkloadOptions &options) {
+    if (options.functions_ == 0) {
+        throw std::invalid_argument("workload needs at least one function");
+    }
+    if (options.identifiers_ < 2) {
+        throw std::invalid_argument("workload needs at least two identifiers");
+    }
+    if (options.functions_ + options.identifiers_ > c_max_names) {
+        throw std::invalid_argument(
+            "workload can't have more than " + std::to_string(c_max_names) +
+            " functions and identifiers");
+    }
+
+    Generator(out, options).generate();
+}
+
+} // namespace c
\ No newline at end of file
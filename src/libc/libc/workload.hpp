@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+
+namespace c {
+
+// Shape of a generated program. The same options and seed always give the
+// same program.
+struct WorkloadOptions {
+    std::uint64_t seed_{1};
+    std::size_t functions_{8};
+    // Statements in the body of every function, nested ones included
+    std::size_t statements_{64};
+    std::size_t nesting_depth_{3};
+    // Average number of operands in an expression
+    std::size_t expression_length_{4};
+    // Distinct names of variables, the first two are the parameters
+    std::size_t identifiers_{16};
+    // Probability that a declaration in a nested scope hides a visible name
+    double shadowing_density_{0.2};
+    // Probability that a statement is a printf of a string literal
+    double string_volume_{0.1};
+    std::size_t string_length_{24};
+};
+
+// Writes a valid program of the accepted C subset. Every function calls only
+// the functions defined before it and every loop has a constant trip count.
+// The arrays are initialized and the values are kept small, so the behavior
+// of the program is defined. Throws std::invalid_argument if the options
+// can't give such a program.
+void generate_workload(std::ostream &out, const WorkloadOptions &options);
+
+} // namespace c
@@ -0,0 +1,6 @@
+void f() {}
+
+int main(int argc, char **argv) {
+    int x = f();
+    return 0;
+}
\ No newline at end of file
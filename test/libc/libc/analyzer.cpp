@@ -5,6 +5,8 @@
 #include <libc/symtab.hpp>
 
 #include <sstream>
+#include <string>
+#include <vector>
 
 // NOLINTBEGIN(readability-function-cognitive-complexity)
 
@@ -340,4 +342,212 @@ TEST(Analyzer, InvalidOperationsWithPointers) {
     }
 }
 
+TEST(Analyzer, FunctionEffects) {
+    std::istringstream in("int len(char *s) {"
+                          "   int n = 0;"
+                          "   for (; s[n]; n += 1) {}"
+                          "   return n;"
+                          "}"
+                          "int square(int x) {"
+                          "   int tmp[2];"
+                          "   tmp[0] = x * x;"
+                          "   return tmp[0];"
+                          "}"
+                          "void fill(char *s) { s[0] = 1; }"
+                          "int say(int x) {"
+                          "   printf(\"%d\\n\", x);"
+                          "   return x;"
+                          "}"
+                          "int twice(char *s) { return len(s) + square(2); }"
+                          "int down(int x, char *s) {"
+                          "   if (x > 0) { return down(x - 1, s); }"
+                          "   fill(s);"
+                          "   return 0;"
+                          "}"
+                          "int main(int argc, char **argv) {"
+                          "   return say(twice(argv[0]));"
+                          "}");
+
+    auto parser_result = c::parse(in);
+    ASSERT_TRUE(parser_result.errors_.empty());
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    auto get_effects = [&symtab](const std::string &name) {
+        auto *func = dynamic_cast<c::ast::symtab::FunctionSymbol *>(
+            symtab.find_sym(name)->sym_.get());
+        return func->get_effects();
+    };
+
+    EXPECT_TRUE(get_effects("len").is_readonly());
+    EXPECT_FALSE(get_effects("len").is_readnone());
+    EXPECT_TRUE(get_effects("square").is_readnone());
+    EXPECT_TRUE(get_effects("fill").writes_memory_);
+    EXPECT_FALSE(get_effects("fill").reads_memory_);
+    EXPECT_TRUE(get_effects("say").has_io_);
+    EXPECT_TRUE(get_effects("twice").is_readonly());
+    EXPECT_FALSE(get_effects("twice").is_readnone());
+    EXPECT_TRUE(get_effects("down").writes_memory_);
+    EXPECT_TRUE(get_effects("main").has_io_);
+    EXPECT_TRUE(get_effects("main").reads_memory_);
+}
+
+TEST(Analyzer, CallGraph) {
+    std::istringstream in("int len(char *s) {"
+                          "   int n = 0;"
+                          "   for (; s[n]; n += 1) {}"
+                          "   return n;"
+                          "}"
+                          "char *id(char *s) { return s; }"
+                          "int use(char *s) { return len(s) + len(s); }"
+                          "int keep(char *s) { return len(id(s)); }"
+                          "int copy(char *d, char *s) {"
+                          "   d[0] = s[0];"
+                          "   return 0;"
+                          "}"
+                          "int count(int n) {"
+                          "   if (n == 0) { return 0; }"
+                          "   return count(n - 1) + 1;"
+                          "}"
+                          "int wrap(int n) { return count(n); }"
+                          "int main(int argc, char **argv) {"
+                          "   return use(argv[0]) + wrap(argc);"
+                          "}");
+
+    auto parser_result = c::parse(in);
+    ASSERT_TRUE(parser_result.errors_.empty());
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    auto get_func = [&symtab](const std::string &name) {
+        return dynamic_cast<c::ast::symtab::FunctionSymbol *>(
+            symtab.find_sym(name)->sym_.get());
+    };
+
+    EXPECT_FALSE(get_func("len")->get_effects().is_recursive_);
+    EXPECT_TRUE(get_func("count")->get_effects().is_recursive_);
+    EXPECT_FALSE(get_func("wrap")->get_effects().is_recursive_);
+    EXPECT_FALSE(get_func("main")->get_effects().is_recursive_);
+
+    EXPECT_EQ(
+        get_func("use")->get_callees(),
+        std::vector<c::ast::symtab::FunctionSymbol *>{get_func("len")});
+    EXPECT_EQ(
+        get_func("main")->get_callees(),
+        (std::vector<c::ast::symtab::FunctionSymbol *>{
+            get_func("use"), get_func("wrap")}));
+
+    EXPECT_FALSE(get_func("len")->get_effects().captured_params_[0]);
+    EXPECT_TRUE(get_func("id")->get_effects().captured_params_[0]);
+    EXPECT_FALSE(get_func("use")->get_effects().captured_params_[0]);
+    EXPECT_TRUE(get_func("keep")->get_effects().captured_params_[0]);
+
+    EXPECT_TRUE(get_func("len")->get_effects().noalias_params_[0]);
+    EXPECT_FALSE(get_func("copy")->get_effects().noalias_params_[0]);
+    EXPECT_FALSE(get_func("copy")->get_effects().noalias_params_[1]);
+    EXPECT_FALSE(get_func("main")->get_effects().noalias_params_[1]);
+}
+
+TEST(Analyzer, DeadFunctions) {
+    const std::string source = "int leaf(int x) { return x; }"
+                               "int unused(int x) { return leaf(x); }"
+                               "int helper(int x) { return leaf(x) + 1; }"
+                               "int api(int x) { return x; }"
+                               "int main() { return helper(2); }";
+
+    auto get_ids = [](const c::ast::Program &program) {
+        std::vector<std::string> ids;
+        for (auto *child : program.get_childs()) {
+            if (auto *func =
+                    dynamic_cast<c::ast::FunctionDefinition *>(child)) {
+                ids.push_back(func->id());
+            }
+        }
+        return ids;
+    };
+
+    std::istringstream in(source);
+    auto parser_result = c::parse(in);
+    ASSERT_TRUE(parser_result.errors_.empty());
+    EXPECT_EQ(c::eliminate_dead_functions(parser_result.program_), 2);
+    EXPECT_EQ(
+        get_ids(parser_result.program_),
+        (std::vector<std::string>{"leaf", "helper", "main"}));
+
+    std::istringstream exported_in(source);
+    auto exported_result = c::parse(exported_in);
+    ASSERT_TRUE(exported_result.errors_.empty());
+    EXPECT_EQ(
+        c::eliminate_dead_functions(exported_result.program_, {"api"}), 1);
+    EXPECT_EQ(
+        get_ids(exported_result.program_),
+        (std::vector<std::string>{"leaf", "helper", "api", "main"}));
+
+    std::istringstream library_in("int leaf(int x) { return x; }");
+    auto library_result = c::parse(library_in);
+    ASSERT_TRUE(library_result.errors_.empty());
+    EXPECT_EQ(c::eliminate_dead_functions(library_result.program_), 0);
+}
+
+TEST(Analyzer, ExpressionTypes) {
+    std::istringstream in("int main() {"
+                          "   char c = 1;"
+                          "   double d = c * 2 < 3;"
+                          "   return d;"
+                          "}");
+
+    auto parser_result = c::parse(in);
+    ASSERT_TRUE(parser_result.errors_.empty());
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    const auto &program = parser_result.program_;
+    auto *main = dynamic_cast<c::ast::FunctionDefinition *>(
+        program.get_childs().back());
+    ASSERT_NE(main, nullptr);
+    auto *expression =
+        dynamic_cast<c::ast::Expression *>(main->actions()[1]);
+    ASSERT_NE(expression, nullptr);
+    auto *create =
+        dynamic_cast<c::ast::DataCreate *>(expression->expression());
+    ASSERT_NE(create, nullptr);
+    auto *init = dynamic_cast<c::ast::VariableInit *>(create->data_create());
+    ASSERT_NE(init, nullptr);
+    auto *ret = dynamic_cast<c::ast::ReturnStatement *>(main->actions()[2]);
+    ASSERT_NE(ret, nullptr);
+
+    const auto &rpn = dynamic_cast<c::ast::RvalueOperation *>(init->value())
+                          ->rpn();
+    ASSERT_EQ(rpn.size(), 5);
+
+    EXPECT_EQ(program.get_expression_type(rpn[0]).type_.name_, "char");
+
+    const auto &mul = program.get_expression_type(rpn[2]);
+    EXPECT_EQ(mul.type_.name_, "int");
+    EXPECT_EQ(mul.lhs_conversion_, c::ast::Conversion::sign_extend);
+    EXPECT_EQ(mul.rhs_conversion_, c::ast::Conversion::none);
+
+    const auto &less = program.get_expression_type(rpn[4]);
+    EXPECT_EQ(less.type_.name_, "bool");
+    EXPECT_EQ(less.operand_type_.name_, "int");
+    EXPECT_EQ(less.lhs_conversion_, c::ast::Conversion::none);
+
+    const auto &value = program.get_expression_type(init->value());
+    EXPECT_EQ(value.type_.name_, "bool");
+    EXPECT_EQ(value.conversion_, c::ast::Conversion::int_to_float);
+
+    EXPECT_EQ(
+        program.get_expression_type(ret->value()).conversion_,
+        c::ast::Conversion::float_to_int);
+}
+
 // NOLINTEND(readability-function-cognitive-complexity)
\ No newline at end of file
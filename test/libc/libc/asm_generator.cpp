@@ -0,0 +1,168 @@
+#include <gtest/gtest.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/asm_generator.hpp>
+#include <libc/parser.hpp>
+#include <libc/symtab.hpp>
+
+#include <sstream>
+
+TEST(AsmGenerator, CallsAndLoops) {
+    std::stringstream correct(
+        "\t.intel_syntax noprefix\n"
+        "\t.text\n\n"
+        "\t.p2align 4\n"
+        "\t.type sum, @function\n"
+        "sum:\n"
+        "\tpush\trbp\n"
+        "\tmov\trbp, rsp\n"
+        "\tmov\trcx, 0\n"
+        "\tmov\tesi, 0\n"
+        "\tjmp\t.LBB0_3\n"
+        ".LBB0_1:\n"
+        "\tmov\tr8d, esi\n"
+        "\timul\tr8d, r8d, 3\n"
+        "\tmovsxd\tr8, r8d\n"
+        "\tmov\tr9, rcx\n"
+        "\tadd\tr9, r8\n"
+        "\tmov\trcx, r9\n"
+        "\tmov\tr8d, esi\n"
+        "\tadd\tr8d, 1\n"
+        "\tmov\tesi, r8d\n"
+        ".LBB0_3:\n"
+        "\tcmp\tesi, edi\n"
+        "\tjl\t.LBB0_1\n"
+        "\tmov\trax, rcx\n"
+        "\tmov\trsp, rbp\n"
+        "\tpop\trbp\n"
+        "\tret\n"
+        "\t.size sum, .-sum\n\n"
+        "\t.globl main\n"
+        "\t.p2align 4\n"
+        "\t.type main, @function\n"
+        "main:\n"
+        "\tpush\trbp\n"
+        "\tmov\trbp, rsp\n"
+        "\tpush\trbx\n"
+        "\tpush\tr12\n"
+        "\tsub\trsp, 16\n"
+        "\tmov\tebx, 0\n"
+        "\tjmp\t.LBB1_3\n"
+        ".LBB1_1:\n"
+        "\tmovsxd\tr12, ebx\n"
+        "\tmov\trdi, rbx\n"
+        "\tcall\tsum\n"
+        "\tmov\trcx, rax\n"
+        "\tmov\tDWORD PTR [rbp + r12*4 - 32], ecx\n"
+        "\tmov\tecx, ebx\n"
+        "\tadd\tecx, 1\n"
+        "\tmov\tebx, ecx\n"
+        ".LBB1_3:\n"
+        "\tcmp\tebx, 4\n"
+        "\tjl\t.LBB1_1\n"
+        "\tmov\tecx, DWORD PTR [rbp - 20]\n"
+        "\tmov\trax, rcx\n"
+        "\tlea\trsp, [rbp - 16]\n"
+        "\tpop\tr12\n"
+        "\tpop\trbx\n"
+        "\tpop\trbp\n"
+        "\tret\n"
+        "\t.size main, .-main\n"
+        "\t.section .note.GNU-stack,\"\",@progbits\n");
+    std::stringstream in("long sum(int size) {\n"
+                         "    long result = 0;\n"
+                         "    for (int i = 0; i < size; i += 1) {\n"
+                         "        result += i * 3;\n"
+                         "    }\n"
+                         "    return result;\n"
+                         "}\n"
+                         "\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    int array[4];\n"
+                         "    for (int i = 0; i < 4; i += 1) {\n"
+                         "        array[i] = sum(i);\n"
+                         "    }\n"
+                         "    return array[3];\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::generate_asm(out, parser_result.program_, symtab);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(AsmGenerator, FloatingPointAndPrintf) {
+    std::stringstream correct(
+        "\t.intel_syntax noprefix\n"
+        "\t.text\n\n"
+        "\t.globl main\n"
+        "\t.p2align 4\n"
+        "\t.type main, @function\n"
+        "main:\n"
+        "\tpush\trbp\n"
+        "\tmov\trbp, rsp\n"
+        "\tcvtsi2sd\txmm0, edi\n"
+        "\tmov\tecx, 2\n"
+        "\tcvtsi2sd\txmm1, ecx\n"
+        "\tmovaps\txmm2, xmm0\n"
+        "\tdivsd\txmm2, xmm1\n"
+        "\tmovaps\txmm0, xmm2\n"
+        "\tcvtsi2sd\txmm1, edi\n"
+        "\tucomisd\txmm1, xmm0\n"
+        "\tjbe\t.LBB0_2\n"
+        "\tlea\trcx, [rip + .L.str0]\n"
+        "\tmov\tesi, 2\n"
+        "\tmov\teax, edi\n"
+        "\tcdq\n"
+        "\tidiv\tesi\n"
+        "\tmov\tesi, eax\n"
+        "\tmov\trdi, rcx\n"
+        "\tmov\teax, 1\n"
+        "\tcall\tprintf@PLT\n"
+        "\tmov\trcx, rax\n"
+        ".LBB0_2:\n"
+        "\tmov\trax, 0\n"
+        "\tmov\trsp, rbp\n"
+        "\tpop\trbp\n"
+        "\tret\n"
+        "\t.size main, .-main\n\n"
+        "\t.section .rodata\n"
+        ".L.str0:\n"
+        "\t.asciz \"%d %f\\012\"\n"
+        "\t.section .note.GNU-stack,\"\",@progbits\n");
+    std::stringstream in("#include <stdio.h>\n"
+                         "\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    double half = argc;\n"
+                         "    half = half / 2;\n"
+                         "    if (half < argc) {\n"
+                         "        printf(\"%d %f\\n\", argc / 2, half);\n"
+                         "    }\n"
+                         "    return 0;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::generate_asm(out, parser_result.program_, symtab);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
\ No newline at end of file
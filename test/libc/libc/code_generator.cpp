@@ -208,6 +208,53 @@ TEST(Generator, CastVar) {
     EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
 }
 
+TEST(Generator, PromoteVariadicArguments) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n"
+        "declare i32 @printf(i8*, ...)\n\n"
+        "@.str0 = private unnamed_addr constant [7 x i8] c\"%f %d\\0A\\00\"\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\t%argc.addr0 = alloca i32\n"
+        "\tstore i32 %argc, i32* %argc.addr0\n"
+        "\t%argv.addr1 = alloca i8**\n"
+        "\tstore i8** %argv, i8*** %argv.addr1\n\n"
+        "\t%f.addr2 = alloca float\n"
+        "\tstore float 2.0, float* %f.addr2\n\n"
+        "\t%s.addr3 = alloca i16\n"
+        "\tstore i16 3, i16* %s.addr3\n\n"
+        "\t%tmp2 = load float, float* %f.addr2\n"
+        "\t%tmp3 = load i16, i16* %s.addr3\n"
+        "\t%tmp4 = fpext float %tmp2 to double\n"
+        "\t%tmp5 = sext i16 %tmp3 to i32\n"
+        "\t%tmp6 = call i32 (i8*, ...) @printf(i8* getelementptr ([7 x i8], "
+        "[7 x i8]* @.str0, i64 0, i64 0), double %tmp4, i32 %tmp5)\n\n"
+        "\tret i32 0\n"
+        "}\n\n");
+    std::stringstream in("#include <stdio.h>\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    float f = 2;\n"
+                         "    short s = 3;\n"
+                         "    printf(\"%f %d\\n\", f, s);\n"
+                         "    return 0;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::generate(out, parser_result.program_, symtab);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
 TEST(Generator, FuncCall) {
     std::stringstream correct(
         "target triple = \"x86_64-pc-linux-gnu\"\n\n"
@@ -414,4 +461,1412 @@ TEST(Generator, Statements) {
     EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
 }
 
-// NOLINTEND(readability-function-cognitive-complexity)
\ No newline at end of file
+TEST(Generator, PromoteScalars) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n\n"
+        "\tbr label %block0\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp3, %block3 ]\n"
+        "\t%phi.1 = phi i32 [ 0, %entry ], [ %phi.3, %block3 ]\n"
+        "\t%tmp0 = icmp slt i32 %phi.0, %argc\n"
+        "\tbr i1 %tmp0, label %block1, label %block2\n\n"
+        "block1:\n"
+        "\t%tmp1 = icmp sgt i32 %phi.0, 2\n"
+        "\tbr i1 %tmp1, label %block4, label %block5\n\n"
+        "block4:\n"
+        "\t%tmp2 = add i32 %phi.1, %phi.0\n\n"
+        "\tbr label %block5\n\n"
+        "block5:\n"
+        "\t%phi.3 = phi i32 [ %phi.1, %block1 ], [ %tmp2, %block4 ]\n"
+        "\tbr label %block3\n\n"
+        "block3:\n"
+        "\t%tmp3 = add i32 %phi.0, 1\n"
+        "\tbr label %block0\n\n"
+        "block2:\n"
+        "\tret i32 %phi.1\n"
+        "}\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int sum = 0;\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        if (i > 2) {\n"
+                         "            sum += i;\n"
+                         "        }\n"
+                         "    }\n"
+                         "    return sum;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, FoldConstants) {
+    std::stringstream correct("target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+                              "define i32 @main(i32 %argc, i8** %argv) {\n"
+                              "entry:\n"
+                              "\t%argc.addr0 = alloca i32\n"
+                              "\tstore i32 %argc, i32* %argc.addr0\n"
+                              "\t%argv.addr1 = alloca i8**\n"
+                              "\tstore i8** %argv, i8*** %argv.addr1\n\n"
+                              "\t%n.addr2 = alloca i32\n"
+                              "\tstore i32 10, i32* %n.addr2\n\n"
+                              "\t%data.addr3 = alloca i32, i64 20\n\n"
+                              "\t%k.addr4 = alloca i32\n"
+                              "\tstore i32 -5, i32* %k.addr4\n\n"
+                              "\t%tmp2 = getelementptr i32, i32* %data.addr3, "
+                              "i64 0\n"
+                              "\t%tmp3 = load i32, i32* %tmp2\n"
+                              "\t%tmp4 = load i32, i32* %argc.addr0\n"
+                              "\t%tmp5 = mul i32 %tmp4, -5\n"
+                              "\tstore i32 %tmp5, i32* %tmp2\n\n"
+                              "\t%c.addr5 = alloca i8\n"
+                              "\tstore i8 -56, i8* %c.addr5\n\n"
+                              "\tret i32 283\n"
+                              "}\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int n = 2 * 3 + 4;\n"
+                         "    int data[n * 2];\n"
+                         "    int k = n % 4 - 7;\n"
+                         "    data[k + 5] = argc * k;\n"
+                         "    char c = 100 + 100;\n"
+                         "    return n / 3 + k * c;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.fold_constants_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, HoistInvariantCalls) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n"
+        "\n"
+        "\n"
+        "define i32 @len(i8* %s) {\n"
+        "entry:\n"
+        "\n"
+        "\n"
+        "\tbr label %block0\n"
+        "\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp4, %block3 ]\n"
+        "\t%tmp0 = sext i32 %phi.0 to i64\n"
+        "\t%tmp1 = getelementptr i8, i8* %s, i64 %tmp0\n"
+        "\t%tmp2 = load i8, i8* %tmp1\n"
+        "\t%tmp3 = icmp ne i8 %tmp2, 0\n"
+        "\tbr i1 %tmp3, label %block1, label %block2\n"
+        "\n"
+        "block1:\n"
+        "\tbr label %block3\n"
+        "\n"
+        "block3:\n"
+        "\t%tmp4 = add i32 %phi.0, 1\n"
+        "\tbr label %block0\n"
+        "\n"
+        "block2:\n"
+        "\tret i32 %phi.0\n"
+        "}\n"
+        "\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\n"
+        "\t%tmp6 = getelementptr i8*, i8** %argv, i64 0\n"
+        "\t%tmp7 = load i8*, i8** %tmp6\n"
+        "\n"
+        "\n"
+        "\t%tmp8 = call i32 @len(i8* %tmp7)\n"
+        "\tbr label %block5\n"
+        "\n"
+        "block5:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp15, %block8 ]\n"
+        "\t%phi.1 = phi i32 [ 0, %entry ], [ %tmp14, %block8 ]\n"
+        "\t%tmp9 = icmp slt i32 %phi.0, %tmp8\n"
+        "\tbr i1 %tmp9, label %block6, label %block7\n"
+        "\n"
+        "block6:\n"
+        "\t%tmp10 = sext i32 %phi.0 to i64\n"
+        "\t%tmp11 = getelementptr i8, i8* %tmp7, i64 %tmp10\n"
+        "\t%tmp12 = load i8, i8* %tmp11\n"
+        "\t%tmp13 = sext i8 %tmp12 to i32\n"
+        "\t%tmp14 = add i32 %phi.1, %tmp13\n"
+        "\n"
+        "\tbr label %block8\n"
+        "\n"
+        "block8:\n"
+        "\t%tmp15 = add i32 %phi.0, 1\n"
+        "\tbr label %block5\n"
+        "\n"
+        "block7:\n"
+        "\tret i32 %phi.1\n"
+        "}\n"
+        "\n");
+    std::stringstream in(
+        "int len(char *s) {\n"
+        "    int n = 0;\n"
+        "    for (; s[n]; n += 1) {\n"
+        "    }\n"
+        "    return n;\n"
+        "}\n"
+        "\n"
+        "int main(int argc, char **argv) {\n"
+        "    char *s = argv[0];\n"
+        "    int sum = 0;\n"
+        "    for (int i = 0; i < len(s); i += 1) {\n"
+        "        sum += s[i];\n"
+        "    }\n"
+        "    return sum;\n"
+        "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.fold_constants_ = true;
+    options.hoist_invariant_calls_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, InferAttributes) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n"
+        "\n"
+        "\n"
+        "define internal i32 @first(i8* noalias nocapture %s) "
+        "nounwind norecurse readonly {\n"
+        "entry:\n"
+        "\t%s.addr0 = alloca i8*\n"
+        "\tstore i8* %s, i8** %s.addr0\n"
+        "\n"
+        "\t%c.addr1 = alloca i32\n"
+        "\t%tmp1 = load i8*, i8** %s.addr0\n"
+        "\t%tmp2 = getelementptr i8, i8* %tmp1, i64 0\n"
+        "\t%tmp3 = load i8, i8* %tmp2\n"
+        "\t%tmp4 = sext i8 %tmp3 to i32\n"
+        "\tstore i32 %tmp4, i32* %c.addr1\n"
+        "\n"
+        "\t%tmp5 = load i32, i32* %c.addr1\n"
+        "\tret i32 %tmp5\n"
+        "}\n"
+        "\n"
+        "define internal i32 @count(i32 %n) nounwind readnone {\n"
+        "entry:\n"
+        "\t%n.addr2 = alloca i32\n"
+        "\tstore i32 %n, i32* %n.addr2\n"
+        "\n"
+        "\t%tmp6 = load i32, i32* %n.addr2\n"
+        "\t%tmp7 = icmp eq i32 %tmp6, 0\n"
+        "\tbr i1 %tmp7, label %block0, label %block1\n"
+        "\n"
+        "block0:\n"
+        "\tret i32 0\n"
+        "\tbr label %block1\n"
+        "\n"
+        "block1:\n"
+        "\t%tmp8 = load i32, i32* %n.addr2\n"
+        "\t%tmp9 = sub i32 %tmp8, 1\n"
+        "\t%tmp10 = call i32 @count(i32 %tmp9)\n"
+        "\t%tmp11 = add i32 %tmp10, 1\n"
+        "\tret i32 %tmp11\n"
+        "}\n"
+        "\n"
+        "define dso_local i32 @main(i32 %argc, i8** nocapture %argv) "
+        "nounwind norecurse readonly {\n"
+        "entry:\n"
+        "\t%argc.addr3 = alloca i32\n"
+        "\tstore i32 %argc, i32* %argc.addr3\n"
+        "\t%argv.addr4 = alloca i8**\n"
+        "\tstore i8** %argv, i8*** %argv.addr4\n"
+        "\n"
+        "\t%tmp13 = load i8**, i8*** %argv.addr4\n"
+        "\t%tmp14 = getelementptr i8*, i8** %tmp13, i64 0\n"
+        "\t%tmp15 = load i8*, i8** %tmp14\n"
+        "\t%tmp16 = call i32 @first(i8* %tmp15)\n"
+        "\t%tmp17 = load i32, i32* %argc.addr3\n"
+        "\t%tmp18 = call i32 @count(i32 %tmp17)\n"
+        "\t%tmp19 = add i32 %tmp16, %tmp18\n"
+        "\tret i32 %tmp19\n"
+        "}\n"
+        "\n");
+    std::stringstream in(
+        "int first(char *s) {\n"
+        "    int c = s[0];\n"
+        "    return c;\n"
+        "}\n"
+        "\n"
+        "int count(int n) {\n"
+        "    if (n == 0) {\n"
+        "        return 0;\n"
+        "    }\n"
+        "    return count(n - 1) + 1;\n"
+        "}\n"
+        "\n"
+        "int main(int argc, char **argv) {\n"
+        "    return first(argv[0]) + count(argc);\n"
+        "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.internalize_ = true;
+    options.infer_attributes_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, InlineCalls) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n"
+        "\n"
+        "\n"
+        "define i32 @max(i32 %a, i32 %b) {\n"
+        "entry:\n"
+        "\n"
+        "\t%tmp0 = icmp sgt i32 %a, %b\n"
+        "\tbr i1 %tmp0, label %block0, label %block1\n"
+        "\n"
+        "block0:\n"
+        "\tret i32 %a\n"
+        "block2:\n"
+        "\tbr label %block1\n"
+        "\n"
+        "block1:\n"
+        "\t%phi.0 = phi i32 [ %b, %entry ], [ undef, %block2 ]\n"
+        "\tret i32 %phi.0\n"
+        "}\n"
+        "\n"
+        "define i32 @twice(i32 %x) {\n"
+        "entry:\n"
+        "\n"
+        "\t%tmp1 = add i32 %x, %x\n"
+        "\tret i32 %tmp1\n"
+        "}\n"
+        "\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\n"
+        "\t%tmp2 = icmp sgt i32 %argc, 2\n"
+        "\tbr i1 %tmp2, label %block6, label %block7\n"
+        "\n"
+        "block6:\n"
+        "\tbr label %block5\n"
+        "block8:\n"
+        "\tbr label %block7\n"
+        "\n"
+        "block7:\n"
+        "\t%phi.0 = phi i32 [ 2, %entry ], [ undef, %block8 ]\n"
+        "\tbr label %block5\n"
+        "\n"
+        "block5:\n"
+        "\t%phi.1 = phi i32 [ %argc, %block6 ], [ %phi.0, %block7 ]\n"
+        "\t%tmp3 = add i32 %phi.1, %phi.1\n"
+        "\tret i32 %tmp3\n"
+        "}\n"
+        "\n");
+    std::stringstream in(
+        "int max(int a, int b) {\n"
+        "    if (a > b) {\n"
+        "        return a;\n"
+        "    }\n"
+        "    return b;\n"
+        "}\n"
+        "\n"
+        "int twice(int x) {\n"
+        "    return x + x;\n"
+        "}\n"
+        "\n"
+        "int main(int argc, char **argv) {\n"
+        "    return twice(max(argc, 2));\n"
+        "}");
+    std::stringstream out;
+    std::stringstream report;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.inline_threshold_ = 25;
+    options.inline_report_ = &report;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+    EXPECT_EQ(
+        report.str(),
+        "main: inlined max (cost 8)\n"
+        "main: inlined twice (cost 4)\n");
+}
+
+TEST(Generator, DeadFunctions) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n"
+        "\n"
+        "declare i32 @printf(i8*, ...)\n"
+        "\n"
+        "@.str0 = private unnamed_addr constant [6 x i8] c\"main\\0A\\00\"\n"
+        "\n"
+        "define internal i32 @square(i32 %x) nounwind norecurse readnone {\n"
+        "entry:\n"
+        "\t%x.addr0 = alloca i32\n"
+        "\tstore i32 %x, i32* %x.addr0\n"
+        "\n"
+        "\t%tmp0 = load i32, i32* %x.addr0\n"
+        "\t%tmp1 = load i32, i32* %x.addr0\n"
+        "\t%tmp2 = mul i32 %tmp0, %tmp1\n"
+        "\tret i32 %tmp2\n"
+        "}\n"
+        "\n"
+        "define dso_local i32 @api(i32 %x) nounwind norecurse readnone {\n"
+        "entry:\n"
+        "\t%x.addr1 = alloca i32\n"
+        "\tstore i32 %x, i32* %x.addr1\n"
+        "\n"
+        "\t%tmp3 = load i32, i32* %x.addr1\n"
+        "\t%tmp4 = call i32 @square(i32 %tmp3)\n"
+        "\t%tmp5 = add i32 %tmp4, 1\n"
+        "\tret i32 %tmp5\n"
+        "}\n"
+        "\n"
+        "define dso_local i32 @main() nounwind norecurse {\n"
+        "entry:\n"
+        "\n"
+        "\t%tmp6 = call i32 (i8*, ...) @printf(i8* getelementptr ([6 x i8], "
+        "[6 x i8]* @.str0, i64 0, i64 0))\n"
+        "\n"
+        "\tret i32 0\n"
+        "}\n"
+        "\n");
+    std::stringstream in(
+        "#include <stdio.h>\n"
+        "\n"
+        "int unused(int x) {\n"
+        "    printf(\"unused %d\\n\", x);\n"
+        "    return x;\n"
+        "}\n"
+        "\n"
+        "int square(int x) {\n"
+        "    return x * x;\n"
+        "}\n"
+        "\n"
+        "int api(int x) {\n"
+        "    return square(x) + 1;\n"
+        "}\n"
+        "\n"
+        "int main() {\n"
+        "    printf(\"main\\n\");\n"
+        "    return 0;\n"
+        "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    EXPECT_EQ(c::eliminate_dead_functions(parser_result.program_, {"api"}), 1);
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.internalize_ = true;
+    options.infer_attributes_ = true;
+    options.exported_ = {"api"};
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, PoolStrings) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n"
+        "\n"
+        "declare i32 @printf(i8*, ...)\n"
+        "\n"
+        "@.str0 = private unnamed_addr constant [5 x i8] c\"abc\\0A\\00\"\n"
+        "@.str1 = private unnamed_addr constant [5 x i8] c\"x\\09y\\0A\\00\"\n"
+        "\n"
+        "define i32 @main() {\n"
+        "entry:\n"
+        "\n"
+        "\t%s.addr0 = alloca i8*\n"
+        "\tstore i8* getelementptr ([5 x i8], "
+        "[5 x i8]* @.str0, i64 0, i64 0), i8** %s.addr0\n"
+        "\n"
+        "\t%tmp0 = load i8*, i8** %s.addr0\n"
+        "\t%tmp1 = call i32 (i8*, ...) @printf(i8* %tmp0)\n"
+        "\n"
+        "\t%tmp2 = call i32 (i8*, ...) @printf(i8* getelementptr ([5 x i8], "
+        "[5 x i8]* @.str0, i64 0, i64 0))\n"
+        "\n"
+        "\t%tmp3 = call i32 (i8*, ...) @printf(i8* getelementptr ([5 x i8], "
+        "[5 x i8]* @.str0, i64 0, i64 2))\n"
+        "\n"
+        "\t%tmp4 = call i32 (i8*, ...) @printf(i8* getelementptr ([5 x i8], "
+        "[5 x i8]* @.str1, i64 0, i64 0))\n"
+        "\n"
+        "\tret i32 0\n"
+        "}\n"
+        "\n");
+    std::stringstream in(
+        "#include <stdio.h>\n"
+        "int main() {\n"
+        "    char *s = \"abc\\n\";\n"
+        "    printf(s);\n"
+        "    printf(\"abc\\n\");\n"
+        "    printf(\"c\\n\");\n"
+        "    printf(\"x\\ty\\n\");\n"
+        "    return 0;\n"
+        "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::generate(out, parser_result.program_, symtab);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, ConvertReturnValue) {
+    std::stringstream correct("target triple = \"x86_64-pc-linux-gnu\"\n"
+                              "\n"
+                              "\n"
+                              "define i64 @wide(i8 %c) {\n"
+                              "entry:\n"
+                              "\t%c.addr0 = alloca i8\n"
+                              "\tstore i8 %c, i8* %c.addr0\n"
+                              "\n"
+                              "\t%tmp0 = load i8, i8* %c.addr0\n"
+                              "\t%tmp1 = sext i8 %tmp0 to i64\n"
+                              "\tret i64 %tmp1\n"
+                              "}\n"
+                              "\n"
+                              "define i32 @less(i32 %a, i32 %b) {\n"
+                              "entry:\n"
+                              "\t%a.addr1 = alloca i32\n"
+                              "\tstore i32 %a, i32* %a.addr1\n"
+                              "\t%b.addr2 = alloca i32\n"
+                              "\tstore i32 %b, i32* %b.addr2\n"
+                              "\n"
+                              "\t%tmp2 = load i32, i32* %a.addr1\n"
+                              "\t%tmp3 = load i32, i32* %b.addr2\n"
+                              "\t%tmp4 = icmp slt i32 %tmp2, %tmp3\n"
+                              "\t%tmp5 = zext i1 %tmp4 to i32\n"
+                              "\tret i32 %tmp5\n"
+                              "}\n"
+                              "\n"
+                              "define i32 @main() {\n"
+                              "entry:\n"
+                              "\n"
+                              "\tret i32 0\n"
+                              "}\n"
+                              "\n");
+    std::stringstream in("long wide(char c) {\n"
+                         "    return c;\n"
+                         "}\n"
+                         "int less(int a, int b) {\n"
+                         "    return a < b;\n"
+                         "}\n"
+                         "int main() {\n"
+                         "    return 0;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::generate(out, parser_result.program_, symtab);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
+TEST(Generator, SimplifyCfg) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n\n"
+        "\tbr label %block0\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp4, %block5 ]\n"
+        "\t%phi.1 = phi i32 [ 0, %entry ], [ %tmp3, %block5 ]\n"
+        "\t%tmp0 = icmp slt i32 %phi.0, %argc\n"
+        "\tbr i1 %tmp0, label %block1, label %block2\n\n"
+        "block1:\n"
+        "\t%tmp1 = icmp sgt i32 %phi.0, 2\n"
+        "\tbr i1 %tmp1, label %block2, label %block5\n\n"
+        "block5:\n"
+        "\t%tmp3 = add i32 %phi.1, %phi.0\n\n\n"
+        "\t%tmp4 = add i32 %phi.0, 1\n"
+        "\tbr label %block0\n\n"
+        "block2:\n"
+        "\t%tmp5 = icmp sgt i32 %phi.1, 5\n"
+        "\tbr i1 %tmp5, label %block7, label %block8\n\n"
+        "block7:\n"
+        "\tret i32 1\n"
+        "block8:\n"
+        "\tret i32 %phi.1\n"
+        "}\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int sum = 0;\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        if (i > 2) {\n"
+                         "            break;\n"
+                         "            sum += 10;\n"
+                         "        }\n"
+                         "        sum += i;\n"
+                         "    }\n"
+                         "    if (sum > 5) {\n"
+                         "        return 1;\n"
+                         "    }\n"
+                         "    return sum;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.simplify_cfg_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, RotateLoops) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n\n"
+        "\t%tmp0 = icmp slt i32 0, %argc\n"
+        "\tbr i1 %tmp0, label %block0, label %block1\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp1, %block0 ]\n"
+        "\t%phi.1 = phi i32 [ 0, %entry ], [ %tmp2, %block0 ]\n"
+        "\t%tmp1 = add i32 %phi.0, %phi.1\n\n\n"
+        "\t%tmp2 = add i32 %phi.1, 1\n"
+        "\t%tmp3 = icmp slt i32 %tmp2, %argc\n"
+        "\tbr i1 %tmp3, label %block0, label %block1, !llvm.loop !1\n\n"
+        "block1:\n"
+        "\t%phi.2 = phi i32 [ 0, %entry ], [ %tmp1, %block0 ]\n\n"
+        "\tret i32 %phi.2\n"
+        "}\n\n"
+        "!0 = !{!\"llvm.loop.mustprogress\"}\n"
+        "!1 = distinct !{!1, !0}\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int sum = 0;\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        sum += i;\n"
+                         "    }\n"
+                         "    for (;;) {\n"
+                         "        break;\n"
+                         "    }\n"
+                         "    return sum;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.simplify_cfg_ = true;
+    options.rotate_loops_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, HoistAllocas) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\t%a.addr0 = alloca i32, i64 4\n"
+        "\t%tmp2 = bitcast i32* %a.addr0 to i8*\n\n"
+        "\tbr label %block0\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp6, %block5 ]\n"
+        "\t%tmp0 = icmp slt i32 %phi.0, %argc\n"
+        "\tbr i1 %tmp0, label %block1, label %block2\n\n"
+        "block1:\n"
+        "\tcall void @llvm.lifetime.start.p0i8(i64 16, i8* %tmp2)\n\n"
+        "\t%tmp3 = sext i32 %argc to i64\n"
+        "\t%tmp4 = call i8* @llvm.stacksave()\n"
+        "\t%b.addr1 = alloca i32, i64 %tmp3\n\n"
+        "\t%tmp5 = icmp sgt i32 %phi.0, 2\n"
+        "\tbr i1 %tmp5, label %block4, label %block5\n\n"
+        "block4:\n"
+        "\tcall void @llvm.stackrestore(i8* %tmp4)\n"
+        "\tcall void @llvm.lifetime.end.p0i8(i64 16, i8* %tmp2)\n"
+        "\tbr label %block2\n"
+        "block5:\n"
+        "\tcall void @llvm.stackrestore(i8* %tmp4)\n"
+        "\tcall void @llvm.lifetime.end.p0i8(i64 16, i8* %tmp2)\n\n"
+        "\t%tmp6 = add i32 %phi.0, 1\n"
+        "\tbr label %block0\n\n"
+        "block2:\n"
+        "\tret i32 0\n"
+        "}\n\n"
+        "declare void @llvm.lifetime.start.p0i8(i64 immarg, i8* nocapture)\n"
+        "declare void @llvm.lifetime.end.p0i8(i64 immarg, i8* nocapture)\n"
+        "declare i8* @llvm.stacksave()\n"
+        "declare void @llvm.stackrestore(i8*)\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        int a[4];\n"
+                         "        int b[argc];\n"
+                         "        if (i > 2) {\n"
+                         "            break;\n"
+                         "        }\n"
+                         "    }\n"
+                         "    return 0;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.simplify_cfg_ = true;
+    options.hoist_allocas_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, OptimizeIndexing) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n\n"
+        "\tbr label %block0\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 1, %entry ], [ %tmp13, %block3 ]\n"
+        "\t%phi.1 = phi i64 [ 1, %entry ], [ %tmp14, %block3 ]\n"
+        "\t%phi.2 = phi i32 [ 0, %entry ], [ %tmp12, %block3 ]\n"
+        "\t%tmp1 = icmp slt i32 %phi.0, %argc\n"
+        "\tbr i1 %tmp1, label %block1, label %block2\n\n"
+        "block1:\n"
+        "\t%tmp2 = getelementptr inbounds i8*, i8** %argv, i64 %phi.1\n"
+        "\t%tmp3 = load i8*, i8** %tmp2\n\n"
+        "\t%tmp5 = getelementptr inbounds i8, i8* %tmp3, i64 0\n"
+        "\t%tmp6 = load i8, i8* %tmp5\n"
+        "\t%tmp8 = getelementptr inbounds i8, i8* %tmp3, i64 1\n"
+        "\t%tmp9 = load i8, i8* %tmp8\n"
+        "\t%tmp10 = add i8 %tmp6, %tmp9\n"
+        "\t%tmp11 = sext i8 %tmp10 to i32\n"
+        "\t%tmp12 = add i32 %phi.2, %tmp11\n\n"
+        "\tbr label %block3\n\n"
+        "block3:\n"
+        "\t%tmp13 = add i32 %phi.0, 1\n"
+        "\t%tmp14 = add nsw i64 %phi.1, 1\n"
+        "\tbr label %block0\n\n"
+        "block2:\n"
+        "\tret i32 %phi.2\n"
+        "}\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int count = 0;\n"
+                         "    for (int i = 1; i < argc; i += 1) {\n"
+                         "        char *arg = argv[i];\n"
+                         "        count += arg[0] + arg[1];\n"
+                         "    }\n"
+                         "    return count;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.optimize_indexing_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, NumberValues) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\t%argc.addr0 = alloca i32\n"
+        "\tstore i32 %argc, i32* %argc.addr0\n"
+        "\t%argv.addr1 = alloca i8**\n"
+        "\tstore i8** %argv, i8*** %argv.addr1\n\n"
+        "\t%a.addr2 = alloca i32, i64 4\n\n"
+        "\t%x.addr3 = alloca i32\n"
+        "\t%tmp1 = add i32 %argc, 1\n"
+        "\tstore i32 %tmp1, i32* %x.addr3\n\n"
+        "\t%tmp2 = sext i32 %tmp1 to i64\n"
+        "\t%tmp3 = getelementptr i32, i32* %a.addr2, i64 %tmp2\n"
+        "\t%tmp4 = load i32, i32* %tmp3\n"
+        "\t%tmp5 = mul i32 %argc, %tmp1\n"
+        "\tstore i32 %tmp5, i32* %tmp3\n\n"
+        "\t%y.addr4 = alloca i32\n"
+        "\t%tmp7 = add i32 %tmp5, %tmp5\n"
+        "\tstore i32 %tmp7, i32* %y.addr4\n\n"
+        "\t%tmp9 = getelementptr i32, i32* %a.addr2, i64 0\n"
+        "\t%tmp10 = load i32, i32* %tmp9\n"
+        "\tstore i32 %tmp7, i32* %tmp9\n\n"
+        "\t%tmp12 = load i32, i32* %tmp3\n"
+        "\t%tmp13 = add i32 %tmp12, %tmp7\n"
+        "\tret i32 %tmp13\n"
+        "}\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    int a[4];\n"
+                         "    int x = argc + 1;\n"
+                         "    a[x] = argc * x;\n"
+                         "    int y = argc * x + a[x];\n"
+                         "    a[0] = y;\n"
+                         "    return a[x] + y;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.number_values_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, ReduceStrength) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @f(i32 %x) {\n"
+        "entry:\n\n"
+        "\t%tmp0 = shl i32 %x, 3\n"
+        "\t%tmp1 = ashr i32 %x, 31\n"
+        "\t%tmp2 = lshr i32 %tmp1, 30\n"
+        "\t%tmp3 = add i32 %x, %tmp2\n"
+        "\t%tmp4 = ashr i32 %tmp3, 2\n"
+        "\t%tmp5 = add i32 %tmp0, %tmp4\n"
+        "\t%tmp6 = ashr i32 %x, 31\n"
+        "\t%tmp7 = lshr i32 %tmp6, 28\n"
+        "\t%tmp8 = add i32 %x, %tmp7\n"
+        "\t%tmp9 = and i32 %tmp8, -16\n"
+        "\t%tmp10 = sub i32 %x, %tmp9\n"
+        "\t%tmp11 = add i32 %tmp5, %tmp10\n"
+        "\t%tmp12 = sext i32 %x to i64\n"
+        "\t%tmp13 = mul i64 %tmp12, -1840700269\n"
+        "\t%tmp14 = ashr i64 %tmp13, 32\n"
+        "\t%tmp15 = trunc i64 %tmp14 to i32\n"
+        "\t%tmp16 = add i32 %tmp15, %x\n"
+        "\t%tmp17 = ashr i32 %tmp16, 2\n"
+        "\t%tmp18 = lshr i32 %tmp17, 31\n"
+        "\t%tmp19 = add i32 %tmp17, %tmp18\n"
+        "\t%tmp20 = add i32 %tmp11, %tmp19\n"
+        "\t%tmp21 = add i32 %tmp20, %x\n"
+        "\tret i32 %tmp21\n"
+        "}\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n"
+        "\t%tmp22 = call i32 @f(i32 %argc)\n"
+        "\tret i32 %tmp22\n"
+        "}\n\n");
+    std::stringstream in(
+        "int f(int x) {\n"
+        "    return x * 8 + x / 4 + x % 16 + x / 7 + 1 * x - 0;\n"
+        "}\n\n"
+        "int main(int argc, char **argv) {\n"
+        "    return f(argc);\n"
+        "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.reduce_strength_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, BranchWeights) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n\n"
+        "\t%tmp0 = icmp sgt i32 %argc, 1\n"
+        "\t%tmp1 = zext i1 %tmp0 to i64\n"
+        "\t%tmp3 = call i64 @llvm.expect.i64(i64 %tmp1, i64 1)\n"
+        "\t%tmp4 = icmp ne i64 %tmp3, 0\n"
+        "\tbr i1 %tmp4, label %block0, label %block1, !prof !0\n\n"
+        "block0:\n"
+        "\t%tmp5 = sub i32 %argc, 1\n\n"
+        "\tbr label %block1\n\n"
+        "block1:\n"
+        "\t%phi.1 = phi i32 [ %argc, %entry ], [ %tmp5, %block0 ]\n\n"
+        "\tbr label %block2\n\n"
+        "block2:\n"
+        "\t%phi.0 = phi i32 [ 0, %block1 ], [ %tmp9, %block5 ]\n"
+        "\t%phi.3 = phi i32 [ 0, %block1 ], [ %tmp8, %block5 ]\n"
+        "\t%tmp6 = icmp slt i32 %phi.0, %phi.1\n"
+        "\tbr i1 %tmp6, label %block3, label %block4, !prof !1\n\n"
+        "block3:\n"
+        "\t%tmp7 = icmp eq i32 %phi.0, 7\n"
+        "\tbr i1 %tmp7, label %block6, label %block7, !prof !2\n\n"
+        "block6:\n"
+        "\tret i32 1\n"
+        "block8:\n"
+        "\tbr label %block7\n\n"
+        "block7:\n"
+        "\t%phi.2 = phi i32 [ %phi.3, %block3 ], [ undef, %block8 ]\n"
+        "\t%phi.4 = phi i32 [ %phi.0, %block3 ], [ undef, %block8 ]\n"
+        "\t%tmp8 = add i32 %phi.2, %phi.4\n\n"
+        "\tbr label %block5\n\n"
+        "block5:\n"
+        "\t%tmp9 = add i32 %phi.4, 1\n"
+        "\tbr label %block2\n\n"
+        "block4:\n"
+        "\tret i32 %phi.3\n"
+        "}\n\n"
+        "declare i64 @llvm.expect.i64(i64, i64)\n\n"
+        "!0 = !{!\"branch_weights\", i32 2000, i32 1}\n"
+        "!1 = !{!\"branch_weights\", i32 124, i32 4}\n"
+        "!2 = !{!\"branch_weights\", i32 4, i32 124}\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    if (__builtin_expect(argc > 1, 1)) {\n"
+                         "        argc = argc - 1;\n"
+                         "    }\n"
+                         "    int sum = 0;\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        if (i == 7) {\n"
+                         "            return 1;\n"
+                         "        }\n"
+                         "        sum += i;\n"
+                         "    }\n"
+                         "    return sum;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.branch_weights_ = true;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, ProfileGenerate) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\t%argc.addr0 = alloca i32\n"
+        "\tstore i32 %argc, i32* %argc.addr0\n"
+        "\t%argv.addr1 = alloca i8**\n"
+        "\tstore i8** %argv, i8*** %argv.addr1\n"
+        "\t%tmp0 = load i64, i64* @__prof.main.0\n"
+        "\t%tmp1 = add i64 %tmp0, 1\n"
+        "\tstore i64 %tmp1, i64* @__prof.main.0\n\n"
+        "\t%tmp2 = load i32, i32* %argc.addr0\n"
+        "\t%tmp3 = icmp sgt i32 %tmp2, 1\n"
+        "\t%tmp4 = load i64, i64* @__prof.main.1\n"
+        "\t%tmp5 = add i64 %tmp4, 1\n"
+        "\tstore i64 %tmp5, i64* @__prof.main.1\n"
+        "\tbr i1 %tmp3, label %block0, label %block1\n\n"
+        "block0:\n"
+        "\t%tmp6 = load i64, i64* @__prof.main.2\n"
+        "\t%tmp7 = add i64 %tmp6, 1\n"
+        "\tstore i64 %tmp7, i64* @__prof.main.2\n"
+        "\tret i32 1\n"
+        "\tbr label %block1\n\n"
+        "block1:\n"
+        "\tret i32 0\n"
+        "}\n\n"
+        "@__prof.main.0 = internal global i64 0\n"
+        "@__prof.main.1 = internal global i64 0\n"
+        "@__prof.main.2 = internal global i64 0\n"
+        "@__prof.path = private unnamed_addr constant [10 x i8] "
+        "c\"main.prof\\00\"\n"
+        "@__prof.mode = private unnamed_addr constant [2 x i8] c\"a\\00\"\n"
+        "@__prof.format.main = private unnamed_addr constant [18 x i8] c\"main "
+        "%lu %lu %lu\\0A\\00\"\n\n"
+        "declare i8* @fopen(i8*, i8*)\n"
+        "declare i32 @fprintf(i8*, i8*, ...)\n"
+        "declare i32 @fclose(i8*)\n\n"
+        "define internal void @__prof.write() {\n"
+        "entry:\n"
+        "\t%file = call i8* @fopen(i8* getelementptr ([10 x i8], [10 x i8]* "
+        "@__prof.path, i64 0, i64 0), i8* getelementptr ([2 x i8], [2 x i8]* "
+        "@__prof.mode, i64 0, i64 0))\n"
+        "\t%is_null = icmp eq i8* %file, null\n"
+        "\tbr i1 %is_null, label %exit, label %write\n\n"
+        "write:\n"
+        "\t%main.0 = load i64, i64* @__prof.main.0\n"
+        "\t%main.1 = load i64, i64* @__prof.main.1\n"
+        "\t%main.2 = load i64, i64* @__prof.main.2\n"
+        "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* getelementptr ([18 "
+        "x i8], [18 x i8]* @__prof.format.main, i64 0, i64 0), i64 %main.0, "
+        "i64 %main.1, i64 %main.2)\n"
+        "\tcall i32 @fclose(i8* %file)\n"
+        "\tbr label %exit\n\n"
+        "exit:\n"
+        "\tret void\n"
+        "}\n\n"
+        "@llvm.global_dtors = appending global [1 x { i32, void ()*, i8* }] [{ "
+        "i32, void ()*, i8* } { i32 65535, void ()* @__prof.write, i8* null "
+        "}]\n\n");
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    if (argc > 1) {\n"
+                         "        return 1;\n"
+                         "    }\n"
+                         "    return 0;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.profile_generate_ = "main.prof";
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, ProfileUse) {
+    const c::Profile profile = {
+        {"twice", {0}}, {"main", {1, 4, 3, 0, 0, 3, 0}}};
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @twice(i32 %x) cold !prof !0 {\n"
+        "entry:\n\n"
+        "\t%tmp0 = add i32 %x, %x\n"
+        "\tret i32 %tmp0\n"
+        "}\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) hot !prof !1 {\n"
+        "entry:\n\n\n"
+        "\tbr label %block1\n\n"
+        "block1:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp4, %block4 ]\n"
+        "\t%phi.2 = phi i32 [ 0, %entry ], [ %tmp3, %block4 ]\n"
+        "\t%tmp1 = icmp slt i32 %phi.0, %argc\n"
+        "\tbr i1 %tmp1, label %block2, label %block3, !prof !2\n\n"
+        "block2:\n"
+        "\t%tmp2 = icmp eq i32 %phi.0, 7\n"
+        "\tbr i1 %tmp2, label %block5, label %block6, !prof !3\n\n"
+        "block5:\n"
+        "\tret i32 1\n"
+        "block7:\n"
+        "\tbr label %block6\n\n"
+        "block6:\n"
+        "\t%phi.1 = phi i32 [ %phi.2, %block2 ], [ undef, %block7 ]\n"
+        "\t%phi.3 = phi i32 [ %phi.0, %block2 ], [ undef, %block7 ]\n"
+        "\t%tmp3 = add i32 %phi.1, %phi.3\n\n"
+        "\tbr label %block4\n\n"
+        "block4:\n"
+        "\t%tmp4 = add i32 %phi.3, 1\n"
+        "\tbr label %block1\n\n"
+        "block3:\n"
+        "\tret i32 %phi.2\n"
+        "}\n\n"
+        "!0 = !{!\"function_entry_count\", i64 0}\n"
+        "!1 = !{!\"function_entry_count\", i64 1}\n"
+        "!2 = !{!\"branch_weights\", i32 3, i32 1}\n"
+        "!3 = !{!\"branch_weights\", i32 0, i32 3}\n");
+    std::stringstream in("int twice(int x) {\n"
+                         "    return x + x;\n"
+                         "}\n"
+                         "\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    int sum = 0;\n"
+                         "    for (int i = 0; i < argc; i += 1) {\n"
+                         "        if (i == 7) {\n"
+                         "            return 1;\n"
+                         "        }\n"
+                         "        sum += i;\n"
+                         "    }\n"
+                         "    return sum;\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.profile_use_ = &profile;
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+
+    // The guard of a rotated loop has counts of its own, the loop entered
+    // once runs 1000 times
+    const c::Profile rotated_profile = {{"main", {1, 1001, 1000, 1, 1}}};
+    std::stringstream rotated_correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) hot !prof !0 {\n"
+        "entry:\n\n\n"
+        "\t%tmp0 = icmp slt i32 0, %argc\n"
+        "\tbr i1 %tmp0, label %block0, label %block1, !prof !1\n\n"
+        "block0:\n"
+        "\t%phi.0 = phi i32 [ 0, %entry ], [ %tmp1, %block0 ]\n"
+        "\t%phi.1 = phi i32 [ 0, %entry ], [ %tmp2, %block0 ]\n"
+        "\t%tmp1 = add i32 %phi.0, %phi.1\n\n\n"
+        "\t%tmp2 = add i32 %phi.1, 1\n"
+        "\t%tmp3 = icmp slt i32 %tmp2, %argc\n"
+        "\tbr i1 %tmp3, label %block0, label %block1, !prof !4, "
+        "!llvm.loop !3\n\n"
+        "block1:\n"
+        "\t%phi.2 = phi i32 [ 0, %entry ], [ %tmp1, %block0 ]\n"
+        "\tret i32 %phi.2\n"
+        "}\n\n"
+        "!0 = !{!\"function_entry_count\", i64 1}\n"
+        "!1 = !{!\"branch_weights\", i32 1, i32 0}\n"
+        "!2 = !{!\"llvm.loop.mustprogress\"}\n"
+        "!3 = distinct !{!3, !2}\n"
+        "!4 = !{!\"branch_weights\", i32 999, i32 1}\n");
+    std::stringstream rotated_in("int main(int argc, char **argv) {\n"
+                                 "    int sum = 0;\n"
+                                 "    for (int i = 0; i < argc; i += 1) {\n"
+                                 "        sum += i;\n"
+                                 "    }\n"
+                                 "    return sum;\n"
+                                 "}");
+    std::stringstream rotated_out;
+
+    auto rotated_result = c::parse(rotated_in);
+    if (!rotated_result.errors_.empty()) {
+        FAIL();
+    }
+
+    ASSERT_NO_THROW({ symtab = c::get_symtab(rotated_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(rotated_result.program_, symtab); });
+
+    options.simplify_cfg_ = true;
+    options.rotate_loops_ = true;
+    options.profile_use_ = &rotated_profile;
+    c::generate(rotated_out, rotated_result.program_, symtab, options);
+
+    EXPECT_STREQ(rotated_out.str().c_str(), rotated_correct.str().c_str());
+}
+
+TEST(Generator, InstrumentFunctions) {
+    std::stringstream correct(
+        "target triple = \"x86_64-pc-linux-gnu\"\n\n\n"
+        "define i32 @twice(i32 %x) {\n"
+        "entry:\n"
+        "\t%tmp0 = call i64 @__instr.enter(i64 0)\n\n"
+        "\t%tmp1 = add i32 %x, %x\n"
+        "\tcall void @__instr.exit(i64 0, i64 %tmp0)\n"
+        "\tret i32 %tmp1\n"
+        "}\n\n"
+        "define i32 @main(i32 %argc, i8** %argv) {\n"
+        "entry:\n"
+        "\t%tmp2 = call i64 @__instr.enter(i64 1)\n\n"
+        "\t%tmp3 = call i32 @twice(i32 %argc)\n"
+        "\tcall void @__instr.exit(i64 1, i64 %tmp2)\n"
+        "\tret i32 %tmp3\n"
+        "}\n\n"
+        "@__instr.calls = internal global [2 x i64] zeroinitializer\n"
+        "@__instr.cycles = internal global [2 x i64] zeroinitializer\n"
+        "@__instr.depths = internal global [2 x i64] zeroinitializer\n"
+        "@__instr.path = private unnamed_addr constant [15 x i8] "
+        "c\"functions.prof\\00\"\n"
+        "@__instr.mode = private unnamed_addr constant [2 x i8] c\"w\\00\"\n"
+        "@__instr.header = private unnamed_addr constant [56 x i8] c\"     "
+        "%%time       cycles      calls  cycles/call  name\\0A\\00\"\n"
+        "@__instr.format.twice = private unnamed_addr constant [33 x i8] "
+        "c\"%10.2f %12lu %10lu %12lu  twice\\0A\\00\"\n"
+        "@__instr.format.main = private unnamed_addr constant [32 x i8] "
+        "c\"%10.2f %12lu %10lu %12lu  main\\0A\\00\"\n\n"
+        "declare i64 @llvm.readcyclecounter()\n"
+        "declare i8* @fopen(i8*, i8*)\n"
+        "declare i32 @fprintf(i8*, i8*, ...)\n"
+        "declare i32 @fclose(i8*)\n\n"
+        "define internal i64 @__instr.enter(i64 %func) alwaysinline nounwind "
+        "{\n"
+        "entry:\n"
+        "\t%depth = getelementptr [2 x i64], [2 x i64]* @__instr.depths, i64 "
+        "0, i64 %func\n"
+        "\t%outer = load i64, i64* %depth\n"
+        "\t%inner = add i64 %outer, 1\n"
+        "\tstore i64 %inner, i64* %depth\n"
+        "\t%start = call i64 @llvm.readcyclecounter()\n"
+        "\tret i64 %start\n"
+        "}\n\n"
+        "define internal void @__instr.exit(i64 %func, i64 %start) "
+        "alwaysinline nounwind {\n"
+        "entry:\n"
+        "\t%end = call i64 @llvm.readcyclecounter()\n"
+        "\t%calls = getelementptr [2 x i64], [2 x i64]* @__instr.calls, i64 0, "
+        "i64 %func\n"
+        "\t%count = load i64, i64* %calls\n"
+        "\t%next = add i64 %count, 1\n"
+        "\tstore i64 %next, i64* %calls\n"
+        "\t%depth = getelementptr [2 x i64], [2 x i64]* @__instr.depths, i64 "
+        "0, i64 %func\n"
+        "\t%inner = load i64, i64* %depth\n"
+        "\t%outer = sub i64 %inner, 1\n"
+        "\tstore i64 %outer, i64* %depth\n"
+        "\t%is_outermost = icmp eq i64 %outer, 0\n"
+        "\tbr i1 %is_outermost, label %time, label %exit\n\n"
+        "time:\n"
+        "\t%cycles = getelementptr [2 x i64], [2 x i64]* @__instr.cycles, i64 "
+        "0, i64 %func\n"
+        "\t%total = load i64, i64* %cycles\n"
+        "\t%elapsed = sub i64 %end, %start\n"
+        "\t%sum = add i64 %total, %elapsed\n"
+        "\tstore i64 %sum, i64* %cycles\n"
+        "\tbr label %exit\n\n"
+        "exit:\n"
+        "\tret void\n"
+        "}\n\n"
+        "define internal void @__instr.write() {\n"
+        "entry:\n"
+        "\t%file = call i8* @fopen(i8* getelementptr ([15 x i8], [15 x i8]* "
+        "@__instr.path, i64 0, i64 0), i8* getelementptr ([2 x i8], [2 x i8]* "
+        "@__instr.mode, i64 0, i64 0))\n"
+        "\t%is_null = icmp eq i8* %file, null\n"
+        "\tbr i1 %is_null, label %exit, label %write\n\n"
+        "write:\n"
+        "\t%cycles.0 = load i64, i64* getelementptr ([2 x i64], [2 x i64]* "
+        "@__instr.cycles, i64 0, i64 0)\n"
+        "\t%calls.0 = load i64, i64* getelementptr ([2 x i64], [2 x i64]* "
+        "@__instr.calls, i64 0, i64 0)\n"
+        "\t%is_longer.0 = icmp ugt i64 %cycles.0, 1\n"
+        "\t%longest.0 = select i1 %is_longer.0, i64 %cycles.0, i64 1\n"
+        "\t%cycles.1 = load i64, i64* getelementptr ([2 x i64], [2 x i64]* "
+        "@__instr.cycles, i64 0, i64 1)\n"
+        "\t%calls.1 = load i64, i64* getelementptr ([2 x i64], [2 x i64]* "
+        "@__instr.calls, i64 0, i64 1)\n"
+        "\t%is_longer.1 = icmp ugt i64 %cycles.1, %longest.0\n"
+        "\t%longest.1 = select i1 %is_longer.1, i64 %cycles.1, i64 %longest.0\n"
+        "\t%longest = uitofp i64 %longest.1 to double\n"
+        "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* getelementptr ([56 "
+        "x i8], [56 x i8]* @__instr.header, i64 0, i64 0))\n"
+        "\t%cycles.f.0 = uitofp i64 %cycles.0 to double\n"
+        "\t%percent.0 = fmul double %cycles.f.0, 100.0\n"
+        "\t%share.0 = fdiv double %percent.0, %longest\n"
+        "\t%is_called.0 = icmp ne i64 %calls.0, 0\n"
+        "\t%divisor.0 = select i1 %is_called.0, i64 %calls.0, i64 1\n"
+        "\t%per_call.0 = udiv i64 %cycles.0, %divisor.0\n"
+        "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* getelementptr ([33 "
+        "x i8], [33 x i8]* @__instr.format.twice, i64 0, i64 0), double "
+        "%share.0, i64 %cycles.0, i64 %calls.0, i64 %per_call.0)\n"
+        "\t%cycles.f.1 = uitofp i64 %cycles.1 to double\n"
+        "\t%percent.1 = fmul double %cycles.f.1, 100.0\n"
+        "\t%share.1 = fdiv double %percent.1, %longest\n"
+        "\t%is_called.1 = icmp ne i64 %calls.1, 0\n"
+        "\t%divisor.1 = select i1 %is_called.1, i64 %calls.1, i64 1\n"
+        "\t%per_call.1 = udiv i64 %cycles.1, %divisor.1\n"
+        "\tcall i32 (i8*, i8*, ...) @fprintf(i8* %file, i8* getelementptr ([32 "
+        "x i8], [32 x i8]* @__instr.format.main, i64 0, i64 0), double "
+        "%share.1, i64 %cycles.1, i64 %calls.1, i64 %per_call.1)\n"
+        "\tcall i32 @fclose(i8* %file)\n"
+        "\tbr label %exit\n\n"
+        "exit:\n"
+        "\tret void\n"
+        "}\n\n"
+        "@llvm.global_dtors = appending global [1 x { i32, void ()*, i8* }] [{ "
+        "i32, void ()*, i8* } { i32 65535, void ()* @__instr.write, i8* null "
+        "}]\n\n");
+    std::stringstream in("int twice(int x) {\n"
+                         "    return x + x;\n"
+                         "}\n"
+                         "\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    return twice(argc);\n"
+                         "}");
+    std::stringstream out;
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    c::ast::CodeGenOptions options;
+    options.promote_scalars_ = true;
+    options.instrument_functions_ = "functions.prof";
+    c::generate(out, parser_result.program_, symtab, options);
+
+    EXPECT_STREQ(out.str().c_str(), correct.str().c_str());
+}
+
+TEST(Generator, CountInstructions) {
+    std::stringstream in("int main(int argc, char **argv) {\n"
+                         "    if (argc > 1) {\n"
+                         "        return 1;\n"
+                         "    }\n"
+                         "    return 0;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    // The jump out of the if after the return is unreachable
+    for (bool promote_scalars : {false, true}) {
+        c::ast::CodeGenOptions options;
+        options.promote_scalars_ = promote_scalars;
+        c::TimeReport report;
+        std::stringstream out;
+        c::generate(out, parser_result.program_, symtab, options, &report);
+
+        std::stringstream json;
+        report.print_json(json);
+        const auto count = promote_scalars ? "\"ir instructions\": 4"
+                                           : "\"ir instructions\": 9";
+        EXPECT_NE(json.str().find(count), std::string::npos) << json.str();
+    }
+}
\ No newline at end of file
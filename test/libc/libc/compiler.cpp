@@ -0,0 +1,30 @@
+#include <gtest/gtest.h>
+
+#include <libc/source_dir.hpp>
+
+#include <sys/wait.h>
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+// The exit code of the compiler, -1 if it didn't exit normally
+int compile(const std::string &args) {
+    const auto command = (c_binary_dir / "c-compiler").string() + " " +
+        (c_source_dir / "test-additional-files/compiler-test/type_error.c")
+            .string() +
+        " " + args + " > /dev/null 2>&1";
+    const int status = std::system(command.c_str());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+} // namespace
+
+TEST(Compiler, TypeErrorStopsCompilation) {
+    EXPECT_EQ(compile("--dump-asm"), 1);
+    EXPECT_EQ(compile("-O --dump-asm"), 1);
+    EXPECT_EQ(compile("--backend x86-64 --dump-asm"), 1);
+    EXPECT_EQ(compile("--backend bytecode --run"), 1);
+    EXPECT_EQ(compile("--run"), 1);
+}
\ No newline at end of file
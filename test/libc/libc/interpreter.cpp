@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/interpreter.hpp>
+#include <libc/parser.hpp>
+#include <libc/symtab.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+TEST(Interpreter, ReturnsExitCode) {
+    std::stringstream in("long sum(int size) {\n"
+                         "    long result = 0;\n"
+                         "    for (int i = 0; i < size; i += 1) {\n"
+                         "        result += i * 3;\n"
+                         "    }\n"
+                         "    return result;\n"
+                         "}\n\n"
+                         "double half(double x) {\n"
+                         "    return x / 2;\n"
+                         "}\n\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    int array[4];\n"
+                         "    for (int i = 0; i < 4; i += 1) {\n"
+                         "        array[i] = sum(i);\n"
+                         "    }\n"
+                         "    int result = half(array[3]);\n"
+                         "    return result;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    EXPECT_EQ(c::interpret(parser_result.program_, symtab, {"program"}), 4);
+}
+
+TEST(Interpreter, PrintsArguments) {
+    std::stringstream in("#include <stdio.h>\n\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    char *arg = argv[argc - 1];\n"
+                         "    int length = 0;\n"
+                         "    for (int i = 0; arg[i] != 0; i += 1) {\n"
+                         "        length += 1;\n"
+                         "    }\n"
+                         "    float ratio = length;\n"
+                         "    char last = arg[length - 1];\n"
+                         "    long scale = 1000000;\n"
+                         "    printf(\"%s %c %5.2f %ld%%\\n\", arg, last, "
+                         "ratio / 4, length * scale * scale);\n"
+                         "    return argc * 10 + length;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    auto *out = std::tmpfile();
+    ASSERT_NE(out, nullptr);
+    EXPECT_EQ(
+        c::interpret(
+            parser_result.program_, symtab, {"program", "a", "hello"}, out),
+        35);
+
+    std::rewind(out);
+    std::string output(64, '\0');
+    output.resize(std::fread(output.data(), 1, output.size(), out));
+    std::fclose(out);
+    EXPECT_EQ(output, "hello o  1.25 5000000000000%\n");
+}
+
+TEST(Interpreter, ComparesAndBranchesAtOnce) {
+    std::stringstream in("int main() {\n"
+                         "    int count = 0;\n"
+                         "    for (int i = 0; i < 100; i += 1) {\n"
+                         "        if (i % 3 == 0) {\n"
+                         "            count += 1;\n"
+                         "        }\n"
+                         "    }\n"
+                         "    return count;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    std::stringstream listing;
+    c::dump_bytecode(listing, parser_result.program_, symtab);
+    EXPECT_NE(listing.str().find("jlti_i64"), std::string::npos);
+    EXPECT_NE(listing.str().find("jnei_i64"), std::string::npos);
+    EXPECT_NE(listing.str().find("addi_i32"), std::string::npos);
+
+    EXPECT_EQ(c::interpret(parser_result.program_, symtab, {"program"}), 34);
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/jit.hpp>
+#include <libc/parser.hpp>
+#include <libc/symtab.hpp>
+
+#include <sstream>
+
+TEST(Jit, ReturnsExitCode) {
+    std::stringstream in("long sum(int size) {\n"
+                         "    long result = 0;\n"
+                         "    for (int i = 0; i < size; i += 1) {\n"
+                         "        result += i * 3;\n"
+                         "    }\n"
+                         "    return result;\n"
+                         "}\n\n"
+                         "double half(double x) {\n"
+                         "    return x / 2;\n"
+                         "}\n\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    int array[4];\n"
+                         "    for (int i = 0; i < 4; i += 1) {\n"
+                         "        array[i] = sum(i);\n"
+                         "    }\n"
+                         "    int result = half(array[3]);\n"
+                         "    return result;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    EXPECT_EQ(c::run(parser_result.program_, symtab, {"program"}), 4);
+}
+
+TEST(Jit, PassesArguments) {
+    std::stringstream in("#include <stdio.h>\n\n"
+                         "int main(int argc, char **argv) {\n"
+                         "    char *arg = argv[argc - 1];\n"
+                         "    int length = 0;\n"
+                         "    for (int i = 0; arg[i] != 0; i += 1) {\n"
+                         "        length += 1;\n"
+                         "    }\n"
+                         "    printf(\"%s\\n\", arg);\n"
+                         "    return argc * 10 + length;\n"
+                         "}");
+
+    auto parser_result = c::parse(in);
+    if (!parser_result.errors_.empty()) {
+        FAIL();
+    }
+
+    c::ast::symtab::Symtab symtab;
+    ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); });
+
+    ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); });
+
+    EXPECT_EQ(
+        c::run(parser_result.program_, symtab, {"program", "a", "hello"}), 35);
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#include <gtest/gtest.h>
+
+#include <libc/profile.hpp>
+
+#include <sstream>
+#include <stdexcept>
+
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+TEST(Profile, SumsTheRuns) {
+    std::istringstream in(
+        "main 1 10 9\n"
+        "sum 9 0 0\n"
+        "\n"
+        "main 1 4 3\n"
+        "sum 3 0 0\n");
+    const auto profile = c::read_profile(in);
+
+    ASSERT_EQ(profile.size(), 2);
+    EXPECT_EQ(profile.at("main"), (std::vector<std::uint64_t>{2, 14, 12}));
+    EXPECT_EQ(profile.at("sum"), (std::vector<std::uint64_t>{12, 0, 0}));
+}
+
+TEST(Profile, MalformedLines) {
+    std::istringstream no_counts("main 1 2 1\nsum\n");
+    EXPECT_THROW(c::read_profile(no_counts), std::runtime_error);
+
+    std::istringstream not_count("main 1 x 1\n");
+    EXPECT_THROW(c::read_profile(not_count), std::runtime_error);
+
+    std::istringstream other_size("main 1 2 1\nmain 1\n");
+    EXPECT_THROW(c::read_profile(other_size), std::runtime_error);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
\ No newline at end of file
@@ -117,4 +117,20 @@ TEST(Symtab, SymbolRedefinition) {
     }
 }
 
+TEST(Symtab, CollidingNames) {
+    // "x" and "func16" have the same hash code
+    std::istringstream in("void x() {}\n"
+                          "void func16() {}\n"
+                          "int main() {\n"
+                          "func16();\n"
+                          "int y = 0;\n"
+                          "return y;\n"
+                          "}\n");
+
+    auto parser_result = c::parse(in);
+    ASSERT_TRUE(parser_result.errors_.empty());
+
+    EXPECT_NO_THROW({ c::get_symtab(parser_result.program_); });
+}
+
 // NOLINTEND(readability-function-cognitive-complexity)
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include <libc/time_report.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+
+// The value of a field of the phase in the JSON report
+double get_field(
+    const c::TimeReport &report,
+    const std::string &phase,
+    const std::string &field) {
+    std::ostringstream json;
+    report.print_json(json);
+    const auto str = json.str();
+    const auto object = str.find("{\"name\": \"" + phase + "\"");
+    const auto key = "\"" + field + "\": ";
+    return std::stod(str.substr(str.find(key, object) + key.size()));
+}
+
+} // namespace
+
+TEST(TimeReport, NestedAndRepeatedPhases) {
+    using namespace std::chrono_literals;
+
+    c::TimeReport report;
+    const auto start = std::chrono::steady_clock::now();
+    {
+        c::TimeReport::Phase outer(&report, "outer");
+        std::this_thread::sleep_for(5ms);
+        for (int i = 0; i < 3; ++i) {
+            c::TimeReport::Phase inner(&report, "inner");
+            std::this_thread::sleep_for(5ms);
+        }
+    }
+    const double total_ms = std::chrono::duration<double, std::milli>(
+                                std::chrono::steady_clock::now() - start)
+                                .count();
+    report.add_count("nodes", 2);
+    report.add_count("nodes", 3);
+
+    std::ostringstream json;
+    report.print_json(json);
+    const auto str = json.str();
+
+    EXPECT_NE(str.find("\"name\": \"outer\""), std::string::npos);
+    EXPECT_NE(str.find("\"name\": \"inner\""), std::string::npos);
+    EXPECT_NE(str.find("\"calls\": 3"), std::string::npos);
+    EXPECT_NE(str.find("\"nodes\": 5"), std::string::npos);
+    EXPECT_LT(str.find("outer"), str.find("inner"));
+
+    // The time of the inner phases is excluded from the outer one, the rest
+    // of the total is the bookkeeping of the phases, far below one sleep
+    const double outer_ms = get_field(report, "outer", "wall_ms");
+    const double inner_ms = get_field(report, "inner", "wall_ms");
+    EXPECT_GE(outer_ms, 0);
+    EXPECT_GE(inner_ms, 15);
+    EXPECT_LE(outer_ms + inner_ms, total_ms);
+    EXPECT_NEAR(outer_ms + inner_ms, total_ms, 5);
+}
+
+TEST(TimeReport, NullReportRecordsNothing) {
+    using namespace std::chrono_literals;
+
+    c::TimeReport report;
+    {
+        c::TimeReport::Phase outer(&report, "outer");
+        c::TimeReport::Phase phase(nullptr, "phase");
+        std::this_thread::sleep_for(1ms);
+    }
+
+    std::ostringstream json;
+    report.print_json(json);
+    EXPECT_EQ(json.str().find("\"name\": \"phase\""), std::string::npos);
+    // Nor is the time taken from the active phase
+    EXPECT_GE(get_field(report, "outer", "wall_ms"), 1);
+}
+
+TEST(TimeReport, AccumulatedNestedTime) {
+    using namespace std::chrono_literals;
+
+    c::TimeReport report;
+    std::chrono::steady_clock::duration nested{};
+    {
+        c::TimeReport::Phase outer(&report, "outer");
+        for (int i = 0; i < 3; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            std::this_thread::sleep_for(1ms);
+            nested += std::chrono::steady_clock::now() - start;
+        }
+        report.add_nested_time("inner", nested, 3);
+    }
+
+    const double nested_ms =
+        std::chrono::duration<double, std::milli>(nested).count();
+    EXPECT_NEAR(get_field(report, "inner", "wall_ms"), nested_ms, 0.001);
+    EXPECT_NEAR(get_field(report, "inner", "cpu_ms"), nested_ms, 0.001);
+    EXPECT_EQ(get_field(report, "inner", "calls"), 3);
+    EXPECT_GE(get_field(report, "outer", "wall_ms"), 0);
+    EXPECT_LT(get_field(report, "outer", "wall_ms"), nested_ms);
+}
\ No newline at end of file
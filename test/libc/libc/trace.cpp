@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+
+#include <libc/trace.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef C_ENABLE_TRACING
+
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// The line of the event in the trace
+std::string get_event(const std::string &trace, const std::string &name) {
+    const auto pos = trace.find("\"name\": \"" + name + "\"");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    const auto begin = trace.rfind('\n', pos) + 1;
+    return trace.substr(begin, trace.find('\n', pos) - begin);
+}
+
+// The text of a number field of the event
+std::string get_field(const std::string &event, const std::string &field) {
+    const auto key = "\"" + field + "\": ";
+    const auto begin = event.find(key) + key.size();
+    return event.substr(begin, event.find_first_of(",}", begin) - begin);
+}
+
+} // namespace
+
+TEST(Trace, NestedScopes) {
+    using namespace std::chrono_literals;
+
+    const auto path = std::filesystem::temp_directory_path() / "c-trace.json";
+    ASSERT_TRUE(c::trace::start(path.string()));
+    {
+        C_TRACE_SCOPE("pipeline", "outer");
+        std::this_thread::sleep_for(1ms);
+        {
+            C_TRACE_SCOPE("codegen", "inner");
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+    c::trace::stop();
+
+    std::ifstream in(path);
+    std::stringstream trace;
+    trace << in.rdbuf();
+    std::filesystem::remove(path);
+
+    const auto outer = get_event(trace.str(), "outer");
+    const auto inner = get_event(trace.str(), "inner");
+    ASSERT_FALSE(outer.empty()) << trace.str();
+    ASSERT_FALSE(inner.empty()) << trace.str();
+    EXPECT_NE(outer.find("\"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(outer.find("\"cat\": \"pipeline\""), std::string::npos);
+    EXPECT_NE(inner.find("\"cat\": \"codegen\""), std::string::npos);
+
+    // Microseconds with three decimals, never in the exponent form
+    for (const auto &event : {outer, inner}) {
+        for (const auto *field : {"ts", "dur"}) {
+            const auto value = get_field(event, field);
+            EXPECT_EQ(value.find('e'), std::string::npos) << value;
+            ASSERT_NE(value.find('.'), std::string::npos) << value;
+            EXPECT_EQ(value.size() - value.find('.'), 4U) << value;
+        }
+    }
+
+    // An event is written when its scope ends, the inner one is within
+    // the outer one
+    EXPECT_LT(trace.str().find(inner), trace.str().find(outer));
+    const double outer_ts = std::stod(get_field(outer, "ts"));
+    const double outer_dur = std::stod(get_field(outer, "dur"));
+    const double inner_ts = std::stod(get_field(inner, "ts"));
+    const double inner_dur = std::stod(get_field(inner, "dur"));
+    EXPECT_LE(outer_ts, inner_ts);
+    EXPECT_GE(inner_dur, 1000);
+    EXPECT_LE(inner_ts + inner_dur, outer_ts + outer_dur);
+    EXPECT_GE(outer_dur, inner_dur + 1000);
+}
+
+#else
+
+TEST(Trace, DisabledByDefault) {
+    const auto path = std::filesystem::temp_directory_path() / "c-trace.json";
+    std::filesystem::remove(path);
+    EXPECT_FALSE(c::trace::start(path.string()));
+    c::trace::stop();
+    EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+#endif
\ No newline at end of file
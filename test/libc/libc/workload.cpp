@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <libc/analyzer.hpp>
+#include <libc/code_generator.hpp>
+#include <libc/parser.hpp>
+#include <libc/symtab.hpp>
+#include <libc/workload.hpp>
+
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// NOLINTBEGIN(readability-function-cognitive-complexity)
+
+namespace {
+
+std::string generate(const c::WorkloadOptions &options) {
+    std::ostringstream out;
+    c::generate_workload(out, options);
+    return out.str();
+}
+
+// The instruction has the value as an operand, or defines it
+bool is_used(const std::string &line, const std::string &value) {
+    for (auto pos = line.find(value); pos != std::string::npos;
+         pos = line.find(value, pos + 1)) {
+        const auto end = pos + value.size();
+        if (end == line.size() ||
+            (std::isalnum(static_cast<unsigned char>(line[end])) == 0 &&
+             line[end] != '.' && line[end] != '_')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every function stores to its data array before it uses a value loaded
+// from it. The code generator loads the element of a plain assignment too,
+// but never uses that value.
+bool writes_data_first(const std::string &ir) {
+    std::istringstream in(ir);
+    std::vector<std::string> elements;
+    std::vector<std::string> loaded;
+    bool is_written = false;
+    for (std::string line; std::getline(in, line);) {
+        if (line.rfind("define", 0) == 0) {
+            elements.clear();
+            loaded.clear();
+            is_written = false;
+            continue;
+        }
+        if (!is_written) {
+            for (const auto &value : loaded) {
+                if (is_used(line, value)) {
+                    return false;
+                }
+            }
+        }
+
+        const auto assign = line.find(" = ");
+        if (line.find(" = getelementptr i32, i32* %data.") !=
+            std::string::npos) {
+            elements.push_back(line.substr(1, assign - 1));
+            continue;
+        }
+        for (const auto &element : elements) {
+            if (!is_used(line, element)) {
+                continue;
+            }
+            if (line.rfind("\tstore ", 0) == 0) {
+                is_written = true;
+            } else if (line.find(" = load ") != std::string::npos) {
+                loaded.push_back(line.substr(1, assign - 1));
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(Workload, SameSeedSameProgram) {
+    c::WorkloadOptions options;
+    options.seed_ = 42;
+    const auto program = generate(options);
+
+    EXPECT_EQ(program, generate(options));
+
+    options.seed_ = 43;
+    EXPECT_NE(program, generate(options));
+}
+
+TEST(Workload, ValidPrograms) {
+    c::WorkloadOptions options;
+    options.functions_ = 4;
+    options.statements_ = 200;
+    options.nesting_depth_ = 4;
+    options.identifiers_ = 6;
+    options.shadowing_density_ = 0.5;
+    options.string_volume_ = 0.3;
+
+    for (std::uint64_t seed = 0; seed < 8; ++seed) {
+        options.seed_ = seed;
+        std::istringstream in(generate(options));
+
+        auto parser_result = c::parse(in);
+        ASSERT_TRUE(parser_result.errors_.empty()) << "seed " << seed;
+
+        c::ast::symtab::Symtab symtab;
+        ASSERT_NO_THROW({ symtab = c::get_symtab(parser_result.program_); })
+            << "seed " << seed;
+        ASSERT_NO_THROW({ c::analyze(parser_result.program_, symtab); })
+            << "seed " << seed;
+
+        std::ostringstream ir;
+        ASSERT_NO_THROW({ c::generate(ir, parser_result.program_, symtab); })
+            << "seed " << seed;
+        EXPECT_TRUE(writes_data_first(ir.str())) << "seed " << seed;
+    }
+}
+
+TEST(Workload, InvalidOptions) {
+    c::WorkloadOptions options;
+    options.functions_ = 0;
+    EXPECT_THROW(generate(options), std::invalid_argument);
+
+    options.functions_ = 150;
+    options.identifiers_ = 100;
+    EXPECT_THROW(generate(options), std::invalid_argument);
+}
+
+// NOLINTEND(readability-function-cognitive-complexity)
\ No newline at end of file